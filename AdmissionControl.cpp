@@ -0,0 +1,129 @@
+/**
+ * @file AdmissionControl.cpp
+ * @brief Implementation of the AdmissionControl class.
+ */
+
+#include "AdmissionControl.h"
+#include "Checkpoint.h"
+#include <cmath>
+
+/**
+ * @brief Constructor implementation.
+ */
+AdmissionControl::AdmissionControl(const AdmissionConfig& config)
+ : config(config),
+   red_average(0.0),
+   codel_first_above(0),
+   codel_dropping(false),
+   codel_drop_next(0),
+   codel_count(0),
+   rejected(0) {}
+
+/**
+ * @brief Updates the average and drops with probability rising linearly
+ * from 0 at the min threshold to red_max_probability at the max threshold.
+ */
+bool AdmissionControl::redDrop(std::size_t queue_size, double uniform) {
+    red_average += config.red_weight * (static_cast<double>(queue_size) - red_average);
+
+    if (red_average < config.red_min_threshold) return false;
+    if (red_average >= config.red_max_threshold) return true;
+
+    double span = config.red_max_threshold - config.red_min_threshold;
+    double p = config.red_max_probability * (red_average - config.red_min_threshold) / span;
+    return uniform < p;
+}
+
+/**
+ * @brief CoDel control law evaluated at arrival time.
+ *
+ * Once the head request has waited more than codel_target for a whole
+ * codel_interval, one arrival is dropped and the next drop is scheduled
+ * interval / sqrt(count) later, until the delay falls below target.
+ */
+bool AdmissionControl::codelDrop(std::size_t queue_size, int head_sojourn, int current_cycle) {
+    bool ok_to_drop = false;
+
+    if (head_sojourn < config.codel_target || queue_size == 0) {
+        codel_first_above = 0;
+    } else if (codel_first_above == 0) {
+        codel_first_above = current_cycle + config.codel_interval;
+    } else if (current_cycle >= codel_first_above) {
+        ok_to_drop = true;
+    }
+
+    if (codel_dropping) {
+        if (!ok_to_drop) {
+            codel_dropping = false;
+            return false;
+        }
+        if (current_cycle >= codel_drop_next) {
+            codel_count++;
+            codel_drop_next = current_cycle +
+                static_cast<int>(config.codel_interval / std::sqrt(static_cast<double>(codel_count)));
+            return true;
+        }
+        return false;
+    }
+
+    if (ok_to_drop) {
+        codel_dropping = true;
+        // resume near the previous drop rate if we only just left dropping
+        bool recent = current_cycle - codel_drop_next < 16 * config.codel_interval;
+        codel_count = (codel_count > 2 && recent) ? codel_count - 2 : 1;
+        codel_drop_next = current_cycle +
+            static_cast<int>(config.codel_interval / std::sqrt(static_cast<double>(codel_count)));
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Applies the capacity limit, then the configured policy.
+ */
+bool AdmissionControl::admit(std::size_t queue_size, int head_sojourn, int current_cycle, double uniform) {
+    bool drop = config.max_queue_length > 0 && queue_size >= config.max_queue_length;
+
+    if (!drop) {
+        if (config.policy == AdmissionPolicy::RED) {
+            drop = redDrop(queue_size, uniform);
+        } else if (config.policy == AdmissionPolicy::CoDel) {
+            drop = codelDrop(queue_size, head_sojourn, current_cycle);
+        }
+    }
+
+    if (drop) rejected++;
+    return !drop;
+}
+
+/**
+ * @brief Returns rejected arrivals.
+ */
+long long AdmissionControl::getRejectedCount() const {
+    return rejected;
+}
+
+/**
+ * @brief RED average, CoDel state and the rejection count; the policy
+ * itself comes from the configuration.
+ */
+void AdmissionControl::save(CheckpointWriter& out) const {
+    out.put(red_average);
+    out.put(codel_first_above);
+    out.put(codel_dropping);
+    out.put(codel_drop_next);
+    out.put(codel_count);
+    out.put(rejected);
+}
+
+/**
+ * @brief Reads the fields in save() order.
+ */
+void AdmissionControl::restore(CheckpointReader& in) {
+    in.get(red_average);
+    in.get(codel_first_above);
+    in.get(codel_dropping);
+    in.get(codel_drop_next);
+    in.get(codel_count);
+    in.get(rejected);
+}
\ No newline at end of file
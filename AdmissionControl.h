@@ -0,0 +1,139 @@
+/**
+ * @file AdmissionControl.h
+ * @brief Defines queue admission policies applied when requests arrive.
+ *
+ * Each LoadBalancer owns one AdmissionControl instance that decides
+ * whether a new request may join its queue:
+ * - TailDrop: reject only when the queue is at its capacity limit
+ * - RED: random early detection on an EWMA of the queue length
+ * - CoDel: shed arrivals while the oldest queued request has waited
+ *   longer than a target for at least one interval
+ *
+ * A hard capacity limit (when set) applies under every policy.
+ */
+
+#pragma once
+#include <cstddef>
+
+class CheckpointWriter;
+class CheckpointReader;
+
+/**
+ * @enum AdmissionPolicy
+ * @brief How arrivals are shed before the queue is full.
+ */
+enum class AdmissionPolicy {
+    /** @brief Admit until the capacity limit, then drop. */
+    TailDrop,
+    /** @brief Random early detection. */
+    RED,
+    /** @brief Controlled delay: shed based on queueing delay. */
+    CoDel
+};
+
+/**
+ * @struct AdmissionConfig
+ * @brief Capacity limit and policy parameters.
+ */
+struct AdmissionConfig {
+
+    /** @brief Selected policy. */
+    AdmissionPolicy policy = AdmissionPolicy::TailDrop;
+
+    /** @brief Maximum queued requests per balancer (0 = unbounded). */
+    std::size_t max_queue_length = 0;
+
+    /** @brief RED: average queue length where early drops start. */
+    double red_min_threshold = 50.0;
+
+    /** @brief RED: average queue length where every arrival is dropped. */
+    double red_max_threshold = 150.0;
+
+    /** @brief RED: drop probability reached at red_max_threshold. */
+    double red_max_probability = 0.1;
+
+    /** @brief RED: EWMA weight given to the instantaneous queue length. */
+    double red_weight = 0.002;
+
+    /** @brief CoDel: acceptable queueing delay in cycles. */
+    int codel_target = 5;
+
+    /** @brief CoDel: window over which delay must stay above target. */
+    int codel_interval = 100;
+};
+
+/**
+ * @class AdmissionControl
+ * @brief Per-queue admission state for one load balancer.
+ */
+class AdmissionControl {
+private:
+
+    /** @brief Policy parameters. */
+    AdmissionConfig config;
+
+    /** @brief RED: exponentially weighted average queue length. */
+    double red_average;
+
+    /** @brief CoDel: cycle at which delay first stayed above target (0 = not above). */
+    int codel_first_above;
+
+    /** @brief CoDel: whether the controller is in its dropping state. */
+    bool codel_dropping;
+
+    /** @brief CoDel: cycle of the next scheduled drop. */
+    int codel_drop_next;
+
+    /** @brief CoDel: drops since entering the dropping state. */
+    int codel_count;
+
+    /** @brief Arrivals rejected so far. */
+    long long rejected;
+
+    /**
+     * @brief Applies the RED rule.
+     * @return True if the arrival should be dropped.
+     */
+    bool redDrop(std::size_t queue_size, double uniform);
+
+    /**
+     * @brief Applies the CoDel control law.
+     * @return True if the arrival should be dropped.
+     */
+    bool codelDrop(std::size_t queue_size, int head_sojourn, int current_cycle);
+
+public:
+
+    /**
+     * @brief Constructs admission state for one queue.
+     *
+     * @param config Capacity limit and policy parameters.
+     */
+    explicit AdmissionControl(const AdmissionConfig& config = AdmissionConfig());
+
+    /**
+     * @brief Decides whether an arriving request may join the queue.
+     *
+     * @param queue_size Current queue length.
+     * @param head_sojourn Cycles the head request has waited in this queue (0 if empty).
+     * @param current_cycle Current simulation clock cycle.
+     * @param uniform Random draw in [0, 1) used by RED.
+     * @return True to admit, false to reject.
+     */
+    bool admit(std::size_t queue_size, int head_sojourn, int current_cycle, double uniform);
+
+    /**
+     * @brief Returns the number of rejected arrivals.
+     */
+    long long getRejectedCount() const;
+
+    /**
+     * @brief Appends the policy state to a checkpoint.
+     */
+    void save(CheckpointWriter& out) const;
+
+    /**
+     * @brief Replaces the policy state with one read from a checkpoint.
+     */
+    void restore(CheckpointReader& in);
+};
\ No newline at end of file
@@ -0,0 +1,87 @@
+/**
+ * @file Blocklist.cpp
+ * @brief Implementation of the Blocklist class.
+ */
+
+#include "Blocklist.h"
+#include <algorithm>
+#include <utility>
+
+/**
+ * @brief Constructor implementation.
+ */
+Blocklist::Blocklist(const std::vector<IPRange>& ranges) {
+    std::vector<std::pair<unsigned int, unsigned int>> raw;
+    raw.reserve(ranges.size());
+    for (const IPRange& range : ranges) {
+        raw.emplace_back(range.low.getValue(), range.high.getValue());
+    }
+    *this = Blocklist(std::move(raw));
+}
+
+/**
+ * @brief Merges the intervals and splits them into the lookup arrays.
+ */
+Blocklist::Blocklist(std::vector<std::pair<unsigned int, unsigned int>>&& intervals) {
+    mergeIntervals(intervals);
+    lows.reserve(intervals.size());
+    highs.reserve(intervals.size());
+    for (const auto& interval : intervals) {
+        lows.push_back(interval.first);
+        highs.push_back(interval.second);
+    }
+}
+
+/**
+ * @brief Sort, then fold each interval into its predecessor when they touch.
+ */
+void Blocklist::mergeIntervals(std::vector<std::pair<unsigned int, unsigned int>>& intervals) {
+    intervals.erase(std::remove_if(intervals.begin(), intervals.end(),
+                                   [](const std::pair<unsigned int, unsigned int>& i) {
+                                       return i.first > i.second;
+                                   }),
+                    intervals.end());
+    std::sort(intervals.begin(), intervals.end());
+
+    std::size_t out = 0;
+    for (std::size_t i = 0; i < intervals.size(); i++) {
+        // widen to 64 bits so a range ending at 255.255.255.255 cannot wrap
+        if (out > 0 &&
+            static_cast<unsigned long long>(intervals[i].first) <=
+            static_cast<unsigned long long>(intervals[out - 1].second) + 1) {
+            intervals[out - 1].second = std::max(intervals[out - 1].second, intervals[i].second);
+        } else {
+            intervals[out++] = intervals[i];
+        }
+    }
+    intervals.resize(out);
+}
+
+/**
+ * @brief Zips the lookup arrays back into pairs.
+ */
+std::vector<std::pair<unsigned int, unsigned int>> Blocklist::intervals() const {
+    std::vector<std::pair<unsigned int, unsigned int>> result;
+    result.reserve(lows.size());
+    for (std::size_t i = 0; i < lows.size(); i++) {
+        result.emplace_back(lows[i], highs[i]);
+    }
+    return result;
+}
+
+/**
+ * @brief Finds the last interval starting at or below the address.
+ */
+bool Blocklist::contains(const IPAddress& address) const {
+    unsigned int value = address.getValue();
+    auto it = std::upper_bound(lows.begin(), lows.end(), value);
+    if (it == lows.begin()) return false;
+    return value <= highs[(it - lows.begin()) - 1];
+}
+
+/**
+ * @brief Returns interval count.
+ */
+std::size_t Blocklist::size() const {
+    return lows.size();
+}
\ No newline at end of file
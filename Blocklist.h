@@ -0,0 +1,76 @@
+/**
+ * @file Blocklist.h
+ * @brief Defines a compiled, immutable set of blocked IPv4 ranges.
+ *
+ * Ranges from the configuration are sorted and merged once, after which a
+ * lookup is a binary search over disjoint intervals instead of a scan of
+ * every configured range.
+ */
+
+#pragma once
+#include "IPAddress.h"
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+/**
+ * @class Blocklist
+ * @brief Sorted, non-overlapping inclusive address intervals.
+ */
+class Blocklist {
+private:
+
+    /** @brief Interval lower bounds, ascending. */
+    std::vector<unsigned int> lows;
+
+    /** @brief Interval upper bounds; highs[i] belongs to lows[i]. */
+    std::vector<unsigned int> highs;
+
+public:
+
+    /**
+     * @brief Constructs an empty blocklist.
+     */
+    Blocklist() = default;
+
+    /**
+     * @brief Sorts and merges ranges into disjoint intervals.
+     *
+     * Overlapping and adjacent ranges are merged; ranges with low > high
+     * are ignored.
+     *
+     * @param ranges Ranges in any order.
+     */
+    explicit Blocklist(const std::vector<IPRange>& ranges);
+
+    /**
+     * @brief Builds a blocklist from raw [low, high] intervals.
+     *
+     * @param intervals Intervals in any order; consumed (sorted in place).
+     */
+    explicit Blocklist(std::vector<std::pair<unsigned int, unsigned int>>&& intervals);
+
+    /**
+     * @brief Sorts intervals and merges overlapping or adjacent ones in place.
+     *
+     * @param intervals Intervals to normalise; low > high entries are dropped.
+     */
+    static void mergeIntervals(std::vector<std::pair<unsigned int, unsigned int>>& intervals);
+
+    /**
+     * @brief Returns the disjoint intervals in ascending order.
+     */
+    std::vector<std::pair<unsigned int, unsigned int>> intervals() const;
+
+    /**
+     * @brief Returns whether an address lies in any interval.
+     *
+     * @param address Address to test.
+     */
+    bool contains(const IPAddress& address) const;
+
+    /**
+     * @brief Returns the number of disjoint intervals.
+     */
+    std::size_t size() const;
+};
\ No newline at end of file
@@ -0,0 +1,291 @@
+/**
+ * @file BlocklistFile.cpp
+ * @brief Implementation of the parallel blocklist importer and its sidecar cache.
+ */
+
+#include "BlocklistFile.h"
+#include "Blocklist.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <thread>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/** @brief Identifies a sidecar file and its layout version. */
+static const char SIDECAR_MAGIC[8] = {'L', 'B', 'B', 'L', 'K', '0', '0', '1'};
+
+/** @brief Minimum bytes per parser thread; smaller files use fewer threads. */
+static const std::size_t MIN_CHUNK_BYTES = 1 << 20;
+
+/**
+ * @struct SidecarHeader
+ * @brief Fixed header of the binary cache, followed by count interval pairs.
+ */
+struct SidecarHeader {
+    char magic[8];
+    std::uint64_t source_size;
+    std::int64_t source_mtime_ns;
+    std::uint64_t count;
+};
+
+typedef std::vector<std::pair<unsigned int, unsigned int>> IntervalList;
+
+/**
+ * @brief Skips spaces and tabs.
+ */
+static const char* skipBlanks(const char* p, const char* end) {
+    while (p < end && (*p == ' ' || *p == '\t')) p++;
+    return p;
+}
+
+/**
+ * @brief Parses a dotted-decimal IPv4 address without allocating.
+ *
+ * @return Pointer past the address, or null if it is malformed.
+ */
+static const char* parseAddress(const char* p, const char* end, unsigned int& value) {
+    unsigned int result = 0;
+    for (int octet = 0; octet < 4; octet++) {
+        if (octet > 0) {
+            if (p >= end || *p != '.') return nullptr;
+            p++;
+        }
+        unsigned int n = 0;
+        int digits = 0;
+        while (p < end && *p >= '0' && *p <= '9' && digits < 3) {
+            n = n * 10 + static_cast<unsigned int>(*p - '0');
+            p++;
+            digits++;
+        }
+        if (digits == 0 || n > 255) return nullptr;
+        result = (result << 8) | n;
+    }
+    value = result;
+    return p;
+}
+
+/**
+ * @brief Parses one line into an interval.
+ *
+ * @return 1 if an interval was produced, 0 for blank/comment lines,
+ *         -1 for malformed lines.
+ */
+static int parseLine(const char* p, const char* end, std::pair<unsigned int, unsigned int>& out) {
+    p = skipBlanks(p, end);
+    if (p < end && end[-1] == '\r') end--;
+    if (p >= end || *p == '#') return 0;
+    if (end - p > 6 && std::memcmp(p, "block", 5) == 0 && (p[5] == ' ' || p[5] == '\t')) {
+        p = skipBlanks(p + 6, end);
+    }
+
+    unsigned int low;
+    p = parseAddress(p, end, low);
+    if (p == nullptr) return -1;
+    p = skipBlanks(p, end);
+
+    unsigned int high = low;
+    if (p < end && *p == '/') {
+        unsigned int prefix = 0;
+        int digits = 0;
+        for (p++; p < end && *p >= '0' && *p <= '9' && digits < 2; p++, digits++) {
+            prefix = prefix * 10 + static_cast<unsigned int>(*p - '0');
+        }
+        if (digits == 0 || prefix > 32) return -1;
+        unsigned int mask = (prefix == 0) ? 0u : 0xFFFFFFFFu << (32 - prefix);
+        low &= mask;
+        high = low | ~mask;
+    } else if (p < end && *p == '-') {
+        p = parseAddress(skipBlanks(p + 1, end), end, high);
+        if (p == nullptr) return -1;
+    }
+
+    p = skipBlanks(p, end);
+    if (p < end && *p != '#') return -1;
+    out = std::make_pair(low, high);
+    return 1;
+}
+
+/**
+ * @brief Parses every line in [begin, end) and merges the result.
+ */
+static void parseChunk(const char* begin, const char* end, IntervalList& intervals,
+                       std::size_t& parsed, std::size_t& malformed) {
+    std::pair<unsigned int, unsigned int> interval;
+    const char* line = begin;
+    while (line < end) {
+        const char* eol = static_cast<const char*>(std::memchr(line, '\n', end - line));
+        if (eol == nullptr) eol = end;
+
+        int result = parseLine(line, eol, interval);
+        if (result > 0) {
+            intervals.push_back(interval);
+            parsed++;
+        } else if (result < 0) {
+            malformed++;
+        }
+        line = eol + 1;
+    }
+    Blocklist::mergeIntervals(intervals);
+}
+
+/**
+ * @brief Returns the modification time of a stat result in nanoseconds.
+ */
+static std::int64_t mtimeNs(const struct stat& st) {
+    return static_cast<std::int64_t>(st.st_mtim.tv_sec) * 1000000000LL + st.st_mtim.tv_nsec;
+}
+
+/**
+ * @brief Loads the sidecar if it was built from this exact source file.
+ */
+static bool readSidecar(const std::string& path, const struct stat& source, IntervalList& intervals) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+
+    struct stat st;
+    bool ok = fstat(fd, &st) == 0 && static_cast<std::size_t>(st.st_size) >= sizeof(SidecarHeader);
+    void* map = ok ? mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+    close(fd);
+    if (map == MAP_FAILED) return false;
+
+    SidecarHeader header;
+    std::memcpy(&header, map, sizeof(header));
+    std::size_t expected = sizeof(SidecarHeader) + header.count * 2 * sizeof(std::uint32_t);
+    ok = std::memcmp(header.magic, SIDECAR_MAGIC, sizeof(SIDECAR_MAGIC)) == 0 &&
+         header.source_size == static_cast<std::uint64_t>(source.st_size) &&
+         header.source_mtime_ns == mtimeNs(source) &&
+         expected == static_cast<std::size_t>(st.st_size);
+
+    if (ok) {
+        const std::uint32_t* data = reinterpret_cast<const std::uint32_t*>(
+            static_cast<const char*>(map) + sizeof(SidecarHeader));
+        intervals.resize(header.count);
+        for (std::size_t i = 0; i < header.count; i++) {
+            intervals[i] = std::make_pair(data[2 * i], data[2 * i + 1]);
+        }
+    }
+    munmap(map, st.st_size);
+    return ok;
+}
+
+/**
+ * @brief Writes the sidecar to a temporary file and renames it into place,
+ * so a concurrent reader never sees a partial cache.
+ */
+static void writeSidecar(const std::string& path, const struct stat& source, const IntervalList& intervals) {
+    std::string tmp = path + ".tmp";
+    std::FILE* out = std::fopen(tmp.c_str(), "wb");
+    if (out == nullptr) return;
+
+    SidecarHeader header;
+    std::memcpy(header.magic, SIDECAR_MAGIC, sizeof(SIDECAR_MAGIC));
+    header.source_size = static_cast<std::uint64_t>(source.st_size);
+    header.source_mtime_ns = mtimeNs(source);
+    header.count = intervals.size();
+
+    bool ok = std::fwrite(&header, sizeof(header), 1, out) == 1;
+    for (const auto& interval : intervals) {
+        std::uint32_t pair[2] = {interval.first, interval.second};
+        ok = ok && std::fwrite(pair, sizeof(pair), 1, out) == 1;
+    }
+    ok = (std::fclose(out) == 0) && ok;
+
+    if (!ok || std::rename(tmp.c_str(), path.c_str()) != 0) {
+        std::remove(tmp.c_str());
+    }
+}
+
+/**
+ * @brief Sidecar first; otherwise mmap, split at newlines, parse in
+ * parallel, merge the sorted chunk results and refresh the sidecar.
+ */
+bool loadBlocklistFile(const std::string& path, IntervalList& intervals, BlocklistLoadStats* stats) {
+    auto begin = std::chrono::steady_clock::now();
+    BlocklistLoadStats local;
+
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return false;
+    }
+
+    std::string sidecar = path + ".bin";
+    intervals.clear();
+    if (readSidecar(sidecar, st, intervals)) {
+        close(fd);
+        local.from_cache = true;
+    } else {
+        std::size_t size = static_cast<std::size_t>(st.st_size);
+        const char* data = nullptr;
+        void* map = MAP_FAILED;
+        if (size > 0) {
+            map = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (map == MAP_FAILED) {
+                close(fd);
+                return false;
+            }
+            madvise(map, size, MADV_SEQUENTIAL);
+            data = static_cast<const char*>(map);
+        }
+        close(fd);
+
+        // chunk boundaries are moved forward to the next newline
+        unsigned int threads = std::max(1u, std::thread::hardware_concurrency());
+        threads = static_cast<unsigned int>(std::min<std::size_t>(threads, size / MIN_CHUNK_BYTES + 1));
+        std::vector<const char*> bounds(threads + 1, data + size);
+        bounds[0] = data;
+        for (unsigned int t = 1; t < threads; t++) {
+            const char* p = std::max(data + size * t / threads, bounds[t - 1]);
+            const char* nl = (p < data + size)
+                ? static_cast<const char*>(std::memchr(p, '\n', data + size - p)) : nullptr;
+            bounds[t] = (nl == nullptr) ? data + size : nl + 1;
+        }
+
+        std::vector<IntervalList> parts(threads);
+        std::vector<std::size_t> parsed(threads, 0), malformed(threads, 0);
+        std::vector<std::thread> workers;
+        for (unsigned int t = 1; t < threads; t++) {
+            workers.emplace_back(parseChunk, bounds[t], bounds[t + 1], std::ref(parts[t]),
+                                 std::ref(parsed[t]), std::ref(malformed[t]));
+        }
+        parseChunk(bounds[0], bounds[1], parts[0], parsed[0], malformed[0]);
+        for (std::thread& worker : workers) worker.join();
+        if (map != MAP_FAILED) munmap(map, size);
+
+        // each part is sorted and disjoint; concatenate, merge runs, then fold overlaps
+        std::vector<std::size_t> run_starts;
+        for (unsigned int t = 0; t < threads; t++) {
+            run_starts.push_back(intervals.size());
+            intervals.insert(intervals.end(), parts[t].begin(), parts[t].end());
+            local.parsed_entries += parsed[t];
+            local.malformed_lines += malformed[t];
+        }
+        for (std::size_t width = 1; width < run_starts.size(); width *= 2) {
+            for (std::size_t i = 0; i + width < run_starts.size(); i += 2 * width) {
+                auto first = intervals.begin() + run_starts[i];
+                auto middle = intervals.begin() + run_starts[i + width];
+                auto last = (i + 2 * width < run_starts.size())
+                    ? intervals.begin() + run_starts[i + 2 * width] : intervals.end();
+                std::inplace_merge(first, middle, last);
+            }
+        }
+        Blocklist::mergeIntervals(intervals);
+        local.threads = threads;
+
+        writeSidecar(sidecar, st, intervals);
+    }
+
+    local.merged_ranges = intervals.size();
+    local.elapsed_us = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - begin).count();
+    if (stats != nullptr) *stats = local;
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,61 @@
+/**
+ * @file BlocklistFile.h
+ * @brief Bulk import of blocked ranges from large external threat feeds.
+ *
+ * A blocklist file holds one entry per line, in any of these forms:
+ * - a.b.c.d - e.f.g.h   (inclusive range; a leading "block" is allowed)
+ * - a.b.c.d/n           (CIDR block)
+ * - a.b.c.d             (single address)
+ *
+ * Blank lines and lines starting with '#' are ignored. The file is memory
+ * mapped and split at line boundaries into chunks parsed on separate
+ * threads. The merged intervals are cached in a binary sidecar file
+ * (path + ".bin") tagged with the source's size and modification time,
+ * so later loads of an unchanged file skip parsing entirely.
+ */
+
+#pragma once
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * @struct BlocklistLoadStats
+ * @brief What one import did, for logging.
+ */
+struct BlocklistLoadStats {
+
+    /** @brief Entries parsed from the text file (0 when the sidecar was used). */
+    std::size_t parsed_entries = 0;
+
+    /** @brief Non-comment lines that could not be parsed. */
+    std::size_t malformed_lines = 0;
+
+    /** @brief Disjoint intervals after merging. */
+    std::size_t merged_ranges = 0;
+
+    /** @brief Parser threads used (0 when the sidecar was used). */
+    unsigned int threads = 0;
+
+    /** @brief Whether the intervals came from the binary sidecar. */
+    bool from_cache = false;
+
+    /** @brief Wall time of the import, in microseconds. */
+    long long elapsed_us = 0;
+};
+
+/**
+ * @brief Loads and merges every range in a blocklist file.
+ *
+ * Uses the sidecar cache when it matches the file, otherwise parses the
+ * file in parallel and rewrites the sidecar.
+ *
+ * @param path Path of the text blocklist.
+ * @param intervals Receives merged [low, high] intervals, ascending.
+ * @param stats Receives import statistics; may be null.
+ * @return False if the file could not be opened or mapped.
+ */
+bool loadBlocklistFile(const std::string& path,
+                       std::vector<std::pair<unsigned int, unsigned int>>& intervals,
+                       BlocklistLoadStats* stats = nullptr);
\ No newline at end of file
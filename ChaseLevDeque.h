@@ -0,0 +1,152 @@
+/**
+ * @file ChaseLevDeque.h
+ * @brief Bounded Chase-Lev work-stealing deque.
+ *
+ * One owner thread pushes and pops at the bottom while any number of
+ * thief threads steal from the top. Owner operations are wait-free and
+ * thieves synchronise with a single compare-and-swap on the top index,
+ * so balancers can publish and steal work from worker threads without
+ * a lock.
+ *
+ * Unlike the original Chase-Lev deque the buffer does not grow while
+ * thieves are active; the owner calls reserve() between steal phases,
+ * when no thief can observe the buffer.
+ */
+
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @class ChaseLevDeque
+ * @brief Single-owner, multi-thief deque of trivially copyable values.
+ *
+ * @tparam T Element type. Thieves may read a slot that the owner is
+ *           concurrently overwriting, so T should be trivially copyable.
+ */
+template <typename T>
+class ChaseLevDeque {
+private:
+
+    /** @brief Index of the next element thieves will steal. */
+    alignas(64) std::atomic<std::int64_t> top{0};
+
+    /** @brief Index one past the last element pushed by the owner. */
+    alignas(64) std::atomic<std::int64_t> bottom{0};
+
+    /** @brief Ring buffer storage (size is a power of two). */
+    std::vector<T> buffer;
+
+    /** @brief buffer.size() - 1, used to wrap indices. */
+    std::int64_t mask = -1;
+
+public:
+
+    ChaseLevDeque() = default;
+
+    /** @brief Deques are owned by one balancer and are not copied. */
+    ChaseLevDeque(const ChaseLevDeque&) = delete;
+    ChaseLevDeque& operator=(const ChaseLevDeque&) = delete;
+
+    /**
+     * @brief Move constructor so owners can live in a std::vector.
+     *
+     * Only valid while no thief is accessing @p other.
+     */
+    ChaseLevDeque(ChaseLevDeque&& other) noexcept
+     : buffer(std::move(other.buffer)), mask(other.mask) {
+        top.store(other.top.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        bottom.store(other.bottom.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Ensures room for at least @p capacity elements.
+     *
+     * Owner only, and only while the deque is empty and no thief is active.
+     *
+     * @param capacity Minimum number of elements the deque must hold.
+     */
+    void reserve(std::size_t capacity) {
+        if (static_cast<std::int64_t>(capacity) <= mask + 1) return;
+        std::size_t size = 1;
+        while (size < capacity) size <<= 1;
+        buffer.assign(size, T());
+        mask = static_cast<std::int64_t>(size) - 1;
+        top.store(0, std::memory_order_relaxed);
+        bottom.store(0, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Pushes a value at the bottom (owner only).
+     *
+     * @param value Value to push.
+     * @return False if the deque is full.
+     */
+    bool pushBottom(const T& value) {
+        std::int64_t b = bottom.load(std::memory_order_relaxed);
+        std::int64_t t = top.load(std::memory_order_acquire);
+        if (b - t > mask) return false;
+        buffer[b & mask] = value;
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom.store(b + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    /**
+     * @brief Pops the most recently pushed value (owner only).
+     *
+     * @param out Receives the value on success.
+     * @return False if the deque was empty or a thief won the last element.
+     */
+    bool popBottom(T& out) {
+        std::int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+        bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::int64_t t = top.load(std::memory_order_relaxed);
+
+        if (t > b) {
+            bottom.store(b + 1, std::memory_order_relaxed);
+            return false;
+        }
+
+        out = buffer[b & mask];
+        if (t == b) {
+            // last element: race against thieves for it
+            bool won = top.compare_exchange_strong(t, t + 1,
+                                                   std::memory_order_seq_cst,
+                                                   std::memory_order_relaxed);
+            bottom.store(b + 1, std::memory_order_relaxed);
+            return won;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Steals the oldest pushed value (any thread).
+     *
+     * @param out Receives the value on success.
+     * @return False if the deque was empty or another thief won the race.
+     */
+    bool steal(T& out) {
+        std::int64_t t = top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::int64_t b = bottom.load(std::memory_order_acquire);
+        if (t >= b) return false;
+
+        out = buffer[t & mask];
+        return top.compare_exchange_strong(t, t + 1,
+                                           std::memory_order_seq_cst,
+                                           std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Returns an estimate of the number of elements.
+     */
+    std::size_t size() const {
+        std::int64_t b = bottom.load(std::memory_order_relaxed);
+        std::int64_t t = top.load(std::memory_order_relaxed);
+        return b > t ? static_cast<std::size_t>(b - t) : 0;
+    }
+};
\ No newline at end of file
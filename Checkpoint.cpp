@@ -0,0 +1,224 @@
+/**
+ * @file Checkpoint.cpp
+ * @brief Implementation of the checkpoint writer and reader.
+ */
+
+#include "Checkpoint.h"
+#include <cstdio>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/** @brief Identifies a checkpoint file. */
+static const char CHECKPOINT_MAGIC[4] = {'L', 'B', 'C', 'K'};
+
+/** @brief Layout version; readers refuse others. */
+static const std::uint32_t CHECKPOINT_VERSION = 3;
+
+/** @brief Size of the write buffer. */
+static const std::size_t WRITE_BUFFER_BYTES = 1 << 20;
+
+/**
+ * @brief Constructor implementation.
+ */
+CheckpointWriter::CheckpointWriter(const std::string& path)
+ : path(path),
+   temp_path(path + ".tmp"),
+   fd(-1),
+   buffer(WRITE_BUFFER_BYTES),
+   used(0),
+   bytes(0),
+   failed(false) {
+
+    fd = open(temp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return;
+    putBytes(CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC));
+    put(CHECKPOINT_VERSION);
+}
+
+/**
+ * @brief Destructor implementation.
+ */
+CheckpointWriter::~CheckpointWriter() {
+    if (fd < 0) return;
+    close(fd);
+    unlink(temp_path.c_str());
+}
+
+/**
+ * @brief Returns whether the file was created.
+ */
+bool CheckpointWriter::isOpen() const {
+    return fd >= 0;
+}
+
+/**
+ * @brief Writes the whole buffer, retrying short writes.
+ */
+void CheckpointWriter::flush() {
+    std::size_t done = 0;
+    while (fd >= 0 && !failed && done < used) {
+        ssize_t written = write(fd, buffer.data() + done, used - done);
+        if (written <= 0) {
+            failed = true;
+            break;
+        }
+        done += static_cast<std::size_t>(written);
+    }
+    used = 0;
+}
+
+/**
+ * @brief Length as a u32, then the characters.
+ */
+void CheckpointWriter::putText(const std::string& text) {
+    put(static_cast<std::uint32_t>(text.size()));
+    putBytes(text.data(), text.size());
+}
+
+/**
+ * @brief Tags are written without a length.
+ */
+void CheckpointWriter::putTag(const char* tag) {
+    putBytes(tag, 4);
+}
+
+/**
+ * @brief Renames only a completely written file.
+ */
+bool CheckpointWriter::finish() {
+    if (fd < 0) return false;
+    flush();
+    bool written = !failed && close(fd) == 0;
+    fd = -1;
+    if (written && std::rename(temp_path.c_str(), path.c_str()) == 0) return true;
+    unlink(temp_path.c_str());
+    return false;
+}
+
+/**
+ * @brief Returns bytes written.
+ */
+long long CheckpointWriter::getByteCount() const {
+    return bytes;
+}
+
+/**
+ * @brief Constructor implementation.
+ */
+CheckpointReader::CheckpointReader(const std::string& path)
+ : data(nullptr),
+   size(0),
+   offset(0) {
+
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        fail("cannot open " + path);
+        return;
+    }
+    struct stat info;
+    void* map = MAP_FAILED;
+    if (fstat(fd, &info) == 0 && info.st_size > 0) {
+        map = mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+    if (map == MAP_FAILED) {
+        fail("cannot map " + path);
+        return;
+    }
+    data = static_cast<const char*>(map);
+    size = static_cast<std::size_t>(info.st_size);
+    // the file is read front to back exactly once
+    madvise(map, size, MADV_SEQUENTIAL);
+
+    char magic[sizeof(CHECKPOINT_MAGIC)];
+    getBytes(magic, sizeof(magic));
+    if (ok() && std::memcmp(magic, CHECKPOINT_MAGIC, sizeof(magic)) != 0) {
+        fail(path + " is not a checkpoint");
+    }
+    std::uint32_t version = get<std::uint32_t>();
+    if (ok() && version != CHECKPOINT_VERSION) {
+        fail(path + " has checkpoint version " + std::to_string(version) + ", expected " +
+             std::to_string(CHECKPOINT_VERSION));
+    }
+}
+
+/**
+ * @brief Destructor implementation.
+ */
+CheckpointReader::~CheckpointReader() {
+    if (data != nullptr) munmap(const_cast<char*>(data), size);
+}
+
+/**
+ * @brief Length as a u32, then the characters.
+ */
+std::string CheckpointReader::getText() {
+    std::uint32_t length = get<std::uint32_t>();
+    if (length > size - offset) {
+        fail("checkpoint is truncated");
+        return std::string();
+    }
+    std::string text(length, '\0');
+    getBytes(&text[0], length);
+    return text;
+}
+
+/**
+ * @brief Compares the next four bytes with the tag.
+ */
+void CheckpointReader::expectTag(const char* tag) {
+    char found[4];
+    getBytes(found, sizeof(found));
+    if (ok() && std::memcmp(found, tag, sizeof(found)) != 0) {
+        fail("checkpoint section " + std::string(found, sizeof(found)) + " found where " +
+             std::string(tag, 4) + " was expected");
+    }
+}
+
+/**
+ * @brief Reads a u64 count and compares it.
+ */
+void CheckpointReader::expectCount(std::size_t expected, const char* what) {
+    std::uint64_t found = get<std::uint64_t>();
+    if (ok() && found != expected) {
+        fail("checkpoint has " + std::to_string(found) + " " + what + ", configuration has " +
+             std::to_string(expected));
+    }
+}
+
+/**
+ * @brief Keeps the first reason only.
+ */
+void CheckpointReader::fail(const std::string& reason) {
+    if (error.empty()) error = reason;
+}
+
+/**
+ * @brief Returns whether no failure was recorded.
+ */
+bool CheckpointReader::ok() const {
+    return error.empty();
+}
+
+/**
+ * @brief Returns the first failure.
+ */
+const std::string& CheckpointReader::getError() const {
+    return error;
+}
+
+/**
+ * @brief Returns whether the read position reached the end of the file.
+ */
+bool CheckpointReader::atEnd() const {
+    return offset == size;
+}
+
+/**
+ * @brief Returns the mapped size.
+ */
+std::size_t CheckpointReader::getByteCount() const {
+    return size;
+}
\ No newline at end of file
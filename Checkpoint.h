@@ -0,0 +1,330 @@
+/**
+ * @file Checkpoint.h
+ * @brief Defines the binary checkpoint file a run's state is written to
+ * and restored from.
+ *
+ * A checkpoint is a flat stream: the "LBCK" magic and a version, then
+ * the state of every object in a fixed order. Each stateful class has a
+ * save() that appends its fields and a restore() that reads them back in
+ * the same order. Four-byte tags between sections catch a writer and a
+ * reader that disagree, and restore() checks that the configuration it
+ * restores into has the same shape (nodes, classes, balancers, queue
+ * disciplines) as the one that was saved.
+ *
+ * Plain structs such as Request are copied as raw bytes, so a checkpoint
+ * is only meant to be read by a build with the same layout.
+ *
+ * Writing streams through a fixed buffer into a temporary file that is
+ * renamed over the target once complete, so an interrupted write never
+ * leaves a truncated checkpoint under the real name. Reading maps the
+ * file read-only: runs restoring the same checkpoint share its pages in
+ * the page cache instead of each reading a private copy.
+ */
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <queue>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+/**
+ * @brief Returns the storage of a std::priority_queue, in heap order.
+ *
+ * Saving and restoring the heap array itself (rather than popping and
+ * pushing) keeps the order of equal elements, so a restored run pops
+ * them exactly as the original would have.
+ *
+ * @param queue Queue whose underlying container is returned.
+ */
+template <typename Queue>
+typename Queue::container_type& heapStorage(Queue& queue) {
+    struct Access : Queue {
+        static typename Queue::container_type& of(Queue& q) {
+            return q.*&Access::c;
+        }
+    };
+    return Access::of(queue);
+}
+
+/**
+ * @brief Returns the storage of a const std::priority_queue, in heap order.
+ */
+template <typename Queue>
+const typename Queue::container_type& heapStorage(const Queue& queue) {
+    struct Access : Queue {
+        static const typename Queue::container_type& of(const Queue& q) {
+            return q.*&Access::c;
+        }
+    };
+    return Access::of(queue);
+}
+
+/**
+ * @class CheckpointWriter
+ * @brief Streams values into a new checkpoint file.
+ */
+class CheckpointWriter {
+private:
+
+    /** @brief Final path of the checkpoint. */
+    std::string path;
+
+    /** @brief Path written to until finish() renames it. */
+    std::string temp_path;
+
+    /** @brief File descriptor of temp_path (-1 if it could not be created). */
+    int fd;
+
+    /** @brief Bytes waiting to be written. */
+    std::vector<char> buffer;
+
+    /** @brief Bytes of buffer in use. */
+    std::size_t used;
+
+    /** @brief Bytes written so far, including the buffer. */
+    long long bytes;
+
+    /** @brief Set when a write failed; finish() then removes the file. */
+    bool failed;
+
+    /** @brief Writes the buffer out. */
+    void flush();
+
+public:
+
+    /**
+     * @brief Creates the temporary file and writes the file header.
+     *
+     * @param path Path the checkpoint is renamed to by finish().
+     */
+    explicit CheckpointWriter(const std::string& path);
+
+    /**
+     * @brief Removes the temporary file if finish() was not called.
+     */
+    ~CheckpointWriter();
+
+    CheckpointWriter(const CheckpointWriter&) = delete;
+    CheckpointWriter& operator=(const CheckpointWriter&) = delete;
+
+    /**
+     * @brief Returns whether the temporary file was created.
+     */
+    bool isOpen() const;
+
+    /**
+     * @brief Appends raw bytes.
+     */
+    void putBytes(const void* data, std::size_t size) {
+        if (size == 0) return;
+        if (used + size > buffer.size()) {
+            flush();
+            if (size > buffer.size()) {
+                buffer.resize(size);
+            }
+        }
+        std::memcpy(buffer.data() + used, data, size);
+        used += size;
+        bytes += static_cast<long long>(size);
+    }
+
+    /**
+     * @brief Appends a value of a trivially copyable type.
+     */
+    template <typename T>
+    void put(const T& value) {
+        static_assert(std::is_trivially_copyable<T>::value, "only plain values are copied raw");
+        putBytes(&value, sizeof(T));
+    }
+
+    /**
+     * @brief Appends a length-prefixed string.
+     */
+    void putText(const std::string& text);
+
+    /**
+     * @brief Appends a section tag of exactly four characters.
+     */
+    void putTag(const char* tag);
+
+    /**
+     * @brief Appends a count and the elements of a vector of plain values.
+     */
+    template <typename T>
+    void putVector(const std::vector<T>& values) {
+        static_assert(std::is_trivially_copyable<T>::value, "only plain values are copied raw");
+        put<std::uint64_t>(values.size());
+        putBytes(values.data(), values.size() * sizeof(T));
+    }
+
+    /**
+     * @brief Appends a count and the elements of a deque of plain values.
+     */
+    template <typename T>
+    void putDeque(const std::deque<T>& values) {
+        put<std::uint64_t>(values.size());
+        for (const T& value : values) put(value);
+    }
+
+    /**
+     * @brief Flushes, closes and renames the file over the target.
+     *
+     * @return False if any write, the close or the rename failed.
+     */
+    bool finish();
+
+    /**
+     * @brief Returns the bytes written so far.
+     */
+    long long getByteCount() const;
+};
+
+/**
+ * @class CheckpointReader
+ * @brief Reads values back from a mapped checkpoint file.
+ *
+ * Reading past the end, a wrong tag or a failed check recorded with
+ * fail() marks the reader as failed; later reads return zeros, so a
+ * restore can run to completion and check ok() once.
+ */
+class CheckpointReader {
+private:
+
+    /** @brief Mapped file (null if it could not be mapped). */
+    const char* data;
+
+    /** @brief File size in bytes. */
+    std::size_t size;
+
+    /** @brief Read position. */
+    std::size_t offset;
+
+    /** @brief First failure, empty while the reader is ok. */
+    std::string error;
+
+public:
+
+    /**
+     * @brief Maps the file and checks its header.
+     *
+     * @param path Checkpoint written by a CheckpointWriter.
+     */
+    explicit CheckpointReader(const std::string& path);
+
+    /**
+     * @brief Unmaps the file.
+     */
+    ~CheckpointReader();
+
+    CheckpointReader(const CheckpointReader&) = delete;
+    CheckpointReader& operator=(const CheckpointReader&) = delete;
+
+    /**
+     * @brief Copies the next @p count bytes, or zeros if they are not there.
+     */
+    void getBytes(void* out, std::size_t count) {
+        if (count == 0) return;
+        if (!error.empty() || count > size - offset) {
+            if (error.empty()) fail("checkpoint is truncated");
+            std::memset(out, 0, count);
+            return;
+        }
+        std::memcpy(out, data + offset, count);
+        offset += count;
+    }
+
+    /**
+     * @brief Reads a value of a trivially copyable type.
+     */
+    template <typename T>
+    void get(T& value) {
+        static_assert(std::is_trivially_copyable<T>::value, "only plain values are copied raw");
+        getBytes(&value, sizeof(T));
+    }
+
+    /**
+     * @brief Reads and returns a value of a trivially copyable type.
+     */
+    template <typename T>
+    T get() {
+        T value{};
+        get(value);
+        return value;
+    }
+
+    /**
+     * @brief Reads a length-prefixed string.
+     */
+    std::string getText();
+
+    /**
+     * @brief Fails unless the next four bytes are @p tag.
+     */
+    void expectTag(const char* tag);
+
+    /**
+     * @brief Reads a vector written by putVector(), replacing @p values.
+     */
+    template <typename T>
+    void getVector(std::vector<T>& values) {
+        static_assert(std::is_trivially_copyable<T>::value, "only plain values are copied raw");
+        std::uint64_t count = get<std::uint64_t>();
+        if (count > (size - offset) / sizeof(T)) {
+            fail("checkpoint is truncated");
+            count = 0;
+        }
+        values.resize(static_cast<std::size_t>(count));
+        getBytes(values.data(), values.size() * sizeof(T));
+    }
+
+    /**
+     * @brief Reads a deque written by putDeque(), replacing @p values.
+     */
+    template <typename T>
+    void getDeque(std::deque<T>& values) {
+        std::uint64_t count = get<std::uint64_t>();
+        if (count > (size - offset) / sizeof(T)) {
+            fail("checkpoint is truncated");
+            count = 0;
+        }
+        values.resize(static_cast<std::size_t>(count));
+        for (T& value : values) get(value);
+    }
+
+    /**
+     * @brief Reads a count and fails unless it equals @p expected.
+     *
+     * @param expected Count in the configuration being restored into.
+     * @param what Name of the counted items, for the error message.
+     */
+    void expectCount(std::size_t expected, const char* what);
+
+    /**
+     * @brief Records a failure; only the first one is kept.
+     */
+    void fail(const std::string& reason);
+
+    /**
+     * @brief Returns whether every read so far succeeded.
+     */
+    bool ok() const;
+
+    /**
+     * @brief Returns the first failure, or an empty string.
+     */
+    const std::string& getError() const;
+
+    /**
+     * @brief Returns whether every byte of the file was read.
+     */
+    bool atEnd() const;
+
+    /**
+     * @brief Returns the size of the mapped file.
+     */
+    std::size_t getByteCount() const;
+};
\ No newline at end of file
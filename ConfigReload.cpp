@@ -0,0 +1,194 @@
+/**
+ * @file ConfigReload.cpp
+ * @brief Implementation of policy snapshots and the ConfigWatcher thread.
+ */
+
+#include "ConfigReload.h"
+#include <cerrno>
+#include <csignal>
+#include <fstream>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+/** @brief Write end of the active watcher's self-pipe, for the signal handler. */
+static volatile sig_atomic_t sighup_fd = -1;
+
+/**
+ * @brief SIGHUP handler; write() is async-signal-safe.
+ */
+static void onSighup(int) {
+    int saved = errno;
+    if (sighup_fd >= 0) {
+        char c = 'h';
+        ssize_t ignored = write(sighup_fd, &c, 1);
+        (void)ignored;
+    }
+    errno = saved;
+}
+
+/**
+ * @brief Copies the reloadable settings, imports blocklist files and
+ * compiles every range into one lookup structure.
+ */
+PolicySnapshot* buildPolicySnapshot(const SwitchConfig& config, unsigned long long version) {
+    PolicySnapshot* snapshot = new PolicySnapshot();
+
+    std::vector<std::pair<unsigned int, unsigned int>> intervals;
+    for (const IPRange& range : config.blocked_ranges) {
+        intervals.emplace_back(range.low.getValue(), range.high.getValue());
+    }
+    for (const std::string& path : config.blocklist_files) {
+        BlocklistImport import;
+        import.path = path;
+        std::vector<std::pair<unsigned int, unsigned int>> imported;
+        import.loaded = loadBlocklistFile(path, imported, &import.stats);
+        intervals.insert(intervals.end(), imported.begin(), imported.end());
+        snapshot->imports.push_back(import);
+    }
+    snapshot->blocklist = Blocklist(std::move(intervals));
+    snapshot->max_requests_per_cycle = config.max_requests_per_cycle;
+    snapshot->min_request_time = config.min_request_time;
+    snapshot->max_request_time = config.max_request_time;
+    snapshot->version = version;
+    snapshot->published_at = std::chrono::steady_clock::now();
+    return snapshot;
+}
+
+/**
+ * @brief Constructor implementation.
+ *
+ * Sets up inotify and the self-pipe, installs the SIGHUP handler and
+ * starts the thread.
+ */
+ConfigWatcher::ConfigWatcher(const std::string& path, RcuCell<PolicySnapshot>& cell)
+ : path(path),
+   cell(cell),
+   inotify_fd(-1),
+   wake_pipe{-1, -1},
+   running(true),
+   reloads(0),
+   next_version(1) {
+
+    if (pipe2(wake_pipe, O_CLOEXEC | O_NONBLOCK) != 0) {
+        wake_pipe[0] = wake_pipe[1] = -1;
+    }
+
+    // watch the directory: editors often replace the file rather than rewrite it
+    std::size_t slash = path.rfind('/');
+    std::string dir = (slash == std::string::npos) ? "." : path.substr(0, slash + 1);
+    inotify_fd = inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+    if (inotify_fd >= 0 &&
+        inotify_add_watch(inotify_fd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+        close(inotify_fd);
+        inotify_fd = -1;
+    }
+
+    sighup_fd = wake_pipe[1];
+    struct sigaction action{};
+    action.sa_handler = onSighup;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+    sigaction(SIGHUP, &action, nullptr);
+
+    worker = std::thread(&ConfigWatcher::run, this);
+}
+
+/**
+ * @brief Destructor implementation.
+ */
+ConfigWatcher::~ConfigWatcher() {
+    stop();
+    if (inotify_fd >= 0) close(inotify_fd);
+    if (wake_pipe[0] >= 0) close(wake_pipe[0]);
+    if (wake_pipe[1] >= 0) close(wake_pipe[1]);
+}
+
+/**
+ * @brief Signals the thread and waits for it.
+ */
+void ConfigWatcher::stop() {
+    if (!worker.joinable()) return;
+
+    signal(SIGHUP, SIG_DFL);
+    sighup_fd = -1;
+    running.store(false, std::memory_order_release);
+    if (wake_pipe[1] >= 0) {
+        char c = 'q';
+        ssize_t ignored = write(wake_pipe[1], &c, 1);
+        (void)ignored;
+    }
+    worker.join();
+}
+
+/**
+ * @brief Reads all queued inotify events and matches them to the file name.
+ */
+bool ConfigWatcher::drainFileEvents() {
+    std::size_t slash = path.rfind('/');
+    std::string name = (slash == std::string::npos) ? path : path.substr(slash + 1);
+
+    bool changed = false;
+    alignas(struct inotify_event) char buffer[4096];
+    ssize_t n;
+    while ((n = read(inotify_fd, buffer, sizeof(buffer))) > 0) {
+        for (char* p = buffer; p < buffer + n;) {
+            const struct inotify_event* event = reinterpret_cast<const struct inotify_event*>(p);
+            if (event->len > 0 && name == event->name) changed = true;
+            p += sizeof(struct inotify_event) + event->len;
+        }
+    }
+    return changed;
+}
+
+/**
+ * @brief Builds a snapshot from the file and swaps it in.
+ */
+void ConfigWatcher::reload() {
+    auto begin = std::chrono::steady_clock::now();
+
+    // loadSwitchConfig falls back to defaults, which must not wipe the blocklist
+    if (!std::ifstream(path)) return;
+    SwitchConfig config = loadSwitchConfig(path);
+    PolicySnapshot* snapshot = buildPolicySnapshot(config, next_version++);
+    snapshot->build_us = std::chrono::duration_cast<std::chrono::microseconds>(
+        snapshot->published_at - begin).count();
+
+    cell.publish(snapshot);
+    reloads.fetch_add(1, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Event loop; wakes at least every 10 ms to reclaim old snapshots.
+ */
+void ConfigWatcher::run() {
+    struct pollfd fds[2];
+    fds[0] = {wake_pipe[0], POLLIN, 0};
+    fds[1] = {inotify_fd, POLLIN, 0};
+
+    while (running.load(std::memory_order_acquire)) {
+        int ready = poll(fds, 2, 10);
+        bool changed = false;
+
+        if (ready > 0 && (fds[0].revents & POLLIN)) {
+            char c;
+            while (read(wake_pipe[0], &c, 1) == 1) {
+                if (c == 'h') changed = true;
+            }
+        }
+        if (ready > 0 && inotify_fd >= 0 && (fds[1].revents & POLLIN)) {
+            changed = drainFileEvents() || changed;
+        }
+
+        if (changed && running.load(std::memory_order_acquire)) reload();
+        cell.reclaim();
+    }
+}
+
+/**
+ * @brief Returns reload count.
+ */
+long long ConfigWatcher::getReloadCount() const {
+    return reloads.load(std::memory_order_relaxed);
+}
\ No newline at end of file
@@ -0,0 +1,159 @@
+/**
+ * @file ConfigReload.h
+ * @brief Defines hot-reloadable switch policy and the watcher that reloads it.
+ *
+ * Settings that are safe to change mid-run (the blocklist, including any
+ * included blocklist files, and the request generator limits) are compiled into an immutable PolicySnapshot. A
+ * ConfigWatcher thread rebuilds the snapshot whenever the config file is
+ * rewritten or the process receives SIGHUP, and installs it in an RcuCell
+ * so the simulation thread picks it up without taking a lock.
+ *
+ * Every other setting (pool sizes, queue and admission policy, ...) is
+ * fixed at startup.
+ */
+
+#pragma once
+#include "Blocklist.h"
+#include "RcuCell.h"
+#include "BlocklistFile.h"
+#include "SwitchConfig.h"
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @struct BlocklistImport
+ * @brief Outcome of importing one include_blocklist file.
+ */
+struct BlocklistImport {
+
+    /** @brief File path as written in the config. */
+    std::string path;
+
+    /** @brief Whether the file could be read. */
+    bool loaded = false;
+
+    /** @brief Import statistics. */
+    BlocklistLoadStats stats;
+};
+
+/**
+ * @struct PolicySnapshot
+ * @brief Immutable set of hot-reloadable settings.
+ */
+struct PolicySnapshot {
+
+    /** @brief Compiled static block ranges, inline and imported. */
+    Blocklist blocklist;
+
+    /** @brief One entry per include_blocklist file, for logging. */
+    std::vector<BlocklistImport> imports;
+
+    /** @brief Upper bound of the uniform number of arrivals per cycle. */
+    int max_requests_per_cycle = 5;
+
+    /** @brief Minimum generated request processing time. */
+    int min_request_time = 1;
+
+    /** @brief Maximum generated request processing time. */
+    int max_request_time = 5;
+
+    /** @brief Reload sequence number (0 = loaded at startup). */
+    unsigned long long version = 0;
+
+    /** @brief Time spent reading, parsing and compiling the file, in microseconds. */
+    long long build_us = 0;
+
+    /** @brief When the snapshot was installed. */
+    std::chrono::steady_clock::time_point published_at;
+};
+
+/**
+ * @brief Compiles the hot-reloadable part of a configuration.
+ *
+ * @param config Loaded configuration.
+ * @param version Sequence number stored in the snapshot.
+ * @return Heap-allocated snapshot for RcuCell::publish().
+ */
+PolicySnapshot* buildPolicySnapshot(const SwitchConfig& config, unsigned long long version);
+
+/**
+ * @class ConfigWatcher
+ * @brief Background thread that reloads the config file into an RcuCell.
+ *
+ * Changes are detected with inotify on the file's directory (so editors
+ * that replace the file are seen) and with SIGHUP. The thread is also the
+ * RCU writer, so it periodically frees snapshots the reader has released.
+ */
+class ConfigWatcher {
+private:
+
+    /** @brief Config file to reload. */
+    std::string path;
+
+    /** @brief Cell receiving new snapshots. */
+    RcuCell<PolicySnapshot>& cell;
+
+    /** @brief inotify descriptor, or -1 if inotify is unavailable. */
+    int inotify_fd;
+
+    /** @brief Self-pipe woken by SIGHUP and by stop(). */
+    int wake_pipe[2];
+
+    /** @brief Cleared to ask the thread to exit. */
+    std::atomic<bool> running;
+
+    /** @brief Successful reloads. */
+    std::atomic<long long> reloads;
+
+    /** @brief Version given to the next snapshot. */
+    unsigned long long next_version;
+
+    /** @brief Worker thread. */
+    std::thread worker;
+
+    /**
+     * @brief Waits for file events, signals or the reclaim timer.
+     */
+    void run();
+
+    /**
+     * @brief Parses the file and publishes a new snapshot.
+     */
+    void reload();
+
+    /**
+     * @brief Returns true if pending inotify events concern the config file.
+     */
+    bool drainFileEvents();
+
+public:
+
+    /**
+     * @brief Starts watching @p path.
+     *
+     * @param path Config file path.
+     * @param cell Cell to publish into; must outlive the watcher.
+     */
+    ConfigWatcher(const std::string& path, RcuCell<PolicySnapshot>& cell);
+
+    /**
+     * @brief Stops and joins the thread.
+     */
+    ~ConfigWatcher();
+
+    ConfigWatcher(const ConfigWatcher&) = delete;
+    ConfigWatcher& operator=(const ConfigWatcher&) = delete;
+
+    /**
+     * @brief Stops the thread; safe to call more than once.
+     */
+    void stop();
+
+    /**
+     * @brief Returns the number of successful reloads.
+     */
+    long long getReloadCount() const;
+};
\ No newline at end of file
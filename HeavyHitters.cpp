@@ -0,0 +1,145 @@
+/**
+ * @file HeavyHitters.cpp
+ * @brief Implementation of the HeavyHitterSketch class.
+ */
+
+#include "HeavyHitters.h"
+#include "Checkpoint.h"
+#include "MaglevTable.h"
+#include <algorithm>
+
+/** @brief Per-row hash seeds; rows must hash independently. */
+static const unsigned int ROW_SEEDS[] = {0x9e3779b9u, 0x7f4a7c15u, 0x94d049bbu, 0xbf58476du};
+
+/**
+ * @brief Constructor implementation.
+ */
+HeavyHitterSketch::HeavyHitterSketch(std::size_t width, std::size_t top_k)
+ : width_mask(0), top_used(0) {
+
+    std::size_t row = 1;
+    while (row < width) row <<= 1;
+    width_mask = row - 1;
+    counters.assign(DEPTH * row, 0);
+
+    top_k = std::max<std::size_t>(top_k, 1);
+    top_keys.assign(top_k, 0);
+    top_counts.assign(top_k, 0);
+}
+
+/**
+ * @brief Conservative update, then Space-Saving update.
+ *
+ * Conservative update only raises the counters that equal the current
+ * minimum, which keeps overestimates from hash collisions much smaller
+ * than incrementing every row.
+ */
+std::uint32_t HeavyHitterSketch::update(std::uint32_t key) {
+    std::uint32_t* cell[DEPTH];
+    std::uint32_t low = UINT32_MAX;
+    for (std::size_t d = 0; d < DEPTH; d++) {
+        std::size_t col = MaglevTable::hash(key, ROW_SEEDS[d]) & width_mask;
+        cell[d] = &counters[d * (width_mask + 1) + col];
+        low = std::min(low, *cell[d]);
+    }
+    std::uint32_t estimate = low + 1;
+    for (std::size_t d = 0; d < DEPTH; d++) {
+        if (*cell[d] < estimate) *cell[d] = estimate;
+    }
+
+    // Space-Saving: count a monitored key, or replace the smallest entry
+    for (std::size_t i = 0; i < top_used; i++) {
+        if (top_keys[i] == key) {
+            top_counts[i]++;
+            return estimate;
+        }
+    }
+    if (top_used < top_keys.size()) {
+        top_keys[top_used] = key;
+        top_counts[top_used] = 1;
+        top_used++;
+        return estimate;
+    }
+    std::size_t smallest = 0;
+    for (std::size_t i = 1; i < top_used; i++) {
+        if (top_counts[i] < top_counts[smallest]) smallest = i;
+    }
+    top_keys[smallest] = key;
+    top_counts[smallest]++;
+    return estimate;
+}
+
+/**
+ * @brief Minimum over the key's counters.
+ */
+std::uint32_t HeavyHitterSketch::estimate(std::uint32_t key) const {
+    std::uint32_t low = UINT32_MAX;
+    for (std::size_t d = 0; d < DEPTH; d++) {
+        std::size_t col = MaglevTable::hash(key, ROW_SEEDS[d]) & width_mask;
+        low = std::min(low, counters[d * (width_mask + 1) + col]);
+    }
+    return low;
+}
+
+/**
+ * @brief Copies and sorts the Space-Saving entries.
+ */
+std::vector<std::pair<std::uint32_t, std::uint32_t>>
+HeavyHitterSketch::topTalkers(std::size_t limit) const {
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> talkers;
+    for (std::size_t i = 0; i < top_used; i++) {
+        talkers.emplace_back(top_keys[i], top_counts[i]);
+    }
+    std::sort(talkers.begin(), talkers.end(),
+              [](const std::pair<std::uint32_t, std::uint32_t>& a,
+                 const std::pair<std::uint32_t, std::uint32_t>& b) {
+                  return a.second > b.second;
+              });
+    if (talkers.size() > limit) talkers.resize(limit);
+    return talkers;
+}
+
+/**
+ * @brief Zeroes the sketch and empties the summary.
+ */
+void HeavyHitterSketch::reset() {
+    std::fill(counters.begin(), counters.end(), 0);
+    top_used = 0;
+}
+
+/**
+ * @brief Returns counter and summary storage size.
+ */
+std::size_t HeavyHitterSketch::getMemoryBytes() const {
+    return (counters.size() + top_keys.size() + top_counts.size()) * sizeof(std::uint32_t);
+}
+
+/**
+ * @brief Counters and the top-k table.
+ */
+void HeavyHitterSketch::save(CheckpointWriter& out) const {
+    out.putVector(counters);
+    out.putVector(top_keys);
+    out.putVector(top_counts);
+    out.put<std::uint64_t>(top_used);
+}
+
+/**
+ * @brief Fails if the sketch was sized differently.
+ */
+void HeavyHitterSketch::restore(CheckpointReader& in) {
+    std::size_t width = counters.size();
+    std::size_t top_k = top_keys.size();
+    in.getVector(counters);
+    in.getVector(top_keys);
+    in.getVector(top_counts);
+    top_used = static_cast<std::size_t>(in.get<std::uint64_t>());
+    if (counters.size() != width || top_keys.size() != top_k || top_counts.size() != top_k ||
+        top_used > top_k) {
+        in.fail("heavy hitter sketch was sized differently");
+        counters.assign(width, 0);
+        top_keys.assign(top_k, 0);
+        top_counts.assign(top_k, 0);
+        top_used = 0;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,97 @@
+/**
+ * @file HeavyHitters.h
+ * @brief Defines a constant-memory streaming sketch for finding flooding sources.
+ *
+ * Two structures are updated for every request:
+ * - A Count-Min sketch (conservative update) estimating how many requests
+ *   any source sent in the current window, never underestimating
+ * - A Space-Saving summary of fixed size holding the top talkers
+ *
+ * Both are cleared at the start of each window, so estimates describe the
+ * recent request rate rather than the whole run.
+ */
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+class CheckpointWriter;
+class CheckpointReader;
+
+/**
+ * @class HeavyHitterSketch
+ * @brief Count-Min sketch plus Space-Saving top-K over 32-bit keys.
+ */
+class HeavyHitterSketch {
+private:
+
+    /** @brief Independent hash rows in the Count-Min sketch. */
+    static const std::size_t DEPTH = 4;
+
+    /** @brief Counters per row minus one (row width is a power of two). */
+    std::size_t width_mask;
+
+    /** @brief DEPTH rows of counters, stored row after row. */
+    std::vector<std::uint32_t> counters;
+
+    /** @brief Space-Saving monitored keys. */
+    std::vector<std::uint32_t> top_keys;
+
+    /** @brief Space-Saving counts (upper bounds) per monitored key. */
+    std::vector<std::uint32_t> top_counts;
+
+    /** @brief Number of Space-Saving entries in use. */
+    std::size_t top_used;
+
+public:
+
+    /**
+     * @brief Constructs an empty sketch.
+     *
+     * @param width Counters per row, rounded up to a power of two.
+     * @param top_k Number of top talkers tracked.
+     */
+    HeavyHitterSketch(std::size_t width = 2048, std::size_t top_k = 16);
+
+    /**
+     * @brief Counts one request from @p key.
+     *
+     * @param key Source identifier (IPv4 address).
+     * @return Count-Min estimate of the key's requests this window, including this one.
+     */
+    std::uint32_t update(std::uint32_t key);
+
+    /**
+     * @brief Returns the Count-Min estimate for @p key without counting.
+     */
+    std::uint32_t estimate(std::uint32_t key) const;
+
+    /**
+     * @brief Returns the monitored keys with their counts, largest first.
+     *
+     * @param limit Maximum entries returned.
+     */
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> topTalkers(std::size_t limit) const;
+
+    /**
+     * @brief Clears every counter to start a new window.
+     */
+    void reset();
+
+    /**
+     * @brief Returns the memory used by counters and the summary, in bytes.
+     */
+    std::size_t getMemoryBytes() const;
+
+    /**
+     * @brief Appends the sketch to a checkpoint.
+     */
+    void save(CheckpointWriter& out) const;
+
+    /**
+     * @brief Replaces the sketch with one read from a checkpoint.
+     */
+    void restore(CheckpointReader& in);
+};
\ No newline at end of file
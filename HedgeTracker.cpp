@@ -0,0 +1,124 @@
+/**
+ * @file HedgeTracker.cpp
+ * @brief Implementation of the HedgeTracker class.
+ */
+
+#include "HedgeTracker.h"
+#include "Checkpoint.h"
+
+/**
+ * @brief Constructor implementation.
+ */
+HedgeTracker::HedgeTracker()
+ : cancelled(0), hedge_wins(0) {}
+
+/**
+ * @brief Decrements the queued copies and forgets the request at zero.
+ */
+void HedgeTracker::release(std::unordered_map<long long, Entry>::iterator it) {
+    if (--it->second.queued <= 0) {
+        entries.erase(it);
+    }
+}
+
+/**
+ * @brief Starts tracking a request with one queued copy.
+ */
+void HedgeTracker::track(long long id) {
+    entries[id] = Entry{1, false};
+}
+
+/**
+ * @brief Adds a second queued copy unless a copy already started.
+ */
+bool HedgeTracker::addCopy(long long id) {
+    auto it = entries.find(id);
+    if (it == entries.end() || it->second.started) return false;
+    it->second.queued++;
+    return true;
+}
+
+/**
+ * @brief Removes a copy that will never start.
+ */
+bool HedgeTracker::dropCopy(long long id) {
+    auto it = entries.find(id);
+    if (it == entries.end()) return false;
+
+    bool failed = !it->second.started && it->second.queued == 1;
+    release(it);
+    return failed;
+}
+
+/**
+ * @brief First caller wins; later copies are counted as cancelled.
+ *
+ * Untracked ids are always allowed to start.
+ */
+bool HedgeTracker::tryStart(long long id, bool hedge_copy) {
+    auto it = entries.find(id);
+    if (it == entries.end()) return true;
+
+    bool won = !it->second.started;
+    if (won) {
+        it->second.started = true;
+        if (hedge_copy) hedge_wins++;
+    } else {
+        cancelled++;
+    }
+    release(it);
+    return won;
+}
+
+/**
+ * @brief Checks whether a request is still waiting in some queue.
+ */
+bool HedgeTracker::isWaiting(long long id) const {
+    auto it = entries.find(id);
+    return it != entries.end() && !it->second.started;
+}
+
+/**
+ * @brief Returns cancelled copies.
+ */
+long long HedgeTracker::getCancelledCount() const {
+    return cancelled;
+}
+
+/**
+ * @brief Returns hedge copy wins.
+ */
+long long HedgeTracker::getHedgeWins() const {
+    return hedge_wins;
+}
+
+/**
+ * @brief Every tracked request with its copy count and start flag.
+ */
+void HedgeTracker::save(CheckpointWriter& out) const {
+    out.put<std::uint64_t>(entries.size());
+    for (const auto& entry : entries) {
+        out.put(entry.first);
+        out.put(entry.second.queued);
+        out.put(entry.second.started);
+    }
+    out.put(cancelled);
+    out.put(hedge_wins);
+}
+
+/**
+ * @brief Reads the fields in save() order.
+ */
+void HedgeTracker::restore(CheckpointReader& in) {
+    entries.clear();
+    std::uint64_t count = in.get<std::uint64_t>();
+    for (std::uint64_t i = 0; i < count && in.ok(); i++) {
+        long long id = in.get<long long>();
+        Entry entry{};
+        in.get(entry.queued);
+        in.get(entry.started);
+        entries[id] = entry;
+    }
+    in.get(cancelled);
+    in.get(hedge_wins);
+}
\ No newline at end of file
@@ -0,0 +1,116 @@
+/**
+ * @file HedgeTracker.h
+ * @brief Defines the registry that lets the first copy of a hedged request win.
+ *
+ * A hedged request may be queued at two load balancers at once. Whichever
+ * copy reaches a server first claims the request; the other copy is
+ * cancelled when it is dequeued, so at most one copy is ever served.
+ */
+
+#pragma once
+#include <unordered_map>
+
+class CheckpointWriter;
+class CheckpointReader;
+
+/**
+ * @class HedgeTracker
+ * @brief Tracks queued copies of hedged requests by request id.
+ *
+ * Entries are removed once every copy has been started, cancelled or
+ * expired, so the table only holds requests that are still in flight.
+ */
+class HedgeTracker {
+private:
+
+    /**
+     * @struct Entry
+     * @brief Copies still queued and whether one has started.
+     */
+    struct Entry {
+        int queued;
+        bool started;
+    };
+
+    /** @brief In-flight hedged requests keyed by Request::id. */
+    std::unordered_map<long long, Entry> entries;
+
+    /** @brief Copies cancelled because the other copy started first. */
+    long long cancelled;
+
+    /** @brief Requests won by the hedge copy rather than the original. */
+    long long hedge_wins;
+
+    /**
+     * @brief Removes one queued copy and erases the entry when none remain.
+     */
+    void release(std::unordered_map<long long, Entry>::iterator it);
+
+public:
+
+    /**
+     * @brief Constructs an empty tracker.
+     */
+    HedgeTracker();
+
+    /**
+     * @brief Registers the first queued copy of a request.
+     *
+     * @param id Request id.
+     */
+    void track(long long id);
+
+    /**
+     * @brief Registers a hedge copy if the request is still waiting.
+     *
+     * @param id Request id.
+     * @return False if the request already started or is no longer tracked.
+     */
+    bool addCopy(long long id);
+
+    /**
+     * @brief Removes a copy that was rejected or expired without starting.
+     *
+     * @param id Request id.
+     * @return True if this was the last copy and none started, i.e. the
+     *         client saw the request fail.
+     */
+    bool dropCopy(long long id);
+
+    /**
+     * @brief Called when a copy reaches a free server.
+     *
+     * @param id Request id.
+     * @param hedge_copy Whether the calling copy is the hedge duplicate.
+     * @return True if this copy should be served, false if it lost the race
+     *         and must be cancelled.
+     */
+    bool tryStart(long long id, bool hedge_copy);
+
+    /**
+     * @brief Returns whether the request is tracked and no copy has started.
+     *
+     * @param id Request id.
+     */
+    bool isWaiting(long long id) const;
+
+    /**
+     * @brief Returns copies cancelled because the other copy started first.
+     */
+    long long getCancelledCount() const;
+
+    /**
+     * @brief Returns requests whose hedge copy started before the original.
+     */
+    long long getHedgeWins() const;
+
+    /**
+     * @brief Appends the registry to a checkpoint.
+     */
+    void save(CheckpointWriter& out) const;
+
+    /**
+     * @brief Replaces the registry with one read from a checkpoint.
+     */
+    void restore(CheckpointReader& in);
+};
\ No newline at end of file
@@ -9,6 +9,7 @@
  * - Conversion between dotted-decimal string format and 32-bit integer format
  * - Comparison operations between IP addresses
  * - Retrieval of numeric and string representations
+ * - Parsing of CIDR blocks
  *
  * Part of the load balancer simulation project.
  */
@@ -128,4 +129,34 @@ bool IPAddress::operator==(const IPAddress& other) const {
  */
 bool IPAddress::operator!=(const IPAddress& other) const {
     return address != other.address;
+}
+
+/**
+ * @brief Splits "a.b.c.d/n" and masks off the host bits.
+ */
+IPRange parseCidr(const std::string& cidr, int* prefix_length) {
+    std::size_t slash = cidr.find('/');
+    IPAddress base(cidr.substr(0, slash));
+
+    int prefix = 32;
+    if (slash != std::string::npos) {
+        std::size_t used = 0;
+        std::string digits = cidr.substr(slash + 1);
+        try {
+            prefix = std::stoi(digits, &used);
+        } catch (...) {
+            throw std::invalid_argument("Invalid CIDR prefix length");
+        }
+        if (used != digits.size() || prefix < 0 || prefix > 32) {
+            throw std::invalid_argument("Invalid CIDR prefix length");
+        }
+    }
+
+    // shifting a 32-bit value by 32 is undefined, so /0 is special-cased
+    unsigned int mask = (prefix == 0) ? 0u : 0xFFFFFFFFu << (32 - prefix);
+    IPAddress low(base.getValue() & mask);
+    IPAddress high(base.getValue() | ~mask);
+
+    if (prefix_length != nullptr) *prefix_length = prefix;
+    return IPRange(low, high);
 }
\ No newline at end of file
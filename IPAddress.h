@@ -5,7 +5,7 @@
  * Provides functionality for representing IPv4 addresses as 32-bit integers,
  * converting between integer and dotted-decimal formats, and performing
  * comparison operations. Also defines IPRange for representing blocked or
- * monitored IP intervals.
+ * monitored IP intervals, and parsing of CIDR blocks into ranges.
  */
 
 #pragma once
@@ -126,4 +126,18 @@ struct IPRange {
      * @param h Upper IP address.
      */
     IPRange(IPAddress& l, IPAddress& h) : low(l), high(h) {}
-};
\ No newline at end of file
+};
+
+/**
+ * @brief Parses a CIDR block into the range of addresses it covers.
+ *
+ * Example format: "10.0.0.0/8". Host bits set in the address are ignored,
+ * so "10.1.2.3/8" also yields 10.0.0.0 - 10.255.255.255. An address
+ * without a prefix length is treated as /32.
+ *
+ * @param cidr CIDR string.
+ * @param prefix_length Receives the prefix length (0-32), if not null.
+ * @return Inclusive range covered by the block.
+ * @throws std::invalid_argument if the address or prefix length is invalid.
+ */
+IPRange parseCidr(const std::string& cidr, int* prefix_length = nullptr);
\ No newline at end of file
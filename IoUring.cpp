@@ -0,0 +1,236 @@
+/**
+ * @file IoUring.cpp
+ * @brief Implementation of the raw-syscall io_uring wrapper.
+ */
+
+#include "IoUring.h"
+#include <cerrno>
+#include <cstring>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+/**
+ * @brief io_uring_setup(2).
+ */
+static int uringSetup(unsigned entries, io_uring_params* params) {
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+/**
+ * @brief io_uring_enter(2) with an extended argument.
+ */
+static int uringEnter(int fd, unsigned submit, unsigned wait, unsigned flags, void* arg, std::size_t size) {
+    return static_cast<int>(syscall(__NR_io_uring_enter, fd, submit, wait, flags, arg, size));
+}
+
+/**
+ * @brief Acquire load of a ring index written by the kernel.
+ */
+static unsigned loadAcquire(const unsigned* p) {
+    return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+/**
+ * @brief Release store of a ring index read by the kernel.
+ */
+static void storeRelease(unsigned* p, unsigned v) {
+    __atomic_store_n(p, v, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Constructor implementation.
+ *
+ * Both rings share one mapping (IORING_FEAT_SINGLE_MMAP, Linux 5.4), and
+ * the wait takes a timeout argument (IORING_FEAT_EXT_ARG, Linux 5.11);
+ * older kernels are refused rather than handled.
+ */
+IoUring::IoUring(unsigned entries)
+ : fd(-1),
+   params(),
+   ring_map(MAP_FAILED),
+   ring_bytes(0),
+   sqes(nullptr),
+   sqes_bytes(0),
+   sq_head(nullptr),
+   sq_tail(nullptr),
+   sq_mask(nullptr),
+   sq_array(nullptr),
+   cq_head(nullptr),
+   cq_tail(nullptr),
+   cq_mask(nullptr),
+   cqes(nullptr),
+   pending(0),
+   buffer_bytes(0),
+   buffer_count(0) {
+
+    params.flags = IORING_SETUP_CQSIZE | IORING_SETUP_SUBMIT_ALL;
+    params.cq_entries = entries * 4;
+    int ring = uringSetup(entries, &params);
+    if (ring < 0) {
+        error = std::string("io_uring_setup: ") + std::strerror(errno);
+        return;
+    }
+    if (!(params.features & IORING_FEAT_SINGLE_MMAP) || !(params.features & IORING_FEAT_EXT_ARG)) {
+        error = "kernel too old (needs IORING_FEAT_SINGLE_MMAP and IORING_FEAT_EXT_ARG)";
+        close(ring);
+        return;
+    }
+
+    std::size_t sq_bytes = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    std::size_t cq_bytes = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    ring_bytes = sq_bytes > cq_bytes ? sq_bytes : cq_bytes;
+    ring_map = mmap(nullptr, ring_bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring,
+                    IORING_OFF_SQ_RING);
+    sqes_bytes = params.sq_entries * sizeof(io_uring_sqe);
+    void* sqe_map = mmap(nullptr, sqes_bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring,
+                         IORING_OFF_SQES);
+    if (ring_map == MAP_FAILED || sqe_map == MAP_FAILED) {
+        error = std::string("mmap: ") + std::strerror(errno);
+        if (ring_map != MAP_FAILED) munmap(ring_map, ring_bytes);
+        if (sqe_map != MAP_FAILED) munmap(sqe_map, sqes_bytes);
+        ring_map = MAP_FAILED;
+        close(ring);
+        return;
+    }
+
+    char* base = static_cast<char*>(ring_map);
+    sq_head = reinterpret_cast<unsigned*>(base + params.sq_off.head);
+    sq_tail = reinterpret_cast<unsigned*>(base + params.sq_off.tail);
+    sq_mask = reinterpret_cast<unsigned*>(base + params.sq_off.ring_mask);
+    sq_array = reinterpret_cast<unsigned*>(base + params.sq_off.array);
+    cq_head = reinterpret_cast<unsigned*>(base + params.cq_off.head);
+    cq_tail = reinterpret_cast<unsigned*>(base + params.cq_off.tail);
+    cq_mask = reinterpret_cast<unsigned*>(base + params.cq_off.ring_mask);
+    cqes = reinterpret_cast<io_uring_cqe*>(base + params.cq_off.cqes);
+    sqes = static_cast<io_uring_sqe*>(sqe_map);
+
+    // slot i of the indirection array always names entry i
+    for (unsigned i = 0; i < params.sq_entries; i++) sq_array[i] = i;
+    fd = ring;
+}
+
+/**
+ * @brief Destructor implementation.
+ */
+IoUring::~IoUring() {
+    if (sqes != nullptr) munmap(sqes, sqes_bytes);
+    if (ring_map != MAP_FAILED) munmap(ring_map, ring_bytes);
+    if (fd >= 0) close(fd);
+}
+
+/**
+ * @brief One IORING_OP_PROVIDE_BUFFERS entry: fd carries the count, off
+ * the first id.
+ */
+void IoUring::queueBuffers(unsigned first, unsigned count, unsigned char flags) {
+    io_uring_sqe* sqe = getSqe();
+    while (sqe == nullptr) {
+        submitAndWait(0);
+        sqe = getSqe();
+    }
+    sqe->opcode = IORING_OP_PROVIDE_BUFFERS;
+    sqe->fd = static_cast<int>(count);
+    sqe->addr = reinterpret_cast<std::uint64_t>(getBuffer(first));
+    sqe->len = static_cast<unsigned>(buffer_bytes);
+    sqe->off = first;
+    sqe->buf_group = BUFFER_GROUP;
+    sqe->flags = flags;
+    sqe->user_data = INTERNAL;
+}
+
+/**
+ * @brief Provides every buffer with one entry and waits for its result.
+ */
+bool IoUring::provideBuffers(unsigned count, std::size_t bytes) {
+    buffer_count = count;
+    buffer_bytes = bytes;
+    buffer_memory.assign(static_cast<std::size_t>(buffer_count) * buffer_bytes, 0);
+    queueBuffers(0, buffer_count, 0);
+    if (!submitAndWait(1000000000LL)) return false;
+
+    unsigned head = *cq_head;
+    if (head == loadAcquire(cq_tail)) {
+        error = "IORING_OP_PROVIDE_BUFFERS: no completion";
+        return false;
+    }
+    int result = cqes[head & *cq_mask].res;
+    storeRelease(cq_head, head + 1);
+    if (result < 0) {
+        error = std::string("IORING_OP_PROVIDE_BUFFERS: ") + std::strerror(-result);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Only a failure posts a completion (IOSQE_CQE_SKIP_SUCCESS).
+ */
+void IoUring::recycleBuffer(unsigned id) {
+    queueBuffers(id, 1, IOSQE_CQE_SKIP_SUCCESS);
+}
+
+/**
+ * @brief The tail is private to this process until submitAndWait()
+ * publishes it.
+ */
+io_uring_sqe* IoUring::getSqe() {
+    unsigned head = loadAcquire(sq_head);
+    unsigned tail = *sq_tail + pending;
+    if (tail - head >= params.sq_entries) return nullptr;
+    io_uring_sqe* sqe = &sqes[tail & *sq_mask];
+    std::memset(sqe, 0, sizeof(*sqe));
+    pending++;
+    return sqe;
+}
+
+/**
+ * @brief One io_uring_enter() submits the batch and waits.
+ */
+bool IoUring::submitAndWait(long long timeout_ns) {
+    unsigned submit = pending;
+    storeRelease(sq_tail, *sq_tail + pending);
+    pending = 0;
+
+    unsigned flags = 0;
+    unsigned wait = 0;
+    __kernel_timespec timeout{};
+    io_uring_getevents_arg arg{};
+    if (timeout_ns > 0) {
+        timeout.tv_sec = timeout_ns / 1000000000LL;
+        timeout.tv_nsec = timeout_ns % 1000000000LL;
+        arg.ts = reinterpret_cast<std::uint64_t>(&timeout);
+        flags = IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG;
+        wait = 1;
+    }
+    if (submit == 0 && wait == 0) return true;
+
+    int result = uringEnter(fd, submit, wait, flags, wait > 0 ? &arg : nullptr, wait > 0 ? sizeof(arg) : 0);
+    if (result < 0 && errno != ETIME && errno != EINTR && errno != EBUSY) {
+        error = std::string("io_uring_enter: ") + std::strerror(errno);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Reads the completion at the head without consuming it; a failed
+ * buffer return is recorded in the error and skipped.
+ */
+const io_uring_cqe* IoUring::peek() {
+    for (;;) {
+        unsigned head = *cq_head;
+        if (head == loadAcquire(cq_tail)) return nullptr;
+        const io_uring_cqe* cqe = &cqes[head & *cq_mask];
+        if (cqe->user_data != INTERNAL) return cqe;
+        error = std::string("IORING_OP_PROVIDE_BUFFERS: ") + std::strerror(-cqe->res);
+        storeRelease(cq_head, head + 1);
+    }
+}
+
+/**
+ * @brief Advances the head so the kernel can reuse the slot.
+ */
+void IoUring::seen() {
+    storeRelease(cq_head, *cq_head + 1);
+}
\ No newline at end of file
@@ -0,0 +1,170 @@
+/**
+ * @file IoUring.h
+ * @brief Defines a minimal io_uring instance driven by raw system calls.
+ *
+ * Only what the load generator needs is wrapped: the submission and
+ * completion rings mapped from the kernel, one group of provided receive
+ * buffers for multishot receives, and a single call that submits the
+ * queued entries and waits for completions with a timeout.
+ *
+ * Buffers are handed to the kernel with IORING_OP_PROVIDE_BUFFERS entries
+ * queued like any other operation, so recycling a buffer costs no system
+ * call of its own. (Ring-mapped buffers, IORING_REGISTER_PBUF_RING, came
+ * back empty on some kernels that accept the registration.)
+ *
+ * Entries are only queued by getSqe(); nothing reaches the kernel until
+ * submitAndWait(), so every operation prepared in one pass of the caller's
+ * loop goes in with one io_uring_enter().
+ */
+
+#pragma once
+#include <linux/io_uring.h>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @class IoUring
+ * @brief Submission queue, completion queue and provided receive buffers.
+ */
+class IoUring {
+private:
+
+    /** @brief Ring descriptor (-1 if setup failed). */
+    int fd;
+
+    /** @brief Parameters filled in by io_uring_setup. */
+    io_uring_params params;
+
+    /** @brief Shared mapping of both rings (single mmap). */
+    void* ring_map;
+    std::size_t ring_bytes;
+
+    /** @brief Mapping of the submission queue entries. */
+    io_uring_sqe* sqes;
+    std::size_t sqes_bytes;
+
+    /** @brief Submission ring fields inside ring_map. */
+    unsigned* sq_head;
+    unsigned* sq_tail;
+    unsigned* sq_mask;
+    unsigned* sq_array;
+
+    /** @brief Completion ring fields inside ring_map. */
+    unsigned* cq_head;
+    unsigned* cq_tail;
+    unsigned* cq_mask;
+    io_uring_cqe* cqes;
+
+    /** @brief Entries queued since the last submit. */
+    unsigned pending;
+
+    /** @brief Backing memory of the provided buffers. */
+    std::vector<char> buffer_memory;
+
+    /** @brief Size of each provided buffer. */
+    std::size_t buffer_bytes;
+
+    /** @brief Number of provided buffers. */
+    unsigned buffer_count;
+
+    /** @brief Reason the last failed call failed. */
+    std::string error;
+
+    /** @brief Queues an entry providing @p count buffers from id @p first on. */
+    void queueBuffers(unsigned first, unsigned count, unsigned char flags);
+
+public:
+
+    /** @brief Buffer group id of the provided buffers. */
+    static const unsigned short BUFFER_GROUP = 0;
+
+    /** @brief user_data of the wrapper's own entries; peek() skips their completions. */
+    static const std::uint64_t INTERNAL = ~0ULL;
+
+    /**
+     * @brief Creates the rings; check isReady() before use.
+     *
+     * @param entries Submission queue size; the completion queue is four
+     *                times larger, since multishot receives post many
+     *                completions per entry.
+     */
+    explicit IoUring(unsigned entries);
+
+    /**
+     * @brief Unmaps the rings and closes the descriptor.
+     */
+    ~IoUring();
+
+    IoUring(const IoUring&) = delete;
+    IoUring& operator=(const IoUring&) = delete;
+
+    /**
+     * @brief Returns whether setup succeeded.
+     */
+    bool isReady() const {
+        return fd >= 0;
+    }
+
+    /**
+     * @brief Returns why the last failing call failed.
+     */
+    const std::string& getError() const {
+        return error;
+    }
+
+    /**
+     * @brief Provides @p count buffers of @p bytes each as buffer group
+     * BUFFER_GROUP, for receives with IOSQE_BUFFER_SELECT.
+     *
+     * @return False if the kernel refused them.
+     */
+    bool provideBuffers(unsigned count, std::size_t bytes);
+
+    /**
+     * @brief Returns the data of a provided buffer named in a completion.
+     */
+    const char* getBuffer(unsigned id) const {
+        return buffer_memory.data() + static_cast<std::size_t>(id) * buffer_bytes;
+    }
+
+    /**
+     * @brief Queues a consumed buffer's return to the kernel; it goes in
+     * with the next submit.
+     */
+    void recycleBuffer(unsigned id);
+
+    /**
+     * @brief Returns a zeroed entry to fill in, or null if the submission
+     * queue is full (submit first).
+     */
+    io_uring_sqe* getSqe();
+
+    /**
+     * @brief Returns the number of entries queued and not yet submitted.
+     */
+    unsigned getPending() const {
+        return pending;
+    }
+
+    /**
+     * @brief Submits every queued entry and waits until a completion is
+     * available or @p timeout_ns has passed.
+     *
+     * @param timeout_ns Wait limit (0 = submit without waiting).
+     * @return False on an error other than an interrupted or timed-out wait.
+     */
+    bool submitAndWait(long long timeout_ns);
+
+    /**
+     * @brief Returns the next completion of a caller's entry, or null if
+     * there is none; call seen() once done with it.
+     */
+    const io_uring_cqe* peek();
+
+    /**
+     * @brief Releases the completion returned by peek().
+     */
+    void seen();
+};
\ No newline at end of file
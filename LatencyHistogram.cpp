@@ -0,0 +1,145 @@
+/**
+ * @file LatencyHistogram.cpp
+ * @brief Implementation of the LatencyHistogram class.
+ */
+
+#include "LatencyHistogram.h"
+#include "Checkpoint.h"
+#include <algorithm>
+
+/** @brief Values below this are counted exactly. */
+static const int EXACT_LIMIT = 64;
+
+/** @brief log2 of the number of sub-buckets per power of two. */
+static const int SUB_BITS = 5;
+
+/** @brief Number of sub-buckets per power of two. */
+static const int SUB_COUNT = 1 << SUB_BITS;
+
+/** @brief Buckets needed to cover every non-negative int. */
+static const std::size_t BUCKET_COUNT = EXACT_LIMIT + (31 - SUB_BITS) * SUB_COUNT;
+
+/**
+ * @brief Constructor implementation.
+ */
+LatencyHistogram::LatencyHistogram()
+ : counts(BUCKET_COUNT, 0), total(0), sum(0.0), max_value(0) {}
+
+/**
+ * @brief Exact index below EXACT_LIMIT, otherwise 32 sub-buckets per octave.
+ */
+std::size_t LatencyHistogram::bucketOf(int value) {
+    if (value < EXACT_LIMIT) return static_cast<std::size_t>(value);
+
+    int msb = 31 - __builtin_clz(static_cast<unsigned int>(value));
+    int shift = msb - SUB_BITS;
+    int top = value >> shift;
+    return EXACT_LIMIT + static_cast<std::size_t>(shift - 1) * SUB_COUNT + (top - SUB_COUNT);
+}
+
+/**
+ * @brief Inverse of bucketOf() for the low edge of a bucket.
+ */
+int LatencyHistogram::bucketLowerBound(std::size_t bucket) {
+    if (bucket < static_cast<std::size_t>(EXACT_LIMIT)) return static_cast<int>(bucket);
+
+    std::size_t rest = bucket - EXACT_LIMIT;
+    int shift = static_cast<int>(rest / SUB_COUNT) + 1;
+    int top = static_cast<int>(rest % SUB_COUNT) + SUB_COUNT;
+    return top << shift;
+}
+
+/**
+ * @brief Records one sample.
+ */
+void LatencyHistogram::record(int value) {
+    if (value < 0) value = 0;
+    counts[bucketOf(value)]++;
+    total++;
+    sum += value;
+    max_value = std::max(max_value, value);
+}
+
+/**
+ * @brief Adds another histogram's samples.
+ */
+void LatencyHistogram::merge(const LatencyHistogram& other) {
+    for (std::size_t i = 0; i < counts.size(); i++) {
+        counts[i] += other.counts[i];
+    }
+    total += other.total;
+    sum += other.sum;
+    max_value = std::max(max_value, other.max_value);
+}
+
+/**
+ * @brief Clears all samples.
+ */
+void LatencyHistogram::reset() {
+    std::fill(counts.begin(), counts.end(), 0);
+    total = 0;
+    sum = 0.0;
+    max_value = 0;
+}
+
+/**
+ * @brief Returns sample count.
+ */
+long long LatencyHistogram::count() const {
+    return total;
+}
+
+/**
+ * @brief Returns the mean.
+ */
+double LatencyHistogram::mean() const {
+    return total > 0 ? sum / total : 0.0;
+}
+
+/**
+ * @brief Returns the maximum.
+ */
+int LatencyHistogram::max() const {
+    return max_value;
+}
+
+/**
+ * @brief Walks buckets until the requested rank is reached.
+ */
+int LatencyHistogram::percentile(double p) const {
+    if (total == 0) return 0;
+
+    long long rank = static_cast<long long>(p / 100.0 * total);
+    if (rank >= total) rank = total - 1;
+
+    long long seen = 0;
+    for (std::size_t i = 0; i < counts.size(); i++) {
+        seen += counts[i];
+        if (seen > rank) return std::min(bucketLowerBound(i), max_value);
+    }
+    return max_value;
+}
+
+/**
+ * @brief Counts, then the running totals.
+ */
+void LatencyHistogram::save(CheckpointWriter& out) const {
+    out.putVector(counts);
+    out.put(total);
+    out.put(sum);
+    out.put(max_value);
+}
+
+/**
+ * @brief Fails on a bucket layout other than this build's.
+ */
+void LatencyHistogram::restore(CheckpointReader& in) {
+    in.getVector(counts);
+    in.get(total);
+    in.get(sum);
+    in.get(max_value);
+    if (counts.size() != BUCKET_COUNT) {
+        in.fail("latency histogram has a different bucket layout");
+        counts.assign(BUCKET_COUNT, 0);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,102 @@
+/**
+ * @file LatencyHistogram.h
+ * @brief Defines a compact log-linear histogram for latency percentiles.
+ *
+ * Values below 64 are counted exactly; larger values fall into buckets
+ * with 32 sub-buckets per power of two, bounding the relative error of
+ * any reported percentile to about 3%.
+ */
+
+#pragma once
+#include <cstddef>
+#include <vector>
+
+class CheckpointWriter;
+class CheckpointReader;
+
+/**
+ * @class LatencyHistogram
+ * @brief Records non-negative integer latencies (in clock cycles).
+ */
+class LatencyHistogram {
+private:
+
+    /** @brief Count of samples per bucket. */
+    std::vector<long long> counts;
+
+    /** @brief Total number of samples. */
+    long long total;
+
+    /** @brief Sum of all samples, for the mean. */
+    double sum;
+
+    /** @brief Largest sample recorded. */
+    int max_value;
+
+    /**
+     * @brief Maps a value to its bucket index.
+     */
+    static std::size_t bucketOf(int value);
+
+    /**
+     * @brief Returns the smallest value that maps to a bucket.
+     */
+    static int bucketLowerBound(std::size_t bucket);
+
+public:
+
+    /**
+     * @brief Constructs an empty histogram.
+     */
+    LatencyHistogram();
+
+    /**
+     * @brief Adds one sample.
+     *
+     * @param value Latency in cycles (negative values are recorded as 0).
+     */
+    void record(int value);
+
+    /**
+     * @brief Adds every sample of another histogram.
+     */
+    void merge(const LatencyHistogram& other);
+
+    /**
+     * @brief Removes all samples.
+     */
+    void reset();
+
+    /**
+     * @brief Returns the number of samples.
+     */
+    long long count() const;
+
+    /**
+     * @brief Returns the mean sample, or 0 when empty.
+     */
+    double mean() const;
+
+    /**
+     * @brief Returns the largest sample, or 0 when empty.
+     */
+    int max() const;
+
+    /**
+     * @brief Returns the value at a percentile.
+     *
+     * @param p Percentile in [0, 100].
+     * @return Lower bound of the bucket holding the percentile, or 0 when empty.
+     */
+    int percentile(double p) const;
+
+    /**
+     * @brief Appends the histogram to a checkpoint.
+     */
+    void save(CheckpointWriter& out) const;
+
+    /**
+     * @brief Replaces the histogram with one read from a checkpoint.
+     */
+    void restore(CheckpointReader& in);
+};
\ No newline at end of file
@@ -0,0 +1,125 @@
+/**
+ * @file LiveBackend.cpp
+ * @brief Implementation of the echo backend processes.
+ */
+
+#include "LiveBackend.h"
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/prctl.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/** @brief Descriptor the listening socket is moved to in the child. */
+static const int BACKEND_LISTEN_FD = 3;
+
+/** @brief Largest message read (and echoed) at once. */
+static const std::size_t BACKEND_BUFFER_BYTES = 64 * 1024;
+
+/**
+ * @brief Echo loop of a backend process; never returns.
+ *
+ * Sockets are blocking and epoll is level-triggered: each readable
+ * connection gets one read, the service delay and a full echo before
+ * the next event is looked at.
+ */
+[[noreturn]] static void runBackend(int listen_fd, int delay_us, pid_t parent) {
+    // the kernel stops the backend with the proxy, even if it crashes
+    prctl(PR_SET_PDEATHSIG, SIGTERM);
+    if (getppid() != parent) _exit(0);
+    // handlers of the proxy do not apply here; Ctrl-C is for the proxy
+    signal(SIGTERM, SIG_DFL);
+    signal(SIGINT, SIG_IGN);
+
+    dup2(listen_fd, BACKEND_LISTEN_FD);
+    close_range(BACKEND_LISTEN_FD + 1, ~0u, 0);
+
+    int epoll_fd = epoll_create1(0);
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = BACKEND_LISTEN_FD;
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, BACKEND_LISTEN_FD, &event);
+
+    static char buffer[BACKEND_BUFFER_BYTES];
+    epoll_event ready[64];
+    for (;;) {
+        int count = epoll_wait(epoll_fd, ready, 64, -1);
+        for (int i = 0; i < count; i++) {
+            int fd = ready[i].data.fd;
+            if (fd == BACKEND_LISTEN_FD) {
+                int connection = accept4(BACKEND_LISTEN_FD, nullptr, nullptr, SOCK_CLOEXEC);
+                if (connection < 0) continue;
+                event.events = EPOLLIN | EPOLLRDHUP;
+                event.data.fd = connection;
+                epoll_ctl(epoll_fd, EPOLL_CTL_ADD, connection, &event);
+                continue;
+            }
+
+            ssize_t received = recv(fd, buffer, sizeof(buffer), 0);
+            if (received <= 0) {
+                close(fd);
+                continue;
+            }
+            if (delay_us > 0) usleep(static_cast<useconds_t>(delay_us));
+            ssize_t sent = 0;
+            while (sent < received) {
+                ssize_t n = send(fd, buffer + sent, static_cast<std::size_t>(received - sent), MSG_NOSIGNAL);
+                if (n <= 0) break;
+                sent += n;
+            }
+            if (sent < received) close(fd);
+        }
+    }
+}
+
+/**
+ * @brief Binds an ephemeral loopback port, then forks the process that
+ * serves it.
+ */
+bool spawnLiveBackend(LiveBackend& backend, int delay_us, std::string& error) {
+    int listen_fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listen_fd < 0) {
+        error = std::strerror(errno);
+        return false;
+    }
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = 0;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t length = sizeof(address);
+    if (bind(listen_fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        listen(listen_fd, SOMAXCONN) != 0 ||
+        getsockname(listen_fd, reinterpret_cast<sockaddr*>(&address), &length) != 0) {
+        error = std::strerror(errno);
+        close(listen_fd);
+        return false;
+    }
+
+    pid_t parent = getpid();
+    pid_t pid = fork();
+    if (pid == 0) runBackend(listen_fd, delay_us, parent);
+    close(listen_fd);
+    if (pid < 0) {
+        error = std::strerror(errno);
+        return false;
+    }
+
+    backend = LiveBackend();
+    backend.pid = pid;
+    backend.port = ntohs(address.sin_port);
+    return true;
+}
+
+/**
+ * @brief SIGTERM, then reap the child.
+ */
+void stopLiveBackend(LiveBackend& backend) {
+    if (!backend.isRunning()) return;
+    kill(backend.pid, SIGTERM);
+    waitpid(backend.pid, nullptr, 0);
+    backend.pid = -1;
+}
\ No newline at end of file
@@ -0,0 +1,65 @@
+/**
+ * @file LiveBackend.h
+ * @brief Defines the backend worker processes a live proxy forwards to.
+ *
+ * A backend is a forked child listening on an ephemeral loopback port. It
+ * echoes every message it receives, optionally after sleeping for a fixed
+ * service time, and handles one message at a time: like a WebServer with
+ * a single slot, its throughput is bounded and queueing shows up as
+ * latency at the proxy.
+ *
+ * The listening socket is created by the parent before the fork, so the
+ * port is known without a handshake. The child closes every other
+ * inherited descriptor, only makes system calls (the parent may have
+ * other threads running), and is killed by the kernel if the parent dies.
+ */
+
+#pragma once
+#include <string>
+#include <sys/types.h>
+
+/**
+ * @struct LiveBackend
+ * @brief One backend process as the proxy sees it.
+ */
+struct LiveBackend {
+
+    /** @brief Process id (-1 once stopped). */
+    pid_t pid = -1;
+
+    /** @brief Loopback port the backend accepts on. */
+    int port = 0;
+
+    /** @brief Connections currently forwarded to the backend. */
+    int open = 0;
+
+    /** @brief Connections forwarded to the backend in total. */
+    long long connections = 0;
+
+    /** @brief Set when scaling down: no new connections, stopped once idle. */
+    bool draining = false;
+
+    /**
+     * @brief Returns whether the backend process is running.
+     */
+    bool isRunning() const {
+        return pid > 0;
+    }
+};
+
+/**
+ * @brief Forks a backend process listening on 127.0.0.1.
+ *
+ * @param backend Receives the pid and port; its counters are reset.
+ * @param delay_us Time the backend sleeps before answering each message.
+ * @param error Receives the reason on failure.
+ * @return False if the socket or the process could not be created.
+ */
+bool spawnLiveBackend(LiveBackend& backend, int delay_us, std::string& error);
+
+/**
+ * @brief Terminates a backend process and waits for it.
+ *
+ * @param backend Backend to stop; its pid is cleared.
+ */
+void stopLiveBackend(LiveBackend& backend);
\ No newline at end of file
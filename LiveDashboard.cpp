@@ -0,0 +1,181 @@
+/**
+ * @file LiveDashboard.cpp
+ * @brief Terminal dashboard for a running simulation's live snapshot.
+ *
+ * Attaches read-only to the shared-memory segment named by live_snapshot
+ * and redraws every refresh interval:
+ * - progress, simulated cycles per second
+ * - per balancer: queue depth (with a bar), servers, utilisation,
+ *   completions per cycle since the last redraw, rejections and the
+ *   p50/p95/p99 response times in cycles
+ *
+ * The simulation does not know the dashboard is there. When there are
+ * more balancers than terminal rows, the ones with the deepest queues
+ * are shown.
+ *
+ * Usage:
+ *   ./dashboard [/lbsim-live] [--refresh ms]
+ */
+
+#include "LiveSnapshot.h"
+#include "Color.h"
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+/** @brief Width of the queue bar in characters. */
+static const int BAR_WIDTH = 20;
+
+/** @brief Lines used by the header, column names and totals. */
+static const int FIXED_LINES = 7;
+
+/** @brief Cleared by SIGINT to leave the redraw loop. */
+static volatile std::sig_atomic_t keep_running = 1;
+
+/**
+ * @brief SIGINT handler.
+ */
+static void onInterrupt(int) {
+    keep_running = 0;
+}
+
+/**
+ * @brief Returns the terminal height, or 24 when it is not a terminal.
+ */
+static int terminalRows() {
+    winsize size{};
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &size) == 0 && size.ws_row > 0) return size.ws_row;
+    return 24;
+}
+
+/**
+ * @brief Returns a bar of @p value relative to @p max.
+ */
+static std::string bar(double value, double max) {
+    int filled = max > 0.0 ? static_cast<int>(value / max * BAR_WIDTH + 0.5) : 0;
+    filled = std::clamp(filled, 0, BAR_WIDTH);
+    return std::string(static_cast<std::size_t>(filled), '#') +
+           std::string(static_cast<std::size_t>(BAR_WIDTH - filled), '.');
+}
+
+/**
+ * @brief Draws one frame.
+ *
+ * @param view Current snapshot.
+ * @param previous Snapshot of the last frame, for rates (may be empty).
+ */
+static void render(const LiveView& view, const LiveView& previous) {
+    int cycles = view.cycle - previous.cycle;
+    bool has_previous = !previous.balancers.empty() && cycles > 0;
+    double seconds = (view.wall_ns - previous.wall_ns) / 1e9;
+    double cycles_per_second = has_previous && seconds > 0.0 ? cycles / seconds : 0.0;
+    double progress = view.total_cycles > 0 ? 100.0 * view.cycle / view.total_cycles : 0.0;
+
+    // deepest queues first when they do not all fit
+    std::vector<std::size_t> order(view.balancers.size());
+    for (std::size_t b = 0; b < order.size(); b++) order[b] = b;
+    std::size_t rows = static_cast<std::size_t>(std::max(terminalRows() - FIXED_LINES, 1));
+    if (order.size() > rows) {
+        std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+            return view.balancers[a].queue > view.balancers[b].queue;
+        });
+    }
+
+    double max_queue = 0.0;
+    double total_queue = 0.0, total_servers = 0.0, total_rate = 0.0;
+    long long total_rejected = 0;
+    for (std::size_t b = 0; b < view.balancers.size(); b++) {
+        const LiveBalancerView& lb = view.balancers[b];
+        max_queue = std::max(max_queue, lb.queue);
+        total_queue += lb.queue;
+        total_servers += lb.servers;
+        total_rejected += lb.rejected;
+        if (has_previous) total_rate += static_cast<double>(lb.completed - previous.balancers[b].completed) / cycles;
+    }
+
+    std::string frame = "\033[H\033[2J";
+    char line[256];
+    std::snprintf(line, sizeof(line), "Simulation pid %d | cycle %d / %d (%.1f%%) | %.0f cycles/s%s\n",
+                  view.pid, view.cycle, view.total_cycles, progress, cycles_per_second,
+                  view.finished ? " | finished" : "");
+    frame += Color::TURQUOISE + line + Color::RESET + "\n";
+    std::snprintf(line, sizeof(line), "%-12s %-10s %9s %-*s %7s %6s %9s %9s %6s %6s %6s\n",
+                  "node", "balancer", "queue", BAR_WIDTH, "", "servers", "util", "done/cyc",
+                  "rejected", "p50", "p95", "p99");
+    frame += Color::CYAN + line + Color::RESET;
+
+    for (std::size_t i = 0; i < order.size() && i < rows; i++) {
+        const LiveBalancerView& lb = view.balancers[order[i]];
+        double rate = has_previous
+            ? static_cast<double>(lb.completed - previous.balancers[order[i]].completed) / cycles : 0.0;
+        const std::string& colour = lb.utilisation >= 0.95 ? Color::RED
+                                  : lb.utilisation >= 0.75 ? Color::YELLOW : Color::GREEN;
+        std::snprintf(line, sizeof(line), "%-12.12s %-10.10s %9.0f %s %7.0f ",
+                      lb.node.c_str(), lb.label.c_str(), lb.queue, bar(lb.queue, max_queue).c_str(),
+                      lb.servers);
+        frame += line;
+        std::snprintf(line, sizeof(line), "%5.1f%%", 100.0 * lb.utilisation);
+        frame += colour + line + Color::RESET;
+        std::snprintf(line, sizeof(line), " %9.2f %9lld %6d %6d %6d\n",
+                      rate, lb.rejected, lb.p50, lb.p95, lb.p99);
+        frame += line;
+    }
+    if (order.size() > rows) {
+        std::snprintf(line, sizeof(line), "... %zu more balancer(s) with shorter queues\n", order.size() - rows);
+        frame += line;
+    }
+
+    std::snprintf(line, sizeof(line), "\n%-23s %9.0f %-*s %7.0f %6s %9.2f %9lld\n",
+                  "total", total_queue, BAR_WIDTH, "", total_servers, "", total_rate, total_rejected);
+    frame += Color::GREEN + line + Color::RESET;
+    std::cout << frame << std::flush;
+}
+
+int main(int argc, char* argv[]) {
+    std::string name = "/lbsim-live";
+    int refresh_ms = 250;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (i + 1 < argc && arg == "--refresh") refresh_ms = std::max(std::atoi(argv[++i]), 10);
+        else if (!arg.empty() && arg[0] == '/') name = arg;
+        else {
+            std::cerr << "usage: " << argv[0] << " [/segment-name] [--refresh ms]\n";
+            return 2;
+        }
+    }
+    std::signal(SIGINT, onInterrupt);
+
+    // the simulation may not have created the segment yet
+    std::unique_ptr<LiveSnapshotReader> reader;
+    while (keep_running) {
+        reader = std::make_unique<LiveSnapshotReader>(name);
+        if (reader->isAttached()) break;
+        std::cout << "\rWaiting for live snapshot " << name << " ..." << std::flush;
+        std::this_thread::sleep_for(std::chrono::milliseconds(refresh_ms));
+    }
+
+    LiveView view, previous;
+    while (keep_running) {
+        if (reader->read(view)) {
+            render(view, previous);
+            previous = view;
+            if (view.finished) break;
+        }
+        // a crashed simulation never sets finished
+        if (kill(view.pid, 0) != 0) {
+            std::cout << "Simulation " << view.pid << " has exited\n";
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(refresh_ms));
+    }
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,736 @@
+/**
+ * @file LiveProxy.cpp
+ * @brief Implementation of the live TCP proxy mode.
+ */
+
+#include "LiveProxy.h"
+#include "Switch.h"
+#include "LoadBalancer.h"
+#include "Color.h"
+#include "Log.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+/** @brief Most bytes moved by one splice() call. */
+static const std::size_t SPLICE_BYTES = 64 * 1024;
+
+/** @brief Interval between housekeeping passes (policy, scaling, metrics). */
+static const long long TICK_MS = 100;
+
+/** @brief Events taken from epoll per wait. */
+static const int EVENT_BATCH = 256;
+
+/** @brief Set by SIGINT/SIGTERM; the event loop checks it after every wait. */
+static volatile std::sig_atomic_t stop_requested = 0;
+
+/**
+ * @brief Asks the event loop to stop.
+ */
+static void requestStop(int) {
+    stop_requested = 1;
+}
+
+/**
+ * @brief Nanoseconds on the steady clock.
+ */
+static long long nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * @brief Closes a descriptor if it is open and marks it closed.
+ */
+static void closeFd(int& fd) {
+    if (fd >= 0) close(fd);
+    fd = -1;
+}
+
+/**
+ * @brief Constructor implementation.
+ *
+ * Balancers are listed group by group, so a balancer's index never
+ * changes while the proxy runs.
+ */
+LiveProxy::LiveProxy(Switch& node, const LiveProxyConfig& config)
+ : node(node),
+   config(config),
+   epoll_fd(-1),
+   start_ns(0),
+   failed_total(0) {
+
+    this->config.max_backends = std::max(this->config.max_backends, 1);
+    group_balancers.resize(node.groups.size());
+    for (std::size_t g = 0; g < node.groups.size(); g++) {
+        for (LoadBalancer& lb : node.groups[g].balancers) {
+            group_balancers[g].push_back(balancers.size());
+            balancers.emplace_back();
+            balancers.back().lb = &lb;
+            balancers.back().group = g;
+        }
+    }
+}
+
+/**
+ * @brief Destructor implementation.
+ */
+LiveProxy::~LiveProxy() {
+    for (std::unique_ptr<Connection>& connection : connections) {
+        if (!connection) continue;
+        closeFd(connection->client);
+        closeFd(connection->backend);
+        closeFd(connection->upstream.pipe_read);
+        closeFd(connection->upstream.pipe_write);
+        closeFd(connection->downstream.pipe_read);
+        closeFd(connection->downstream.pipe_write);
+    }
+    for (int& listener : listeners) closeFd(listener);
+    closeFd(epoll_fd);
+    for (Balancer& balancer : balancers) {
+        for (LiveBackend& backend : balancer.backends) stopLiveBackend(backend);
+    }
+}
+
+/**
+ * @brief Same series as a simulated run, with connections in place of
+ * requests, plus the first-byte latency in microseconds.
+ */
+void LiveProxy::registerMetrics(MetricsRegistry& registry) {
+    static const std::vector<double> FIRST_BYTE_BOUNDS = {50, 100, 200, 500, 1000, 2000, 5000, 10000, 20000, 50000};
+    for (BalancerGroup& group : node.groups) {
+        std::string labels = metricLabel("node", node.name) + "," + metricLabel("class", group.name);
+        group.generated_metric = &registry.counter("lb_switch_arrivals_total",
+                                                   "Requests arriving at the switch node.", labels);
+        group.blocked_metric = &registry.counter("lb_switch_blocked_total",
+                                                 "Arrivals whose source is blocked.", labels);
+        group.rate_limited_metric = &registry.counter("lb_switch_rate_limited_total",
+                                                      "Attempts dropped by the rate limiter.", labels);
+    }
+    for (Balancer& balancer : balancers) {
+        std::string labels = metricLabel("node", node.name) + ","
+                             + metricLabel("class", node.groups[balancer.group].name) + ","
+                             + metricLabel("balancer", balancer.lb->getLabel());
+        balancer.open_metric = &registry.gauge("lb_queue_depth", "Requests waiting in the balancer queue.", labels);
+        balancer.backends_metric = &registry.gauge("lb_servers", "Servers in the balancer pool.", labels);
+        balancer.arrivals_metric = &registry.counter("lb_arrivals_total",
+                                                     "Requests queued at or offered to the balancer.", labels);
+        balancer.refused_metric = &registry.counter("lb_rejected_total", "Arrivals refused by admission control.",
+                                                    labels);
+        balancer.completed_metric = &registry.counter("lb_completed_total", "Requests that finished processing.",
+                                                      labels);
+        balancer.first_byte_metric = &registry.histogram("lb_response_time_us",
+                                                         "Live mode: accept to first response byte, in microseconds.",
+                                                         labels, FIRST_BYTE_BOUNDS);
+    }
+}
+
+/**
+ * @brief Binds 127.0.0.1:port+c for each job class c.
+ */
+bool LiveProxy::openListeners() {
+    for (std::size_t g = 0; g < node.groups.size(); g++) {
+        int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd < 0) return false;
+        listeners.push_back(fd);
+
+        int on = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(static_cast<std::uint16_t>(config.port + static_cast<int>(g)));
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+            listen(fd, SOMAXCONN) != 0) {
+            logStream() << Color::RED << "[SWITCH] Could not listen on 127.0.0.1:"
+                      << config.port + static_cast<int>(g) << ": " << std::strerror(errno)
+                      << Color::RESET << "\n";
+            return false;
+        }
+
+        epoll_event event{};
+        event.events = EPOLLIN | EPOLLET;
+        event.data.u64 = g;
+        epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event);
+        logStream() << Color::CYAN << "[SWITCH] Class " << node.groups[g].name
+                  << " listening on 127.0.0.1:" << config.port + static_cast<int>(g)
+                  << Color::RESET << "\n";
+    }
+    return true;
+}
+
+/**
+ * @brief One backend per configured server, at least one per balancer.
+ */
+bool LiveProxy::startBackends() {
+    for (Balancer& balancer : balancers) {
+        int initial = std::min(std::max(balancer.lb->getServerCount(), 1), config.max_backends);
+        for (int i = 0; i < initial; i++) {
+            if (!addBackend(balancer)) return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Reuses a stopped backend's slot so indices held by open
+ * connections stay valid.
+ */
+bool LiveProxy::addBackend(Balancer& balancer) {
+    std::size_t index = 0;
+    while (index < balancer.backends.size() && balancer.backends[index].isRunning()) index++;
+    if (index == balancer.backends.size()) balancer.backends.emplace_back();
+
+    std::string error;
+    LiveBackend& backend = balancer.backends[index];
+    if (!spawnLiveBackend(backend, config.backend_delay_us, error)) {
+        logStream() << Color::RED << "[LOAD BALANCER ACTION " << balancer.lb->getLabel()
+                  << "] Could not start a backend: " << error
+                  << Color::RESET << "\n";
+        return false;
+    }
+
+    logStream() << Color::GREEN << "[LOAD BALANCER ACTION " << balancer.lb->getLabel()
+              << "] Added backend pid " << backend.pid << " on port " << backend.port
+              << " | Total backends: " << activeBackends(balancer)
+              << Color::RESET << "\n";
+    return true;
+}
+
+/**
+ * @brief Counts running backends that are not draining.
+ */
+int LiveProxy::activeBackends(const Balancer& balancer) {
+    int active = 0;
+    for (const LiveBackend& backend : balancer.backends) {
+        if (backend.isRunning() && !backend.draining) active++;
+    }
+    return active;
+}
+
+/**
+ * @brief Least open connections; ties go to the lowest index.
+ */
+int LiveProxy::pickBackend(const Balancer& balancer) const {
+    int best = -1;
+    for (std::size_t i = 0; i < balancer.backends.size(); i++) {
+        const LiveBackend& backend = balancer.backends[i];
+        if (!backend.isRunning() || backend.draining) continue;
+        if (best < 0 || backend.open < balancer.backends[static_cast<std::size_t>(best)].open) {
+            best = static_cast<int>(i);
+        }
+    }
+    return best;
+}
+
+/**
+ * @brief Affinity mode hashes the source like a simulated request;
+ * otherwise the fewest open connections per backend wins.
+ */
+std::size_t LiveProxy::route(std::size_t group, const IPAddress& peer) {
+    const std::vector<std::size_t>& candidates = group_balancers[group];
+    if (candidates.empty()) return NO_BALANCER;
+    if (node.routing_mode == RoutingMode::Affinity) {
+        int index = node.groups[group].table.lookup(peer.getValue());
+        if (index >= 0) return candidates[static_cast<std::size_t>(index)];
+    }
+
+    std::size_t best = candidates.front();
+    double min_load = 0.0;
+    for (std::size_t i = 0; i < candidates.size(); i++) {
+        const Balancer& balancer = balancers[candidates[i]];
+        double load = static_cast<double>(balancer.open) / std::max(activeBackends(balancer), 1);
+        if (i == 0 || load < min_load) {
+            min_load = load;
+            best = candidates[i];
+        }
+    }
+    return best;
+}
+
+/**
+ * @brief Drains the listener's accept queue (the listener is edge-triggered).
+ */
+void LiveProxy::acceptConnections(std::size_t group, long long now_ns) {
+    for (;;) {
+        sockaddr_in address{};
+        socklen_t length = sizeof(address);
+        int client = accept4(listeners[group], reinterpret_cast<sockaddr*>(&address), &length,
+                             SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (client < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            // EAGAIN, or out of descriptors: the next edge retries
+            return;
+        }
+        admit(group, client, IPAddress(ntohl(address.sin_addr.s_addr)), now_ns);
+    }
+}
+
+/**
+ * @brief The switch's checks in the order addRequestToBalancer() applies
+ * them, then a non-blocking connect to the chosen backend.
+ */
+void LiveProxy::admit(std::size_t group, int client, const IPAddress& peer, long long now_ns) {
+    int cycle = static_cast<int>((now_ns - start_ns) / 1000000);
+    BalancerGroup& classes = node.groups[group];
+    classes.generated++;
+
+    if (node.heavy_hitter_threshold > 0.0) node.trackSource(peer, cycle);
+
+    Request request;
+    request.in = peer;
+    request.job_class = static_cast<int>(group);
+    if (node.isBlocked(request, cycle)) {
+        classes.blocked++;
+        if (logEnabled()) {
+            logStream() << Color::RED << "[SWITCH ACTION] Blocked IP: " << peer.getString()
+                      << Color::RESET << "\n";
+        }
+        close(client);
+        return;
+    }
+    if (!node.rate_limiter.allow(peer, cycle)) {
+        classes.rate_limited++;
+        if (logEnabled()) {
+            logStream() << Color::RED << "[SWITCH ACTION] Rate limited IP: " << peer.getString()
+                      << Color::RESET << "\n";
+        }
+        close(client);
+        return;
+    }
+    std::size_t index = route(group, peer);
+    if (index == NO_BALANCER) {
+        classes.unroutable++;
+        close(client);
+        return;
+    }
+    classes.admitted++;
+
+    Balancer& balancer = balancers[index];
+    balancer.arrivals++;
+    int backend_index = pickBackend(balancer);
+    if (backend_index < 0) {
+        balancer.refused++;
+        close(client);
+        return;
+    }
+    LiveBackend& backend = balancer.backends[static_cast<std::size_t>(backend_index)];
+
+    std::unique_ptr<Connection> connection = std::make_unique<Connection>();
+    connection->client = client;
+    connection->balancer = index;
+    connection->backend_index = static_cast<std::size_t>(backend_index);
+    connection->accepted_ns = now_ns;
+
+    int pipes[2][2];
+    bool ready = pipe2(pipes[0], O_NONBLOCK | O_CLOEXEC) == 0;
+    if (ready) {
+        connection->upstream.pipe_read = pipes[0][0];
+        connection->upstream.pipe_write = pipes[0][1];
+        ready = pipe2(pipes[1], O_NONBLOCK | O_CLOEXEC) == 0;
+    }
+    if (ready) {
+        connection->downstream.pipe_read = pipes[1][0];
+        connection->downstream.pipe_write = pipes[1][1];
+        connection->backend = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        ready = connection->backend >= 0;
+    }
+    if (ready) {
+        int on = 1;
+        setsockopt(client, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+        setsockopt(connection->backend, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(static_cast<std::uint16_t>(backend.port));
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        ready = connect(connection->backend, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0 ||
+                errno == EINPROGRESS;
+    }
+
+    std::size_t slot;
+    if (free_slots.empty()) {
+        slot = connections.size();
+        connections.emplace_back();
+    } else {
+        slot = free_slots.back();
+        free_slots.pop_back();
+    }
+    connections[slot] = std::move(connection);
+    balancer.open++;
+    backend.open++;
+    backend.connections++;
+    if (!ready) {
+        balancer.refused++;
+        finish(slot, false, now_ns);
+        return;
+    }
+
+    // both sockets wake the same slot; either event pumps both directions
+    epoll_event event{};
+    event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+    event.data.u64 = listeners.size() + slot;
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, client, &event);
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, connections[slot]->backend, &event);
+}
+
+/**
+ * @brief Alternates pipe-to-destination and source-to-pipe splices until
+ * neither moves anything, then forwards a finished stream's end.
+ *
+ * EAGAIN means the destination is full, the source is empty or the pipe
+ * is full; the edge that changes that calls pump() again.
+ */
+bool LiveProxy::pump(int source, int destination, Flow& flow) {
+    bool progress = true;
+    while (progress) {
+        progress = false;
+        if (flow.pending > 0) {
+            ssize_t moved = splice(flow.pipe_read, nullptr, destination, nullptr, flow.pending,
+                                   SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+            if (moved > 0) {
+                flow.pending -= static_cast<std::size_t>(moved);
+                flow.bytes += moved;
+                progress = true;
+            } else if (moved < 0 && errno != EAGAIN && errno != EINTR) {
+                return false;
+            }
+        }
+        if (!flow.eof) {
+            ssize_t moved = splice(source, nullptr, flow.pipe_write, nullptr, SPLICE_BYTES,
+                                   SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+            if (moved > 0) {
+                flow.pending += static_cast<std::size_t>(moved);
+                progress = true;
+            } else if (moved == 0) {
+                flow.eof = true;
+            } else if (errno != EAGAIN && errno != EINTR) {
+                return false;
+            }
+        }
+    }
+
+    if (flow.eof && flow.pending == 0 && !flow.shut) {
+        shutdown(destination, SHUT_WR);
+        flow.shut = true;
+    }
+    return true;
+}
+
+/**
+ * @brief Completes the backend connect, then pumps both directions.
+ *
+ * Events of a slot freed and reused in the same batch reach the new
+ * connection; pumping it is harmless.
+ */
+void LiveProxy::service(std::size_t slot, long long now_ns) {
+    Connection& connection = *connections[slot];
+    if (!connection.connected) {
+        int error = 0;
+        socklen_t length = sizeof(error);
+        getsockopt(connection.backend, SOL_SOCKET, SO_ERROR, &error, &length);
+        if (error != 0) {
+            balancers[connection.balancer].refused++;
+            finish(slot, false, now_ns);
+            return;
+        }
+        sockaddr_in peer{};
+        length = sizeof(peer);
+        // still in progress: not an error, and not connected yet
+        if (getpeername(connection.backend, reinterpret_cast<sockaddr*>(&peer), &length) != 0) return;
+        connection.connected = true;
+    }
+
+    Balancer& balancer = balancers[connection.balancer];
+    long long up_before = connection.upstream.bytes;
+    long long down_before = connection.downstream.bytes;
+    bool ok = pump(connection.client, connection.backend, connection.upstream) &&
+              pump(connection.backend, connection.client, connection.downstream);
+    balancer.bytes_in += connection.upstream.bytes - up_before;
+    balancer.bytes_out += connection.downstream.bytes - down_before;
+
+    if (!connection.answered && connection.downstream.bytes > 0) {
+        connection.answered = true;
+        long long us = (now_ns - connection.accepted_ns) / 1000;
+        balancer.first_byte.record(static_cast<int>(std::min(us, 2000000000LL)));
+        if (balancer.first_byte_metric != nullptr) balancer.first_byte_metric->observe(static_cast<double>(us));
+    }
+
+    if (!ok) {
+        finish(slot, false, now_ns);
+    } else if (connection.upstream.shut && connection.downstream.shut) {
+        finish(slot, true, now_ns);
+    }
+}
+
+/**
+ * @brief Closing a descriptor also removes it from the epoll set.
+ */
+void LiveProxy::finish(std::size_t slot, bool completed, long long now_ns) {
+    Connection& connection = *connections[slot];
+    Balancer& balancer = balancers[connection.balancer];
+    balancer.open--;
+    balancer.backends[connection.backend_index].open--;
+    if (completed) {
+        balancer.completed++;
+        long long us = (now_ns - connection.accepted_ns) / 1000;
+        balancer.lifetime.record(static_cast<int>(std::min(us, 2000000000LL)));
+    } else {
+        balancer.failed++;
+        failed_total++;
+    }
+
+    closeFd(connection.client);
+    closeFd(connection.backend);
+    closeFd(connection.upstream.pipe_read);
+    closeFd(connection.upstream.pipe_write);
+    closeFd(connection.downstream.pipe_read);
+    closeFd(connection.downstream.pipe_write);
+    connections[slot].reset();
+    free_slots.push_back(slot);
+}
+
+/**
+ * @brief Scales on open connections per active backend, at most once per
+ * cooldown. Scaling up first takes back a draining backend, which still
+ * runs, before forking a new one.
+ */
+void LiveProxy::maybeScale(Balancer& balancer, long long now_ms) {
+    if (balancer.scale_ups + balancer.scale_downs > 0 &&
+        now_ms - balancer.last_scale_ms < config.scale_cooldown_ms) {
+        return;
+    }
+    int active = activeBackends(balancer);
+    double load = static_cast<double>(balancer.open) / std::max(active, 1);
+
+    if (load > config.scale_up_connections && active < config.max_backends) {
+        bool added = false;
+        for (LiveBackend& backend : balancer.backends) {
+            if (!backend.isRunning() || !backend.draining) continue;
+            backend.draining = false;
+            added = true;
+            logStream() << Color::GREEN << "[LOAD BALANCER ACTION " << balancer.lb->getLabel()
+                      << "] Resumed backend pid " << backend.pid << " on port " << backend.port
+                      << " | Total backends: " << activeBackends(balancer)
+                      << Color::RESET << "\n";
+            break;
+        }
+        if (!added) added = addBackend(balancer);
+        if (added) {
+            balancer.scale_ups++;
+            balancer.last_scale_ms = now_ms;
+        }
+        return;
+    }
+
+    if (load < config.scale_down_connections && active > 1) {
+        LiveBackend* idlest = nullptr;
+        for (LiveBackend& backend : balancer.backends) {
+            if (!backend.isRunning() || backend.draining) continue;
+            if (idlest == nullptr || backend.open < idlest->open) idlest = &backend;
+        }
+        idlest->draining = true;
+        balancer.scale_downs++;
+        balancer.last_scale_ms = now_ms;
+        logStream() << Color::GREEN << "[LOAD BALANCER ACTION " << balancer.lb->getLabel()
+                  << "] Draining backend pid " << idlest->pid << " on port " << idlest->port
+                  << " | Total backends: " << activeBackends(balancer)
+                  << Color::RESET << "\n";
+    }
+}
+
+/**
+ * @brief A draining backend is stopped once its last connection closed.
+ */
+void LiveProxy::reapBackends(Balancer& balancer) {
+    for (LiveBackend& backend : balancer.backends) {
+        if (!backend.isRunning() || !backend.draining || backend.open > 0) continue;
+        logStream() << Color::GREEN << "[LOAD BALANCER ACTION " << balancer.lb->getLabel()
+                  << "] Removed backend pid " << backend.pid
+                  << " after " << backend.connections << " connections"
+                  << " | Total backends: " << activeBackends(balancer)
+                  << Color::RESET << "\n";
+        stopLiveBackend(backend);
+    }
+}
+
+/**
+ * @brief Plain stores, as in a simulated run.
+ */
+void LiveProxy::publishMetrics(long long now_ms) {
+    (void)now_ms;
+    node.publishMetrics(0);
+    for (Balancer& balancer : balancers) {
+        if (balancer.open_metric == nullptr) continue;
+        balancer.open_metric->set(static_cast<double>(balancer.open));
+        balancer.backends_metric->set(static_cast<double>(activeBackends(balancer)));
+        balancer.arrivals_metric->set(static_cast<std::uint64_t>(balancer.arrivals));
+        balancer.refused_metric->set(static_cast<std::uint64_t>(balancer.refused));
+        balancer.completed_metric->set(static_cast<std::uint64_t>(balancer.completed));
+    }
+}
+
+/**
+ * @brief Writes the same text to the log and the console.
+ */
+void LiveProxy::reportStatus(long long now_ms) {
+    std::ostringstream text;
+    text << Color::TURQUOISE << "[SWITCH] Live status at " << now_ms << " ms\n";
+    for (const Balancer& balancer : balancers) {
+        text << "  " << balancer.lb->getLabel()
+             << ": open=" << balancer.open
+             << " backends=" << activeBackends(balancer)
+             << " completed=" << balancer.completed
+             << " refused=" << balancer.refused
+             << " p99=" << balancer.first_byte.percentile(99) << " us\n";
+    }
+    text << Color::RESET;
+    logStream() << text.str();
+    std::cerr << text.str();
+}
+
+/**
+ * @brief Totals, one line per balancer and the latency lines of a
+ * simulated run, with microseconds as the unit.
+ */
+void LiveProxy::reportSummary(long long now_ns) {
+    double seconds = std::max(static_cast<double>(now_ns - start_ns) / 1e9, 1e-9);
+    long long accepted = 0, blocked = 0, rate_limited = 0, refused = 0;
+    for (const BalancerGroup& group : node.groups) {
+        accepted += group.generated;
+        blocked += group.blocked;
+        rate_limited += group.rate_limited;
+        refused += group.unroutable;
+    }
+    long long completed = 0, bytes = 0;
+    for (const Balancer& balancer : balancers) {
+        completed += balancer.completed;
+        refused += balancer.refused;
+        bytes += balancer.bytes_in + balancer.bytes_out;
+    }
+
+    logStream() << Color::GREEN << "\n[SWITCH] Live run complete!\n"
+              << "  Run time: " << std::fixed << std::setprecision(2) << seconds << " s\n"
+              << "  Total connections accepted: " << accepted << "\n"
+              << "  Total connections blocked: " << blocked << "\n"
+              << "  Total connections rate limited: " << rate_limited << "\n"
+              << "  Total connections refused: " << refused << "\n"
+              << "  Total connections failed: " << failed_total << "\n"
+              << "  Total connections completed: " << completed << "\n"
+              << "  Throughput: " << completed / seconds << " connections/s, "
+              << bytes / seconds / (1024.0 * 1024.0) << " MB/s\n";
+    if (node.policy_reloads > 0) {
+        logStream() << "  Config reloads: " << node.policy_reloads
+                  << " mean_latency_us=" << static_cast<double>(node.policy_reload_us) / node.policy_reloads
+                  << " snapshots_reclaimed=" << node.policy.getReclaimedCount()
+                  << " pending=" << node.policy.getPendingCount() << "\n";
+    }
+    for (const Balancer& balancer : balancers) {
+        int running = 0;
+        for (const LiveBackend& backend : balancer.backends) running += backend.isRunning() ? 1 : 0;
+        logStream() << "  Balancer " << balancer.lb->getLabel()
+                  << ": arrivals=" << balancer.arrivals
+                  << " completed=" << balancer.completed
+                  << " refused=" << balancer.refused
+                  << " failed=" << balancer.failed
+                  << " bytes_in=" << balancer.bytes_in
+                  << " bytes_out=" << balancer.bytes_out
+                  << " backends=" << running
+                  << " scale_ups=" << balancer.scale_ups
+                  << " scale_downs=" << balancer.scale_downs << "\n";
+    }
+    logStream() << std::defaultfloat << std::setprecision(6);
+
+    // first-byte latency per class, merged over its balancers
+    logStream() << "  Latency unit: microseconds from accept to first response byte\n";
+    for (std::size_t g = 0; g < node.groups.size(); g++) {
+        LatencyHistogram merged;
+        for (std::size_t index : group_balancers[g]) merged.merge(balancers[index].first_byte);
+        logStream() << "  Latency (" << node.groups[g].name << ") class " << g
+                  << ": count=" << merged.count()
+                  << " mean=" << merged.mean()
+                  << " p50=" << merged.percentile(50)
+                  << " p99=" << merged.percentile(99)
+                  << " max=" << merged.max() << "\n";
+    }
+    logStream() << Color::RESET;
+}
+
+/**
+ * @brief Single-threaded epoll loop with a housekeeping tick.
+ */
+bool LiveProxy::run() {
+    if (!node.children.empty() || node.leaf_process_count > 1) {
+        logStream() << Color::RED << "[SWITCH] Live mode needs a flat switch (no topology)"
+                  << Color::RESET << "\n";
+        std::cerr << "ERROR: live_proxy_port requires a switch without topology\n";
+        return false;
+    }
+
+    std::signal(SIGPIPE, SIG_IGN);
+    std::signal(SIGINT, requestStop);
+    std::signal(SIGTERM, requestStop);
+
+    start_ns = nowNs();
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd < 0 || !openListeners() || !startBackends()) {
+        std::cerr << "ERROR: could not start the live proxy (see switchlog.ansi)\n";
+        return false;
+    }
+    logStream().flush();
+
+    long long end_ns = config.seconds > 0 ? start_ns + config.seconds * 1000000000LL : 0;
+    long long next_tick_ms = TICK_MS;
+    long long next_status_ms = config.status_ms;
+    epoll_event events[EVENT_BATCH];
+    while (!stop_requested) {
+        long long now_ns = nowNs();
+        if (end_ns > 0 && now_ns >= end_ns) break;
+
+        long long now_ms = (now_ns - start_ns) / 1000000;
+        int timeout = static_cast<int>(std::max(next_tick_ms - now_ms, 0LL));
+        int count = epoll_wait(epoll_fd, events, EVENT_BATCH, timeout);
+        now_ns = nowNs();
+        for (int i = 0; i < count; i++) {
+            std::uint64_t key = events[i].data.u64;
+            if (key < listeners.size()) {
+                acceptConnections(static_cast<std::size_t>(key), now_ns);
+                continue;
+            }
+            std::size_t slot = static_cast<std::size_t>(key - listeners.size());
+            if (slot < connections.size() && connections[slot]) service(slot, now_ns);
+        }
+
+        now_ms = (nowNs() - start_ns) / 1000000;
+        if (now_ms < next_tick_ms) continue;
+        next_tick_ms = now_ms + TICK_MS;
+
+        // config reloads apply to live traffic as they do to simulated
+        // traffic; a tick is the live mode's cycle boundary, so the old
+        // snapshot is released first and may then be freed
+        node.releasePolicy();
+        node.applyPolicy();
+        for (Balancer& balancer : balancers) {
+            maybeScale(balancer, now_ms);
+            reapBackends(balancer);
+        }
+        publishMetrics(now_ms);
+        if (config.status_ms > 0 && now_ms >= next_status_ms) {
+            reportStatus(now_ms);
+            next_status_ms = now_ms + config.status_ms;
+        }
+    }
+
+    reportSummary(nowNs());
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,265 @@
+/**
+ * @file LiveProxy.h
+ * @brief Defines the live mode, in which the Switch and its LoadBalancers
+ * route real TCP connections on localhost instead of simulated requests.
+ *
+ * Each job class listens on 127.0.0.1 at live_proxy_port plus its class
+ * index. An accepted connection goes through the same front door as a
+ * generated request: the heavy-hitter sketch, isBlocked() on the peer
+ * address and the source's rate-limit bucket. It is then routed to a
+ * balancer of its class (by source affinity or by fewest open connections
+ * per backend) and from there to the balancer's least busy backend
+ * process. Clients may bind any 127.x.y.z source to exercise blocklists.
+ *
+ * Bytes are forwarded with splice() through a pipe per direction, so they
+ * never leave the kernel. One epoll loop drives every socket,
+ * edge-triggered: every readiness event pumps both directions of its
+ * connection until the kernel would block.
+ *
+ * Each balancer starts with as many backends as it has servers. Every
+ * tick it compares open connections per backend with the scaling
+ * thresholds; scaling up forks a backend, scaling down stops routing to
+ * one and stops it once its last connection closes. Cycle-based settings
+ * of the switch (rate limits, heavy-hitter window and block TTL) count
+ * milliseconds since the start of the run.
+ *
+ * Latency is the time from accept to the first response byte, recorded in
+ * microseconds in the same LatencyHistogram as simulated response times,
+ * and reported in the simulator's summary and metric formats.
+ */
+
+#pragma once
+#include "LatencyHistogram.h"
+#include "LiveBackend.h"
+#include "Metrics.h"
+#include "IPAddress.h"
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+class Switch;
+class LoadBalancer;
+
+/**
+ * @struct LiveProxyConfig
+ * @brief Settings of the live mode.
+ */
+struct LiveProxyConfig {
+
+    /** @brief Port of job class 0; class c listens on port + c (0 = simulate instead). */
+    int port = 0;
+
+    /** @brief Length of the run in seconds (0 = until interrupted). */
+    int seconds = 10;
+
+    /** @brief Time a backend sleeps before answering each message, in microseconds. */
+    int backend_delay_us = 0;
+
+    /** @brief Open connections per backend above which a backend is added. */
+    double scale_up_connections = 8.0;
+
+    /** @brief Open connections per backend below which a backend is retired. */
+    double scale_down_connections = 2.0;
+
+    /** @brief Minimum time between two scaling actions of a balancer. */
+    int scale_cooldown_ms = 1000;
+
+    /** @brief Most backends per balancer. */
+    int max_backends = 16;
+
+    /** @brief Interval between status reports (0 = none). */
+    int status_ms = 1000;
+};
+
+/**
+ * @class LiveProxy
+ * @brief Event loop of the live mode.
+ */
+class LiveProxy {
+private:
+
+    /**
+     * @brief One direction of a connection: source socket, pipe, destination.
+     */
+    struct Flow {
+        int pipe_read = -1;
+        int pipe_write = -1;
+        /** @brief Bytes in the pipe, not yet written to the destination. */
+        std::size_t pending = 0;
+        /** @brief Source reached end of stream. */
+        bool eof = false;
+        /** @brief Destination's write side was shut down after eof. */
+        bool shut = false;
+        /** @brief Bytes delivered to the destination. */
+        long long bytes = 0;
+    };
+
+    /**
+     * @brief A proxied connection, addressed by its slot in connections.
+     */
+    struct Connection {
+        int client = -1;
+        int backend = -1;
+        /** @brief Client to backend. */
+        Flow upstream;
+        /** @brief Backend to client. */
+        Flow downstream;
+        std::size_t balancer = 0;
+        std::size_t backend_index = 0;
+        long long accepted_ns = 0;
+        /** @brief The non-blocking connect to the backend completed. */
+        bool connected = false;
+        /** @brief The first response byte was delivered. */
+        bool answered = false;
+    };
+
+    /**
+     * @brief Live state of one of the switch's LoadBalancers.
+     */
+    struct Balancer {
+        LoadBalancer* lb = nullptr;
+        std::size_t group = 0;
+        std::vector<LiveBackend> backends;
+        int open = 0;
+        long long arrivals = 0;
+        long long completed = 0;
+        long long refused = 0;
+        long long failed = 0;
+        long long bytes_in = 0;
+        long long bytes_out = 0;
+        long long last_scale_ms = 0;
+        long long scale_ups = 0;
+        long long scale_downs = 0;
+        /** @brief Accept to first response byte, in microseconds. */
+        LatencyHistogram first_byte;
+        /** @brief Accept to close, in microseconds. */
+        LatencyHistogram lifetime;
+        MetricGauge* open_metric = nullptr;
+        MetricGauge* backends_metric = nullptr;
+        MetricCounter* arrivals_metric = nullptr;
+        MetricCounter* refused_metric = nullptr;
+        MetricCounter* completed_metric = nullptr;
+        MetricHistogram* first_byte_metric = nullptr;
+    };
+
+    /** @brief Switch whose groups, blocklist and rate limiter are used. */
+    Switch& node;
+
+    /** @brief Live mode settings. */
+    LiveProxyConfig config;
+
+    /** @brief The event loop's epoll instance. */
+    int epoll_fd;
+
+    /** @brief Listening socket per job class. */
+    std::vector<int> listeners;
+
+    /** @brief Every balancer of every group, in group order. */
+    std::vector<Balancer> balancers;
+
+    /** @brief Indices into balancers of each group's balancers. */
+    std::vector<std::vector<std::size_t>> group_balancers;
+
+    /** @brief Connection slots (null when free). */
+    std::vector<std::unique_ptr<Connection>> connections;
+
+    /** @brief Free connection slots. */
+    std::vector<std::size_t> free_slots;
+
+    /** @brief Steady-clock time the run started, in nanoseconds. */
+    long long start_ns;
+
+    /** @brief Connections closed for failing in flight. */
+    long long failed_total;
+
+    /** @brief Opens one listening socket per job class. */
+    bool openListeners();
+
+    /** @brief Forks each balancer's initial backends. */
+    bool startBackends();
+
+    /** @brief Accepts pending connections of a job class. */
+    void acceptConnections(std::size_t group, long long now_ns);
+
+    /**
+     * @brief Admits or drops one accepted connection and connects it to a backend.
+     */
+    void admit(std::size_t group, int client, const IPAddress& peer, long long now_ns);
+
+    /** @brief Returned by route() for a class without balancers. */
+    static const std::size_t NO_BALANCER = static_cast<std::size_t>(-1);
+
+    /** @brief Picks a balancer of the group for a source (NO_BALANCER if it has none). */
+    std::size_t route(std::size_t group, const IPAddress& peer);
+
+    /** @brief Returns the running, non-draining backend with fewest open connections (-1 if none). */
+    int pickBackend(const Balancer& balancer) const;
+
+    /**
+     * @brief Moves bytes from @p source through the flow's pipe to @p destination.
+     *
+     * @return False on an error that ends the connection.
+     */
+    bool pump(int source, int destination, Flow& flow);
+
+    /** @brief Handles a readiness event of a connection. */
+    void service(std::size_t slot, long long now_ns);
+
+    /** @brief Closes a connection and updates its balancer and backend. */
+    void finish(std::size_t slot, bool completed, long long now_ns);
+
+    /** @brief Adds or retires a backend of a balancer per the thresholds. */
+    void maybeScale(Balancer& balancer, long long now_ms);
+
+    /** @brief Forks one more backend for a balancer. */
+    bool addBackend(Balancer& balancer);
+
+    /** @brief Stops draining backends without open connections. */
+    void reapBackends(Balancer& balancer);
+
+    /** @brief Returns the number of backends accepting new connections. */
+    static int activeBackends(const Balancer& balancer);
+
+    /** @brief Copies the counters into the registered series. */
+    void publishMetrics(long long now_ms);
+
+    /** @brief Prints open connections, backends and latency per balancer. */
+    void reportStatus(long long now_ms);
+
+    /** @brief Prints the totals, per-balancer and latency summaries. */
+    void reportSummary(long long now_ns);
+
+public:
+
+    /**
+     * @brief Prepares a proxy over the switch's groups; nothing is opened yet.
+     *
+     * @param node Flat (single-node) switch providing groups and policies.
+     * @param config Live mode settings.
+     */
+    LiveProxy(Switch& node, const LiveProxyConfig& config);
+
+    /**
+     * @brief Closes every socket and stops every backend.
+     */
+    ~LiveProxy();
+
+    LiveProxy(const LiveProxy&) = delete;
+    LiveProxy& operator=(const LiveProxy&) = delete;
+
+    /**
+     * @brief Registers switch and balancer series under the simulator's names.
+     *
+     * @param registry Registry that owns the series; must outlive the run.
+     */
+    void registerMetrics(MetricsRegistry& registry);
+
+    /**
+     * @brief Serves connections until the configured time has passed or
+     * SIGINT/SIGTERM arrives, then prints the summary.
+     *
+     * @return False if the listeners or the first backends could not be started.
+     */
+    bool run();
+};
\ No newline at end of file
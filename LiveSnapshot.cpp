@@ -0,0 +1,194 @@
+/**
+ * @file LiveSnapshot.cpp
+ * @brief Implementation of the shared-memory snapshot writer and reader.
+ */
+
+#include "LiveSnapshot.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <new>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/** @brief Identifies a snapshot segment. */
+static const char LIVE_MAGIC[8] = "LBLIVE";
+
+/** @brief Layout version; readers refuse others. */
+static const std::uint32_t LIVE_VERSION = 1;
+
+/** @brief Copies a reader makes before giving up on a busy writer. */
+static const int READ_ATTEMPTS = 1000;
+
+/**
+ * @brief Copies @p text into a fixed field, truncating and terminating it.
+ */
+static void copyName(char* field, const std::string& text) {
+    std::size_t length = std::min(text.size(), LIVE_NAME_BYTES - 1);
+    std::memcpy(field, text.data(), length);
+    field[length] = '\0';
+}
+
+/**
+ * @brief Constructor implementation.
+ *
+ * The magic is written last, so a reader attaching early sees an
+ * unrecognised segment rather than half-written names.
+ */
+LiveSnapshot::LiveSnapshot(const std::string& name, const std::vector<std::string>& nodes,
+                           const std::vector<std::string>& labels, int total_cycles)
+ : name(name),
+   header(nullptr),
+   slots(nullptr),
+   mapped_bytes(0) {
+
+    int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if (fd < 0) return;
+
+    std::size_t bytes = sizeof(LiveHeader) + labels.size() * sizeof(LiveBalancer);
+    void* map = MAP_FAILED;
+    if (ftruncate(fd, static_cast<off_t>(bytes)) == 0) {
+        map = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (map == MAP_FAILED) {
+        shm_unlink(name.c_str());
+        return;
+    }
+
+    mapped_bytes = bytes;
+    header = new (map) LiveHeader();
+    slots = reinterpret_cast<LiveBalancer*>(static_cast<char*>(map) + sizeof(LiveHeader));
+    for (std::size_t b = 0; b < labels.size(); b++) {
+        LiveBalancer* slot = new (&slots[b]) LiveBalancer();
+        copyName(slot->node, nodes[b]);
+        copyName(slot->label, labels[b]);
+    }
+    header->version = LIVE_VERSION;
+    header->count = static_cast<std::uint32_t>(labels.size());
+    header->pid = static_cast<std::int32_t>(getpid());
+    header->total_cycles = total_cycles;
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(header->magic, LIVE_MAGIC, sizeof(LIVE_MAGIC));
+}
+
+/**
+ * @brief Destructor implementation.
+ */
+LiveSnapshot::~LiveSnapshot() {
+    if (header == nullptr) return;
+    munmap(header, mapped_bytes);
+    shm_unlink(name.c_str());
+}
+
+/**
+ * @brief Returns whether the mapping exists.
+ */
+bool LiveSnapshot::isValid() const {
+    return header != nullptr;
+}
+
+/**
+ * @brief Stores the cycle and time, then makes the sequence even again.
+ */
+void LiveSnapshot::end(int cycle, bool finished) {
+    long long now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    header->cycle.store(cycle, std::memory_order_relaxed);
+    header->wall_ns.store(now, std::memory_order_relaxed);
+    if (finished) header->finished.store(1, std::memory_order_relaxed);
+    header->sequence.store(header->sequence.load(std::memory_order_relaxed) + 1,
+                           std::memory_order_release);
+}
+
+/**
+ * @brief Maps the segment if it exists and has the expected layout.
+ */
+LiveSnapshotReader::LiveSnapshotReader(const std::string& name)
+ : header(nullptr),
+   slots(nullptr),
+   mapped_bytes(0) {
+
+    int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0) return;
+    struct stat info;
+    void* map = MAP_FAILED;
+    if (fstat(fd, &info) == 0 && static_cast<std::size_t>(info.st_size) >= sizeof(LiveHeader)) {
+        map = mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (map == MAP_FAILED) return;
+
+    const LiveHeader* mapped = static_cast<const LiveHeader*>(map);
+    std::size_t size = static_cast<std::size_t>(info.st_size);
+    bool valid = std::memcmp(mapped->magic, LIVE_MAGIC, sizeof(LIVE_MAGIC)) == 0;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    valid = valid && mapped->version == LIVE_VERSION &&
+            size >= sizeof(LiveHeader) + mapped->count * sizeof(LiveBalancer);
+    if (!valid) {
+        munmap(map, size);
+        return;
+    }
+
+    mapped_bytes = size;
+    header = mapped;
+    slots = reinterpret_cast<const LiveBalancer*>(static_cast<const char*>(map) + sizeof(LiveHeader));
+}
+
+/**
+ * @brief Destructor implementation.
+ */
+LiveSnapshotReader::~LiveSnapshotReader() {
+    if (header != nullptr) munmap(const_cast<LiveHeader*>(header), mapped_bytes);
+}
+
+/**
+ * @brief Returns whether a segment is mapped.
+ */
+bool LiveSnapshotReader::isAttached() const {
+    return header != nullptr;
+}
+
+/**
+ * @brief Seqlock read: copy between two equal, even sequence values.
+ */
+bool LiveSnapshotReader::read(LiveView& view) const {
+    if (header == nullptr) return false;
+
+    view.pid = header->pid;
+    view.total_cycles = header->total_cycles;
+    view.balancers.resize(header->count);
+    for (std::size_t b = 0; b < header->count; b++) {
+        view.balancers[b].node = slots[b].node;
+        view.balancers[b].label = slots[b].label;
+    }
+
+    for (int attempt = 0; attempt < READ_ATTEMPTS; attempt++) {
+        std::uint64_t before = header->sequence.load(std::memory_order_acquire);
+        if (before & 1) continue;
+
+        view.cycle = header->cycle.load(std::memory_order_relaxed);
+        view.wall_ns = header->wall_ns.load(std::memory_order_relaxed);
+        view.finished = header->finished.load(std::memory_order_relaxed) != 0;
+        for (std::size_t b = 0; b < header->count; b++) {
+            const LiveBalancer& slot = slots[b];
+            LiveBalancerView& copy = view.balancers[b];
+            copy.queue = slot.queue.load(std::memory_order_relaxed);
+            copy.servers = slot.servers.load(std::memory_order_relaxed);
+            copy.utilisation = slot.utilisation.load(std::memory_order_relaxed);
+            copy.arrivals = slot.arrivals.load(std::memory_order_relaxed);
+            copy.completed = slot.completed.load(std::memory_order_relaxed);
+            copy.rejected = slot.rejected.load(std::memory_order_relaxed);
+            copy.expired = slot.expired.load(std::memory_order_relaxed);
+            copy.p50 = slot.p50.load(std::memory_order_relaxed);
+            copy.p95 = slot.p95.load(std::memory_order_relaxed);
+            copy.p99 = slot.p99.load(std::memory_order_relaxed);
+        }
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (header->sequence.load(std::memory_order_relaxed) == before) return true;
+    }
+    return false;
+}
\ No newline at end of file
@@ -0,0 +1,223 @@
+/**
+ * @file LiveSnapshot.h
+ * @brief Defines a seqlock-protected snapshot of balancer state in a
+ * named POSIX shared-memory segment, and the reader a dashboard uses.
+ *
+ * The simulation is the only writer. A publish bumps the sequence to an
+ * odd value, stores every field with relaxed atomic stores (plain moves
+ * on x86) and bumps it to even again. It never waits and does not know
+ * whether anyone is reading. A reader copies the fields and retries if
+ * the sequence was odd or changed meanwhile, so it only ever sees whole
+ * snapshots.
+ *
+ * Node names and labels are written once, before the first publish.
+ * The segment is unlinked when the writer goes away; an attached reader
+ * keeps its mapping and sees the finished flag.
+ */
+
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/** @brief Bytes kept of node names and balancer labels, with the terminator. */
+static const std::size_t LIVE_NAME_BYTES = 32;
+
+/**
+ * @struct LiveBalancer
+ * @brief One balancer's slot in the segment.
+ */
+struct LiveBalancer {
+    char node[LIVE_NAME_BYTES];
+    char label[LIVE_NAME_BYTES];
+    std::atomic<double> queue;
+    std::atomic<double> servers;
+    std::atomic<double> utilisation;
+    std::atomic<long long> arrivals;
+    std::atomic<long long> completed;
+    std::atomic<long long> rejected;
+    std::atomic<long long> expired;
+    std::atomic<int> p50;
+    std::atomic<int> p95;
+    std::atomic<int> p99;
+};
+
+/**
+ * @struct LiveHeader
+ * @brief Start of the segment, followed by count LiveBalancer slots.
+ */
+struct LiveHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t count;
+    std::int32_t pid;
+    std::int32_t total_cycles;
+
+    /** @brief Odd while a publish is in progress. */
+    alignas(64) std::atomic<std::uint64_t> sequence;
+
+    /** @brief Cycle of the snapshot. */
+    std::atomic<int> cycle;
+
+    /** @brief Steady-clock time of the snapshot, in nanoseconds. */
+    std::atomic<long long> wall_ns;
+
+    /** @brief Set by the last publish of the run. */
+    std::atomic<int> finished;
+};
+
+static_assert(std::atomic<double>::is_always_lock_free &&
+              std::atomic<long long>::is_always_lock_free &&
+              std::atomic<std::uint64_t>::is_always_lock_free,
+              "snapshot fields must be lock-free to be shared between processes");
+
+/**
+ * @struct LiveBalancerView
+ * @brief Reader's copy of one balancer.
+ */
+struct LiveBalancerView {
+    std::string node;
+    std::string label;
+    double queue = 0.0;
+    double servers = 0.0;
+    double utilisation = 0.0;
+    long long arrivals = 0;
+    long long completed = 0;
+    long long rejected = 0;
+    long long expired = 0;
+    int p50 = 0;
+    int p95 = 0;
+    int p99 = 0;
+};
+
+/**
+ * @struct LiveView
+ * @brief Reader's consistent copy of a snapshot.
+ */
+struct LiveView {
+    int pid = 0;
+    int cycle = 0;
+    int total_cycles = 0;
+    long long wall_ns = 0;
+    bool finished = false;
+    std::vector<LiveBalancerView> balancers;
+};
+
+/**
+ * @class LiveSnapshot
+ * @brief Writer side: creates the segment and publishes into it.
+ */
+class LiveSnapshot {
+private:
+
+    /** @brief Segment name passed to shm_open. */
+    std::string name;
+
+    /** @brief Mapped header, or null if creation failed. */
+    LiveHeader* header;
+
+    /** @brief Slots following the header. */
+    LiveBalancer* slots;
+
+    /** @brief Total bytes mapped. */
+    std::size_t mapped_bytes;
+
+public:
+
+    /**
+     * @brief Creates (or replaces) the segment and writes the names.
+     *
+     * @param name Segment name, such as /lbsim-live.
+     * @param nodes Switch node of each balancer.
+     * @param labels Label of each balancer.
+     * @param total_cycles Length of the run, for progress.
+     */
+    LiveSnapshot(const std::string& name, const std::vector<std::string>& nodes,
+                 const std::vector<std::string>& labels, int total_cycles);
+
+    /**
+     * @brief Unmaps and unlinks the segment.
+     */
+    ~LiveSnapshot();
+
+    LiveSnapshot(const LiveSnapshot&) = delete;
+    LiveSnapshot& operator=(const LiveSnapshot&) = delete;
+
+    /**
+     * @brief Returns whether the segment was created and mapped.
+     */
+    bool isValid() const;
+
+    /**
+     * @brief Starts a publish; readers retry until end() is called.
+     */
+    void begin() {
+        header->sequence.store(header->sequence.load(std::memory_order_relaxed) + 1,
+                               std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+
+    /**
+     * @brief Returns the slot of balancer @p index for relaxed stores.
+     */
+    LiveBalancer& slot(std::size_t index) {
+        return slots[index];
+    }
+
+    /**
+     * @brief Completes a publish.
+     *
+     * @param cycle Cycle the stored values belong to.
+     * @param finished Whether this is the last publish of the run.
+     */
+    void end(int cycle, bool finished);
+};
+
+/**
+ * @class LiveSnapshotReader
+ * @brief Reader side: attaches to a segment and copies snapshots.
+ */
+class LiveSnapshotReader {
+private:
+
+    /** @brief Mapped header, or null if not attached. */
+    const LiveHeader* header;
+
+    /** @brief Slots following the header. */
+    const LiveBalancer* slots;
+
+    /** @brief Total bytes mapped. */
+    std::size_t mapped_bytes;
+
+public:
+
+    /**
+     * @brief Maps the segment read-only.
+     *
+     * @param name Segment name used by the writer.
+     */
+    explicit LiveSnapshotReader(const std::string& name);
+
+    /**
+     * @brief Unmaps the segment.
+     */
+    ~LiveSnapshotReader();
+
+    LiveSnapshotReader(const LiveSnapshotReader&) = delete;
+    LiveSnapshotReader& operator=(const LiveSnapshotReader&) = delete;
+
+    /**
+     * @brief Returns whether a valid segment is mapped.
+     */
+    bool isAttached() const;
+
+    /**
+     * @brief Copies the latest complete snapshot.
+     *
+     * @param view Receives the copy.
+     * @return False if no consistent copy was obtained after many retries.
+     */
+    bool read(LiveView& view) const;
+};
\ No newline at end of file
@@ -4,8 +4,14 @@
  */
 
 #include "LoadBalancer.h"
+#include "Checkpoint.h"
 #include "IPAddress.h"
+#include "ServerScan.h"
 #include "Color.h"
+#include "Log.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <chrono>
 #include <iostream>
 #include <random>
 
@@ -13,11 +19,42 @@
  * @brief Constructor implementation.
  */
 LoadBalancer::LoadBalancer(int initial_servers, int num_wait_clock_cycles,
-                           const std::string& label)
- : label(label),
+                           const std::string& label,
+                           const std::vector<ServerProfile>& profiles,
+                           bool affinity_routing,
+                           const QueueConfig& queue_config,
+                           const AdmissionConfig& admission_config)
+ : busy_speed(0.0),
+   request_queue(queue_config),
+   label(label),
    last_scale_clock_cycle(0),
-   num_wait_clock_cycles(num_wait_clock_cycles) {
+   num_wait_clock_cycles(num_wait_clock_cycles),
+   server_profiles(profiles),
+   total_capacity(0.0),
+   busy_capacity_cycles(0.0),
+   total_capacity_cycles(0.0),
+   completed_requests(0),
+   published_surplus(0),
+   stolen_in(0),
+   stolen_out(0),
+   affinity_routing(affinity_routing),
+   affinity_spills(0),
+   retired_cache_hits(0),
+   retired_cache_misses(0),
+   queue_length_sum(0.0),
+   cycles_run(0),
+   admission(admission_config),
+   expired_count(0),
+   hedge_tracker(nullptr),
+   phase_timing(false),
+   scaling_ns(0),
+   arrivals(0),
+   scale_ups(0),
+   scale_downs(0) {
 
+    if (server_profiles.empty()) {
+        server_profiles.push_back(ServerProfile());
+    }
     for (int i = 0; i < initial_servers; i++) {
         addServer();
     }
@@ -27,16 +64,25 @@ LoadBalancer::LoadBalancer(int initial_servers, int num_wait_clock_cycles,
 /**
  * @brief Adds a new WebServer instance.
  *
- * Assigns a sequential ID and updates scaling thresholds.
+ * Assigns a sequential ID, picks the next profile in the mix and
+ * updates capacity and scaling thresholds.
  */
 void LoadBalancer::addServer() {
     int new_id = servers.size() + 1;
-    servers.emplace_back(new_id);
+    const ServerProfile& profile = server_profiles[servers.size() % server_profiles.size()];
+    servers.emplace_back(new_id, profile);
+    server_free_at.push_back(servers.back().getBusyUntil());
+    server_next_done.push_back(servers.back().getNextCompletion());
+    scan_mask.resize((servers.size() + 63) / 64);
+    total_capacity += servers.back().getCapacity();
     updateScalingThresholds();
+    rebuildServerTable();
 
-    std::cout << Color::GREEN << "[LOAD BALANCER ACTION";
-    if (!label.empty()) std::cout << " " << label;
-    std::cout << "] Added server with ID: " << new_id
+    logStream() << Color::GREEN << "[LOAD BALANCER ACTION";
+    if (!label.empty()) logStream() << " " << label;
+    logStream() << "] Added server with ID: " << new_id
+              << " (speed=" << servers.back().getSpeed()
+              << " slots=" << servers.back().getSlotCount() << ")"
               << " | Total servers: " << servers.size()
               << Color::RESET << "\n";
 }
@@ -47,62 +93,283 @@ void LoadBalancer::addServer() {
 void LoadBalancer::removeServer() {
     if (!servers.empty()) {
         int removed_id = servers.back().getId();
+        total_capacity -= servers.back().getCapacity();
+        retired_cache_hits += servers.back().getCacheHits();
+        retired_cache_misses += servers.back().getCacheMisses();
+        // in-flight work still finishes, so later stages see it on time
+        std::size_t drained = draining_requests.size();
+        servers.back().takeInFlight(draining_requests);
+        busy_speed -= (draining_requests.size() - drained) * servers.back().getSpeed();
         servers.pop_back();
+        server_free_at.pop_back();
+        server_next_done.pop_back();
+        scan_mask.resize((servers.size() + 63) / 64);
         updateScalingThresholds();
+        rebuildServerTable();
 
-        std::cout << Color::GREEN << "[LOAD BALANCER ACTION";
-        if (!label.empty()) std::cout << " " << label;
-        std::cout << "] Removed server with ID: " << removed_id
+        logStream() << Color::GREEN << "[LOAD BALANCER ACTION";
+        if (!label.empty()) logStream() << " " << label;
+        logStream() << "] Removed server with ID: " << removed_id
                   << " | Total servers: " << servers.size()
                   << Color::RESET << "\n";
     }
 }
 
 /**
- * @brief Updates scaling thresholds based on server count.
+ * @brief Updates scaling thresholds based on pool capacity.
  *
- * Thresholds are proportional to number of servers.
+ * Thresholds are proportional to total capacity, which equals the
+ * number of servers when every server uses the baseline profile.
  */
 void LoadBalancer::updateScalingThresholds() {
-    min_queue_size_for_scaling = 50 * servers.size();
-    max_queue_size_for_scaling = 80 * servers.size();
+    min_queue_size_for_scaling = static_cast<size_t>(50 * total_capacity);
+    max_queue_size_for_scaling = static_cast<size_t>(80 * total_capacity);
 }
 
 /**
- * @brief Assigns queued requests to available servers.
+ * @brief Rebuilds the Maglev table over server ids.
+ *
+ * Server ids are stable (removal always drops the newest server) and the
+ * table size is fixed, so a rebuild moves only about 1/(n+1) of the
+ * source IPs, nearly all of them to or from the added or removed server.
  */
-void LoadBalancer::assignRequests(int current_cycle) {
-    for (WebServer& server : servers) {
-        if (!server.isBusy(current_cycle) && !request_queue.empty()) {
-            Request& r = request_queue.front();
-            server.assignRequest(r, current_cycle);
-            request_queue.pop();
-
-            std::cout << Color::YELLOW << "[LOAD BALANCER ACTION";
-            if (!label.empty()) std::cout << " " << label;
-            std::cout << "] Assigned request to server "
-                      << server.getId()
-                      << " at cycle " << current_cycle
+void LoadBalancer::rebuildServerTable() {
+    if (!affinity_routing) return;
+
+    std::vector<unsigned int> ids;
+    ids.reserve(servers.size());
+    for (const WebServer& server : servers) {
+        ids.push_back(static_cast<unsigned int>(server.getId()));
+    }
+    server_table.build(ids);
+}
+
+/**
+ * @brief Records the request's response time and writes an assignment line.
+ *
+ * Completion time is known at assignment, so latency is recorded here
+ * rather than when the slot is released.
+ */
+void LoadBalancer::recordAssignment(const Request& request, const WebServer& server,
+                                    int slot, int current_cycle) {
+    int finish = server.getSlotBusyUntil(slot);
+    busy_speed += server.getSpeed();
+    stage_latency.record(finish - request.stage_arrival_cycle);
+
+    // earlier stages only contribute to the end-to-end time of the last one
+    if (!request.hasNextStage()) {
+        std::size_t c = static_cast<std::size_t>(std::max(request.priority, 0));
+        if (c >= latency_by_class.size()) latency_by_class.resize(c + 1);
+        latency_by_class[c].record(finish - request.arrival_cycle);
+        if (metrics.response_time != nullptr) metrics.response_time->observe(finish - request.arrival_cycle);
+
+        if (request.route_length > 1) {
+            std::size_t origin = request.route[0];
+            if (origin >= latency_by_route.size()) latency_by_route.resize(origin + 1);
+            latency_by_route[origin].record(finish - request.arrival_cycle);
+        }
+    }
+
+    logStream() << Color::YELLOW << "[LOAD BALANCER ACTION";
+    if (!label.empty()) logStream() << " " << label;
+    logStream() << "] Assigned request to server "
+              << server.getId() << " slot " << slot
+              << " at cycle " << current_cycle
+              << Color::RESET << "\n";
+}
+
+/**
+ * @brief Counts the server's completions and queues multi-stage requests
+ * for the Switch.
+ */
+void LoadBalancer::collectCompleted(WebServer& server, int current_cycle) {
+    int completed = server.completeRequests(current_cycle, forwarded_requests);
+    completed_requests += completed;
+    busy_speed -= completed * server.getSpeed();
+}
+
+/**
+ * @brief Refreshes the dense copies after the server's slots changed.
+ */
+void LoadBalancer::syncServer(std::size_t index) {
+    server_free_at[index] = servers[index].getBusyUntil();
+    server_next_done[index] = servers[index].getNextCompletion();
+}
+
+/**
+ * @brief Runs the vectorised compare over all servers.
+ */
+std::size_t LoadBalancer::scanServers(const std::vector<int>& cycles, int current_cycle) {
+    if (servers.empty()) return 0;
+    return scanAtMost(cycles.data(), servers.size(), current_cycle, scan_mask.data());
+}
+
+/**
+ * @brief Releases drained requests that have reached their finish cycle.
+ */
+void LoadBalancer::collectDrained(int current_cycle) {
+    if (draining_requests.empty()) return;
+
+    auto due = [current_cycle](const std::pair<int, Request>& entry) {
+        return current_cycle >= entry.first;
+    };
+    auto it = std::stable_partition(draining_requests.begin(), draining_requests.end(), due);
+    for (auto done = draining_requests.begin(); done != it; ++done) {
+        completed_requests++;
+        if (done->second.hasNextStage()) forwarded_requests.push_back(done->second);
+    }
+    draining_requests.erase(draining_requests.begin(), it);
+}
+
+/**
+ * @brief Removes an expired or cancelled head request.
+ *
+ * A request may start up to and including its deadline cycle. Expired
+ * requests are kept for the Switch; hedge losers are simply dropped.
+ */
+bool LoadBalancer::discardStaleHead(int current_cycle) {
+    Request& r = request_queue.front();
+
+    if (r.deadline >= 0 && current_cycle > r.deadline) {
+        if (logEnabled()) {
+            logStream() << Color::RED << "[LOAD BALANCER ACTION";
+            if (!label.empty()) logStream() << " " << label;
+            logStream() << "] Expired request from " << r.in.getString()
+                      << " | Waited " << current_cycle - r.arrival_cycle << " cycles"
                       << Color::RESET << "\n";
         }
+        expired_requests.push_back(r);
+        expired_count++;
+        request_queue.pop();
+        return true;
     }
+
+    if (r.hedged && hedge_tracker != nullptr && !hedge_tracker->tryStart(r.id, r.hedge_copy)) {
+        if (logEnabled()) {
+            logStream() << Color::RED << "[LOAD BALANCER ACTION";
+            if (!label.empty()) logStream() << " " << label;
+            logStream() << "] Cancelled hedged request from " << r.in.getString()
+                      << " | Other copy already started"
+                      << Color::RESET << "\n";
+        }
+        request_queue.pop();
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Retires finished slots of the servers a scan of server_next_done
+ * selects, in index order.
+ */
+void LoadBalancer::collectDueServers(int current_cycle) {
+    scanServers(server_next_done, current_cycle);
+    for (std::size_t w = 0; w < scan_mask.size(); w++) {
+        for (std::uint64_t bits = scan_mask[w]; bits != 0; bits &= bits - 1) {
+            std::size_t i = w * 64 + static_cast<std::size_t>(__builtin_ctzll(bits));
+            collectCompleted(servers[i], current_cycle);
+            syncServer(i);
+        }
+    }
+}
+
+/**
+ * @brief Assigns queued requests to available server slots.
+ *
+ * Also retires finished requests and accumulates utilisation. Expired
+ * and cancelled requests are discarded as they reach the head. Scans of
+ * the dense cycle arrays pick the servers to visit: first those with a
+ * slot finishing, then those with a free slot in index order until the
+ * queue runs dry.
+ */
+void LoadBalancer::assignRequests(int current_cycle) {
+    {
+        PROFILE_SCOPE(ProfilePhase::Completion);
+        collectDrained(current_cycle);
+        collectDueServers(current_cycle);
+    }
+    PROFILE_SCOPE(ProfilePhase::Assignment);
+
+    if (affinity_routing) {
+        assignRequestsByAffinity(current_cycle);
+        return;
+    }
+
+    if (!request_queue.empty()) {
+        scanServers(server_free_at, current_cycle);
+        for (std::size_t w = 0; w < scan_mask.size() && !request_queue.empty(); w++) {
+            for (std::uint64_t bits = scan_mask[w]; bits != 0 && !request_queue.empty(); bits &= bits - 1) {
+                std::size_t i = w * 64 + static_cast<std::size_t>(__builtin_ctzll(bits));
+                WebServer& server = servers[i];
+
+                while (!request_queue.empty() && !server.isBusy(current_cycle)) {
+                    if (discardStaleHead(current_cycle)) continue;
+                    Request& r = request_queue.front();
+                    int slot = server.assignRequest(r, current_cycle);
+                    recordAssignment(r, server, slot, current_cycle);
+                    request_queue.pop();
+                }
+                syncServer(i);
+            }
+        }
+    }
+
+    busy_capacity_cycles += busy_speed;
+    total_capacity_cycles += total_capacity;
+}
+
+/**
+ * @brief Assigns queued requests in FIFO order to their preferred servers.
+ *
+ * The head request goes to the server its source IP maps to in the Maglev
+ * table. If that server has no free slot the request spills to the first
+ * free server instead, so affinity never leaves capacity idle.
+ */
+void LoadBalancer::assignRequestsByAffinity(int current_cycle) {
+    // the mask tracks servers with a free slot; spills take the lowest
+    std::size_t free_servers = request_queue.empty() ? 0 : scanServers(server_free_at, current_cycle);
+    while (!request_queue.empty() && free_servers > 0) {
+        if (discardStaleHead(current_cycle)) continue;
+        Request& r = request_queue.front();
+        std::size_t target = static_cast<std::size_t>(server_table.lookup(r.in.getValue()));
+
+        if (server_free_at[target] > current_cycle) {
+            affinity_spills++;
+            target = firstSetBit(scan_mask.data(), servers.size());
+        }
+
+        int slot = servers[target].assignRequest(r, current_cycle);
+        recordAssignment(r, servers[target], slot, current_cycle);
+        request_queue.pop();
+        syncServer(target);
+        if (server_free_at[target] > current_cycle) {
+            scan_mask[target / 64] &= ~(std::uint64_t(1) << (target % 64));
+            free_servers--;
+        }
+    }
+
+    busy_capacity_cycles += busy_speed;
+    total_capacity_cycles += total_capacity;
 }
 
 /**
  * @brief Evaluates whether scaling up or down is necessary.
  */
 void LoadBalancer::maybeScale(int current_cycle) {
+    PROFILE_SCOPE(ProfilePhase::Scaling);
     if (!(current_cycle - last_scale_clock_cycle < num_wait_clock_cycles)) {
 
         std::size_t queue_size = request_queue.size();
 
         if (queue_size > max_queue_size_for_scaling) {
             addServer();
+            scale_ups++;
             last_scale_clock_cycle = current_cycle;
 
         } else if (queue_size < min_queue_size_for_scaling &&
                    servers.size() > 1) {
             removeServer();
+            scale_downs++;
             last_scale_clock_cycle = current_cycle;
         }
     }
@@ -112,7 +379,118 @@ void LoadBalancer::maybeScale(int current_cycle) {
  * @brief Adds a request to the internal queue.
  */
 void LoadBalancer::addRequest(Request& request) {
+    arrivals++;
+    request_queue.push(request);
+}
+
+/**
+ * @brief Queues the request if admission control accepts it.
+ *
+ * Queueing delay is measured on the next request to be served, from the
+ * cycle it joined this queue: a retry or a later stage of a multi-stage
+ * request has not been waiting here since it first arrived at the switch.
+ */
+bool LoadBalancer::offerRequest(Request& request, int current_cycle, double uniform) {
+    arrivals++;
+    std::size_t queue_size = request_queue.size();
+    int head_sojourn = request_queue.empty() ? 0
+                       : current_cycle - request_queue.front().stage_arrival_cycle;
+
+    if (!admission.admit(queue_size, head_sojourn, current_cycle, uniform)) {
+        if (logEnabled()) {
+            logStream() << Color::RED << "[LOAD BALANCER ACTION";
+            if (!label.empty()) logStream() << " " << label;
+            logStream() << "] Rejected request from " << request.in.getString()
+                      << " | Queue size: " << queue_size
+                      << Color::RESET << "\n";
+        }
+        return false;
+    }
+
     request_queue.push(request);
+    return true;
+}
+
+/**
+ * @brief Returns rejected arrivals.
+ */
+long long LoadBalancer::getRejectedCount() const {
+    return admission.getRejectedCount();
+}
+
+/**
+ * @brief Stores the shared hedge registry.
+ */
+void LoadBalancer::setHedgeTracker(HedgeTracker* tracker) {
+    hedge_tracker = tracker;
+}
+
+/**
+ * @brief Stores the timing switch.
+ */
+void LoadBalancer::setPhaseTiming(bool enabled) {
+    phase_timing = enabled;
+}
+
+/**
+ * @brief Returns the accumulated scaling time.
+ */
+long long LoadBalancer::getScalingNs() const {
+    return scaling_ns;
+}
+
+/**
+ * @brief Response times use the same cycle units as the summary histograms.
+ */
+void LoadBalancer::registerMetrics(MetricsRegistry& registry, const std::string& labels) {
+    static const std::vector<double> RESPONSE_BOUNDS = {1, 2, 5, 10, 20, 50, 100, 200, 500, 1000};
+    metrics.queue_depth = &registry.gauge("lb_queue_depth", "Requests waiting in the balancer queue.", labels);
+    metrics.servers = &registry.gauge("lb_servers", "Servers in the balancer pool.", labels);
+    metrics.utilisation = &registry.gauge("lb_utilisation", "Busy fraction of the pool's capacity so far.", labels);
+    metrics.arrivals = &registry.counter("lb_arrivals_total", "Requests queued at or offered to the balancer.", labels);
+    metrics.rejected = &registry.counter("lb_rejected_total", "Arrivals refused by admission control.", labels);
+    metrics.expired = &registry.counter("lb_expired_total", "Queued requests dropped past their deadline.", labels);
+    metrics.completed = &registry.counter("lb_completed_total", "Requests that finished processing.", labels);
+    metrics.response_time = &registry.histogram("lb_response_time_cycles",
+                                                "End-to-end response time of requests started here, in cycles.",
+                                                labels, RESPONSE_BOUNDS);
+    publishMetrics();
+}
+
+/**
+ * @brief Plain stores of values the balancer already keeps.
+ */
+void LoadBalancer::publishMetrics() {
+    metrics.queue_depth->set(static_cast<double>(request_queue.size()));
+    metrics.servers->set(static_cast<double>(servers.size()));
+    metrics.utilisation->set(getUtilisation());
+    metrics.arrivals->set(static_cast<std::uint64_t>(arrivals));
+    metrics.rejected->set(static_cast<std::uint64_t>(admission.getRejectedCount()));
+    metrics.expired->set(static_cast<std::uint64_t>(expired_count));
+    metrics.completed->set(static_cast<std::uint64_t>(completed_requests));
+}
+
+/**
+ * @brief Hands expired requests to the caller and clears the outbox.
+ */
+void LoadBalancer::takeExpiredRequests(std::vector<Request>& out) {
+    out.insert(out.end(), expired_requests.begin(), expired_requests.end());
+    expired_requests.clear();
+}
+
+/**
+ * @brief Returns expired request count.
+ */
+long long LoadBalancer::getExpiredCount() const {
+    return expired_count;
+}
+
+/**
+ * @brief Hands forwarded requests to the caller and clears the outbox.
+ */
+void LoadBalancer::takeForwardedRequests(std::vector<Request>& out) {
+    out.insert(out.end(), forwarded_requests.begin(), forwarded_requests.end());
+    forwarded_requests.clear();
 }
 
 /**
@@ -120,7 +498,18 @@ void LoadBalancer::addRequest(Request& request) {
  */
 void LoadBalancer::goThroughClockCycle(int current_cycle) {
     assignRequests(current_cycle);
-    maybeScale(current_cycle);
+    if (phase_timing) {
+        auto start = std::chrono::steady_clock::now();
+        maybeScale(current_cycle);
+        scaling_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count();
+    } else {
+        maybeScale(current_cycle);
+    }
+
+    queue_length_sum += request_queue.size();
+    cycles_run++;
+    if (metrics.completed != nullptr) publishMetrics();
 }
 
 /**
@@ -130,6 +519,155 @@ std::size_t LoadBalancer::getQueueSize() {
     return request_queue.size();
 }
 
+/**
+ * @brief Returns the queue's spill counters.
+ */
+SpillStats LoadBalancer::getQueueSpillStats() const {
+    return request_queue.getSpillStats();
+}
+
+/**
+ * @brief Returns cache hits of current and removed servers.
+ */
+long long LoadBalancer::getCacheHits() const {
+    long long hits = retired_cache_hits;
+    for (const WebServer& server : servers) hits += server.getCacheHits();
+    return hits;
+}
+
+/**
+ * @brief Returns cache misses of current and removed servers.
+ */
+long long LoadBalancer::getCacheMisses() const {
+    long long misses = retired_cache_misses;
+    for (const WebServer& server : servers) misses += server.getCacheMisses();
+    return misses;
+}
+
+/**
+ * @brief Returns affinity spill count.
+ */
+long long LoadBalancer::getAffinitySpills() const {
+    return affinity_spills;
+}
+
+/**
+ * @brief Returns the time-averaged queue size.
+ */
+double LoadBalancer::getAverageQueueSize() const {
+    if (cycles_run == 0) return 0.0;
+    return queue_length_sum / cycles_run;
+}
+
+/**
+ * @brief Returns per-class response-time histograms.
+ */
+const std::vector<LatencyHistogram>& LoadBalancer::getLatencyByClass() const {
+    return latency_by_class;
+}
+
+/**
+ * @brief Returns the per-stage histogram.
+ */
+const LatencyHistogram& LoadBalancer::getStageLatency() const {
+    return stage_latency;
+}
+
+/**
+ * @brief Returns the end-to-end histograms by route origin.
+ */
+const std::vector<LatencyHistogram>& LoadBalancer::getLatencyByRoute() const {
+    return latency_by_route;
+}
+
+/**
+ * @brief Sums free slots over all servers.
+ */
+int LoadBalancer::getIdleSlots(int current_cycle) const {
+    int idle = 0;
+    for (const WebServer& server : servers) {
+        idle += server.getSlotCount() - server.getBusySlots(current_cycle);
+    }
+    return idle;
+}
+
+/**
+ * @brief Publishes requests beyond this cycle's free slots for stealing.
+ *
+ * Requests are taken from the end of service order, last first, so thieves
+ * receive the work that would otherwise wait longest here.
+ */
+std::size_t LoadBalancer::publishSurplus(int current_cycle, std::size_t max_requests) {
+    std::size_t idle = static_cast<std::size_t>(getIdleSlots(current_cycle));
+    std::size_t queued = request_queue.size();
+    if (queued <= idle) return 0;
+
+    std::size_t surplus = std::min(queued - idle, max_requests);
+    steal_deque.reserve(surplus);
+    surplus_requests.clear();
+    request_queue.popBack(surplus, surplus_requests);
+    for (const Request& request : surplus_requests) steal_deque.pushBottom(request);
+    published_surplus = surplus;
+    return surplus;
+}
+
+/**
+ * @brief Steals published surplus from a sibling into this balancer's queue.
+ */
+std::size_t LoadBalancer::stealFrom(LoadBalancer& victim, std::size_t max_requests) {
+    std::size_t stolen = 0;
+    Request r;
+
+    // a failed steal with work remaining means another thief won the race
+    while (stolen < max_requests && victim.steal_deque.size() > 0) {
+        if (victim.steal_deque.steal(r)) {
+            request_queue.push(r);
+            stolen++;
+        }
+    }
+
+    if (stolen > 0) {
+        stolen_in += stolen;
+        logStream() << Color::YELLOW << "[LOAD BALANCER ACTION";
+        if (!label.empty()) logStream() << " " << label;
+        logStream() << "] Stole " << stolen << " request(s) from balancer "
+                  << victim.getLabel() << Color::RESET << "\n";
+    }
+    return stolen;
+}
+
+/**
+ * @brief Pops leftover surplus back onto the queue.
+ *
+ * The oldest published request sits at the bottom of the deque, so popping
+ * from the bottom restores the original FIFO order.
+ */
+std::size_t LoadBalancer::reclaimSurplus() {
+    std::size_t reclaimed = 0;
+    Request r;
+    while (steal_deque.popBottom(r)) {
+        request_queue.push(r);
+        reclaimed++;
+    }
+    stolen_out += static_cast<long long>(published_surplus - reclaimed);
+    published_surplus = 0;
+    return reclaimed;
+}
+
+/**
+ * @brief Returns requests stolen from siblings.
+ */
+long long LoadBalancer::getStolenInCount() const {
+    return stolen_in;
+}
+
+/**
+ * @brief Returns requests stolen by siblings.
+ */
+long long LoadBalancer::getStolenOutCount() const {
+    return stolen_out;
+}
+
 /**
  * @brief Returns number of servers.
  */
@@ -137,9 +675,157 @@ int LoadBalancer::getServerCount() {
     return static_cast<int>(servers.size());
 }
 
+/**
+ * @brief Returns total pool capacity.
+ */
+double LoadBalancer::getCapacity() const {
+    return total_capacity;
+}
+
+/**
+ * @brief Returns busy capacity-cycles over available capacity-cycles.
+ */
+double LoadBalancer::getUtilisation() const {
+    if (total_capacity_cycles <= 0.0) return 0.0;
+    return busy_capacity_cycles / total_capacity_cycles;
+}
+
+/**
+ * @brief Returns the number of completed requests.
+ */
+long long LoadBalancer::getCompletedCount() const {
+    return completed_requests;
+}
+
+/**
+ * @brief Returns the arrival count.
+ */
+long long LoadBalancer::getArrivalCount() const {
+    return arrivals;
+}
+
+/**
+ * @brief Returns the scale-up count.
+ */
+long long LoadBalancer::getScaleUpCount() const {
+    return scale_ups;
+}
+
+/**
+ * @brief Returns the scale-down count.
+ */
+long long LoadBalancer::getScaleDownCount() const {
+    return scale_downs;
+}
+
 /**
  * @brief Returns label identifier.
  */
 std::string LoadBalancer::getLabel() {
     return label;
+}
+
+/**
+ * @brief Label first, so a restore can tell it is reading the right balancer.
+ */
+void LoadBalancer::save(CheckpointWriter& out) const {
+    out.putTag("LBAL");
+    out.putText(label);
+    out.put<std::uint64_t>(servers.size());
+    for (const WebServer& server : servers) server.save(out);
+    out.put(busy_speed);
+    request_queue.save(out);
+    out.put(last_scale_clock_cycle);
+    out.put(total_capacity);
+    out.put(busy_capacity_cycles);
+    out.put(total_capacity_cycles);
+    out.put(completed_requests);
+    out.put(stolen_in);
+    out.put(stolen_out);
+    out.put(affinity_spills);
+    out.put(retired_cache_hits);
+    out.put(retired_cache_misses);
+    out.put(queue_length_sum);
+    out.put(cycles_run);
+
+    out.put<std::uint64_t>(latency_by_class.size());
+    for (const LatencyHistogram& histogram : latency_by_class) histogram.save(out);
+    stage_latency.save(out);
+    out.put<std::uint64_t>(latency_by_route.size());
+    for (const LatencyHistogram& histogram : latency_by_route) histogram.save(out);
+
+    out.putVector(forwarded_requests);
+    out.put<std::uint64_t>(draining_requests.size());
+    for (const std::pair<int, Request>& entry : draining_requests) {
+        out.put(entry.first);
+        out.put(entry.second);
+    }
+    admission.save(out);
+    out.putVector(expired_requests);
+    out.put(expired_count);
+    out.put(arrivals);
+    out.put(scale_ups);
+    out.put(scale_downs);
+}
+
+/**
+ * @brief Reads the fields in save() order, then rebuilds what is derived
+ * from the servers: dense cycle arrays, scan mask, thresholds and the
+ * affinity table.
+ */
+void LoadBalancer::restore(CheckpointReader& in) {
+    in.expectTag("LBAL");
+    std::string saved_label = in.getText();
+    if (in.ok() && saved_label != label) {
+        in.fail("balancer " + saved_label + " found where " + label + " was expected");
+        return;
+    }
+
+    std::uint64_t server_count = in.get<std::uint64_t>();
+    servers.clear();
+    for (std::uint64_t i = 0; i < server_count && in.ok(); i++) {
+        servers.emplace_back(static_cast<int>(i + 1));
+        servers.back().restore(in);
+    }
+    in.get(busy_speed);
+    request_queue.restore(in);
+    in.get(last_scale_clock_cycle);
+    in.get(total_capacity);
+    in.get(busy_capacity_cycles);
+    in.get(total_capacity_cycles);
+    in.get(completed_requests);
+    in.get(stolen_in);
+    in.get(stolen_out);
+    in.get(affinity_spills);
+    in.get(retired_cache_hits);
+    in.get(retired_cache_misses);
+    in.get(queue_length_sum);
+    in.get(cycles_run);
+
+    latency_by_class.assign(static_cast<std::size_t>(in.get<std::uint64_t>()), LatencyHistogram());
+    for (LatencyHistogram& histogram : latency_by_class) histogram.restore(in);
+    stage_latency.restore(in);
+    latency_by_route.assign(static_cast<std::size_t>(in.get<std::uint64_t>()), LatencyHistogram());
+    for (LatencyHistogram& histogram : latency_by_route) histogram.restore(in);
+
+    in.getVector(forwarded_requests);
+    draining_requests.clear();
+    std::uint64_t draining = in.get<std::uint64_t>();
+    for (std::uint64_t i = 0; i < draining && in.ok(); i++) {
+        int finish = in.get<int>();
+        draining_requests.emplace_back(finish, in.get<Request>());
+    }
+    admission.restore(in);
+    in.getVector(expired_requests);
+    in.get(expired_count);
+    in.get(arrivals);
+    in.get(scale_ups);
+    in.get(scale_downs);
+
+    server_free_at.assign(servers.size(), 0);
+    server_next_done.assign(servers.size(), 0);
+    for (std::size_t i = 0; i < servers.size(); i++) syncServer(i);
+    scan_mask.assign((servers.size() + 63) / 64, 0);
+    updateScalingThresholds();
+    rebuildServerTable();
 }
\ No newline at end of file
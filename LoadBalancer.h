@@ -7,20 +7,53 @@
  * - A RequestQueue for incoming requests
  * - Dynamic scaling based on queue size
  * - Assignment of requests per clock cycle
+ * - Capacity and utilisation accounting for heterogeneous servers
+ * - Dense per-server free/finish cycles scanned with SIMD each cycle
+ * - Work stealing between sibling balancers of the same job type
+ * - Optional source-IP affinity via a Maglev table over its servers
+ * - Response-time histograms per request priority class
+ * - Admission control (capacity limit, RED or CoDel) for new arrivals
+ * - Expiry of requests past their deadline and cancellation of hedge losers
+ * - Hand-off of requests that finished a stage and continue elsewhere
+ * - Optional export of its counters to a MetricsRegistry once per cycle
  */
 
 #pragma once
 #include "WebServer.h"
 #include "RequestQueue.h"
+#include "ChaseLevDeque.h"
+#include "MaglevTable.h"
+#include "LatencyHistogram.h"
+#include "AdmissionControl.h"
+#include "HedgeTracker.h"
+#include "Metrics.h"
+#include <cstdint>
+#include <utility>
 #include <vector>
 
+/**
+ * @struct BalancerMetrics
+ * @brief Series one balancer exports; all null when metrics are off.
+ */
+struct BalancerMetrics {
+    MetricGauge* queue_depth = nullptr;
+    MetricGauge* servers = nullptr;
+    MetricGauge* utilisation = nullptr;
+    MetricCounter* arrivals = nullptr;
+    MetricCounter* rejected = nullptr;
+    MetricCounter* expired = nullptr;
+    MetricCounter* completed = nullptr;
+    MetricHistogram* response_time = nullptr;
+};
+
 /**
  * @class LoadBalancer
  * @brief Simulates a load balancer that distributes requests to servers.
  *
  * The LoadBalancer:
- * - Maintains a pool of WebServers
- * - Assigns requests in FIFO order
+ * - Maintains a pool of WebServers, possibly of mixed ServerProfiles
+ * - Assigns requests to free server slots in the order chosen by the
+ *   queue's scheduling discipline
  * - Dynamically scales servers up or down
  * - Operates on discrete clock cycles
  */
@@ -30,6 +63,28 @@ private:
     /** @brief Collection of managed WebServer instances. */
     std::vector<WebServer> servers;
 
+    /**
+     * @brief Per server (same index as servers), the cycle its first slot
+     * frees up (WebServer::getBusyUntil). Kept dense so a cycle finds the
+     * servers that can take work without touching the WebServer objects.
+     */
+    std::vector<int> server_free_at;
+
+    /**
+     * @brief Per server, the cycle its first occupied slot finishes
+     * (WebServer::getNextCompletion, INT_MAX when idle).
+     */
+    std::vector<int> server_next_done;
+
+    /** @brief Bitmask of servers selected by the latest scan. */
+    std::vector<std::uint64_t> scan_mask;
+
+    /**
+     * @brief Speed summed over occupied slots. Finished slots are collected
+     * before utilisation is sampled, so this equals the busy capacity.
+     */
+    double busy_speed;
+
     /** @brief Queue storing incoming requests. */
     RequestQueue request_queue;
 
@@ -60,6 +115,199 @@ private:
     /** @brief Upper queue threshold for scaling up. */
     size_t max_queue_size_for_scaling;
 
+    /**
+     * @brief Server types to cycle through when adding servers.
+     * The n-th server added uses server_profiles[n % size].
+     */
+    std::vector<ServerProfile> server_profiles;
+
+    /** @brief Sum of getCapacity() over all servers. */
+    double total_capacity;
+
+    /** @brief Capacity-weighted busy slot-cycles accumulated so far. */
+    double busy_capacity_cycles;
+
+    /** @brief Capacity-cycles available so far (busy or idle). */
+    double total_capacity_cycles;
+
+    /** @brief Number of requests that finished processing. */
+    long long completed_requests;
+
+    /**
+     * @brief Surplus requests exposed to sibling balancers during a steal phase.
+     * Only this balancer pushes and pops; thieves steal from the other end.
+     */
+    ChaseLevDeque<Request> steal_deque;
+
+    /** @brief Number of requests moved into steal_deque this phase. */
+    std::size_t published_surplus;
+
+    /** @brief Scratch buffer for the requests taken off the queue's tail. */
+    std::vector<Request> surplus_requests;
+
+    /** @brief Requests this balancer stole from siblings. */
+    long long stolen_in;
+
+    /** @brief Requests siblings stole from this balancer. */
+    long long stolen_out;
+
+    /**
+     * @brief Whether requests prefer the server chosen by server_table.
+     */
+    bool affinity_routing;
+
+    /**
+     * @brief Maglev table mapping source IPs to server indices.
+     * Rebuilt whenever the pool changes; empty unless affinity_routing is set.
+     */
+    MaglevTable server_table;
+
+    /** @brief Affinity requests served by a server other than their preferred one. */
+    long long affinity_spills;
+
+    /** @brief Cache hits of servers that have since been removed. */
+    long long retired_cache_hits;
+
+    /** @brief Cache misses of servers that have since been removed. */
+    long long retired_cache_misses;
+
+    /** @brief Sum of queue sizes sampled once per cycle. */
+    double queue_length_sum;
+
+    /** @brief Number of cycles this balancer has run. */
+    long long cycles_run;
+
+    /**
+     * @brief Response time (arrival to completion) per priority class,
+     * recorded for requests whose last stage ran here.
+     */
+    std::vector<LatencyHistogram> latency_by_class;
+
+    /**
+     * @brief Time from entering this balancer's stage to finishing it,
+     * recorded for every request.
+     */
+    LatencyHistogram stage_latency;
+
+    /**
+     * @brief End-to-end response time of multi-stage requests that
+     * finished here, indexed by the job class of their first stage.
+     */
+    std::vector<LatencyHistogram> latency_by_route;
+
+    /**
+     * @brief Requests that finished a stage here and continue at another
+     * balancer class. Drained by the Switch each cycle.
+     */
+    std::vector<Request> forwarded_requests;
+
+    /**
+     * @brief In-flight requests of removed servers with their finish cycles.
+     */
+    std::vector<std::pair<int, Request>> draining_requests;
+
+    /** @brief Decides which arrivals may join request_queue. */
+    AdmissionControl admission;
+
+    /**
+     * @brief Requests dropped at dequeue because their deadline had passed.
+     * Drained by the Switch each cycle so clients can retry.
+     */
+    std::vector<Request> expired_requests;
+
+    /** @brief Total requests expired at dequeue. */
+    long long expired_count;
+
+    /**
+     * @brief Shared registry deciding which copy of a hedged request runs.
+     * Owned by the Switch; null when hedging is off.
+     */
+    HedgeTracker* hedge_tracker;
+
+    /** @brief Whether goThroughClockCycle() times its scaling step. */
+    bool phase_timing;
+
+    /** @brief Nanoseconds spent in maybeScale() while phase_timing was set. */
+    long long scaling_ns;
+
+    /** @brief Requests queued or offered, including preloaded ones. */
+    long long arrivals;
+
+    /** @brief Servers added and removed by maybeScale(). */
+    long long scale_ups;
+    long long scale_downs;
+
+    /** @brief Exported series, written at the end of each cycle. */
+    BalancerMetrics metrics;
+
+    /** @brief Copies the current counters and gauges into metrics. */
+    void publishMetrics();
+
+    /**
+     * @brief Drops the head request if it expired or lost its hedge race.
+     *
+     * Must only be called when a server slot is free, since a winning
+     * hedged request is marked as started.
+     *
+     * @param current_cycle Current simulation clock cycle.
+     * @return True if the head was removed and the caller should look again.
+     */
+    bool discardStaleHead(int current_cycle);
+
+    /**
+     * @brief Retires a server's finished requests and collects the ones
+     * with another stage, including work drained from removed servers.
+     * @param server Server to poll.
+     * @param current_cycle Current simulation clock cycle.
+     */
+    void collectCompleted(WebServer& server, int current_cycle);
+
+    /**
+     * @brief Copies one server's free and finish cycles into the dense arrays.
+     * @param index Index of the server in servers.
+     */
+    void syncServer(std::size_t index);
+
+    /**
+     * @brief Scans a dense cycle array into scan_mask.
+     * @param cycles server_free_at or server_next_done.
+     * @param current_cycle Current simulation clock cycle.
+     * @return Number of servers whose entry is at most current_cycle.
+     */
+    std::size_t scanServers(const std::vector<int>& cycles, int current_cycle);
+
+    /**
+     * @brief Retires finished requests of every server with a slot due.
+     * @param current_cycle Current simulation clock cycle.
+     */
+    void collectDueServers(int current_cycle);
+
+    /**
+     * @brief Completes drained requests whose finish cycle has been reached.
+     * @param current_cycle Current simulation clock cycle.
+     */
+    void collectDrained(int current_cycle);
+
+    /** @brief Rebuilds server_table from the current server ids. */
+    void rebuildServerTable();
+
+    /**
+     * @brief Logs a request assignment and records its response time.
+     * @param request Request that was assigned.
+     * @param server Server that received the request.
+     * @param slot Slot index used on that server.
+     * @param current_cycle Current simulation clock cycle.
+     */
+    void recordAssignment(const Request& request, const WebServer& server,
+                          int slot, int current_cycle);
+
+    /**
+     * @brief Assigns queued requests to their Maglev-preferred servers,
+     * spilling to any free server when the preferred one is full.
+     * @param current_cycle Current simulation clock cycle.
+     */
+    void assignRequestsByAffinity(int current_cycle);
+
     /** @brief Adds a new WebServer to the pool. */
     void addServer();
 
@@ -81,6 +329,9 @@ private:
      */
     void maybeScale(int current_cycle);
 
+    /** @brief Lets the microbenchmarks (MicroBench.cpp) time private hot paths. */
+    friend struct BenchAccess;
+
 public:
 
     /**
@@ -89,17 +340,108 @@ public:
      * @param initial_servers Number of servers to initialize.
      * @param num_wait_clock_cycles Cooldown period before scaling again.
      * @param label Optional identifier for logging.
+     * @param profiles Server types to mix; empty means baseline 1x1 servers.
+     * @param affinity_routing Route each request to a server by source IP.
+     * @param queue_config Scheduling discipline of the request queue.
+     * @param admission_config Queue capacity limit and admission policy.
      */
     LoadBalancer(int initial_servers, int num_wait_clock_cycles,
-                 const std::string& label = "");
+                 const std::string& label = "",
+                 const std::vector<ServerProfile>& profiles = {},
+                 bool affinity_routing = false,
+                 const QueueConfig& queue_config = QueueConfig(),
+                 const AdmissionConfig& admission_config = AdmissionConfig());
 
     /**
-     * @brief Adds a new incoming request to the queue.
+     * @brief Adds a new incoming request to the queue unconditionally.
      *
      * @param request Request to enqueue.
      */
     void addRequest(Request& request);
 
+    /**
+     * @brief Offers an arriving request to the queue's admission control.
+     *
+     * @param request Request to enqueue if admitted.
+     * @param current_cycle Current simulation clock cycle.
+     * @param uniform Random draw in [0, 1) for probabilistic policies.
+     * @return True if the request was queued, false if it was rejected.
+     */
+    bool offerRequest(Request& request, int current_cycle, double uniform);
+
+    /**
+     * @brief Returns the number of arrivals rejected by admission control.
+     */
+    long long getRejectedCount() const;
+
+    /**
+     * @brief Sets the registry consulted before starting a hedged request.
+     *
+     * @param tracker Registry shared by all balancers, or null.
+     */
+    void setHedgeTracker(HedgeTracker* tracker);
+
+    /**
+     * @brief Turns timing of the scaling step on or off.
+     *
+     * @param enabled True to accumulate getScalingNs() from now on.
+     */
+    void setPhaseTiming(bool enabled);
+
+    /**
+     * @brief Returns nanoseconds spent deciding and applying scaling while
+     * phase timing was on.
+     */
+    long long getScalingNs() const;
+
+    /**
+     * @brief Registers this balancer's series and starts updating them.
+     *
+     * @param registry Registry that owns the series; must outlive the run.
+     * @param labels metricLabel() pairs identifying the balancer.
+     */
+    void registerMetrics(MetricsRegistry& registry, const std::string& labels);
+
+    /**
+     * @brief Appends the pool, queue, scaling state and counters to a checkpoint.
+     *
+     * Must be called between cycles, when no steal phase is in progress.
+     *
+     * @param out Checkpoint being written.
+     */
+    void save(CheckpointWriter& out) const;
+
+    /**
+     * @brief Replaces the pool, queue, scaling state and counters with
+     * those read from a checkpoint.
+     *
+     * The label, queue discipline, cooldown and server profiles of later
+     * additions stay as configured, so a restored run can change the
+     * autoscaler while keeping the warmed-up pool.
+     *
+     * @param in Checkpoint being read.
+     */
+    void restore(CheckpointReader& in);
+
+    /**
+     * @brief Moves requests that expired since the last call into @p out.
+     *
+     * @param out Vector the expired requests are appended to.
+     */
+    void takeExpiredRequests(std::vector<Request>& out);
+
+    /**
+     * @brief Returns the number of requests dropped past their deadline.
+     */
+    long long getExpiredCount() const;
+
+    /**
+     * @brief Moves requests that finished a stage since the last call into @p out.
+     *
+     * @param out Vector the forwarded requests are appended to.
+     */
+    void takeForwardedRequests(std::vector<Request>& out);
+
     /**
      * @brief Executes one clock cycle of simulation.
      *
@@ -116,11 +458,133 @@ public:
      */
     std::size_t getQueueSize();
 
+    /**
+     * @brief Returns the queue's traffic to and from its spill file.
+     */
+    SpillStats getQueueSpillStats() const;
+
+    /**
+     * @brief Returns the number of server slots free at the given cycle.
+     *
+     * @param current_cycle Current simulation clock cycle.
+     */
+    int getIdleSlots(int current_cycle) const;
+
+    /** @name Work stealing
+     *
+     * A steal phase runs in three steps, each of which may execute on a
+     * different thread per balancer: the victim publishes its surplus,
+     * thieves steal from it, then the victim reclaims whatever was left.
+     */
+    ///@{
+
+    /**
+     * @brief Moves requests this balancer cannot start this cycle from the
+     * tail of its queue into its steal deque.
+     *
+     * @param current_cycle Current simulation clock cycle.
+     * @param max_requests Upper bound on requests to publish.
+     * @return Number of requests published.
+     */
+    std::size_t publishSurplus(int current_cycle, std::size_t max_requests);
+
+    /**
+     * @brief Steals up to @p max_requests from a sibling's published surplus.
+     *
+     * @param victim Balancer that called publishSurplus() this phase.
+     * @param max_requests Upper bound on requests to steal.
+     * @return Number of requests stolen.
+     */
+    std::size_t stealFrom(LoadBalancer& victim, std::size_t max_requests);
+
+    /**
+     * @brief Returns unstolen surplus to the tail of the queue in original order.
+     *
+     * @return Number of requests reclaimed.
+     */
+    std::size_t reclaimSurplus();
+
+    /** @brief Returns requests this balancer stole from siblings. */
+    long long getStolenInCount() const;
+
+    /** @brief Returns requests siblings stole from this balancer. */
+    long long getStolenOutCount() const;
+
+    ///@}
+
     /**
      * @brief Returns number of active servers.
      */
     int getServerCount();
 
+    /**
+     * @brief Returns total capacity of the pool in baseline-server units.
+     */
+    double getCapacity() const;
+
+    /**
+     * @brief Returns the capacity-weighted fraction of time servers were busy.
+     *
+     * @return Value in [0, 1], or 0 before any cycle has run.
+     */
+    double getUtilisation() const;
+
+    /**
+     * @brief Returns the number of requests that finished processing.
+     */
+    long long getCompletedCount() const;
+
+    /**
+     * @brief Returns requests queued or offered, including preloaded ones.
+     */
+    long long getArrivalCount() const;
+
+    /**
+     * @brief Returns servers added by scaling.
+     */
+    long long getScaleUpCount() const;
+
+    /**
+     * @brief Returns servers removed by scaling.
+     */
+    long long getScaleDownCount() const;
+
+    /**
+     * @brief Returns client cache hits across current and removed servers.
+     */
+    long long getCacheHits() const;
+
+    /**
+     * @brief Returns client cache misses across current and removed servers.
+     */
+    long long getCacheMisses() const;
+
+    /**
+     * @brief Returns affinity requests that could not use their preferred server.
+     */
+    long long getAffinitySpills() const;
+
+    /**
+     * @brief Returns the queue size averaged over all cycles run.
+     */
+    double getAverageQueueSize() const;
+
+    /**
+     * @brief Returns response-time histograms indexed by priority class.
+     */
+    const std::vector<LatencyHistogram>& getLatencyByClass() const;
+
+    /**
+     * @brief Returns the histogram of time spent in this balancer's stage.
+     */
+    const LatencyHistogram& getStageLatency() const;
+
+    /**
+     * @brief Returns end-to-end histograms of multi-stage requests indexed
+     * by the job class of their first stage.
+     */
+    const std::vector<LatencyHistogram>& getLatencyByRoute() const;
+
     /**
      * @brief Returns label associated with this LoadBalancer.
      */
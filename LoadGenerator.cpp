@@ -0,0 +1,594 @@
+/**
+ * @file LoadGenerator.cpp
+ * @brief Open-loop load generator for the live proxy mode.
+ *
+ * Replays a workload as real TCP connections to 127.0.0.1: one
+ * connection per request, which sends the request's payload, shuts down
+ * its write side and reads the echo until the end of stream. Requests of
+ * job class c go to port base + c, the layout the live proxy listens on.
+ *
+ * The workload is either
+ * - synthetic, built from switch.cfg like the simulator's generator: class
+ *   shares, client pool and flooding sources (as 127.x.y.z addresses, so
+ *   blocklists and rate limits apply), the load curve's rate steps, and a
+ *   payload of bytes_per_cycle per cycle of the request time range, with
+ *   Poisson arrivals at --rate; or
+ * - a JSON-lines trace (--trace), one request per line with optional
+ *   fields "at_us", "class" (name or index), "bytes" and "source". Lines
+ *   without "at_us" arrive at --rate; lines without "bytes" send the line
+ *   itself, so any JSON-lines file can be replayed.
+ *
+ * All I/O goes through one io_uring instance set up with raw system calls:
+ * connect, send and shutdown are submitted as a linked chain, the reply is
+ * read by a multishot receive into provided buffers, and everything
+ * prepared in one pass of the loop is submitted with a single
+ * io_uring_enter().
+ *
+ * Pacing is open-loop: arrival times are fixed before the run, and a
+ * request's latency is measured from its scheduled time, so a stalled
+ * target is charged for the requests it delayed instead of quietly
+ * lowering the offered rate (coordinated omission). The service time from
+ * the actual start is reported alongside. Both use the simulator's
+ * LatencyHistogram, in microseconds.
+ *
+ * With --stub the generator starts its own echo backend and sends every
+ * class to it, so the client side can be measured without the proxy.
+ *
+ * Failed requests include connections the switch closed unanswered
+ * (blocked or rate-limited sources).
+ *
+ * Usage:
+ *   ./loadgen [--config switch.cfg] [--trace file.jsonl] [--rate req/s]
+ *             [--seconds s] [--connections n] [--bytes-per-cycle n]
+ *             [--port base] [--stub] [--delay-us n] [--drain-ms n]
+ */
+
+#include "IoUring.h"
+#include "LatencyHistogram.h"
+#include "LiveBackend.h"
+#include "SwitchConfig.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+/** @brief Submission queue entries; the completion queue is four times larger. */
+static const unsigned RING_ENTRIES = 4096;
+
+/** @brief Provided receive buffers and their size. */
+static const unsigned RECEIVE_BUFFERS = 4096;
+static const std::size_t RECEIVE_BUFFER_BYTES = 4096;
+
+/** @brief Start delay beyond which a request counts as late. */
+static const long long LATE_NS = 1000000;
+
+/** @brief Longest wait for completions while requests are due or in flight. */
+static const long long MAX_WAIT_NS = 10000000;
+
+/** @brief Operations of a request, kept in the low bits of user_data. */
+enum : std::uint64_t { OP_CONNECT = 1, OP_SEND = 2, OP_SHUTDOWN = 3, OP_RECEIVE = 4 };
+static const int OP_BITS = 3;
+
+/** @brief Cleared by SIGINT to stop issuing requests. */
+static volatile std::sig_atomic_t keep_running = 1;
+
+/**
+ * @brief SIGINT handler.
+ */
+static void onInterrupt(int) {
+    keep_running = 0;
+}
+
+/**
+ * @brief Nanoseconds on the steady clock.
+ */
+static long long nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * @struct Arrival
+ * @brief One scheduled request.
+ */
+struct Arrival {
+    /** @brief Scheduled start, relative to the start of the run. */
+    long long at_ns;
+    int job_class;
+    /** @brief Source address in host order (0 = no explicit bind). */
+    unsigned int source;
+    /** @brief Payload: index into the trace lines, or -1 for bytes of filler. */
+    long long line;
+    std::size_t bytes;
+};
+
+/**
+ * @struct Flight
+ * @brief A request in flight, addressed by its slot.
+ */
+struct Flight {
+    int fd = -1;
+    int job_class = 0;
+    long long scheduled_ns = 0;
+    long long started_ns = 0;
+    std::size_t expected = 0;
+    std::size_t received = 0;
+    /** @brief Submitted operations whose last completion has not arrived. */
+    int operations = 0;
+    bool failed = false;
+    bool done = false;
+};
+
+/**
+ * @struct ClassStats
+ * @brief Results of one job class.
+ */
+struct ClassStats {
+    std::string name;
+    long long sent = 0;
+    long long completed = 0;
+    long long failed = 0;
+    long long bytes = 0;
+    /** @brief Scheduled start to last reply byte, in microseconds. */
+    LatencyHistogram latency;
+    /** @brief Actual start to last reply byte, in microseconds. */
+    LatencyHistogram service;
+};
+
+/**
+ * @brief Finds "key": value in a flat JSON object and returns the value
+ * (unquoted for strings).
+ */
+static bool jsonField(const std::string& line, const std::string& key, std::string& value) {
+    std::size_t at = line.find("\"" + key + "\"");
+    if (at == std::string::npos) return false;
+    at = line.find(':', at + key.size() + 2);
+    if (at == std::string::npos) return false;
+    at = line.find_first_not_of(" \t", at + 1);
+    if (at == std::string::npos) return false;
+    if (line[at] == '"') {
+        std::size_t end = line.find('"', at + 1);
+        if (end == std::string::npos) return false;
+        value = line.substr(at + 1, end - at - 1);
+        return true;
+    }
+    std::size_t end = line.find_first_of(",}", at);
+    value = line.substr(at, end == std::string::npos ? std::string::npos : end - at);
+    while (!value.empty() && (value.back() == ' ' || value.back() == '\r')) value.pop_back();
+    return !value.empty();
+}
+
+/**
+ * @brief Returns a random address in 127.0.0.0/8, avoiding .0 and .255 hosts.
+ */
+static unsigned int loopbackAddress(std::mt19937& generator) {
+    std::uniform_int_distribution<unsigned int> host(1, 254);
+    std::uniform_int_distribution<unsigned int> net(0, 255);
+    return (127u << 24) | (net(generator) << 16) | (net(generator) << 8) | host(generator);
+}
+
+/**
+ * @brief Schedules Poisson arrivals following the configured request mix
+ * and load curve.
+ */
+static std::vector<Arrival> syntheticWorkload(const SwitchConfig& config, const std::vector<JobClass>& classes,
+                                              double rate, int seconds, int bytes_per_cycle) {
+    std::mt19937 generator(config.random_seed != 0 ? static_cast<unsigned int>(config.random_seed)
+                                                   : std::random_device{}());
+    std::vector<double> shares;
+    for (const JobClass& job_class : classes) shares.push_back(std::max(job_class.share, 0.0));
+    if (std::all_of(shares.begin(), shares.end(), [](double w) { return w <= 0.0; })) {
+        std::fill(shares.begin(), shares.end(), 1.0);
+    }
+    std::discrete_distribution<int> class_dist(shares.begin(), shares.end());
+    std::uniform_int_distribution<int> time_dist(config.min_request_time, config.max_request_time);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+    std::vector<unsigned int> clients, flooders;
+    for (int i = 0; i < config.client_pool_size; i++) clients.push_back(loopbackAddress(generator));
+    for (int i = 0; i < config.flood_sources; i++) flooders.push_back(loopbackAddress(generator));
+
+    // the load curve steps the rate up to load_curve_peak as in a simulated run
+    long long end_ns = seconds * 1000000000LL;
+    int steps = std::max(config.load_curve_steps, 0);
+    std::vector<Arrival> arrivals;
+    double t = 0.0;
+    for (;;) {
+        double factor = 1.0;
+        if (steps > 0) {
+            int step = std::min(static_cast<int>(t / end_ns * steps), steps - 1);
+            factor = config.load_curve_peak * (step + 1) / steps;
+        }
+        t += std::exponential_distribution<double>(rate * factor)(generator) * 1e9;
+        if (t >= end_ns) break;
+
+        Arrival arrival{};
+        arrival.at_ns = static_cast<long long>(t);
+        arrival.job_class = class_dist(generator);
+        arrival.line = -1;
+        arrival.bytes = static_cast<std::size_t>(std::max(time_dist(generator) * bytes_per_cycle, 1));
+        if (!clients.empty()) {
+            arrival.source = clients[std::uniform_int_distribution<std::size_t>(0, clients.size() - 1)(generator)];
+        }
+        if (!flooders.empty() && uniform(generator) < config.flood_fraction) {
+            arrival.source = flooders[std::uniform_int_distribution<std::size_t>(0, flooders.size() - 1)(generator)];
+        }
+        arrivals.push_back(arrival);
+    }
+    return arrivals;
+}
+
+/**
+ * @brief Reads a JSON-lines trace; lines without a time are spread at
+ * @p rate after the previous arrival.
+ */
+static bool traceWorkload(const std::string& path, const std::vector<JobClass>& classes, double rate,
+                          std::vector<Arrival>& arrivals, std::vector<std::string>& lines) {
+    std::ifstream in(path);
+    if (!in) return false;
+    std::mt19937 generator(1);
+    std::exponential_distribution<double> gap(rate);
+    double t = 0.0;
+    std::string line;
+    while (std::getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty()) continue;
+
+        Arrival arrival{};
+        std::string value;
+        try {
+            t = jsonField(line, "at_us", value) ? std::stod(value) * 1e3 : t + gap(generator) * 1e9;
+            if (jsonField(line, "class", value)) {
+                auto named = std::find_if(classes.begin(), classes.end(),
+                                          [&](const JobClass& c) { return c.name == value; });
+                arrival.job_class = named != classes.end() ? static_cast<int>(named - classes.begin())
+                                                           : std::stoi(value);
+            }
+            if (jsonField(line, "bytes", value)) arrival.bytes = static_cast<std::size_t>(std::stoll(value));
+        } catch (...) {
+            // malformed fields keep their defaults
+        }
+        if (arrival.job_class < 0 || arrival.job_class >= static_cast<int>(classes.size())) arrival.job_class = 0;
+        if (jsonField(line, "source", value)) {
+            in_addr address{};
+            if (inet_pton(AF_INET, value.c_str(), &address) == 1) arrival.source = ntohl(address.s_addr);
+        }
+        arrival.at_ns = static_cast<long long>(t);
+        arrival.line = -1;
+        if (arrival.bytes == 0) {
+            arrival.line = static_cast<long long>(lines.size());
+            arrival.bytes = line.size();
+            lines.push_back(line);
+        }
+        arrivals.push_back(arrival);
+    }
+    std::stable_sort(arrivals.begin(), arrivals.end(),
+                     [](const Arrival& a, const Arrival& b) { return a.at_ns < b.at_ns; });
+    return true;
+}
+
+/**
+ * @brief Prints one histogram line in the simulator's latency format.
+ */
+static void printLatency(const char* kind, const ClassStats& stats, int job_class,
+                         const LatencyHistogram& histogram) {
+    std::printf("  %s (%s) class %d: count=%lld mean=%.1f p50=%d p90=%d p99=%d p99.9=%d max=%d\n",
+                kind, stats.name.c_str(), job_class, histogram.count(), histogram.mean(),
+                histogram.percentile(50), histogram.percentile(90), histogram.percentile(99),
+                histogram.percentile(99.9), histogram.max());
+}
+
+int main(int argc, char* argv[]) {
+    std::string config_path = "switch.cfg";
+    std::string trace_path;
+    double rate = 1000.0;
+    int seconds = -1;
+    int max_connections = 1024;
+    int bytes_per_cycle = 256;
+    int port = -1;
+    bool stub = false;
+    int delay_us = 0;
+    int drain_ms = 2000;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (i + 1 < argc && arg == "--config") config_path = argv[++i];
+        else if (i + 1 < argc && arg == "--trace") trace_path = argv[++i];
+        else if (i + 1 < argc && arg == "--rate") rate = std::max(std::atof(argv[++i]), 1.0);
+        else if (i + 1 < argc && arg == "--seconds") seconds = std::max(std::atoi(argv[++i]), 1);
+        else if (i + 1 < argc && arg == "--connections") max_connections = std::max(std::atoi(argv[++i]), 1);
+        else if (i + 1 < argc && arg == "--bytes-per-cycle") bytes_per_cycle = std::max(std::atoi(argv[++i]), 1);
+        else if (i + 1 < argc && arg == "--port") port = std::atoi(argv[++i]);
+        else if (arg == "--stub") stub = true;
+        else if (i + 1 < argc && arg == "--delay-us") delay_us = std::max(std::atoi(argv[++i]), 0);
+        else if (i + 1 < argc && arg == "--drain-ms") drain_ms = std::max(std::atoi(argv[++i]), 0);
+        else {
+            std::cerr << "usage: " << argv[0] << " [--config switch.cfg] [--trace file.jsonl] [--rate req/s]\n"
+                      << "       [--seconds s] [--connections n] [--bytes-per-cycle n] [--port base]\n"
+                      << "       [--stub] [--delay-us n] [--drain-ms n]\n";
+            return 2;
+        }
+    }
+
+    SwitchConfig config = loadSwitchConfig(config_path);
+    std::vector<JobClass> classes = resolveJobClasses(config);
+    if (seconds < 0) seconds = config.live_proxy.seconds > 0 ? config.live_proxy.seconds : 10;
+
+    std::vector<Arrival> arrivals;
+    std::vector<std::string> lines;
+    if (trace_path.empty()) {
+        arrivals = syntheticWorkload(config, classes, rate, seconds, bytes_per_cycle);
+    } else if (!traceWorkload(trace_path, classes, rate, arrivals, lines)) {
+        std::cerr << "ERROR: could not read " << trace_path << "\n";
+        return 1;
+    }
+
+    // the stub stands in for the proxy; otherwise class c goes to base + c
+    LiveBackend backend;
+    if (stub) {
+        std::string error;
+        if (!spawnLiveBackend(backend, delay_us, error)) {
+            std::cerr << "ERROR: could not start the stub backend: " << error << "\n";
+            return 1;
+        }
+    } else if (port < 0) {
+        port = config.live_proxy.port;
+    }
+    if (!stub && port <= 0) {
+        std::cerr << "ERROR: no target; set live_proxy_port, or pass --port or --stub\n";
+        return 1;
+    }
+    std::vector<sockaddr_in> targets(classes.size());
+    for (std::size_t c = 0; c < classes.size(); c++) {
+        targets[c].sin_family = AF_INET;
+        targets[c].sin_port = htons(static_cast<std::uint16_t>(stub ? backend.port : port + static_cast<int>(c)));
+        targets[c].sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    }
+
+    // one descriptor per connection in flight
+    rlimit files{};
+    if (getrlimit(RLIMIT_NOFILE, &files) == 0) {
+        files.rlim_cur = files.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &files);
+        long long usable = static_cast<long long>(files.rlim_cur) - 64;
+        max_connections = static_cast<int>(std::max(std::min<long long>(max_connections, usable), 1LL));
+    }
+
+    IoUring ring(RING_ENTRIES);
+    if (!ring.isReady() || !ring.provideBuffers(RECEIVE_BUFFERS, RECEIVE_BUFFER_BYTES)) {
+        std::cerr << "ERROR: " << ring.getError() << "\n";
+        stopLiveBackend(backend);
+        return 1;
+    }
+
+    std::size_t filler_bytes = 0;
+    for (const Arrival& arrival : arrivals) {
+        if (arrival.line < 0) filler_bytes = std::max(filler_bytes, arrival.bytes);
+    }
+    std::string filler(filler_bytes, 'x');
+
+    std::vector<ClassStats> stats(classes.size());
+    for (std::size_t c = 0; c < classes.size(); c++) stats[c].name = classes[c].name;
+    std::vector<Flight> flights(static_cast<std::size_t>(max_connections));
+    std::vector<std::size_t> free_slots;
+    for (std::size_t s = flights.size(); s > 0; s--) free_slots.push_back(s - 1);
+
+    long long late = 0, max_lag_ns = 0, socket_errors = 0, unfinished = 0;
+    std::signal(SIGINT, onInterrupt);
+    std::signal(SIGPIPE, SIG_IGN);
+
+    std::printf("Load generator: %zu requests over %d s (%s), %zu classes, target %s\n",
+                arrivals.size(), seconds, trace_path.empty() ? "synthetic" : trace_path.c_str(),
+                classes.size(), stub ? "stub backend" : ("127.0.0.1:" + std::to_string(port) + "+class").c_str());
+    std::fflush(stdout);
+
+    // a full submission queue is flushed without waiting
+    auto nextSqe = [&]() {
+        io_uring_sqe* sqe = ring.getSqe();
+        while (sqe == nullptr) {
+            ring.submitAndWait(0);
+            sqe = ring.getSqe();
+        }
+        return sqe;
+    };
+    auto fail = [&](Flight& flight) {
+        if (flight.failed) return;
+        flight.failed = true;
+        // ends a receive still armed on the socket
+        shutdown(flight.fd, SHUT_RDWR);
+    };
+    auto armReceive = [&](std::size_t slot) {
+        io_uring_sqe* sqe = nextSqe();
+        sqe->opcode = IORING_OP_RECV;
+        sqe->fd = flights[slot].fd;
+        sqe->ioprio = IORING_RECV_MULTISHOT;
+        sqe->flags = IOSQE_BUFFER_SELECT;
+        sqe->buf_group = IoUring::BUFFER_GROUP;
+        sqe->user_data = (slot << OP_BITS) | OP_RECEIVE;
+        flights[slot].operations++;
+    };
+
+    long long start_ns = nowNs();
+    long long schedule_ns = arrivals.empty() ? 0 : arrivals.back().at_ns;
+    long long issue_end_ns = start_ns + schedule_ns + drain_ms * 1000000LL;
+    long long drain_end_ns = 0;
+    std::size_t next = 0;
+    std::size_t in_flight = 0;
+    while (true) {
+        long long now_ns = nowNs();
+
+        // start every request that is due; late ones are started at once
+        while (keep_running && next < arrivals.size() && !free_slots.empty() &&
+               start_ns + arrivals[next].at_ns <= now_ns) {
+            const Arrival& arrival = arrivals[next++];
+            ClassStats& class_stats = stats[static_cast<std::size_t>(arrival.job_class)];
+            class_stats.sent++;
+            long long lag = now_ns - (start_ns + arrival.at_ns);
+            max_lag_ns = std::max(max_lag_ns, lag);
+            if (lag > LATE_NS) late++;
+
+            int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+            if (fd < 0) {
+                socket_errors++;
+                class_stats.failed++;
+                continue;
+            }
+            int on = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+            if (arrival.source != 0) {
+                // pick the port at connect time, so sources share the port range
+                setsockopt(fd, IPPROTO_IP, IP_BIND_ADDRESS_NO_PORT, &on, sizeof(on));
+                sockaddr_in source{};
+                source.sin_family = AF_INET;
+                source.sin_addr.s_addr = htonl(arrival.source);
+                bind(fd, reinterpret_cast<sockaddr*>(&source), sizeof(source));
+            }
+
+            std::size_t slot = free_slots.back();
+            free_slots.pop_back();
+            in_flight++;
+            Flight& flight = flights[slot];
+            flight = Flight();
+            flight.fd = fd;
+            flight.job_class = arrival.job_class;
+            flight.scheduled_ns = start_ns + arrival.at_ns;
+            flight.started_ns = now_ns;
+            flight.expected = arrival.bytes;
+            flight.operations = 3;
+            const char* payload = arrival.line >= 0 ? lines[static_cast<std::size_t>(arrival.line)].data()
+                                                    : filler.data();
+
+            // connect -> send -> shutdown(SHUT_WR), each starting once the previous succeeded
+            io_uring_sqe* sqe = nextSqe();
+            sqe->opcode = IORING_OP_CONNECT;
+            sqe->fd = fd;
+            sqe->addr = reinterpret_cast<std::uint64_t>(&targets[static_cast<std::size_t>(arrival.job_class)]);
+            sqe->off = sizeof(sockaddr_in);
+            sqe->flags = IOSQE_IO_LINK;
+            sqe->user_data = (slot << OP_BITS) | OP_CONNECT;
+            sqe = nextSqe();
+            sqe->opcode = IORING_OP_SEND;
+            sqe->fd = fd;
+            sqe->addr = reinterpret_cast<std::uint64_t>(payload);
+            sqe->len = static_cast<unsigned>(arrival.bytes);
+            sqe->msg_flags = MSG_NOSIGNAL | MSG_WAITALL;
+            sqe->flags = IOSQE_IO_LINK;
+            sqe->user_data = (slot << OP_BITS) | OP_SEND;
+            sqe = nextSqe();
+            sqe->opcode = IORING_OP_SHUTDOWN;
+            sqe->fd = fd;
+            sqe->len = SHUT_WR;
+            sqe->user_data = (slot << OP_BITS) | OP_SHUTDOWN;
+        }
+
+        // an overloaded target does not stretch the run beyond the drain time
+        bool issuing = keep_running && next < arrivals.size() && now_ns < issue_end_ns;
+        if (!issuing && in_flight == 0) break;
+        if (!issuing && drain_end_ns == 0) drain_end_ns = now_ns + drain_ms * 1000000LL;
+        if (!issuing && now_ns >= drain_end_ns) break;
+
+        // sleep until the next arrival is due, or a completion arrives
+        long long wait_ns = MAX_WAIT_NS;
+        if (issuing && !free_slots.empty()) {
+            wait_ns = std::min(wait_ns, start_ns + arrivals[next].at_ns - now_ns);
+        }
+        if (!ring.submitAndWait(std::max(wait_ns, 0LL))) {
+            std::cerr << "ERROR: " << ring.getError() << "\n";
+            break;
+        }
+
+        now_ns = nowNs();
+        for (const io_uring_cqe* cqe = ring.peek(); cqe != nullptr; cqe = ring.peek()) {
+            std::size_t slot = static_cast<std::size_t>(cqe->user_data >> OP_BITS);
+            std::uint64_t op = cqe->user_data & ((1u << OP_BITS) - 1);
+            int result = cqe->res;
+            unsigned flags = cqe->flags;
+            ring.seen();
+
+            Flight& flight = flights[slot];
+            bool last = true;
+            if (op == OP_CONNECT) {
+                if (result < 0) fail(flight);
+                else armReceive(slot);
+            } else if (op == OP_SEND) {
+                if (result < 0 || static_cast<std::size_t>(result) < flight.expected) fail(flight);
+            } else if (op == OP_SHUTDOWN) {
+                if (result < 0) fail(flight);
+            } else {
+                if (flags & IORING_CQE_F_BUFFER) ring.recycleBuffer(flags >> IORING_CQE_BUFFER_SHIFT);
+                if (result > 0) flight.received += static_cast<std::size_t>(result);
+                if (!flight.done && !flight.failed && flight.received >= flight.expected) {
+                    flight.done = true;
+                    ClassStats& class_stats = stats[static_cast<std::size_t>(flight.job_class)];
+                    class_stats.latency.record(static_cast<int>(std::min((now_ns - flight.scheduled_ns) / 1000,
+                                                                         2000000000LL)));
+                    class_stats.service.record(static_cast<int>(std::min((now_ns - flight.started_ns) / 1000,
+                                                                         2000000000LL)));
+                    class_stats.bytes += static_cast<long long>(flight.expected + flight.received);
+                }
+                last = !(flags & IORING_CQE_F_MORE);
+                // out of provided buffers: the receive ends and is armed again
+                if (last && result == -ENOBUFS && !flight.failed) {
+                    armReceive(slot);
+                } else if (last && result < 0) {
+                    fail(flight);
+                }
+            }
+            if (!last) continue;
+
+            if (--flight.operations > 0) continue;
+            ClassStats& class_stats = stats[static_cast<std::size_t>(flight.job_class)];
+            if (flight.done && !flight.failed) class_stats.completed++;
+            else class_stats.failed++;
+            close(flight.fd);
+            flight.fd = -1;
+            free_slots.push_back(slot);
+            in_flight--;
+        }
+    }
+    long long end_ns = nowNs();
+
+    for (Flight& flight : flights) {
+        if (flight.fd < 0) continue;
+        unfinished++;
+        close(flight.fd);
+    }
+    stopLiveBackend(backend);
+
+    double elapsed = std::max((end_ns - start_ns) / 1e9, 1e-9);
+    long long sent = 0, completed = 0, failed = 0, bytes = 0;
+    for (const ClassStats& class_stats : stats) {
+        sent += class_stats.sent;
+        completed += class_stats.completed;
+        failed += class_stats.failed;
+        bytes += class_stats.bytes;
+    }
+    std::printf("\n  Run time: %.2f s\n", elapsed);
+    std::printf("  Offered: %lld requests (%.0f req/s scheduled), not sent: %zu\n", sent,
+                arrivals.empty() ? 0.0 : arrivals.size() / std::max(schedule_ns / 1e9, 1e-9),
+                arrivals.size() - next);
+    std::printf("  Completed: %lld (%.0f req/s, %.2f MB/s), failed: %lld, unfinished: %lld, socket errors: %lld\n",
+                completed, completed / elapsed, bytes / elapsed / (1024.0 * 1024.0), failed, unfinished,
+                socket_errors);
+    std::printf("  Late starts (> %lld us behind schedule): %lld, max lag: %lld us\n", LATE_NS / 1000, late,
+                max_lag_ns / 1000);
+    std::printf("  Latency unit: microseconds; latency from the scheduled start, service from the actual start\n");
+    for (std::size_t c = 0; c < stats.size(); c++) {
+        printLatency("Latency", stats[c], static_cast<int>(c), stats[c].latency);
+        printLatency("Service", stats[c], static_cast<int>(c), stats[c].service);
+    }
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,31 @@
+/**
+ * @file Log.cpp
+ * @brief Implementation of the per-thread log stream.
+ */
+
+#include "Log.h"
+#include <iostream>
+
+/** @brief Redirected stream of the current thread (null = std::cout). */
+static thread_local std::ostream* thread_log_stream = nullptr;
+
+/**
+ * @brief Returns the redirected stream or std::cout.
+ */
+std::ostream& logStream() {
+    return thread_log_stream != nullptr ? *thread_log_stream : std::cout;
+}
+
+/**
+ * @brief Stores the calling thread's destination.
+ */
+void setThreadLogStream(std::ostream* stream) {
+    thread_log_stream = stream;
+}
+
+/**
+ * @brief A stream without a buffer discards everything.
+ */
+bool logEnabled() {
+    return logStream().rdbuf() != nullptr;
+}
\ No newline at end of file
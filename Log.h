@@ -0,0 +1,30 @@
+/**
+ * @file Log.h
+ * @brief Per-thread destination for simulation log lines.
+ *
+ * Log lines go to std::cout unless the calling thread redirected them.
+ * Topology subtrees stepped on worker threads log into their own buffers,
+ * which are flushed in a fixed order so the log stays deterministic.
+ * A stream without a buffer turns logging off (headless runs).
+ */
+
+#pragma once
+#include <ostream>
+
+/**
+ * @brief Returns the stream the calling thread writes log lines to.
+ */
+std::ostream& logStream();
+
+/**
+ * @brief Redirects the calling thread's log lines.
+ *
+ * @param stream Destination, or null to restore std::cout.
+ */
+void setThreadLogStream(std::ostream* stream);
+
+/**
+ * @brief Returns whether the calling thread's log lines are written
+ * anywhere, so per-request lines need not be built when they are not.
+ */
+bool logEnabled();
\ No newline at end of file
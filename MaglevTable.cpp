@@ -0,0 +1,76 @@
+/**
+ * @file MaglevTable.cpp
+ * @brief Implementation of the MaglevTable class.
+ */
+
+#include "MaglevTable.h"
+
+/**
+ * @brief Constructor implementation.
+ */
+MaglevTable::MaglevTable() {}
+
+/**
+ * @brief Populates the table using Maglev's permutation-filling algorithm.
+ *
+ * Each backend i walks the sequence (offset_i + j * skip_i) mod M and claims
+ * the first entry it finds unclaimed; backends take turns until every entry
+ * is claimed. M is fixed, so only the entries the permutations hand to a
+ * different backend change between two builds.
+ */
+void MaglevTable::build(const std::vector<unsigned int>& backend_ids) {
+    entries.clear();
+    if (backend_ids.empty()) return;
+
+    std::size_t n = backend_ids.size();
+    const std::size_t m = TABLE_SIZE;
+
+    std::vector<std::size_t> offset(n), skip(n), next(n, 0);
+    for (std::size_t i = 0; i < n; i++) {
+        offset[i] = hash(backend_ids[i], 0x9e3779b9u) % m;
+        skip[i] = hash(backend_ids[i], 0x85ebca6bu) % (m - 1) + 1;
+    }
+
+    entries.assign(m, -1);
+    std::size_t filled = 0;
+    while (true) {
+        for (std::size_t i = 0; i < n; i++) {
+            std::size_t c = (offset[i] + next[i] * skip[i]) % m;
+            while (entries[c] >= 0) {
+                next[i]++;
+                c = (offset[i] + next[i] * skip[i]) % m;
+            }
+            entries[c] = static_cast<int>(i);
+            next[i]++;
+            if (++filled == m) return;
+        }
+    }
+}
+
+/**
+ * @brief Looks up the backend index for a key.
+ */
+int MaglevTable::lookup(unsigned int key) const {
+    if (entries.empty()) return -1;
+    return entries[hash(key, 0xc2b2ae35u) % TABLE_SIZE];
+}
+
+/**
+ * @brief Returns the number of table entries.
+ */
+std::size_t MaglevTable::size() const {
+    return entries.size();
+}
+
+/**
+ * @brief 32-bit finalizer from MurmurHash3, seeded.
+ */
+unsigned int MaglevTable::hash(unsigned int key, unsigned int seed) {
+    unsigned int h = key ^ seed;
+    h ^= h >> 16;
+    h *= 0x85ebca6bu;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35u;
+    h ^= h >> 16;
+    return h;
+}
\ No newline at end of file
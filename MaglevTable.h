@@ -0,0 +1,78 @@
+/**
+ * @file MaglevTable.h
+ * @brief Defines the MaglevTable consistent-hash lookup table.
+ *
+ * Implements the lookup table from Google's Maglev load balancer: each
+ * backend fills table entries in the order of its own pseudo-random
+ * permutation, which gives every backend an almost equal share of the
+ * table while moving only a small fraction of entries when a backend is
+ * added or removed.
+ */
+
+#pragma once
+#include <cstddef>
+#include <vector>
+
+/**
+ * @class MaglevTable
+ * @brief Maps 32-bit keys (e.g. source IPs) to backend indices.
+ *
+ * Backends are identified by stable ids so that rebuilding the table after
+ * a pool change keeps most keys on the same backend.
+ */
+class MaglevTable {
+private:
+
+    /**
+     * @brief Lookup entries; each holds an index into the backend id list.
+     */
+    std::vector<int> entries;
+
+public:
+
+    /**
+     * @brief Number of entries: a prime far above any realistic backend
+     * count, which keeps each backend's share within about 1% of even up
+     * to several hundred backends.
+     */
+    static const std::size_t TABLE_SIZE = 65537;
+
+    /**
+     * @brief Constructs an empty table (lookup() returns -1).
+     */
+    MaglevTable();
+
+    /**
+     * @brief Rebuilds the table for a set of backends.
+     *
+     * The table size is always TABLE_SIZE, whatever the backend count, so
+     * a key hashes to the same entry before and after a pool change and
+     * only about 1/(n+1) of the keys move when one of n backends is added
+     * or removed.
+     *
+     * @param backend_ids Stable identifiers of the backends, in index order.
+     */
+    void build(const std::vector<unsigned int>& backend_ids);
+
+    /**
+     * @brief Returns the backend index for a key.
+     *
+     * @param key Key to look up (e.g. IPAddress::getValue()).
+     * @return Backend index, or -1 if the table is empty.
+     */
+    int lookup(unsigned int key) const;
+
+    /**
+     * @brief Returns the number of entries in the table.
+     */
+    std::size_t size() const;
+
+    /**
+     * @brief Mixes a 32-bit key with a seed into a well-distributed hash.
+     *
+     * @param key Value to hash.
+     * @param seed Seed selecting an independent hash function.
+     * @return 32-bit hash.
+     */
+    static unsigned int hash(unsigned int key, unsigned int seed);
+};
\ No newline at end of file
@@ -0,0 +1,104 @@
+/**
+ * @file MaglevTest.cpp
+ * @brief Checks that MaglevTable moves few keys when the pool changes.
+ *
+ * For pools of 1 to 200 backends it adds one backend, then removes it
+ * again, and counts the sampled keys that change backend. Ideal consistent
+ * hashing moves 1/(n+1) of them. Maglev also shifts a few entries between
+ * backends present in both pools, more as n approaches the table size, so
+ * the check allows one percentage point above the ideal. It also checks
+ * that the sampled keys spread evenly over small pools.
+ *
+ * Build and run with: make check
+ */
+
+#include "MaglevTable.h"
+#include <cstdio>
+#include <random>
+#include <vector>
+
+/** @brief Keys sampled per pool size. */
+static const int SAMPLE_KEYS = 200000;
+
+/** @brief Tolerated moved fraction above the ideal 1/(n+1). */
+static const double MOVED_SLACK = 0.01;
+
+/** @brief Largest tolerated deviation of a backend's share from even. */
+static const double MAX_SHARE_DEVIATION = 0.05;
+
+/**
+ * @brief Returns ids 1..n, the stable server ids a LoadBalancer would use.
+ */
+static std::vector<unsigned int> serverIds(std::size_t n) {
+    std::vector<unsigned int> ids;
+    for (std::size_t i = 1; i <= n; i++) ids.push_back(static_cast<unsigned int>(i));
+    return ids;
+}
+
+/**
+ * @brief Checks one pool change from @p before to @p after backends.
+ *
+ * @return False if more than 1/(n+1) + MOVED_SLACK of the keys moved.
+ */
+static bool checkChange(std::size_t before, std::size_t after, const std::vector<unsigned int>& keys) {
+    MaglevTable old_table, new_table;
+    old_table.build(serverIds(before));
+    new_table.build(serverIds(after));
+
+    std::size_t larger = before > after ? before : after;
+    std::size_t survivors = before < after ? before : after;
+    int moved = 0;
+    int between_survivors = 0;
+    for (unsigned int key : keys) {
+        int from = old_table.lookup(key);
+        int to = new_table.lookup(key);
+        if (from == to) continue;
+        moved++;
+        if (static_cast<std::size_t>(from) < survivors && static_cast<std::size_t>(to) < survivors) {
+            between_survivors++;
+        }
+    }
+
+    double fraction = static_cast<double>(moved) / keys.size();
+    double ideal = 1.0 / larger;
+    bool ok = fraction <= ideal + MOVED_SLACK;
+    std::printf("%-4s %3zu -> %3zu backends: moved %6.2f%% (ideal %6.2f%%), between survivors %d\n",
+                ok ? "ok" : "FAIL", before, after, 100.0 * fraction, 100.0 * ideal, between_survivors);
+    return ok;
+}
+
+/**
+ * @brief Checks that each of @p n backends receives close to 1/n of the keys.
+ */
+static bool checkBalance(std::size_t n, const std::vector<unsigned int>& keys) {
+    MaglevTable table;
+    table.build(serverIds(n));
+    std::vector<int> owned(n, 0);
+    for (unsigned int key : keys) owned[static_cast<std::size_t>(table.lookup(key))]++;
+
+    double even = static_cast<double>(keys.size()) / n;
+    double worst = 0.0;
+    for (int count : owned) {
+        double deviation = (count > even ? count - even : even - count) / even;
+        if (deviation > worst) worst = deviation;
+    }
+    bool ok = worst <= MAX_SHARE_DEVIATION;
+    std::printf("%-4s %3zu backends: worst share %.2f%% off even\n", ok ? "ok" : "FAIL", n, 100.0 * worst);
+    return ok;
+}
+
+int main() {
+    std::mt19937 generator(7);
+    std::vector<unsigned int> keys(SAMPLE_KEYS);
+    for (unsigned int& key : keys) key = generator();
+
+    bool ok = true;
+    for (std::size_t n : {1, 2, 3, 4, 10, 50, 100, 200}) {
+        ok = checkChange(n, n + 1, keys) && ok;
+        ok = checkChange(n + 1, n, keys) && ok;
+    }
+    for (std::size_t n : {2, 3, 10, 20}) ok = checkBalance(n, keys) && ok;
+
+    std::printf("%s\n", ok ? "all checks passed" : "some checks failed");
+    return ok ? 0 : 1;
+}
\ No newline at end of file
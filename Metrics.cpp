@@ -0,0 +1,174 @@
+/**
+ * @file Metrics.cpp
+ * @brief Implementation of the metrics registry and its text format.
+ */
+
+#include "Metrics.h"
+#include <cmath>
+#include <cstdio>
+
+/**
+ * @brief Formats a sample value: integers exactly, others with full
+ * precision, and the special values the way the format spells them.
+ */
+static std::string formatValue(double v) {
+    if (std::isnan(v)) return "NaN";
+    if (std::isinf(v)) return v > 0 ? "+Inf" : "-Inf";
+    char text[32];
+    std::snprintf(text, sizeof(text), "%.17g", v);
+    return text;
+}
+
+/**
+ * @brief Writes "name{labels} value", merging an extra label such as le.
+ */
+static void appendSample(std::string& out, const std::string& name, const std::string& labels,
+                         const std::string& extra, const std::string& value) {
+    out += name;
+    if (!labels.empty() || !extra.empty()) {
+        out += "{";
+        out += labels;
+        if (!labels.empty() && !extra.empty()) out += ",";
+        out += extra;
+        out += "}";
+    }
+    out += " ";
+    out += value;
+    out += "\n";
+}
+
+/**
+ * @brief Constructor implementation.
+ */
+MetricHistogram::MetricHistogram(const std::vector<double>& bounds)
+ : bounds(bounds),
+   buckets(new std::atomic<std::uint64_t>[bounds.size() + 1]) {
+    for (std::size_t b = 0; b <= bounds.size(); b++) buckets[b].store(0, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Returns bucket bounds.
+ */
+const std::vector<double>& MetricHistogram::getBounds() const {
+    return bounds;
+}
+
+/**
+ * @brief Returns one bucket's count.
+ */
+std::uint64_t MetricHistogram::getBucket(std::size_t bucket) const {
+    return buckets[bucket].load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Returns the observation sum.
+ */
+double MetricHistogram::getSum() const {
+    return sum.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Escapes backslash, double quote and newline in the value.
+ */
+std::string metricLabel(const std::string& name, const std::string& value) {
+    std::string text = name + "=\"";
+    for (char c : value) {
+        if (c == '\\') text += "\\\\";
+        else if (c == '"') text += "\\\"";
+        else if (c == '\n') text += "\\n";
+        else text += c;
+    }
+    return text + "\"";
+}
+
+/**
+ * @brief Finds a family by name or appends it.
+ */
+MetricsRegistry::Family& MetricsRegistry::family(const std::string& name, const std::string& help,
+                                                 Kind kind) {
+    for (Family& f : families) {
+        if (f.name == name) return f;
+    }
+    families.push_back(Family{name, help, kind, {}});
+    return families.back();
+}
+
+/**
+ * @brief Adds a counter series.
+ */
+MetricCounter& MetricsRegistry::counter(const std::string& name, const std::string& help,
+                                        const std::string& labels) {
+    std::lock_guard<std::mutex> lock(mutex);
+    Series series;
+    series.labels = labels;
+    series.counter = std::make_unique<MetricCounter>();
+    MetricCounter& metric = *series.counter;
+    family(name, help, Kind::Counter).series.push_back(std::move(series));
+    return metric;
+}
+
+/**
+ * @brief Adds a gauge series.
+ */
+MetricGauge& MetricsRegistry::gauge(const std::string& name, const std::string& help,
+                                    const std::string& labels) {
+    std::lock_guard<std::mutex> lock(mutex);
+    Series series;
+    series.labels = labels;
+    series.gauge = std::make_unique<MetricGauge>();
+    MetricGauge& metric = *series.gauge;
+    family(name, help, Kind::Gauge).series.push_back(std::move(series));
+    return metric;
+}
+
+/**
+ * @brief Adds a histogram series.
+ */
+MetricHistogram& MetricsRegistry::histogram(const std::string& name, const std::string& help,
+                                            const std::string& labels,
+                                            const std::vector<double>& bounds) {
+    std::lock_guard<std::mutex> lock(mutex);
+    Series series;
+    series.labels = labels;
+    series.histogram = std::make_unique<MetricHistogram>(bounds);
+    MetricHistogram& metric = *series.histogram;
+    family(name, help, Kind::Histogram).series.push_back(std::move(series));
+    return metric;
+}
+
+/**
+ * @brief Writes HELP and TYPE per family, then one sample per series
+ * (buckets, sum and count for histograms).
+ *
+ * A histogram's count is taken from its buckets rather than stored, so the
+ * +Inf bucket and the count always agree within a scrape.
+ */
+std::string MetricsRegistry::render() const {
+    static const char* const TYPE_NAMES[] = {"counter", "gauge", "histogram"};
+    std::lock_guard<std::mutex> lock(mutex);
+
+    std::string out;
+    for (const Family& f : families) {
+        out += "# HELP " + f.name + " " + f.help + "\n";
+        out += "# TYPE " + f.name + " " + TYPE_NAMES[static_cast<int>(f.kind)] + "\n";
+        for (const Series& s : f.series) {
+            if (s.counter) {
+                appendSample(out, f.name, s.labels, "", std::to_string(s.counter->get()));
+            } else if (s.gauge) {
+                appendSample(out, f.name, s.labels, "", formatValue(s.gauge->get()));
+            } else if (s.histogram) {
+                const std::vector<double>& bounds = s.histogram->getBounds();
+                std::uint64_t cumulative = 0;
+                for (std::size_t b = 0; b <= bounds.size(); b++) {
+                    cumulative += s.histogram->getBucket(b);
+                    std::string le = b < bounds.size() ? formatValue(bounds[b]) : "+Inf";
+                    appendSample(out, f.name + "_bucket", s.labels, metricLabel("le", le),
+                                 std::to_string(cumulative));
+                }
+                appendSample(out, f.name + "_sum", s.labels, "", formatValue(s.histogram->getSum()));
+                appendSample(out, f.name + "_count", s.labels, "", std::to_string(cumulative));
+            }
+        }
+    }
+    return out;
+}
\ No newline at end of file
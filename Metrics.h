@@ -0,0 +1,219 @@
+/**
+ * @file Metrics.h
+ * @brief Defines counters, gauges and histograms that the simulation
+ * updates and a scraper thread reads, and their Prometheus text format.
+ *
+ * Every metric has a single writer: the thread stepping the balancer or
+ * switch that owns it. Updates are relaxed atomic loads and stores (no
+ * locked instructions, no fences), so a scrape never stalls the
+ * simulation and the simulation never waits for a scrape. A reader may
+ * see one metric a cycle ahead of another; each value on its own is
+ * always a value that was written.
+ *
+ * Series are registered before the run starts. The registry mutex only
+ * guards the series list, which the simulation never touches.
+ */
+
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * @class MetricCounter
+ * @brief Monotonic count.
+ */
+class MetricCounter {
+private:
+    std::atomic<std::uint64_t> value{0};
+
+public:
+
+    /**
+     * @brief Adds @p n; only the owning thread may call this.
+     */
+    void add(std::uint64_t n = 1) {
+        value.store(value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Publishes a total the owner already keeps.
+     */
+    void set(std::uint64_t total) {
+        value.store(total, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Returns the current count.
+     */
+    std::uint64_t get() const {
+        return value.load(std::memory_order_relaxed);
+    }
+};
+
+/**
+ * @class MetricGauge
+ * @brief Value that can go up and down.
+ */
+class MetricGauge {
+private:
+    std::atomic<double> value{0.0};
+
+public:
+
+    /**
+     * @brief Replaces the value.
+     */
+    void set(double v) {
+        value.store(v, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Returns the current value.
+     */
+    double get() const {
+        return value.load(std::memory_order_relaxed);
+    }
+};
+
+/**
+ * @class MetricHistogram
+ * @brief Counts observations per bucket of fixed upper bounds.
+ *
+ * Buckets are stored non-cumulative and summed when rendered, so an
+ * observation writes one bucket, the sum and nothing else.
+ */
+class MetricHistogram {
+private:
+
+    /** @brief Inclusive upper bounds, ascending; +Inf is implicit. */
+    std::vector<double> bounds;
+
+    /** @brief Observations per bucket; the last one is the +Inf bucket. */
+    std::unique_ptr<std::atomic<std::uint64_t>[]> buckets;
+
+    /** @brief Sum of all observations. */
+    std::atomic<double> sum{0.0};
+
+public:
+
+    /**
+     * @brief Constructs an empty histogram.
+     *
+     * @param bounds Bucket upper bounds in ascending order.
+     */
+    explicit MetricHistogram(const std::vector<double>& bounds);
+
+    /**
+     * @brief Records one observation; only the owning thread may call this.
+     */
+    void observe(double v) {
+        std::size_t b = 0;
+        while (b < bounds.size() && v > bounds[b]) b++;
+        buckets[b].store(buckets[b].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        sum.store(sum.load(std::memory_order_relaxed) + v, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Returns the bucket upper bounds.
+     */
+    const std::vector<double>& getBounds() const;
+
+    /**
+     * @brief Returns the observations of one bucket (bounds.size() is +Inf).
+     */
+    std::uint64_t getBucket(std::size_t bucket) const;
+
+    /**
+     * @brief Returns the sum of all observations.
+     */
+    double getSum() const;
+};
+
+/**
+ * @brief Formats one label pair, escaping the value as the text format requires.
+ *
+ * @param name Label name.
+ * @param value Label value.
+ * @return Text such as balancer="1P".
+ */
+std::string metricLabel(const std::string& name, const std::string& value);
+
+/**
+ * @class MetricsRegistry
+ * @brief Owns every metric series and renders them for a scrape.
+ */
+class MetricsRegistry {
+private:
+
+    /** @brief Kinds of metric family. */
+    enum class Kind { Counter, Gauge, Histogram };
+
+    /**
+     * @struct Series
+     * @brief One labelled metric of a family.
+     */
+    struct Series {
+        std::string labels;
+        std::unique_ptr<MetricCounter> counter;
+        std::unique_ptr<MetricGauge> gauge;
+        std::unique_ptr<MetricHistogram> histogram;
+    };
+
+    /**
+     * @struct Family
+     * @brief Series sharing a name, help text and kind.
+     */
+    struct Family {
+        std::string name;
+        std::string help;
+        Kind kind;
+        std::vector<Series> series;
+    };
+
+    /** @brief Guards families. */
+    mutable std::mutex mutex;
+
+    /** @brief Families in registration order. */
+    std::vector<Family> families;
+
+    /**
+     * @brief Returns the family, adding it on first use.
+     */
+    Family& family(const std::string& name, const std::string& help, Kind kind);
+
+public:
+
+    /**
+     * @brief Registers a counter series.
+     *
+     * @param name Metric name, ending in _total by convention.
+     * @param help One-line description.
+     * @param labels Comma-separated metricLabel() pairs, or empty.
+     * @return The counter; valid as long as the registry.
+     */
+    MetricCounter& counter(const std::string& name, const std::string& help,
+                           const std::string& labels = "");
+
+    /**
+     * @brief Registers a gauge series.
+     */
+    MetricGauge& gauge(const std::string& name, const std::string& help,
+                       const std::string& labels = "");
+
+    /**
+     * @brief Registers a histogram series.
+     *
+     * @param bounds Bucket upper bounds in ascending order.
+     */
+    MetricHistogram& histogram(const std::string& name, const std::string& help,
+                               const std::string& labels, const std::vector<double>& bounds);
+
+    /**
+     * @brief Renders every series in the Prometheus text exposition format.
+     */
+    std::string render() const;
+};
\ No newline at end of file
@@ -0,0 +1,178 @@
+/**
+ * @file MetricsServer.cpp
+ * @brief Implementation of the localhost metrics endpoint.
+ */
+
+#include "MetricsServer.h"
+#include "Log.h"
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+/** @brief Largest request header read before answering. */
+static const std::size_t MAX_REQUEST_BYTES = 8192;
+
+/** @brief Milliseconds a client may take to send its request. */
+static const int REQUEST_TIMEOUT_MS = 1000;
+
+/**
+ * @brief Writes the whole buffer, retrying short sends.
+ */
+static void sendAll(int fd, const std::string& data) {
+    std::size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0) return;
+        sent += static_cast<std::size_t>(n);
+    }
+}
+
+/**
+ * @brief Constructor implementation.
+ *
+ * Binds the loopback address only, so the endpoint is never exposed on
+ * other interfaces.
+ */
+MetricsServer::MetricsServer(int port, const MetricsRegistry& registry)
+ : registry(registry),
+   listen_fd(-1),
+   wake_pipe{-1, -1},
+   running(true),
+   scrapes(0) {
+
+    if (pipe2(wake_pipe, O_CLOEXEC | O_NONBLOCK) != 0) {
+        wake_pipe[0] = wake_pipe[1] = -1;
+        return;
+    }
+
+    listen_fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listen_fd < 0) return;
+    int reuse = 1;
+    setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(static_cast<unsigned short>(port));
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(listen_fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        listen(listen_fd, 16) != 0) {
+        std::cerr << "WARNING: metrics endpoint could not listen on 127.0.0.1:" << port
+                  << " (" << std::strerror(errno) << ")\n";
+        close(listen_fd);
+        listen_fd = -1;
+        return;
+    }
+
+    logStream() << "[METRICS] Serving http://127.0.0.1:" << port << "/metrics\n";
+    worker = std::thread(&MetricsServer::run, this);
+}
+
+/**
+ * @brief Destructor implementation.
+ */
+MetricsServer::~MetricsServer() {
+    stop();
+    if (listen_fd >= 0) close(listen_fd);
+    if (wake_pipe[0] >= 0) close(wake_pipe[0]);
+    if (wake_pipe[1] >= 0) close(wake_pipe[1]);
+}
+
+/**
+ * @brief Signals the thread and waits for it.
+ */
+void MetricsServer::stop() {
+    if (!worker.joinable()) return;
+
+    running.store(false, std::memory_order_release);
+    char c = 'q';
+    ssize_t ignored = write(wake_pipe[1], &c, 1);
+    (void)ignored;
+    worker.join();
+}
+
+/**
+ * @brief Waits for connections or the stop signal.
+ */
+void MetricsServer::run() {
+    struct pollfd fds[2];
+    fds[0] = {wake_pipe[0], POLLIN, 0};
+    fds[1] = {listen_fd, POLLIN, 0};
+
+    while (running.load(std::memory_order_acquire)) {
+        if (poll(fds, 2, -1) <= 0) continue;
+        if (fds[0].revents & POLLIN) break;
+        if (fds[1].revents & POLLIN) {
+            int fd = accept4(listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+            if (fd >= 0) serve(fd);
+        }
+    }
+}
+
+/**
+ * @brief Reads up to the end of the request header, then answers from
+ * the request line alone; bodies are not expected and are ignored.
+ */
+void MetricsServer::serve(int fd) {
+    std::string request;
+    char buffer[1024];
+    struct pollfd client = {fd, POLLIN, 0};
+    while (request.find("\r\n\r\n") == std::string::npos && request.size() < MAX_REQUEST_BYTES) {
+        if (poll(&client, 1, REQUEST_TIMEOUT_MS) <= 0) break;
+        ssize_t n = recv(fd, buffer, sizeof(buffer), 0);
+        if (n <= 0) break;
+        request.append(buffer, static_cast<std::size_t>(n));
+    }
+
+    std::string line = request.substr(0, request.find("\r\n"));
+    std::string method = line.substr(0, line.find(' '));
+    std::string target;
+    std::size_t path_start = line.find(' ');
+    if (path_start != std::string::npos) {
+        std::size_t path_end = line.find_first_of(" ?", path_start + 1);
+        target = line.substr(path_start + 1, path_end - path_start - 1);
+    }
+
+    std::string status, type, body;
+    if (method != "GET" && method != "HEAD") {
+        status = "405 Method Not Allowed";
+        type = "text/plain";
+        body = "only GET is supported\n";
+    } else if (target == "/metrics") {
+        status = "200 OK";
+        type = "text/plain; version=0.0.4; charset=utf-8";
+        body = registry.render();
+    } else {
+        status = "404 Not Found";
+        type = "text/plain";
+        body = "metrics are served at /metrics\n";
+    }
+
+    std::string response = "HTTP/1.1 " + status + "\r\n"
+                         + "Content-Type: " + type + "\r\n"
+                         + "Content-Length: " + std::to_string(body.size()) + "\r\n"
+                         + "Connection: close\r\n\r\n";
+    if (method != "HEAD") response += body;
+    sendAll(fd, response);
+    close(fd);
+    scrapes.fetch_add(1, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Returns whether the socket is listening.
+ */
+bool MetricsServer::isListening() const {
+    return listen_fd >= 0;
+}
+
+/**
+ * @brief Returns the request count.
+ */
+long long MetricsServer::getScrapeCount() const {
+    return scrapes.load(std::memory_order_relaxed);
+}
\ No newline at end of file
@@ -0,0 +1,84 @@
+/**
+ * @file MetricsServer.h
+ * @brief Defines a minimal HTTP server that exposes a MetricsRegistry on
+ * localhost for Prometheus to scrape.
+ */
+
+#pragma once
+#include "Metrics.h"
+#include <atomic>
+#include <thread>
+
+/**
+ * @class MetricsServer
+ * @brief Background thread answering GET /metrics on 127.0.0.1.
+ *
+ * Connections are served one at a time: each request is read, answered
+ * with the rendered registry (or 404 for any other path) and closed.
+ * Rendering only loads atomics, so the simulation keeps running while a
+ * scrape is in progress.
+ */
+class MetricsServer {
+private:
+
+    /** @brief Registry to render. */
+    const MetricsRegistry& registry;
+
+    /** @brief Listening socket, or -1 if the port could not be bound. */
+    int listen_fd;
+
+    /** @brief Self-pipe woken by stop(). */
+    int wake_pipe[2];
+
+    /** @brief Cleared to ask the thread to exit. */
+    std::atomic<bool> running;
+
+    /** @brief Requests answered. */
+    std::atomic<long long> scrapes;
+
+    /** @brief Worker thread. */
+    std::thread worker;
+
+    /**
+     * @brief Accepts and answers connections until stopped.
+     */
+    void run();
+
+    /**
+     * @brief Reads one request from @p fd, answers it and closes it.
+     */
+    void serve(int fd);
+
+public:
+
+    /**
+     * @brief Binds 127.0.0.1:@p port and starts the thread.
+     *
+     * @param port TCP port to listen on.
+     * @param registry Metrics to serve; must outlive the server.
+     */
+    MetricsServer(int port, const MetricsRegistry& registry);
+
+    /**
+     * @brief Stops and joins the thread.
+     */
+    ~MetricsServer();
+
+    MetricsServer(const MetricsServer&) = delete;
+    MetricsServer& operator=(const MetricsServer&) = delete;
+
+    /**
+     * @brief Stops the thread; safe to call more than once.
+     */
+    void stop();
+
+    /**
+     * @brief Returns whether the port was bound.
+     */
+    bool isListening() const;
+
+    /**
+     * @brief Returns the number of requests answered.
+     */
+    long long getScrapeCount() const;
+};
\ No newline at end of file
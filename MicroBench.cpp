@@ -0,0 +1,579 @@
+/**
+ * @file MicroBench.cpp
+ * @brief Microbenchmarks of the simulator's hot paths.
+ *
+ * Covers IPAddress parsing and formatting, Switch::isBlocked at growing
+ * blocklist sizes, RequestQueue push/pop per discipline (and for a FIFO
+ * queue spilling to disk),
+ * LoadBalancer::assignRequests at growing pool sizes and
+ * Switch::makeRandomRequest. For each benchmark it reports:
+ * - ns/op, the median of BENCH_REPEATS timed runs
+ * - heap allocations per op, counted by replacing the global operator new
+ * - CPU cycles, instructions, cache misses and branch misses per op, when
+ *   the kernel allows perf_event_open (otherwise "n/a" and null)
+ *
+ * Results are written as JSON, one benchmark per line, so that a run on
+ * another commit can be compared against them with --baseline.
+ *
+ * Usage:
+ *   ./microbench [--filter text] [--label name] [--out file.json] [--baseline old.json]
+ *
+ * `make bench` builds it and writes bench-<commit>.json.
+ */
+
+#include "Color.h"
+#include "IPAddress.h"
+#include "LoadBalancer.h"
+#include "Log.h"
+#include "Request.h"
+#include "RequestQueue.h"
+#include "ServerScan.h"
+#include "Switch.h"
+#include "SwitchConfig.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <new>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+/** @brief Wall time one timed run aims for, in nanoseconds. */
+static const double BENCH_TARGET_NS = 50e6;
+
+/** @brief Timed runs per benchmark; the median is reported. */
+static const int BENCH_REPEATS = 5;
+
+/** @brief Relative ns/op change treated as noise when comparing runs. */
+static const double BENCH_NOISE = 0.05;
+
+/** @brief Pre-generated inputs per benchmark, cycled through by index. */
+static const std::size_t INPUTS = 4096;
+
+//------------------------------------------------------------------------------
+// Allocation counting
+//------------------------------------------------------------------------------
+
+/** @brief Calls to operator new so far; the benchmarks are single-threaded. */
+static long long allocation_count = 0;
+
+void* operator new(std::size_t size) {
+    allocation_count++;
+    if (void* block = std::malloc(size == 0 ? 1 : size)) return block;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* block) noexcept {
+    std::free(block);
+}
+
+void operator delete(void* block, std::size_t) noexcept {
+    std::free(block);
+}
+
+//------------------------------------------------------------------------------
+// Private entry points
+//------------------------------------------------------------------------------
+
+/**
+ * @struct BenchAccess
+ * @brief Friend of Switch and LoadBalancer that forwards to the private
+ * methods being timed.
+ */
+struct BenchAccess {
+    static bool isBlocked(Switch& node, Request& request, int cycle) {
+        return node.isBlocked(request, cycle);
+    }
+
+    static Request makeRandomRequest(Switch& node) {
+        return node.makeRandomRequest();
+    }
+
+    static void assignRequests(LoadBalancer& lb, int cycle) {
+        lb.assignRequests(cycle);
+    }
+};
+
+/**
+ * @brief Keeps the compiler from discarding a computed value.
+ */
+template <typename T>
+static void keep(const T& value) {
+    asm volatile("" : : "r"(&value) : "memory");
+}
+
+//------------------------------------------------------------------------------
+// Hardware counters
+//------------------------------------------------------------------------------
+
+/** @brief Names of the hardware counters, in group order. */
+static const char* const COUNTER_NAMES[] = {"cycles", "instructions", "cache_misses", "branch_misses"};
+
+/** @brief Number of hardware counters. */
+static const int COUNTERS = 4;
+
+/**
+ * @class PerfCounters
+ * @brief One perf_event group counting user-space events of this thread.
+ */
+class PerfCounters {
+private:
+    /** @brief Descriptors of the group leader and members (-1 if unavailable). */
+    int fds[COUNTERS];
+
+public:
+    /**
+     * @brief Opens the group; leaves it unavailable if the kernel refuses
+     * (no PMU in a VM, or perf_event_paranoid too strict).
+     */
+    PerfCounters() {
+        static const unsigned long long configs[COUNTERS] = {
+            PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+            PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+
+        for (int i = 0; i < COUNTERS; i++) fds[i] = -1;
+        for (int i = 0; i < COUNTERS; i++) {
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = configs[i];
+            attr.disabled = i == 0;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_GROUP;
+            fds[i] = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, i == 0 ? -1 : fds[0], 0));
+            if (fds[i] < 0) {
+                close();
+                return;
+            }
+        }
+    }
+
+    ~PerfCounters() {
+        close();
+    }
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    /**
+     * @brief Returns whether every counter opened.
+     */
+    bool isAvailable() const {
+        return fds[0] >= 0;
+    }
+
+    /**
+     * @brief Zeroes and starts the group.
+     */
+    void start() {
+        if (!isAvailable()) return;
+        ioctl(fds[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+
+    /**
+     * @brief Stops the group and adds its counts to @p totals.
+     */
+    void stop(double* totals) {
+        if (!isAvailable()) return;
+        ioctl(fds[0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+        unsigned long long values[1 + COUNTERS];
+        if (read(fds[0], values, sizeof(values)) != static_cast<ssize_t>(sizeof(values))) return;
+        for (int i = 0; i < COUNTERS; i++) totals[i] += static_cast<double>(values[1 + i]);
+    }
+
+    /**
+     * @brief Closes every open descriptor.
+     */
+    void close() {
+        for (int i = 0; i < COUNTERS; i++) {
+            if (fds[i] >= 0) ::close(fds[i]);
+            fds[i] = -1;
+        }
+    }
+};
+
+//------------------------------------------------------------------------------
+// Harness
+//------------------------------------------------------------------------------
+
+/**
+ * @struct Benchmark
+ * @brief A named operation; run(n) performs it n times.
+ */
+struct Benchmark {
+    std::string name;
+    std::function<void(long long)> run;
+};
+
+/**
+ * @struct BenchResult
+ * @brief Per-op figures of one benchmark.
+ */
+struct BenchResult {
+    std::string name;
+    long long iterations = 0;
+    double ns_per_op = 0.0;
+    double allocs_per_op = 0.0;
+    bool has_counters = false;
+    double counters[COUNTERS] = {};
+};
+
+/**
+ * @brief Returns nanoseconds taken by run(iterations).
+ */
+static double timeRun(const Benchmark& bench, long long iterations) {
+    auto start = std::chrono::steady_clock::now();
+    bench.run(iterations);
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * @brief Sizes the iteration count to BENCH_TARGET_NS, then measures
+ * BENCH_REPEATS runs. Allocations and counters are averaged over all runs.
+ */
+static BenchResult measure(const Benchmark& bench, PerfCounters& perf) {
+    // grow until a run is long enough to extrapolate from (also warms up)
+    long long iterations = 1;
+    double elapsed = timeRun(bench, iterations);
+    while (elapsed < BENCH_TARGET_NS / 20) {
+        iterations *= 4;
+        elapsed = timeRun(bench, iterations);
+    }
+    iterations = std::max(1LL, static_cast<long long>(iterations * BENCH_TARGET_NS / elapsed));
+
+    BenchResult result;
+    result.name = bench.name;
+    result.iterations = iterations;
+    std::vector<double> samples;
+    long long allocations = 0;
+    for (int r = 0; r < BENCH_REPEATS; r++) {
+        long long allocations_before = allocation_count;
+        perf.start();
+        samples.push_back(timeRun(bench, iterations) / iterations);
+        perf.stop(result.counters);
+        allocations += allocation_count - allocations_before;
+    }
+    std::sort(samples.begin(), samples.end());
+
+    double ops = static_cast<double>(iterations) * BENCH_REPEATS;
+    result.ns_per_op = samples[BENCH_REPEATS / 2];
+    result.allocs_per_op = allocations / ops;
+    result.has_counters = perf.isAvailable();
+    for (double& counter : result.counters) counter /= ops;
+    return result;
+}
+
+/**
+ * @brief Formats a per-op figure for the console table.
+ */
+static std::string perOp(double value, bool available) {
+    if (!available) return "n/a";
+    char text[32];
+    std::snprintf(text, sizeof(text), value < 10 ? "%.2f" : "%.0f", value);
+    return text;
+}
+
+/**
+ * @brief Escapes a string for a JSON literal.
+ */
+static std::string jsonString(const std::string& text) {
+    std::string out = "\"";
+    for (char c : text) {
+        if (c == '"' || c == '\\') out += '\\';
+        out += c;
+    }
+    return out + "\"";
+}
+
+/**
+ * @brief Writes the run as JSON, one result object per line.
+ */
+static bool writeJson(const std::string& path, const std::string& label,
+                      const std::vector<BenchResult>& results, bool counters) {
+    std::ofstream out(path);
+    if (!out) return false;
+    out << "{\n"
+        << "  \"label\": " << jsonString(label) << ",\n"
+        << "  \"scan_path\": " << jsonString(scanPathName(getScanPath())) << ",\n"
+        << "  \"perf_counters\": " << (counters ? "true" : "false") << ",\n"
+        << "  \"results\": [\n";
+    for (std::size_t i = 0; i < results.size(); i++) {
+        const BenchResult& r = results[i];
+        out << "    {\"name\": " << jsonString(r.name)
+            << ", \"iterations\": " << r.iterations
+            << ", \"ns_per_op\": " << r.ns_per_op
+            << ", \"allocs_per_op\": " << r.allocs_per_op;
+        for (int c = 0; c < COUNTERS; c++) {
+            out << ", \"" << COUNTER_NAMES[c] << "_per_op\": ";
+            if (r.has_counters) out << r.counters[c];
+            else out << "null";
+        }
+        out << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+    return static_cast<bool>(out);
+}
+
+/**
+ * @brief Reads name and ns/op of every result line of an earlier run.
+ */
+static std::map<std::string, double> readBaseline(const std::string& path) {
+    std::map<std::string, double> baseline;
+    std::ifstream in(path);
+    std::string line;
+    while (std::getline(in, line)) {
+        std::size_t name = line.find("\"name\": \"");
+        std::size_t ns = line.find("\"ns_per_op\": ");
+        if (name == std::string::npos || ns == std::string::npos) continue;
+        name += 9;
+        std::size_t end = line.find('"', name);
+        baseline[line.substr(name, end - name)] = std::strtod(line.c_str() + ns + 13, nullptr);
+    }
+    return baseline;
+}
+
+//------------------------------------------------------------------------------
+// Benchmarks
+//------------------------------------------------------------------------------
+
+/**
+ * @brief Returns INPUTS random dotted-quad strings.
+ */
+static std::vector<std::string> randomAddresses(std::mt19937& generator) {
+    std::uniform_int_distribution<int> octet(0, 255);
+    std::vector<std::string> addresses;
+    for (std::size_t i = 0; i < INPUTS; i++) {
+        addresses.push_back(std::to_string(octet(generator)) + "." + std::to_string(octet(generator)) + "." +
+                            std::to_string(octet(generator)) + "." + std::to_string(octet(generator)));
+    }
+    return addresses;
+}
+
+/**
+ * @brief Returns INPUTS requests with random source IPs, lengths 1-8 and
+ * priorities 0-3.
+ */
+static std::vector<Request> randomRequests(std::mt19937& generator) {
+    std::uniform_int_distribution<unsigned int> address;
+    std::uniform_int_distribution<int> length(1, 8);
+    std::uniform_int_distribution<int> priority(0, 3);
+    std::vector<Request> requests;
+    for (std::size_t i = 0; i < INPUTS; i++) {
+        IPAddress in(address(generator)), out(address(generator));
+        Request r(in, out, length(generator), 0);
+        r.priority = priority(generator);
+        requests.push_back(r);
+    }
+    return requests;
+}
+
+static void addAddressBenchmarks(std::vector<Benchmark>& benches, std::mt19937& generator) {
+    auto text = std::make_shared<std::vector<std::string>>(randomAddresses(generator));
+    benches.push_back({"ip/parse", [text](long long n) {
+        for (long long i = 0; i < n; i++) {
+            IPAddress address((*text)[static_cast<std::size_t>(i) % INPUTS]);
+            keep(address);
+        }
+    }});
+
+    auto parsed = std::make_shared<std::vector<IPAddress>>(text->begin(), text->end());
+    benches.push_back({"ip/format", [parsed](long long n) {
+        for (long long i = 0; i < n; i++) {
+            std::string formatted = (*parsed)[static_cast<std::size_t>(i) % INPUTS].getString();
+            keep(formatted);
+        }
+    }});
+}
+
+static void addBlocklistBenchmarks(std::vector<Benchmark>& benches, std::mt19937& generator) {
+    std::uniform_int_distribution<unsigned int> address;
+    std::uniform_int_distribution<unsigned int> width(0, 255);
+    for (int ranges : {0, 1000, 100000, 1000000}) {
+        SwitchConfig config;
+        config.random_seed = 1;
+        for (int i = 0; i < ranges; i++) {
+            unsigned int first = address(generator);
+            IPAddress low(first);
+            IPAddress high(first + std::min(width(generator), 0xFFFFFFFFu - first));
+            config.blocked_ranges.emplace_back(low, high);
+        }
+        auto node = std::make_shared<Switch>(config);
+        auto requests = std::make_shared<std::vector<Request>>(randomRequests(generator));
+        benches.push_back({"switch/is_blocked/ranges=" + std::to_string(ranges), [node, requests](long long n) {
+            for (long long i = 0; i < n; i++) {
+                bool blocked = BenchAccess::isBlocked(*node, (*requests)[static_cast<std::size_t>(i) % INPUTS], 1);
+                keep(blocked);
+            }
+        }});
+    }
+}
+
+static void addQueueBenchmarks(std::vector<Benchmark>& benches, std::mt19937& generator) {
+    const std::pair<const char*, QueueDiscipline> disciplines[] = {
+        {"fifo", QueueDiscipline::FIFO}, {"sjf", QueueDiscipline::SJF},
+        {"priority", QueueDiscipline::Priority}, {"wfq", QueueDiscipline::WFQ}};
+
+    for (const auto& discipline : disciplines) {
+        QueueConfig config;
+        config.discipline = discipline.second;
+        config.priority_classes = 4;
+        auto queue = std::make_shared<RequestQueue>(config);
+        auto requests = std::make_shared<std::vector<Request>>(randomRequests(generator));
+        // a standing backlog, so each op is one push and one pop at that depth
+        for (std::size_t i = 0; i < 1024; i++) queue->push((*requests)[i]);
+        benches.push_back({std::string("queue/push_pop/") + discipline.first, [queue, requests](long long n) {
+            for (long long i = 0; i < n; i++) {
+                queue->push((*requests)[static_cast<std::size_t>(i) % INPUTS]);
+                keep(queue->front());
+                queue->pop();
+            }
+        }});
+    }
+
+    // a backlog four times the memory budget: every block pushed is written
+    // out and every block popped is read back
+    QueueConfig config;
+    config.memory_limit = 8 << 20;
+    config.spill_block = 1 << 20;
+    auto queue = std::make_shared<RequestQueue>(config);
+    auto requests = std::make_shared<std::vector<Request>>(randomRequests(generator));
+    for (std::size_t i = 0; i < 4 * config.memory_limit / sizeof(Request); i++) {
+        queue->push((*requests)[i % INPUTS]);
+    }
+    benches.push_back({"queue/push_pop/fifo_spill", [queue, requests](long long n) {
+        for (long long i = 0; i < n; i++) {
+            queue->push((*requests)[static_cast<std::size_t>(i) % INPUTS]);
+            keep(queue->front());
+            queue->pop();
+        }
+    }});
+}
+
+static void addBalancerBenchmarks(std::vector<Benchmark>& benches, std::mt19937& generator) {
+    for (int servers : {100, 1000, 10000}) {
+        // the cooldown keeps the pool at its initial size
+        auto lb = std::make_shared<LoadBalancer>(servers, 1 << 30);
+        auto requests = std::make_shared<std::vector<Request>>(randomRequests(generator));
+        auto cycle = std::make_shared<int>(0);
+        std::size_t arrivals = static_cast<std::size_t>(servers) / 64 + 1;
+        benches.push_back({"lb/assign_requests/servers=" + std::to_string(servers),
+                           [lb, requests, cycle, arrivals](long long n) {
+            // one op is one cycle: queue a light load, then assign it
+            for (long long i = 0; i < n; i++) {
+                int c = ++*cycle;
+                for (std::size_t a = 0; a < arrivals; a++) {
+                    Request& r = (*requests)[(static_cast<std::size_t>(c) * arrivals + a) % INPUTS];
+                    r.arrival_cycle = c;
+                    r.stage_arrival_cycle = c;
+                    lb->addRequest(r);
+                }
+                BenchAccess::assignRequests(*lb, c);
+            }
+        }});
+    }
+}
+
+static void addGeneratorBenchmarks(std::vector<Benchmark>& benches) {
+    SwitchConfig config;
+    config.random_seed = 1;
+    auto node = std::make_shared<Switch>(config);
+    benches.push_back({"switch/make_random_request", [node](long long n) {
+        for (long long i = 0; i < n; i++) {
+            Request r = BenchAccess::makeRandomRequest(*node);
+            keep(r);
+        }
+    }});
+
+    config.client_pool_size = 1000;
+    auto pooled = std::make_shared<Switch>(config);
+    benches.push_back({"switch/make_random_request/clients=1000", [pooled](long long n) {
+        for (long long i = 0; i < n; i++) {
+            Request r = BenchAccess::makeRandomRequest(*pooled);
+            keep(r);
+        }
+    }});
+}
+
+int main(int argc, char* argv[]) {
+    std::string filter, label = "local", out_path = "bench.json", baseline_path;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (i + 1 < argc && arg == "--filter") filter = argv[++i];
+        else if (i + 1 < argc && arg == "--label") label = argv[++i];
+        else if (i + 1 < argc && arg == "--out") out_path = argv[++i];
+        else if (i + 1 < argc && arg == "--baseline") baseline_path = argv[++i];
+        else {
+            std::cerr << "usage: " << argv[0]
+                      << " [--filter text] [--label name] [--out file.json] [--baseline old.json]" << std::endl;
+            return 2;
+        }
+    }
+
+    // formatting into a stream without a buffer is skipped entirely
+    std::ostream discard(nullptr);
+    setThreadLogStream(&discard);
+
+    std::mt19937 generator(1);
+    std::vector<Benchmark> benches;
+    addAddressBenchmarks(benches, generator);
+    addBlocklistBenchmarks(benches, generator);
+    addQueueBenchmarks(benches, generator);
+    addBalancerBenchmarks(benches, generator);
+    addGeneratorBenchmarks(benches);
+
+    PerfCounters perf;
+    std::map<std::string, double> baseline;
+    if (!baseline_path.empty()) baseline = readBaseline(baseline_path);
+    std::cout << "label " << label << ", scan path " << scanPathName(getScanPath())
+              << ", hardware counters " << (perf.isAvailable() ? "on" : "unavailable") << "\n";
+
+    char line[256];
+    std::snprintf(line, sizeof(line), "%-42s %10s %9s %9s %9s %9s %9s",
+                  "benchmark", "ns/op", "allocs/op", "cycles", "instr", "cache-mis", "br-miss");
+    std::cout << line << std::endl;
+
+    std::vector<BenchResult> results;
+    for (const Benchmark& bench : benches) {
+        if (bench.name.find(filter) == std::string::npos) continue;
+        BenchResult r = measure(bench, perf);
+        results.push_back(r);
+
+        std::snprintf(line, sizeof(line), "%-42s %10.1f %9.2f %9s %9s %9s %9s",
+                      r.name.c_str(), r.ns_per_op, r.allocs_per_op,
+                      perOp(r.counters[0], r.has_counters).c_str(), perOp(r.counters[1], r.has_counters).c_str(),
+                      perOp(r.counters[2], r.has_counters).c_str(), perOp(r.counters[3], r.has_counters).c_str());
+        std::cout << line;
+
+        auto old = baseline.find(r.name);
+        if (old != baseline.end() && old->second > 0) {
+            double change = r.ns_per_op / old->second - 1.0;
+            const std::string& color = change > BENCH_NOISE ? Color::RED
+                                     : change < -BENCH_NOISE ? Color::GREEN : Color::RESET;
+            std::snprintf(line, sizeof(line), "  %+6.1f%% vs %.1f", change * 100.0, old->second);
+            std::cout << color << line << Color::RESET;
+        }
+        std::cout << std::endl;
+    }
+
+    if (!writeJson(out_path, label, results, perf.isAvailable())) {
+        std::cerr << "cannot write " << out_path << std::endl;
+        return 1;
+    }
+    std::cout << "wrote " << out_path << std::endl;
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,279 @@
+/**
+ * @file Profiler.cpp
+ * @brief Thread registry, hardware counters and report of the phase timers.
+ */
+
+#include "Profiler.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <linux/perf_event.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+/** @brief Entries timed to estimate the cost of one scope. */
+static const int OVERHEAD_SAMPLES = 100000;
+
+/**
+ * @struct ProfileRegistry
+ * @brief Every thread's accumulator and the clock reference for converting ticks.
+ */
+struct ProfileRegistry {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<ProfileAccumulator>> threads;
+    std::uint64_t start_ticks = profileTicks();
+    std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+};
+
+/**
+ * @brief Returns the registry, created on first use.
+ */
+static ProfileRegistry& registry() {
+    static ProfileRegistry instance;
+    return instance;
+}
+
+/** @brief Whether newly registered threads open hardware counters. */
+static std::atomic<bool> counters_wanted{false};
+
+/**
+ * @brief Opens the thread's counter group and maps each counter's page
+ * for rdpmc; leaves counting off if the kernel refuses.
+ */
+static void openCounters(ProfileAccumulator& accumulator) {
+    static const unsigned long long configs[PROFILE_COUNTERS] = {
+        PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+        PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+    if (accumulator.counting) return;
+
+    long page_size = sysconf(_SC_PAGESIZE);
+    for (int c = 0; c < PROFILE_COUNTERS; c++) {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = configs[c];
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        int group = c == 0 ? -1 : accumulator.fds[0];
+        accumulator.fds[c] = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, group, 0));
+        if (accumulator.fds[c] < 0) {
+            for (int o = 0; o < c; o++) {
+                if (accumulator.pages[o] != nullptr) munmap(accumulator.pages[o], page_size);
+                close(accumulator.fds[o]);
+                accumulator.pages[o] = nullptr;
+                accumulator.fds[o] = -1;
+            }
+            return;
+        }
+
+        // user-space reads need the metadata page and cap_user_rdpmc
+        void* page = mmap(nullptr, page_size, PROT_READ, MAP_SHARED, accumulator.fds[c], 0);
+        if (page != MAP_FAILED &&
+            static_cast<perf_event_mmap_page*>(page)->cap_user_rdpmc) {
+            accumulator.pages[c] = page;
+        } else if (page != MAP_FAILED) {
+            munmap(page, page_size);
+        }
+    }
+    accumulator.counting = true;
+}
+
+/**
+ * @brief Adds an accumulator for the calling thread.
+ */
+ProfileAccumulator& registerProfileThread() {
+    ProfileRegistry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    reg.threads.push_back(std::make_unique<ProfileAccumulator>());
+    ProfileAccumulator& accumulator = *reg.threads.back();
+    if (counters_wanted.load()) openCounters(accumulator);
+    return accumulator;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+/**
+ * @brief Reads a hardware performance counter from user space.
+ */
+static inline std::uint64_t readPmc(unsigned int counter) {
+    unsigned int low, high;
+    asm volatile("rdpmc" : "=a"(low), "=d"(high) : "c"(counter));
+    return (static_cast<std::uint64_t>(high) << 32) | low;
+}
+#endif
+
+/**
+ * @brief Uses the seqlock protocol of the perf mmap page and rdpmc when
+ * available, and a read() system call otherwise.
+ */
+void ProfileAccumulator::readCounters(std::uint64_t* values) {
+    for (int c = 0; c < PROFILE_COUNTERS; c++) {
+#if defined(__x86_64__) || defined(__i386__)
+        if (pages[c] != nullptr) {
+            volatile perf_event_mmap_page* page = static_cast<perf_event_mmap_page*>(pages[c]);
+            std::uint32_t sequence;
+            std::uint64_t count;
+            do {
+                sequence = page->lock;
+                asm volatile("" ::: "memory");
+                count = static_cast<std::uint64_t>(page->offset);
+                std::uint32_t index = page->index;
+                if (index != 0) {
+                    unsigned int width = page->pmc_width;
+                    std::uint64_t pmc = readPmc(index - 1);
+                    pmc <<= 64 - width;
+                    count += static_cast<std::uint64_t>(static_cast<std::int64_t>(pmc) >> (64 - width));
+                }
+                asm volatile("" ::: "memory");
+            } while (page->lock != sequence);
+            values[c] = count;
+            continue;
+        }
+#endif
+        std::uint64_t count = 0;
+        if (read(fds[c], &count, sizeof(count)) != static_cast<ssize_t>(sizeof(count))) count = 0;
+        values[c] = count;
+    }
+}
+
+/**
+ * @brief Sets the flag for new threads and opens the caller's counters.
+ */
+void enableProfileCounters() {
+#ifdef LB_PROFILE
+    counters_wanted.store(true);
+    openCounters(threadProfile());
+#endif
+}
+
+#ifdef LB_PROFILE
+
+/** @brief Phase names, indented by nesting. */
+static const char* const PHASE_LABELS[PROFILE_PHASES] = {
+    "preload", "cycle", "  generation", "  routing", "  step", "    completion",
+    "    assignment", "    scaling", "  forwarding", "  reporting"};
+
+/**
+ * @brief Times empty scopes of a phase on the calling thread, then
+ * removes them from its totals again.
+ *
+ * @return Ticks per scope.
+ */
+static double measureScopeTicks(ProfilePhase phase) {
+    ProfileAccumulator& accumulator = threadProfile();
+    const ProfileAccumulator saved = accumulator;
+
+    std::uint64_t start = profileTicks();
+    for (int i = 0; i < OVERHEAD_SAMPLES; i++) {
+        ProfileScope scope(phase);
+    }
+    std::uint64_t elapsed = profileTicks() - start;
+
+    accumulator = saved;
+    return static_cast<double>(elapsed) / OVERHEAD_SAMPLES;
+}
+
+/**
+ * @brief Sums every thread, converts ticks with the rate measured since
+ * the registry was created, and prints one row per phase.
+ */
+void reportProfile(std::ostream& out) {
+    double exact_scope_ticks = measureScopeTicks(ProfilePhase::Cycle);
+    double sampled_scope_ticks = measureScopeTicks(ProfilePhase::Reporting);
+    ProfileRegistry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+
+    ProfileAccumulator total;
+    bool counting = false;
+    for (const std::unique_ptr<ProfileAccumulator>& thread : reg.threads) {
+        counting = counting || thread->counting;
+        for (int p = 0; p < PROFILE_PHASES; p++) {
+            total.ticks[p] += thread->ticks[p];
+            total.calls[p] += thread->calls[p];
+            total.timed_calls[p] += thread->timed_calls[p];
+            for (int c = 0; c < PROFILE_COUNTERS; c++) total.counts[p][c] += thread->counts[p][c];
+        }
+    }
+
+    double elapsed_ns = std::chrono::duration<double, std::nano>(
+        std::chrono::steady_clock::now() - reg.start_time).count();
+    double ticks_per_ns = elapsed_ns > 0.0
+        ? static_cast<double>(profileTicks() - reg.start_ticks) / elapsed_ns : 1.0;
+    double run_ticks = static_cast<double>(total.ticks[static_cast<int>(ProfilePhase::Preload)] +
+                                           total.ticks[static_cast<int>(ProfilePhase::Cycle)]);
+    bool sampled = false;
+
+    // untimed entries are scaled up by the sampling ratio of their phase
+    double estimated_ticks[PROFILE_PHASES] = {};
+    double overhead_ticks = 0.0;
+    for (int p = 0; p < PROFILE_PHASES; p++) {
+        if (total.timed_calls[p] == 0) continue;
+        double scale = static_cast<double>(total.calls[p]) / total.timed_calls[p];
+        estimated_ticks[p] = total.ticks[p] * scale;
+        for (int c = 0; c < PROFILE_COUNTERS; c++) total.counts[p][c] = static_cast<std::uint64_t>(total.counts[p][c] * scale);
+        overhead_ticks += total.calls[p] * (p <= static_cast<int>(ProfilePhase::Cycle)
+                                            ? exact_scope_ticks : sampled_scope_ticks);
+    }
+
+    char line[256];
+    std::snprintf(line, sizeof(line), "  Profile: %.2f ticks/ns, %zu thread(s), hardware counters %s\n",
+                  ticks_per_ns, reg.threads.size(),
+                  counting ? "on" : counters_wanted.load() ? "unavailable" : "off");
+    out << line;
+    std::snprintf(line, sizeof(line), "    %-16s %10s %11s %7s %11s", "phase", "calls", "total_ms", "share", "ns/call");
+    out << line;
+    if (counting) {
+        std::snprintf(line, sizeof(line), " %11s %11s %5s %10s %10s",
+                      "cycles/call", "instr/call", "IPC", "cmiss/call", "bmiss/call");
+        out << line;
+    }
+    out << "\n";
+
+    for (int p = 0; p < PROFILE_PHASES; p++) {
+        if (total.timed_calls[p] == 0) continue;
+        sampled = sampled || total.timed_calls[p] < total.calls[p];
+        double ms = estimated_ticks[p] / ticks_per_ns / 1e6;
+        double calls = static_cast<double>(total.calls[p]);
+        double share = run_ticks > 0.0 ? 100.0 * estimated_ticks[p] / run_ticks : 0.0;
+        std::snprintf(line, sizeof(line), "    %-16s %10llu %11.2f %6.1f%% %11.1f",
+                      PHASE_LABELS[p], static_cast<unsigned long long>(total.calls[p]), ms, share,
+                      ms * 1e6 / calls);
+        out << line;
+        if (counting) {
+            double cycles = total.counts[p][0] / calls;
+            double instructions = total.counts[p][1] / calls;
+            std::snprintf(line, sizeof(line), " %11.0f %11.0f %5.2f %10.2f %10.2f",
+                          cycles, instructions, cycles > 0.0 ? instructions / cycles : 0.0,
+                          total.counts[p][2] / calls, total.counts[p][3] / calls);
+            out << line;
+        }
+        out << "\n";
+    }
+
+    double overhead = run_ticks > 0.0 ? 100.0 * overhead_ticks / run_ticks : 0.0;
+    std::snprintf(line, sizeof(line),
+                  "    instrumentation: %.1f ns per timed scope, %.1f ns per sampled scope, about %.2f%% of the run\n",
+                  exact_scope_ticks / ticks_per_ns, sampled_scope_ticks / ticks_per_ns, overhead);
+    out << line;
+    if (sampled) {
+        std::snprintf(line, sizeof(line), "    nested phases timed on 1 in %u entries and scaled up\n",
+                      PROFILE_SAMPLE_PERIOD);
+        out << line;
+    }
+}
+
+#else
+
+/**
+ * @brief Profiling is compiled out.
+ */
+void reportProfile(std::ostream&) {
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,195 @@
+/**
+ * @file Profiler.h
+ * @brief Scoped phase timers for the simulation hot paths.
+ *
+ * PROFILE_SCOPE(phase) charges the time until the end of the enclosing
+ * block to a phase of the simulation cycle. Time is read with rdtsc into
+ * plain per-thread accumulators, so a timed scope costs two TSC reads and
+ * no shared writes. Optionally each timed scope also reads cycles,
+ * instructions, cache misses and branch misses from perf_event_open
+ * counters of its thread (through rdpmc when the kernel allows it).
+ *
+ * Preload and Cycle are timed on every entry, so totals and shares are
+ * exact. The nested phases run per request or per balancer, far more
+ * often, so they are timed on a random 1 in PROFILE_SAMPLE_PERIOD entries
+ * and scaled by calls over timed calls. That keeps the overhead well
+ * under 2% even where rdtsc is slow, as in many VMs.
+ *
+ * Totals are summed over every thread that entered a scope; leaf
+ * processes of a multi-process topology keep their own and are not shown.
+ *
+ * The timers are compiled in only with -DLB_PROFILE (make PROFILE=1);
+ * otherwise PROFILE_SCOPE expands to nothing and costs nothing.
+ */
+
+#pragma once
+#include <cstdint>
+#include <ostream>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <chrono>
+#endif
+
+/**
+ * @enum ProfilePhase
+ * @brief Timed phases. Generation to Reporting run inside Cycle, and
+ * Completion to Scaling inside Step.
+ */
+enum class ProfilePhase {
+    Preload,
+    Cycle,
+    Generation,
+    Routing,
+    Step,
+    Completion,
+    Assignment,
+    Scaling,
+    Forwarding,
+    Reporting,
+    Count
+};
+
+/** @brief Number of timed phases. */
+static const int PROFILE_PHASES = static_cast<int>(ProfilePhase::Count);
+
+/** @brief Hardware counters read per scope when counters are enabled. */
+static const int PROFILE_COUNTERS = 4;
+
+/** @brief One in this many entries of a nested phase is timed (a power of two). */
+static const unsigned int PROFILE_SAMPLE_PERIOD = 8;
+
+/**
+ * @struct ProfileAccumulator
+ * @brief Totals of one thread; only that thread writes them.
+ */
+struct ProfileAccumulator {
+
+    /** @brief Entries per phase, and how many of them were timed. */
+    std::uint64_t calls[PROFILE_PHASES] = {};
+    std::uint64_t timed_calls[PROFILE_PHASES] = {};
+
+    /** @brief Timestamp ticks of the timed entries. */
+    std::uint64_t ticks[PROFILE_PHASES] = {};
+
+    /** @brief Hardware counter deltas of the timed entries. */
+    std::uint64_t counts[PROFILE_PHASES][PROFILE_COUNTERS] = {};
+
+    /** @brief Xorshift state choosing the timed entries. */
+    std::uint32_t sample_state = 0x9E3779B9u;
+
+    /** @brief Whether this thread's counters opened. */
+    bool counting = false;
+
+    /** @brief Counter descriptors and their mmap pages (null without rdpmc). */
+    int fds[PROFILE_COUNTERS] = {-1, -1, -1, -1};
+    void* pages[PROFILE_COUNTERS] = {};
+
+    /**
+     * @brief Reads the current value of every counter.
+     *
+     * @param values Receives PROFILE_COUNTERS values.
+     */
+    void readCounters(std::uint64_t* values);
+
+    /**
+     * @brief Returns whether the next entry of @p phase is timed.
+     */
+    bool sample(int phase) {
+        if (phase <= static_cast<int>(ProfilePhase::Cycle)) return true;
+        sample_state ^= sample_state << 13;
+        sample_state ^= sample_state >> 17;
+        sample_state ^= sample_state << 5;
+        return (sample_state & (PROFILE_SAMPLE_PERIOD - 1)) == 0;
+    }
+};
+
+/**
+ * @brief Returns the calling thread's accumulator, registering it on first use.
+ */
+ProfileAccumulator& registerProfileThread();
+
+/**
+ * @brief Returns the calling thread's accumulator.
+ */
+inline ProfileAccumulator& threadProfile() {
+    static thread_local ProfileAccumulator* accumulator = &registerProfileThread();
+    return *accumulator;
+}
+
+/**
+ * @brief Returns a timestamp in ticks (TSC on x86, nanoseconds elsewhere).
+ */
+inline std::uint64_t profileTicks() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+/**
+ * @class ProfileScope
+ * @brief Charges its lifetime to a phase of the current thread.
+ */
+class ProfileScope {
+private:
+    ProfileAccumulator& accumulator;
+    int phase;
+    bool timed;
+    std::uint64_t start;
+    std::uint64_t start_counts[PROFILE_COUNTERS];
+
+public:
+    explicit ProfileScope(ProfilePhase phase)
+     : accumulator(threadProfile()),
+       phase(static_cast<int>(phase)),
+       timed(accumulator.sample(static_cast<int>(phase))),
+       start(0) {
+        accumulator.calls[this->phase]++;
+        if (!timed) return;
+        if (accumulator.counting) accumulator.readCounters(start_counts);
+        start = profileTicks();
+    }
+
+    ~ProfileScope() {
+        if (!timed) return;
+        accumulator.ticks[phase] += profileTicks() - start;
+        accumulator.timed_calls[phase]++;
+        if (accumulator.counting) {
+            std::uint64_t end_counts[PROFILE_COUNTERS];
+            accumulator.readCounters(end_counts);
+            for (int c = 0; c < PROFILE_COUNTERS; c++) {
+                accumulator.counts[phase][c] += end_counts[c] - start_counts[c];
+            }
+        }
+    }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+};
+
+/**
+ * @brief Makes threads that start profiling from now on also open
+ * hardware counters. Does nothing in builds without LB_PROFILE.
+ */
+void enableProfileCounters();
+
+/**
+ * @brief Prints the per-phase table over all threads; prints nothing in
+ * builds without LB_PROFILE.
+ *
+ * @param out Stream to print to.
+ */
+void reportProfile(std::ostream& out);
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+#ifdef LB_PROFILE
+#define PROFILE_SCOPE(phase) ProfileScope PROFILE_CONCAT(profile_scope_, __LINE__)(phase)
+#else
+#define PROFILE_SCOPE(phase) do {} while (false)
+#endif
\ No newline at end of file
@@ -0,0 +1,165 @@
+/**
+ * @file RateLimiter.cpp
+ * @brief Implementation of the RateLimiter class.
+ */
+
+#include "RateLimiter.h"
+#include "Checkpoint.h"
+#include "MaglevTable.h"
+#include <algorithm>
+
+/**
+ * @brief Constructor implementation.
+ *
+ * Sorts rules so the first match is the longest prefix and sizes the table.
+ */
+RateLimiter::RateLimiter(const std::vector<RateLimitRule>& rules, std::size_t max_sources)
+ : rules(rules), set_mask(0), limited(0), evictions(0) {
+
+    std::stable_sort(this->rules.begin(), this->rules.end(),
+                     [](const RateLimitRule& a, const RateLimitRule& b) {
+                         return a.prefix_length > b.prefix_length;
+                     });
+    if (this->rules.empty()) return;
+
+    std::size_t set_count = 1;
+    while (set_count * WAYS < max_sources) set_count <<= 1;
+    set_mask = set_count - 1;
+
+    Set empty;
+    for (Slot& slot : empty.way) slot = Slot{0, EMPTY, 0.0f, 0};
+    sets.assign(set_count, empty);
+}
+
+/**
+ * @brief Linear scan; rule lists are short, and the result is cached in the
+ * table, so only sources without a slot are scanned.
+ */
+std::uint32_t RateLimiter::matchRule(std::uint32_t key) const {
+    for (std::size_t i = 0; i < rules.size(); i++) {
+        if (key >= rules[i].range.low.getValue() && key <= rules[i].range.high.getValue()) {
+            return static_cast<std::uint32_t>(i);
+        }
+    }
+    return NO_RULE;
+}
+
+/**
+ * @brief Free slots go first, then cached rule-less sources, then buckets.
+ */
+int RateLimiter::evictionRank(const Slot& slot) {
+    if (slot.rule == EMPTY) return 0;
+    return slot.rule == NO_RULE ? 1 : 2;
+}
+
+/**
+ * @brief Finds or claims the source's slot in its set, refills, and spends a token.
+ *
+ * A new source starts with a full bucket. The victim is a free slot if
+ * the set has one, else the least recently seen rule-less source, else the
+ * least recently seen bucket. A source matched by no rule is only cached
+ * when that costs no bucket.
+ */
+bool RateLimiter::allow(const IPAddress& source, int current_cycle) {
+    if (rules.empty()) return true;
+
+    std::uint32_t key = source.getValue();
+    Slot* set = sets[MaglevTable::hash(key, 0x85ebca6bu) & set_mask].way;
+    Slot* slot = nullptr;
+    Slot* victim = &set[0];
+
+    for (std::size_t w = 0; w < WAYS; w++) {
+        if (set[w].rule != EMPTY && set[w].key == key) {
+            slot = &set[w];
+            break;
+        }
+        int rank = evictionRank(set[w]);
+        int victim_rank = evictionRank(*victim);
+        if (rank < victim_rank || (rank == victim_rank && rank > 0 && set[w].last_cycle < victim->last_cycle)) {
+            victim = &set[w];
+        }
+    }
+
+    if (slot == nullptr) {
+        std::uint32_t rule = matchRule(key);
+        if (rule == NO_RULE) {
+            if (evictionRank(*victim) < 2) *victim = Slot{key, NO_RULE, 0.0f, current_cycle};
+            return true;
+        }
+
+        if (evictionRank(*victim) == 2) evictions++;
+        slot = victim;
+        *slot = Slot{key, rule, static_cast<float>(rules[rule].burst), current_cycle};
+    }
+
+    if (slot->rule == NO_RULE) {
+        slot->last_cycle = current_cycle;
+        return true;
+    }
+
+    // lazy refill for the cycles since the bucket was last touched
+    const RateLimitRule& r = rules[slot->rule];
+    double tokens = slot->tokens + r.rate * (current_cycle - slot->last_cycle);
+    tokens = std::min(tokens, r.burst);
+    slot->last_cycle = current_cycle;
+
+    if (tokens < 1.0) {
+        slot->tokens = static_cast<float>(tokens);
+        limited++;
+        return false;
+    }
+    slot->tokens = static_cast<float>(tokens - 1.0);
+    return true;
+}
+
+/**
+ * @brief Returns whether any rule exists.
+ */
+bool RateLimiter::isEnabled() const {
+    return !rules.empty();
+}
+
+/**
+ * @brief Returns refused requests.
+ */
+long long RateLimiter::getLimitedCount() const {
+    return limited;
+}
+
+/**
+ * @brief Returns evictions.
+ */
+long long RateLimiter::getEvictionCount() const {
+    return evictions;
+}
+
+/**
+ * @brief Returns the slot array size in bytes.
+ */
+std::size_t RateLimiter::getMemoryBytes() const {
+    return sets.size() * sizeof(Set);
+}
+
+/**
+ * @brief The bucket table as raw sets, then the counters.
+ */
+void RateLimiter::save(CheckpointWriter& out) const {
+    out.putVector(sets);
+    out.put(limited);
+    out.put(evictions);
+}
+
+/**
+ * @brief Fails if the table was sized differently.
+ */
+void RateLimiter::restore(CheckpointReader& in) {
+    std::size_t expected = sets.size();
+    in.getVector(sets);
+    in.get(limited);
+    in.get(evictions);
+    if (sets.size() != expected) {
+        in.fail("rate limiter table has " + std::to_string(sets.size()) + " sets, configuration has " +
+                std::to_string(expected));
+        sets.assign(expected, Set());
+    }
+}
\ No newline at end of file
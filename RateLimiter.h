@@ -0,0 +1,155 @@
+/**
+ * @file RateLimiter.h
+ * @brief Defines a per-source-IP token-bucket rate limiter with fixed memory.
+ *
+ * Buckets live in a set-associative open-addressing table keyed on the
+ * source address. Each set is four slots (one 64-byte cache line), so a
+ * lookup touches a single line. When a set is full the slot that was used
+ * least recently is evicted, which bounds memory no matter how many
+ * distinct sources arrive. Tokens are refilled lazily on access.
+ */
+
+#pragma once
+#include "IPAddress.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class CheckpointWriter;
+class CheckpointReader;
+
+/**
+ * @struct RateLimitRule
+ * @brief Token rate and burst applied to every source inside a CIDR block.
+ */
+struct RateLimitRule {
+
+    /** @brief Addresses the rule applies to. */
+    IPRange range;
+
+    /** @brief CIDR prefix length; longer prefixes take precedence. */
+    int prefix_length;
+
+    /** @brief Tokens added per clock cycle (requests per cycle sustained). */
+    double rate;
+
+    /** @brief Bucket capacity (largest burst admitted at once). */
+    double burst;
+};
+
+/**
+ * @class RateLimiter
+ * @brief Admits a request if its source's bucket holds at least one token.
+ *
+ * Sources matched by no rule are never limited. Their lookup result is
+ * cached in a rule-less slot so that a repeat source skips the rule scan,
+ * but such a slot only takes a free or rule-less way and never evicts a
+ * token bucket.
+ */
+class RateLimiter {
+private:
+
+    /**
+     * @struct Slot
+     * @brief One token bucket; 16 bytes so four fit in a cache line.
+     */
+    struct Slot {
+        std::uint32_t key;
+        std::uint32_t rule;
+        float tokens;
+        std::int32_t last_cycle;
+    };
+
+    /** @brief Slots per set. */
+    static const std::size_t WAYS = 4;
+
+    /**
+     * @struct Set
+     * @brief Slots sharing one hash value, aligned to a cache line.
+     */
+    struct alignas(64) Set {
+        Slot way[WAYS];
+    };
+
+    /** @brief Marks an unused slot in Slot::rule. */
+    static const std::uint32_t EMPTY = 0xFFFFFFFFu;
+
+    /** @brief Marks, in Slot::rule, a cached source that no rule matches. */
+    static const std::uint32_t NO_RULE = 0xFFFFFFFEu;
+
+    /** @brief Rules ordered by descending prefix length. */
+    std::vector<RateLimitRule> rules;
+
+    /** @brief Table of sets. */
+    std::vector<Set> sets;
+
+    /** @brief Number of sets minus one (set count is a power of two). */
+    std::size_t set_mask;
+
+    /** @brief Requests refused for lack of tokens. */
+    long long limited;
+
+    /** @brief Buckets evicted to make room for a new source. */
+    long long evictions;
+
+    /**
+     * @brief Returns the index of the most specific rule matching @p key,
+     * or NO_RULE if none does.
+     */
+    std::uint32_t matchRule(std::uint32_t key) const;
+
+    /**
+     * @brief Returns a slot's eviction class: 0 free, 1 rule-less, 2 bucket.
+     */
+    static int evictionRank(const Slot& slot);
+
+public:
+
+    /**
+     * @brief Constructs a limiter.
+     *
+     * @param rules Per-CIDR limits; order does not matter.
+     * @param max_sources Bucket budget, rounded up to a power-of-two
+     *                    multiple of the set size.
+     */
+    RateLimiter(const std::vector<RateLimitRule>& rules = {}, std::size_t max_sources = 0);
+
+    /**
+     * @brief Takes one token from the source's bucket if possible.
+     *
+     * @param source Source address of the request.
+     * @param current_cycle Current simulation clock cycle.
+     * @return True to admit, false if the source is over its limit.
+     */
+    bool allow(const IPAddress& source, int current_cycle);
+
+    /**
+     * @brief Returns whether any rule is configured.
+     */
+    bool isEnabled() const;
+
+    /**
+     * @brief Returns the number of requests refused.
+     */
+    long long getLimitedCount() const;
+
+    /**
+     * @brief Returns the number of buckets evicted from full sets.
+     */
+    long long getEvictionCount() const;
+
+    /**
+     * @brief Returns the table's memory footprint in bytes.
+     */
+    std::size_t getMemoryBytes() const;
+
+    /**
+     * @brief Appends the bucket table to a checkpoint.
+     */
+    void save(CheckpointWriter& out) const;
+
+    /**
+     * @brief Replaces the bucket table with one read from a checkpoint.
+     */
+    void restore(CheckpointReader& in);
+};
\ No newline at end of file
@@ -0,0 +1,156 @@
+/**
+ * @file RcuCell.h
+ * @brief Read-copy-update cell with quiescent-state-based reclamation.
+ *
+ * A writer thread replaces an immutable value by publishing a new pointer
+ * with one atomic store. The reader never locks: it loads the pointer and
+ * announces a quiescent state (a point where it holds no reference) once
+ * per simulation cycle. An old value is freed only after the reader has
+ * passed a quiescent state that started after the swap.
+ *
+ * The cell supports a single reader thread, which is how the Switch
+ * consumes it, and a single writer thread.
+ */
+
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @class RcuCell
+ * @brief Holds the current immutable snapshot of type T.
+ *
+ * @tparam T Snapshot type; never modified after publication.
+ */
+template <typename T>
+class RcuCell {
+private:
+
+    /**
+     * @struct Retired
+     * @brief A replaced snapshot waiting for the reader to move on.
+     */
+    struct Retired {
+        const T* value;
+        std::uint64_t epoch;
+        std::chrono::steady_clock::time_point retired_at;
+    };
+
+    /** @brief Snapshot readers see. */
+    alignas(64) std::atomic<const T*> current{nullptr};
+
+    /** @brief Number of publications so far. */
+    std::atomic<std::uint64_t> epoch{0};
+
+    /** @brief Latest epoch the reader has observed at a quiescent state. */
+    alignas(64) std::atomic<std::uint64_t> reader_epoch{0};
+
+    /** @brief Snapshots replaced but not yet freed (writer only). */
+    std::vector<Retired> retired;
+
+    /** @brief Snapshots freed so far. */
+    std::atomic<long long> reclaimed{0};
+
+    /** @brief Snapshots retired but not yet freed. */
+    std::atomic<long long> pending{0};
+
+    /** @brief Sum of retire-to-free delays, in microseconds. */
+    std::atomic<long long> reclaim_delay_us{0};
+
+public:
+
+    RcuCell() = default;
+
+    /** @brief The cell owns its snapshots and is not copied. */
+    RcuCell(const RcuCell&) = delete;
+    RcuCell& operator=(const RcuCell&) = delete;
+
+    /**
+     * @brief Frees the current and all retired snapshots.
+     *
+     * The reader and writer must both have stopped.
+     */
+    ~RcuCell() {
+        delete current.load(std::memory_order_relaxed);
+        for (const Retired& r : retired) delete r.value;
+    }
+
+    /**
+     * @brief Returns the current snapshot (reader side).
+     *
+     * The pointer stays valid until the reader's next quiescent().
+     */
+    const T* read() const {
+        return current.load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief Announces that the reader holds no snapshot reference.
+     */
+    void quiescent() {
+        reader_epoch.store(epoch.load(std::memory_order_acquire), std::memory_order_release);
+    }
+
+    /**
+     * @brief Installs a new snapshot and retires the old one (writer side).
+     *
+     * @param value Heap-allocated snapshot; the cell takes ownership.
+     */
+    void publish(const T* value) {
+        const T* old = current.exchange(value, std::memory_order_acq_rel);
+        std::uint64_t e = epoch.fetch_add(1, std::memory_order_acq_rel) + 1;
+        if (old != nullptr) {
+            retired.push_back(Retired{old, e, std::chrono::steady_clock::now()});
+            pending.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * @brief Frees retired snapshots the reader can no longer hold (writer side).
+     *
+     * @return Number of snapshots freed.
+     */
+    std::size_t reclaim() {
+        std::uint64_t seen = reader_epoch.load(std::memory_order_acquire);
+        auto now = std::chrono::steady_clock::now();
+        std::size_t freed = 0;
+
+        std::size_t kept = 0;
+        for (std::size_t i = 0; i < retired.size(); i++) {
+            if (retired[i].epoch <= seen) {
+                delete retired[i].value;
+                reclaim_delay_us.fetch_add(
+                    std::chrono::duration_cast<std::chrono::microseconds>(
+                        now - retired[i].retired_at).count(),
+                    std::memory_order_relaxed);
+                freed++;
+            } else {
+                retired[kept++] = retired[i];
+            }
+        }
+        retired.resize(kept);
+
+        reclaimed.fetch_add(static_cast<long long>(freed), std::memory_order_relaxed);
+        pending.fetch_sub(static_cast<long long>(freed), std::memory_order_relaxed);
+        return freed;
+    }
+
+    /** @brief Returns the number of snapshots freed. */
+    long long getReclaimedCount() const {
+        return reclaimed.load(std::memory_order_relaxed);
+    }
+
+    /** @brief Returns the number of retired snapshots not yet freed. */
+    long long getPendingCount() const {
+        return pending.load(std::memory_order_relaxed);
+    }
+
+    /** @brief Returns the mean retire-to-free delay in microseconds. */
+    double getMeanReclaimDelayUs() const {
+        long long n = getReclaimedCount();
+        return n > 0 ? static_cast<double>(reclaim_delay_us.load(std::memory_order_relaxed)) / n : 0.0;
+    }
+};
\ No newline at end of file
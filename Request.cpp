@@ -11,10 +11,14 @@
  * Initializes the request with:
  * - Default source and destination IPs
  * - Processing time of 0
- * - Default job type 'P'
+ * - Job class 0 with a single-stage route
+ * - Priority class 0 and arrival cycle 0
+ * - Id 0, no deadline, first attempt, not hedged
  */
 Request::Request()
- : in(), out(), time(0), job('P') {}
+ : in(), out(), time(0), job_class(0), route{0}, route_length(1), stage(0),
+   stage_arrival_cycle(0), priority(0), arrival_cycle(0),
+   id(0), deadline(-1), attempt(0), hedged(false), hedge_copy(false) {}
 
 /**
  * @brief Parameterized constructor implementation.
@@ -22,7 +26,10 @@ Request::Request()
  * @param in Source IP address
  * @param out Destination IP address
  * @param time Processing time in clock cycles
- * @param job Job type ('P' for processing, 'S' for streaming)
+ * @param job_class Dense job class id
  */
-Request::Request(IPAddress& in, IPAddress& out, int time, char job)
- : in(in), out(out), time(time), job(job) {}
\ No newline at end of file
+Request::Request(IPAddress& in, IPAddress& out, int time, int job_class)
+ : in(in), out(out), time(time), job_class(job_class),
+   route{static_cast<unsigned short>(job_class)}, route_length(1), stage(0),
+   stage_arrival_cycle(0), priority(0), arrival_cycle(0),
+   id(0), deadline(-1), attempt(0), hedged(false), hedge_copy(false) {}
\ No newline at end of file
@@ -6,7 +6,10 @@
  * - Source IP address
  * - Destination IP address
  * - Processing time (in clock cycles)
- * - Job type (Processing or Streaming)
+ * - Job class id from the Switch's class registry
+ * - Priority class and arrival cycle, used for scheduling and latency
+ * - Identity, deadline and retry/hedge bookkeeping
+ * - A route of job classes for multi-stage requests
  */
 
 #pragma once
@@ -37,13 +40,77 @@ struct Request {
      */
     int time;
 
+    /** @brief Maximum number of stages in a request's route. */
+    static constexpr int MAX_STAGES = 4;
+
+    /**
+     * @brief Job class id: index into the Switch's class registry and its
+     * table of balancer groups. Always equals route[stage].
+     */
+    int job_class;
+
+    /**
+     * @brief Job class ids of the stages the request passes through, in order.
+     */
+    unsigned short route[MAX_STAGES];
+
+    /** @brief Number of valid entries in route (1 = single stage). */
+    unsigned char route_length;
+
+    /** @brief Index of the current stage in route. */
+    unsigned char stage;
+
+    /**
+     * @brief Clock cycle at which the request entered its current stage.
+     */
+    int stage_arrival_cycle;
+
+    /**
+     * @brief Priority class (0 = most urgent).
+     *
+     * Only the priority queue discipline orders by it; every discipline
+     * reports latency per class.
+     */
+    int priority;
+
+    /**
+     * @brief Clock cycle at which the request entered the system.
+     */
+    int arrival_cycle;
+
+    /**
+     * @brief Identifier shared by every retry and hedge copy of one client request.
+     */
+    long long id;
+
     /**
-     * @brief Job type identifier.
+     * @brief Last clock cycle at which the request may still start (-1 = none).
      *
-     * 'P' = Processing workload  
-     * 'S' = Streaming workload
+     * A request still queued after its deadline is dropped when it reaches
+     * the head of the queue instead of occupying a server.
+     */
+    int deadline;
+
+    /**
+     * @brief Number of earlier attempts that timed out (0 = first attempt).
+     */
+    int attempt;
+
+    /**
+     * @brief Whether another copy of this request may be in flight.
+     * Only hedged requests consult the Switch's HedgeTracker before starting.
+     */
+    bool hedged;
+
+    /**
+     * @brief Whether this is the duplicate sent after the hedge delay.
+     */
+    bool hedge_copy;
+
+    /**
+     * @brief Returns whether another stage follows the current one.
      */
-    char job;
+    bool hasNextStage() const { return stage + 1 < route_length; }
 
     /**
      * @brief Default constructor.
@@ -51,7 +118,9 @@ struct Request {
      * Initializes:
      * - in and out to default IPAddress (0.0.0.0)
      * - time to 0
-     * - job type to 'P'
+     * - job class to 0 with a single-stage route
+     * - priority and arrival cycle to 0
+     * - id to 0, no deadline, first attempt, not hedged
      */
     Request();
 
@@ -61,7 +130,7 @@ struct Request {
      * @param in Source IP address
      * @param out Destination IP address
      * @param time Number of clock cycles required
-     * @param job Job type ('P' or 'S')
+     * @param job_class Job class id
      */
-    Request(IPAddress& in, IPAddress& out, int time, char job);
+    Request(IPAddress& in, IPAddress& out, int time, int job_class);
 };
\ No newline at end of file
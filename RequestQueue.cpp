@@ -1,33 +1,367 @@
 /**
  * @file RequestQueue.cpp
- * @brief Implementation of the RequestQueue wrapper class.
+ * @brief Implementation of the RequestQueue scheduling disciplines.
  */
 
 #include "RequestQueue.h"
+#include "Checkpoint.h"
+#include "MaglevTable.h"
+#include <algorithm>
 
 /**
- * @brief Pushes a request onto the queue.
+ * @brief Constructor implementation.
+ *
+ * Sizes the per-class and per-bucket containers for the chosen discipline,
+ * and for a FIFO queue with a memory budget prepares its spill file.
+ */
+RequestQueue::RequestQueue(const QueueConfig& config)
+ : config(config),
+   count(0),
+   next_seq(0),
+   memory_requests(0),
+   block_requests(0),
+   sjf_root(-1),
+   nonempty_classes(0),
+   wfq_virtual_time(0.0) {
+
+    if (this->config.discipline == QueueDiscipline::Priority) {
+        this->config.priority_classes = std::clamp(this->config.priority_classes, 1, 32);
+        class_queues.resize(this->config.priority_classes);
+    }
+    if (this->config.discipline == QueueDiscipline::WFQ) {
+        this->config.wfq_buckets = std::max(this->config.wfq_buckets, 1);
+        wfq_queues.resize(this->config.wfq_buckets);
+        wfq_last_finish.assign(this->config.wfq_buckets, 0.0);
+    }
+    // only arrival order can be cut into blocks that are served whole
+    if (this->config.discipline != QueueDiscipline::FIFO) this->config.memory_limit = 0;
+    if (this->config.memory_limit > 0) {
+        spill = std::make_unique<SpillFile>(this->config.spill_directory, this->config.spill_block);
+        block_requests = spill->getBlockRequests();
+        // at least one block's room at each end
+        memory_requests = std::max(this->config.memory_limit / sizeof(Request), 2 * block_requests);
+    }
+}
+
+/**
+ * @brief Clamps a request's priority to a valid class index.
+ */
+int RequestQueue::classOf(const Request& request) const {
+    return std::clamp(request.priority, 0, config.priority_classes - 1);
+}
+
+/**
+ * @brief Hashes the source IP into a WFQ bucket.
+ */
+int RequestQueue::bucketOf(const Request& request) const {
+    return static_cast<int>(MaglevTable::hash(request.in.getValue(), 0x27d4eb2fu)
+                            % static_cast<unsigned int>(config.wfq_buckets));
+}
+
+/**
+ * @brief Returns the configured weight of a WFQ bucket.
+ */
+double RequestQueue::weightOf(int bucket) const {
+    if (config.wfq_weights.empty()) return 1.0;
+    double w = config.wfq_weights[bucket % config.wfq_weights.size()];
+    return w > 0.0 ? w : 1.0;
+}
+
+/**
+ * @brief Orders two heap nodes: longer jobs, then later arrivals, go last.
+ */
+bool RequestQueue::servedLater(int a, int b) const {
+    const HeapNode& na = sjf_nodes[a];
+    const HeapNode& nb = sjf_nodes[b];
+    return na.request.time > nb.request.time ||
+           (na.request.time == nb.request.time && na.seq > nb.seq);
+}
+
+/**
+ * @brief Links two heap roots; the one with the longer job becomes a child.
+ */
+int RequestQueue::linkNodes(int a, int b) {
+    if (a < 0) return b;
+    if (b < 0) return a;
+
+    bool a_first = servedLater(b, a);
+    int parent = a_first ? a : b;
+    int child = a_first ? b : a;
+
+    sjf_nodes[child].sibling = sjf_nodes[parent].child;
+    sjf_nodes[parent].child = child;
+    return parent;
+}
+
+/**
+ * @brief Two-pass pairing of a sibling list, done iteratively.
+ */
+int RequestQueue::mergePairs(int first) {
+    std::vector<int>& pairs = sjf_pairs;
+    pairs.clear();
+    while (first >= 0) {
+        int a = first;
+        int b = sjf_nodes[a].sibling;
+        first = (b >= 0) ? sjf_nodes[b].sibling : -1;
+        sjf_nodes[a].sibling = -1;
+        if (b >= 0) sjf_nodes[b].sibling = -1;
+        pairs.push_back(linkNodes(a, b));
+    }
+
+    int root = -1;
+    for (auto it = pairs.rbegin(); it != pairs.rend(); ++it) {
+        root = linkNodes(*it, root);
+    }
+    return root;
+}
+
+/**
+ * @brief Appends to a FIFO queue with a memory budget.
+ *
+ * The head takes arrivals until it is a block short of the budget; after
+ * that everything goes to the tail, behind whatever was spilled, and the
+ * oldest block of the tail is written out whenever head and tail
+ * together reach the budget.
+ */
+void RequestQueue::pushFifo(const Request& request) {
+    if (tail.empty() && spill->empty() && queue.size() + block_requests < memory_requests) {
+        queue.push_back(request);
+        return;
+    }
+    tail.push_back(request);
+    if (tail.size() >= block_requests && queue.size() + tail.size() >= memory_requests) {
+        spill->pushBack(tail);
+    }
+}
+
+/**
+ * @brief Prefetches the next block once the head is down to one block,
+ * and refills an empty head from disk, or from the tail when nothing is
+ * spilled.
+ */
+void RequestQueue::refillHead() {
+    if (queue.size() <= block_requests) spill->prefetchFront();
+    if (!queue.empty()) return;
+    if (!spill->empty()) {
+        spill->popFront(queue);
+    } else {
+        queue.swap(tail);
+    }
+}
+
+/**
+ * @brief Returns the part of a FIFO queue holding its newest request,
+ * reading the newest block back into the tail if that is where it is.
+ */
+std::deque<Request>& RequestQueue::backPart() {
+    if (tail.empty() && spill && !spill->empty()) spill->popBack(tail);
+    return tail.empty() ? queue : tail;
+}
+
+/**
+ * @brief Pushes a request according to the active discipline.
  *
  * @param request Request to enqueue.
  */
 void RequestQueue::push(Request& request) {
-    queue.push(request);
+    std::uint64_t seq = next_seq++;
+    count++;
+
+    switch (config.discipline) {
+    case QueueDiscipline::FIFO:
+        if (spill) {
+            pushFifo(request);
+        } else {
+            queue.push_back(request);
+        }
+        break;
+
+    case QueueDiscipline::SJF: {
+        int node;
+        if (!sjf_free.empty()) {
+            node = sjf_free.back();
+            sjf_free.pop_back();
+        } else {
+            node = static_cast<int>(sjf_nodes.size());
+            sjf_nodes.emplace_back();
+        }
+        sjf_nodes[node] = HeapNode{request, seq, -1, -1};
+        sjf_root = linkNodes(sjf_root, node);
+        break;
+    }
+
+    case QueueDiscipline::Priority: {
+        int c = classOf(request);
+        class_queues[c].push_back(request);
+        nonempty_classes |= 1u << c;
+        break;
+    }
+
+    case QueueDiscipline::WFQ: {
+        int b = bucketOf(request);
+        double start = std::max(wfq_virtual_time, wfq_last_finish[b]);
+        double finish = start + request.time / weightOf(b);
+        wfq_last_finish[b] = finish;
+        wfq_queues[b].emplace_back(finish, request);
+        if (wfq_queues[b].size() == 1) {
+            wfq_heads.push(WfqHead{finish, seq, b});
+        }
+        break;
+    }
+    }
 }
 
 /**
- * @brief Removes the front request from the queue.
+ * @brief Removes the front request.
  */
 void RequestQueue::pop() {
-    queue.pop();
+    count--;
+
+    switch (config.discipline) {
+    case QueueDiscipline::FIFO:
+        queue.pop_front();
+        if (spill) refillHead();
+        break;
+
+    case QueueDiscipline::SJF: {
+        int old_root = sjf_root;
+        sjf_root = mergePairs(sjf_nodes[old_root].child);
+        sjf_free.push_back(old_root);
+        break;
+    }
+
+    case QueueDiscipline::Priority: {
+        int c = __builtin_ctz(nonempty_classes);
+        class_queues[c].pop_front();
+        if (class_queues[c].empty()) nonempty_classes &= ~(1u << c);
+        break;
+    }
+
+    case QueueDiscipline::WFQ: {
+        WfqHead head = wfq_heads.top();
+        wfq_heads.pop();
+        std::deque<std::pair<double, Request>>& bucket = wfq_queues[head.bucket];
+        // self-clocked: virtual time is the finish tag of the request in service
+        wfq_virtual_time = bucket.front().first;
+        bucket.pop_front();
+        if (!bucket.empty()) {
+            wfq_heads.push(WfqHead{bucket.front().first, next_seq++, head.bucket});
+        }
+        break;
+    }
+    }
 }
 
 /**
- * @brief Returns the request at the front of the queue.
+ * @brief Returns the request that will be served next.
  *
  * @return Reference to front Request.
  */
 Request& RequestQueue::front() {
-    return queue.front();
+    switch (config.discipline) {
+    case QueueDiscipline::SJF:
+        return sjf_nodes[sjf_root].request;
+    case QueueDiscipline::Priority:
+        return class_queues[__builtin_ctz(nonempty_classes)].front();
+    case QueueDiscipline::WFQ:
+        return wfq_queues[wfq_heads.top().bucket].front().second;
+    case QueueDiscipline::FIFO:
+    default:
+        return queue.front();
+    }
+}
+
+/**
+ * @brief Removes up to @p max_requests from the end of service order.
+ *
+ * SJF collects every heap node, keeps the longest jobs and relinks the
+ * rest into a fresh heap. WFQ repeatedly takes the latest finish tag,
+ * which is always at the back of some bucket, and rolls that bucket's
+ * last finish back so later arrivals are not charged for removed work.
+ *
+ * @return Number of requests moved into @p out.
+ */
+std::size_t RequestQueue::popBack(std::size_t max_requests, std::vector<Request>& out) {
+    std::size_t taken = std::min(max_requests, count);
+    if (taken == 0) return 0;
+    count -= taken;
+
+    switch (config.discipline) {
+    case QueueDiscipline::FIFO:
+        for (std::size_t i = 0; i < taken; i++) {
+            std::deque<Request>& part = backPart();
+            out.push_back(part.back());
+            part.pop_back();
+        }
+        break;
+
+    case QueueDiscipline::Priority:
+        for (std::size_t i = 0; i < taken; i++) {
+            int c = 31 - __builtin_clz(nonempty_classes);
+            out.push_back(class_queues[c].back());
+            class_queues[c].pop_back();
+            if (class_queues[c].empty()) nonempty_classes &= ~(1u << c);
+        }
+        break;
+
+    case QueueDiscipline::SJF: {
+        // the node list doubles as the breadth-first worklist
+        std::vector<int>& nodes = sjf_pairs;
+        nodes.clear();
+        nodes.push_back(sjf_root);
+        for (std::size_t i = 0; i < nodes.size(); i++) {
+            for (int c = sjf_nodes[nodes[i]].child; c >= 0; c = sjf_nodes[c].sibling) {
+                nodes.push_back(c);
+            }
+        }
+
+        auto later = [this](int a, int b) { return servedLater(a, b); };
+        auto split = nodes.begin() + static_cast<std::ptrdiff_t>(taken);
+        std::nth_element(nodes.begin(), split, nodes.end(), later);
+        std::sort(nodes.begin(), split, later);
+        for (auto it = nodes.begin(); it != split; ++it) {
+            out.push_back(sjf_nodes[*it].request);
+            sjf_free.push_back(*it);
+        }
+
+        sjf_root = -1;
+        for (auto it = split; it != nodes.end(); ++it) {
+            sjf_nodes[*it].child = -1;
+            sjf_nodes[*it].sibling = -1;
+            sjf_root = linkNodes(sjf_root, *it);
+        }
+        break;
+    }
+
+    case QueueDiscipline::WFQ: {
+        bool emptied = false;
+        for (std::size_t i = 0; i < taken; i++) {
+            int latest = -1;
+            for (int b = 0; b < config.wfq_buckets; b++) {
+                if (wfq_queues[b].empty()) continue;
+                if (latest < 0 || wfq_queues[b].back().first > wfq_queues[latest].back().first) latest = b;
+            }
+            std::deque<std::pair<double, Request>>& bucket = wfq_queues[latest];
+            const std::pair<double, Request>& last = bucket.back();
+            out.push_back(last.second);
+            wfq_last_finish[latest] = bucket.size() > 1 ? bucket[bucket.size() - 2].first
+                                                        : last.first - last.second.time / weightOf(latest);
+            bucket.pop_back();
+            emptied = emptied || bucket.empty();
+        }
+
+        // drop the scheduling entries of buckets that are now empty
+        if (emptied) {
+            std::vector<WfqHead> heads;
+            for (; !wfq_heads.empty(); wfq_heads.pop()) {
+                if (!wfq_queues[wfq_heads.top().bucket].empty()) heads.push_back(wfq_heads.top());
+            }
+            for (const WfqHead& head : heads) wfq_heads.push(head);
+        }
+        break;
+    }
+    }
+    return taken;
 }
 
 /**
@@ -36,7 +370,7 @@ Request& RequestQueue::front() {
  * @return True if no requests are stored.
  */
 bool RequestQueue::empty() {
-    return queue.empty();
+    return count == 0;
 }
 
 /**
@@ -45,5 +379,116 @@ bool RequestQueue::empty() {
  * @return Current queue size.
  */
 std::size_t RequestQueue::size() {
-    return queue.size();
+    return count;
+}
+
+/**
+ * @brief Returns the scheduling discipline.
+ */
+QueueDiscipline RequestQueue::getDiscipline() const {
+    return config.discipline;
+}
+
+/**
+ * @brief Maps a discipline back to its config file name.
+ */
+const char* queueDisciplineName(QueueDiscipline discipline) {
+    switch (discipline) {
+        case QueueDiscipline::SJF: return "sjf";
+        case QueueDiscipline::Priority: return "priority";
+        case QueueDiscipline::WFQ: return "wfq";
+        default: return "fifo";
+    }
+}
+
+/**
+ * @brief Returns the spill file's counters.
+ */
+SpillStats RequestQueue::getSpillStats() const {
+    return spill ? spill->getStats() : SpillStats();
+}
+
+/**
+ * @brief The discipline's shape, then every container as stored, so
+ * heap layouts and tie-breaking sequence numbers survive a restore.
+ */
+void RequestQueue::save(CheckpointWriter& out) const {
+    out.put(static_cast<int>(config.discipline));
+    out.put(config.priority_classes);
+    out.put(config.wfq_buckets);
+    out.put<std::uint64_t>(count);
+    out.put(next_seq);
+
+    // a spilled FIFO queue is written as one deque, head to tail
+    out.put<std::uint64_t>(queue.size() + tail.size() + (spill ? spill->size() : 0));
+    for (const Request& request : queue) out.put(request);
+    if (spill) spill->forEach([&](const Request& request) { out.put(request); });
+    for (const Request& request : tail) out.put(request);
+
+    out.putVector(sjf_nodes);
+    out.putVector(sjf_free);
+    out.put(sjf_root);
+
+    for (const std::deque<Request>& class_queue : class_queues) out.putDeque(class_queue);
+    out.put(nonempty_classes);
+
+    for (const std::deque<std::pair<double, Request>>& bucket : wfq_queues) {
+        out.put<std::uint64_t>(bucket.size());
+        for (const std::pair<double, Request>& entry : bucket) {
+            out.put(entry.first);
+            out.put(entry.second);
+        }
+    }
+    out.putVector(wfq_last_finish);
+    out.putVector(heapStorage(wfq_heads));
+    out.put(wfq_virtual_time);
+}
+
+/**
+ * @brief Fails unless the discipline, class count and bucket count match
+ * the configuration; the containers are then replaced wholesale.
+ */
+void RequestQueue::restore(CheckpointReader& in) {
+    int discipline = in.get<int>();
+    int priority_classes = in.get<int>();
+    int wfq_buckets = in.get<int>();
+    if (in.ok() && (discipline != static_cast<int>(config.discipline) ||
+                    (config.discipline == QueueDiscipline::Priority &&
+                     priority_classes != config.priority_classes) ||
+                    (config.discipline == QueueDiscipline::WFQ && wfq_buckets != config.wfq_buckets))) {
+        in.fail("queue discipline differs from the configuration");
+        return;
+    }
+    count = static_cast<std::size_t>(in.get<std::uint64_t>());
+    in.get(next_seq);
+
+    if (spill) {
+        // refilled through the budget, so it spills again as it grows
+        queue.clear();
+        tail.clear();
+        spill->clear();
+        std::uint64_t requests = in.get<std::uint64_t>();
+        for (std::uint64_t i = 0; i < requests && in.ok(); i++) pushFifo(in.get<Request>());
+    } else {
+        in.getDeque(queue);
+    }
+
+    in.getVector(sjf_nodes);
+    in.getVector(sjf_free);
+    in.get(sjf_root);
+
+    for (std::deque<Request>& class_queue : class_queues) in.getDeque(class_queue);
+    in.get(nonempty_classes);
+
+    for (std::deque<std::pair<double, Request>>& bucket : wfq_queues) {
+        bucket.clear();
+        std::uint64_t entries = in.get<std::uint64_t>();
+        for (std::uint64_t i = 0; i < entries && in.ok(); i++) {
+            double finish = in.get<double>();
+            bucket.emplace_back(finish, in.get<Request>());
+        }
+    }
+    in.getVector(wfq_last_finish);
+    in.getVector(heapStorage(wfq_heads));
+    in.get(wfq_virtual_time);
 }
\ No newline at end of file
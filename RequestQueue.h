@@ -1,57 +1,231 @@
 /**
  * @file RequestQueue.h
- * @brief Wrapper class around std::queue for handling Request objects.
+ * @brief Request queue with selectable scheduling disciplines.
  *
- * This class encapsulates a standard FIFO queue of Request objects.
- * It allows for future extension (e.g., logging, metrics, priority handling)
- * without modifying the rest of the system.
+ * The queue keeps the push/front/pop interface of a FIFO queue while the
+ * order in which requests come out is decided by a QueueDiscipline:
+ * - FIFO: arrival order (std::deque, O(1))
+ * - SJF: shortest processing time first (pairing heap, O(1) push,
+ *   O(log n) amortized pop)
+ * - Priority: strict priority classes, FIFO within a class (one deque per
+ *   class plus a bitmask of non-empty classes, O(1))
+ * - WFQ: weighted fair queueing across source-IP buckets (self-clocked
+ *   finish tags, O(log buckets))
+ *
+ * A FIFO queue can be given a memory budget. Beyond it the queue is kept
+ * in three parts: a head that requests are served from, a tail that
+ * arrivals are appended to, and in between a SpillFile of blocks cut from
+ * the front of the tail. Requests keep their arrival order; only the
+ * part that would be served neither soon nor stolen soon leaves memory.
  */
 
 #pragma once
 #include "Request.h"
+#include "SpillFile.h"
 #include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
 #include <queue>
+#include <string>
+#include <utility>
+#include <vector>
+
+class CheckpointWriter;
+class CheckpointReader;
+
+/**
+ * @enum QueueDiscipline
+ * @brief Order in which a RequestQueue releases requests.
+ */
+enum class QueueDiscipline {
+    /** @brief First in, first out. */
+    FIFO,
+    /** @brief Shortest job first (non-preemptive SRPT). */
+    SJF,
+    /** @brief Strict priority by Request::priority, FIFO within a class. */
+    Priority,
+    /** @brief Weighted fair queueing across hashed source-IP buckets. */
+    WFQ
+};
+
+/**
+ * @brief Returns the queue_discipline name of a discipline ("fifo", "sjf",
+ * "priority", "wfq").
+ */
+const char* queueDisciplineName(QueueDiscipline discipline);
+
+/**
+ * @struct QueueConfig
+ * @brief Scheduling parameters for a RequestQueue.
+ */
+struct QueueConfig {
+
+    /** @brief Scheduling discipline. */
+    QueueDiscipline discipline = QueueDiscipline::FIFO;
+
+    /** @brief Number of priority classes (Priority discipline, max 32). */
+    int priority_classes = 1;
+
+    /** @brief Number of source-IP buckets (WFQ discipline). */
+    int wfq_buckets = 16;
+
+    /**
+     * @brief Per-bucket weights, repeated cyclically over the buckets.
+     * Empty means every bucket has weight 1.
+     */
+    std::vector<double> wfq_weights;
+
+    /**
+     * @brief Bytes of requests a FIFO queue keeps in memory before it
+     * spills to disk (0 = never spill; other disciplines never spill).
+     */
+    std::size_t memory_limit = 0;
+
+    /** @brief Bytes written to or read from disk at a time. */
+    std::size_t spill_block = 4 << 20;
+
+    /** @brief Directory of the spill files. */
+    std::string spill_directory = "/tmp";
+};
 
 /**
  * @class RequestQueue
- * @brief FIFO queue abstraction for managing incoming requests.
+ * @brief Queue abstraction for managing incoming requests.
  *
- * Internally uses std::queue<Request> to store and manage requests.
- * Designed as a wrapper to allow additional functionality later
- * (e.g., monitoring queue length, filtering, statistics collection).
+ * Designed as a wrapper so scheduling can change without touching the
+ * rest of the system. The tail is also accessible so other balancers can
+ * steal the work that would be served last: the newest arrivals (FIFO),
+ * the newest of the lowest class (Priority), the longest jobs (SJF) or the
+ * latest finish tags (WFQ).
  */
 class RequestQueue {
 private:
 
     /**
-     * @brief Underlying STL queue storing Request objects.
+     * @brief Node of the SJF pairing heap, addressed by index into sjf_nodes.
+     */
+    struct HeapNode {
+        Request request;
+        std::uint64_t seq;
+        int child;
+        int sibling;
+    };
+
+    /**
+     * @brief Entry of the WFQ scheduling heap: one per non-empty bucket.
+     */
+    struct WfqHead {
+        double finish;
+        std::uint64_t seq;
+        int bucket;
+        bool operator>(const WfqHead& other) const {
+            if (finish != other.finish) return finish > other.finish;
+            return seq > other.seq;
+        }
+    };
+
+    /** @brief Active scheduling parameters. */
+    QueueConfig config;
+
+    /** @brief Number of stored requests. */
+    std::size_t count;
+
+    /** @brief Arrival counter used to break ties in FIFO order. */
+    std::uint64_t next_seq;
+
+    /**
+     * @brief Underlying STL deque storing Request objects (FIFO); the head
+     * of the queue when it spills.
      */
-    std::queue<Request> queue;
+    std::deque<Request> queue;
+
+    /** @name Disk spill (FIFO with a memory budget) */
+    ///@{
+    /** @brief Blocks between the head and the tail (null if disabled). */
+    std::unique_ptr<SpillFile> spill;
+    /** @brief Newest requests, kept in memory behind the spilled blocks. */
+    std::deque<Request> tail;
+    /** @brief Requests kept in memory, head and tail together. */
+    std::size_t memory_requests;
+    /** @brief Requests per spilled block. */
+    std::size_t block_requests;
+    void pushFifo(const Request& request);
+    void refillHead();
+    std::deque<Request>& backPart();
+    ///@}
+
+    /** @name SJF pairing heap */
+    ///@{
+    std::vector<HeapNode> sjf_nodes;
+    std::vector<int> sjf_free;
+    std::vector<int> sjf_pairs;
+    int sjf_root;
+    int linkNodes(int a, int b);
+    int mergePairs(int first);
+    bool servedLater(int a, int b) const;
+    ///@}
+
+    /** @name Priority classes */
+    ///@{
+    std::vector<std::deque<Request>> class_queues;
+    std::uint32_t nonempty_classes;
+    int classOf(const Request& request) const;
+    ///@}
+
+    /** @name Weighted fair queueing */
+    ///@{
+    std::vector<std::deque<std::pair<double, Request>>> wfq_queues;
+    std::vector<double> wfq_last_finish;
+    std::priority_queue<WfqHead, std::vector<WfqHead>, std::greater<WfqHead>> wfq_heads;
+    double wfq_virtual_time;
+    int bucketOf(const Request& request) const;
+    double weightOf(int bucket) const;
+    ///@}
 
 public:
 
     /**
-     * @brief Adds a request to the back of the queue.
+     * @brief Constructs an empty queue.
+     *
+     * @param config Scheduling discipline and its parameters.
+     */
+    explicit RequestQueue(const QueueConfig& config = QueueConfig());
+
+    /**
+     * @brief Adds a request to the queue.
      *
      * @param request Request object to be added.
      */
     void push(Request& request);
 
     /**
-     * @brief Removes the request at the front of the queue.
+     * @brief Removes the request that front() returns.
      *
      * Behavior is undefined if the queue is empty.
      */
     void pop();
 
     /**
-     * @brief Returns a reference to the front request.
+     * @brief Returns a reference to the next request to serve.
      *
-     * @return Reference to the first Request in the queue.
+     * @return Reference to the first Request in service order.
      * @warning Calling this on an empty queue results in undefined behavior.
      */
     Request& front();
 
+    /**
+     * @brief Removes the requests that would be served last.
+     *
+     * SJF walks its whole heap once per call, so take the tail in one call
+     * rather than one request at a time.
+     *
+     * @param max_requests Upper bound on requests to remove.
+     * @param out Receives the removed requests, the last in service order first.
+     * @return Number of requests removed.
+     */
+    std::size_t popBack(std::size_t max_requests, std::vector<Request>& out);
+
     /**
      * @brief Checks whether the queue is empty.
      *
@@ -65,4 +239,24 @@ public:
      * @return Size of the queue.
      */
     std::size_t size();
+
+    /**
+     * @brief Returns the active scheduling discipline.
+     */
+    QueueDiscipline getDiscipline() const;
+
+    /**
+     * @brief Returns the traffic to and from disk (all zero without a budget).
+     */
+    SpillStats getSpillStats() const;
+
+    /**
+     * @brief Appends the queue to a checkpoint.
+     */
+    void save(CheckpointWriter& out) const;
+
+    /**
+     * @brief Replaces the queue with one read from a checkpoint.
+     */
+    void restore(CheckpointReader& in);
 };
\ No newline at end of file
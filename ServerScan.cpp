@@ -0,0 +1,151 @@
+/**
+ * @file ServerScan.cpp
+ * @brief Scalar, SSE2 and AVX2 implementations of the server scan.
+ */
+
+#include "ServerScan.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SERVER_SCAN_X86 1
+#endif
+
+/**
+ * @brief Packs the comparison of one block of up to 64 entries.
+ */
+static std::uint64_t scanWordScalar(const int* values, std::size_t count, int limit) {
+    std::uint64_t bits = 0;
+    for (std::size_t i = 0; i < count; i++) {
+        bits |= static_cast<std::uint64_t>(values[i] <= limit) << i;
+    }
+    return bits;
+}
+
+#ifdef SERVER_SCAN_X86
+
+/**
+ * @brief Four compares of four entries each per 16 bits; x86-64 always has SSE2.
+ */
+__attribute__((target("sse2")))
+static std::uint64_t scanWordSse2(const int* values, int limit) {
+    const __m128i bound = _mm_set1_epi32(limit);
+    std::uint64_t above = 0;
+    for (int i = 0; i < 64; i += 4) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(values + i));
+        int lanes = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(v, bound)));
+        above |= static_cast<std::uint64_t>(lanes) << i;
+    }
+    return ~above;
+}
+
+/**
+ * @brief Two 8-entry compares per 16 bits, unrolled over the word.
+ */
+__attribute__((target("avx2")))
+static std::uint64_t scanWordAvx2(const int* values, int limit) {
+    const __m256i bound = _mm256_set1_epi32(limit);
+    std::uint64_t above = 0;
+    for (int i = 0; i < 64; i += 16) {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + i));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + i + 8));
+        unsigned int low = static_cast<unsigned int>(
+            _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(a, bound))));
+        unsigned int high = static_cast<unsigned int>(
+            _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(b, bound))));
+        above |= static_cast<std::uint64_t>(low | (high << 8)) << i;
+    }
+    return ~above;
+}
+
+#endif
+
+/**
+ * @brief Checks the CPU once.
+ */
+ScanPath bestScanPath() {
+#ifdef SERVER_SCAN_X86
+    // may run during static initialisation, before the CPU model is set up
+    __builtin_cpu_init();
+    static const ScanPath best = __builtin_cpu_supports("avx2") ? ScanPath::Avx2
+                               : __builtin_cpu_supports("sse2") ? ScanPath::Sse2
+                               : ScanPath::Scalar;
+    return best;
+#else
+    return ScanPath::Scalar;
+#endif
+}
+
+/** @brief Path in use; starts at the best supported one. */
+static ScanPath active_path = bestScanPath();
+
+/**
+ * @brief Returns the active path.
+ */
+ScanPath getScanPath() {
+    return active_path;
+}
+
+/**
+ * @brief Never selects a path above the CPU's best.
+ */
+void setScanPath(ScanPath path) {
+    active_path = static_cast<int>(path) <= static_cast<int>(bestScanPath()) ? path : bestScanPath();
+}
+
+/**
+ * @brief Returns the path's name.
+ */
+const char* scanPathName(ScanPath path) {
+    switch (path) {
+        case ScanPath::Avx2: return "avx2";
+        case ScanPath::Sse2: return "sse2";
+        default: return "scalar";
+    }
+}
+
+/**
+ * @brief Full 64-entry words go through the active vector path; the
+ * trailing partial word is always scalar.
+ */
+std::size_t scanAtMost(const int* values, std::size_t count, int limit, std::uint64_t* mask) {
+    std::size_t set = 0;
+    std::size_t full_words = count / 64;
+    ScanPath path = active_path;
+
+    for (std::size_t w = 0; w < full_words; w++) {
+        const int* block = values + w * 64;
+        std::uint64_t bits;
+#ifdef SERVER_SCAN_X86
+        if (path == ScanPath::Avx2) {
+            bits = scanWordAvx2(block, limit);
+        } else if (path == ScanPath::Sse2) {
+            bits = scanWordSse2(block, limit);
+        } else {
+            bits = scanWordScalar(block, 64, limit);
+        }
+#else
+        (void)path;
+        bits = scanWordScalar(block, 64, limit);
+#endif
+        mask[w] = bits;
+        set += static_cast<std::size_t>(__builtin_popcountll(bits));
+    }
+
+    std::size_t tail = count - full_words * 64;
+    if (tail > 0) {
+        mask[full_words] = scanWordScalar(values + full_words * 64, tail, limit);
+        set += static_cast<std::size_t>(__builtin_popcountll(mask[full_words]));
+    }
+    return set;
+}
+
+/**
+ * @brief Skips empty words.
+ */
+std::size_t firstSetBit(const std::uint64_t* mask, std::size_t count) {
+    std::size_t words = (count + 63) / 64;
+    for (std::size_t w = 0; w < words; w++) {
+        if (mask[w] != 0) return w * 64 + static_cast<std::size_t>(__builtin_ctzll(mask[w]));
+    }
+    return count;
+}
\ No newline at end of file
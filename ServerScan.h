@@ -0,0 +1,67 @@
+/**
+ * @file ServerScan.h
+ * @brief Vectorised scan of dense per-server cycle arrays.
+ *
+ * A LoadBalancer keeps, for each server, the earliest cycle one of its
+ * slots frees up in a plain int array. Finding the servers that need a
+ * visit this cycle is then a compare of that array against the current
+ * cycle, done 16 entries at a time with AVX2 or SSE2 and packed into a
+ * bitmask, one bit per server. The instruction set is picked at run time,
+ * so the build needs no -mavx2 and runs on any x86-64 or other CPU.
+ */
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @enum ScanPath
+ * @brief Implementation used by scanAtMost().
+ */
+enum class ScanPath {
+    Scalar,
+    Sse2,
+    Avx2
+};
+
+/**
+ * @brief Returns the fastest path this CPU supports.
+ */
+ScanPath bestScanPath();
+
+/**
+ * @brief Returns the path scanAtMost() currently uses.
+ */
+ScanPath getScanPath();
+
+/**
+ * @brief Forces a path (clamped to what the CPU supports); for benchmarks.
+ *
+ * @param path Path to use from now on.
+ */
+void setScanPath(ScanPath path);
+
+/**
+ * @brief Returns a short name for a path ("scalar", "sse2", "avx2").
+ */
+const char* scanPathName(ScanPath path);
+
+/**
+ * @brief Marks every entry that is at most @p limit.
+ *
+ * @param values Dense array of cycles.
+ * @param count Number of entries.
+ * @param limit Cycle to compare against.
+ * @param mask Receives bit i of word i / 64 set for values[i] <= limit;
+ *             must hold (count + 63) / 64 words, all of which are written.
+ * @return Number of bits set.
+ */
+std::size_t scanAtMost(const int* values, std::size_t count, int limit, std::uint64_t* mask);
+
+/**
+ * @brief Returns the lowest set bit of a mask, or @p count if none is set.
+ *
+ * @param mask Mask written by scanAtMost().
+ * @param count Number of entries the mask covers.
+ */
+std::size_t firstSetBit(const std::uint64_t* mask, std::size_t count);
\ No newline at end of file
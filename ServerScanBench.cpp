@@ -0,0 +1,134 @@
+/**
+ * @file ServerScanBench.cpp
+ * @brief Benchmark of the server scan at 1k, 10k and 100k servers per balancer.
+ *
+ * For each pool size it times:
+ * - the old per-object walk calling WebServer::isBusy on every server
+ * - scanAtMost over the dense free-cycle array on each supported path
+ * - a full LoadBalancer cycle (scan, completions, assignment) per path
+ *
+ * Build and run with: make scan_bench && ./scan_bench
+ */
+
+#include "LoadBalancer.h"
+#include "ServerScan.h"
+#include "WebServer.h"
+#include "Log.h"
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+/** @brief Cycles each timed loop runs for. */
+static const int BENCH_CYCLES = 2000;
+
+/**
+ * @brief Returns nanoseconds elapsed since @p start.
+ */
+static double elapsedNs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * @brief Paths this CPU can run, slowest first.
+ */
+static std::vector<ScanPath> supportedPaths() {
+    std::vector<ScanPath> paths;
+    for (ScanPath path : {ScanPath::Scalar, ScanPath::Sse2, ScanPath::Avx2}) {
+        if (static_cast<int>(path) <= static_cast<int>(bestScanPath())) paths.push_back(path);
+    }
+    return paths;
+}
+
+/**
+ * @brief Times one idle-server lookup over @p count servers, object walk
+ * against the dense array.
+ */
+static void benchScan(std::size_t count, std::mt19937& generator) {
+    // about a quarter of the servers are free at the probe cycle
+    const int probe = 1000;
+    std::uniform_int_distribution<int> length(1, 4000);
+    std::vector<WebServer> servers;
+    std::vector<int> free_at(count);
+    Request r;
+    servers.reserve(count);
+    for (std::size_t i = 0; i < count; i++) {
+        servers.emplace_back(static_cast<int>(i + 1));
+        r.time = length(generator);
+        servers.back().assignRequest(r, 0);
+        free_at[i] = servers.back().getBusyUntil();
+    }
+
+    std::size_t idle = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int c = 0; c < BENCH_CYCLES; c++) {
+        for (const WebServer& server : servers) {
+            if (!server.isBusy(probe + (c & 1))) idle++;
+        }
+    }
+    double walk_ns = elapsedNs(start) / BENCH_CYCLES;
+    std::printf("%8zu servers | object walk       %10.0f ns/scan %6.2f ns/server (idle=%zu)\n",
+                count, walk_ns, walk_ns / count, idle / BENCH_CYCLES);
+
+    std::vector<std::uint64_t> mask((count + 63) / 64);
+    for (ScanPath path : supportedPaths()) {
+        setScanPath(path);
+        idle = 0;
+        start = std::chrono::steady_clock::now();
+        for (int c = 0; c < BENCH_CYCLES; c++) {
+            idle += scanAtMost(free_at.data(), count, probe + (c & 1), mask.data());
+        }
+        double scan_ns = elapsedNs(start) / BENCH_CYCLES;
+        std::printf("%8zu servers | dense %-6s      %10.0f ns/scan %6.2f ns/server (idle=%zu, %.1fx)\n",
+                    count, scanPathName(path), scan_ns, scan_ns / count, idle / BENCH_CYCLES,
+                    walk_ns / scan_ns);
+    }
+    setScanPath(bestScanPath());
+}
+
+/**
+ * @brief Times LoadBalancer cycles with a light arrival rate, so most of
+ * the work is finding the few servers that finish or can take a request.
+ */
+static void benchBalancer(std::size_t count) {
+    std::uniform_int_distribution<int> length(1, 8);
+    std::size_t arrivals = count / 64 + 1;
+    IPAddress in(0x0A000001u), out(0x0A000002u);
+
+    for (ScanPath path : supportedPaths()) {
+        setScanPath(path);
+        // same arrivals on every path; the cooldown keeps the pool at its initial size
+        std::mt19937 generator(static_cast<unsigned int>(count));
+        LoadBalancer lb(static_cast<int>(count), 1 << 30);
+
+        auto start = std::chrono::steady_clock::now();
+        for (int c = 1; c <= BENCH_CYCLES; c++) {
+            for (std::size_t a = 0; a < arrivals; a++) {
+                Request r(in, out, length(generator), 0);
+                r.arrival_cycle = c;
+                r.stage_arrival_cycle = c;
+                lb.addRequest(r);
+            }
+            lb.goThroughClockCycle(c);
+        }
+        double cycle_ns = elapsedNs(start) / BENCH_CYCLES;
+        std::printf("%8zu servers | balancer %-6s   %10.0f ns/cycle (completed=%lld util=%.3f)\n",
+                    count, scanPathName(path), cycle_ns, lb.getCompletedCount(), lb.getUtilisation());
+    }
+    setScanPath(bestScanPath());
+}
+
+int main() {
+    // formatting into a stream without a buffer is skipped entirely
+    std::ostream discard(nullptr);
+    setThreadLogStream(&discard);
+
+    std::mt19937 generator(1);
+    std::printf("best scan path: %s\n", scanPathName(bestScanPath()));
+    for (std::size_t count : {std::size_t(1000), std::size_t(10000), std::size_t(100000)}) {
+        benchScan(count, generator);
+        benchBalancer(count);
+    }
+    return 0;
+}
\ No newline at end of file
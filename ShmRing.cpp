@@ -0,0 +1,140 @@
+/**
+ * @file ShmRing.cpp
+ * @brief Implementation of the shared-memory byte ring.
+ */
+
+#include "ShmRing.h"
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include <string>
+#include <thread>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+/** @brief Failed attempts before a waiting side starts yielding its core. */
+static const int SPIN_LIMIT = 256;
+
+/** @brief Yields between liveness checks of the peer. */
+static const int YIELDS_PER_CHECK = 1024;
+
+/**
+ * @brief Maps a fresh segment; the name is unlinked at once, so the
+ * memory lives exactly as long as some process keeps it mapped.
+ */
+ShmRing::ShmRing(std::size_t min_capacity)
+ : indices(nullptr),
+   data(nullptr),
+   capacity(4096),
+   mapped_bytes(0) {
+
+    while (capacity < min_capacity) capacity <<= 1;
+
+    static std::atomic<unsigned int> serial{0};
+    std::string name = "/lbsim-ring-" + std::to_string(getpid()) + "-" + std::to_string(serial++);
+    int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0) return;
+    shm_unlink(name.c_str());
+
+    std::size_t bytes = sizeof(Indices) + capacity;
+    void* map = MAP_FAILED;
+    if (ftruncate(fd, static_cast<off_t>(bytes)) == 0) {
+        map = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (map == MAP_FAILED) return;
+
+    mapped_bytes = bytes;
+    indices = new (map) Indices();
+    data = static_cast<unsigned char*>(map) + sizeof(Indices);
+}
+
+/**
+ * @brief Unmaps the segment.
+ */
+ShmRing::~ShmRing() {
+    if (indices != nullptr) munmap(indices, mapped_bytes);
+}
+
+/**
+ * @brief Returns whether the mapping exists.
+ */
+bool ShmRing::isValid() const {
+    return indices != nullptr;
+}
+
+/**
+ * @brief Copies into the free space, in two pieces when it wraps, then
+ * publishes the new head.
+ */
+std::size_t ShmRing::tryWrite(const unsigned char* bytes, std::size_t size) {
+    std::uint64_t head = indices->head.load(std::memory_order_relaxed);
+    std::uint64_t tail = indices->tail.load(std::memory_order_acquire);
+    std::size_t count = std::min<std::size_t>(size, capacity - static_cast<std::size_t>(head - tail));
+    if (count == 0) return 0;
+
+    std::size_t offset = static_cast<std::size_t>(head & (capacity - 1));
+    std::size_t first = std::min(count, capacity - offset);
+    std::memcpy(data + offset, bytes, first);
+    std::memcpy(data, bytes + first, count - first);
+    indices->head.store(head + count, std::memory_order_release);
+    return count;
+}
+
+/**
+ * @brief Copies out of the filled space, then releases it to the producer.
+ */
+std::size_t ShmRing::tryRead(unsigned char* bytes, std::size_t size) {
+    std::uint64_t tail = indices->tail.load(std::memory_order_relaxed);
+    std::uint64_t head = indices->head.load(std::memory_order_acquire);
+    std::size_t count = std::min<std::size_t>(size, static_cast<std::size_t>(head - tail));
+    if (count == 0) return 0;
+
+    std::size_t offset = static_cast<std::size_t>(tail & (capacity - 1));
+    std::size_t first = std::min(count, capacity - offset);
+    std::memcpy(bytes, data + offset, first);
+    std::memcpy(bytes + first, data, count - first);
+    indices->tail.store(tail + count, std::memory_order_release);
+    return count;
+}
+
+/**
+ * @brief Spins briefly, then yields, checking the peer now and then.
+ */
+bool ShmRing::write(const void* bytes, std::size_t size, const std::function<bool()>& peer_alive) {
+    const unsigned char* next = static_cast<const unsigned char*>(bytes);
+    int idle = 0;
+    while (size > 0) {
+        std::size_t written = tryWrite(next, size);
+        next += written;
+        size -= written;
+        if (written > 0) {
+            idle = 0;
+        } else if (++idle > SPIN_LIMIT) {
+            std::this_thread::yield();
+            if (idle % YIELDS_PER_CHECK == 0 && !peer_alive()) return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Spins briefly, then yields, checking the peer now and then.
+ */
+bool ShmRing::read(void* bytes, std::size_t size, const std::function<bool()>& peer_alive) {
+    unsigned char* next = static_cast<unsigned char*>(bytes);
+    int idle = 0;
+    while (size > 0) {
+        std::size_t got = tryRead(next, size);
+        next += got;
+        size -= got;
+        if (got > 0) {
+            idle = 0;
+        } else if (++idle > SPIN_LIMIT) {
+            std::this_thread::yield();
+            if (idle % YIELDS_PER_CHECK == 0 && !peer_alive()) return false;
+        }
+    }
+    return true;
+}
\ No newline at end of file
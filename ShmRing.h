@@ -0,0 +1,105 @@
+/**
+ * @file ShmRing.h
+ * @brief Defines a single-producer, single-consumer byte ring in POSIX
+ * shared memory.
+ *
+ * The ring is created before fork() and used by exactly one writing and
+ * one reading process. Head and tail are lock-free atomics on separate
+ * cache lines; data is published with release stores, so no lock or
+ * system call is needed per message. Reads and writes stream through the
+ * ring, so a message may be larger than its capacity.
+ */
+
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+/**
+ * @class ShmRing
+ * @brief Byte stream from one process to another over shared memory.
+ */
+class ShmRing {
+private:
+
+    /**
+     * @struct Indices
+     * @brief Free-running byte counters at the start of the mapping.
+     */
+    struct Indices {
+
+        /** @brief Bytes written so far (advanced by the producer). */
+        alignas(64) std::atomic<std::uint64_t> head;
+
+        /** @brief Bytes read so far (advanced by the consumer). */
+        alignas(64) std::atomic<std::uint64_t> tail;
+    };
+
+    static_assert(std::atomic<std::uint64_t>::is_always_lock_free,
+                  "ring indices must be lock-free to be shared between processes");
+
+    /** @brief Start of the shared mapping (null if creation failed). */
+    Indices* indices;
+
+    /** @brief Data area following the indices. */
+    unsigned char* data;
+
+    /** @brief Size of the data area, a power of two. */
+    std::size_t capacity;
+
+    /** @brief Total bytes mapped. */
+    std::size_t mapped_bytes;
+
+    /**
+     * @brief Copies up to @p size bytes in without blocking.
+     * @return Bytes written.
+     */
+    std::size_t tryWrite(const unsigned char* bytes, std::size_t size);
+
+    /**
+     * @brief Copies up to @p size bytes out without blocking.
+     * @return Bytes read.
+     */
+    std::size_t tryRead(unsigned char* bytes, std::size_t size);
+
+public:
+
+    /**
+     * @brief Creates and maps an unlinked shared memory segment.
+     *
+     * @param min_capacity Data bytes wanted; rounded up to a power of two.
+     */
+    explicit ShmRing(std::size_t min_capacity);
+
+    /** @brief Unmaps the segment in this process. */
+    ~ShmRing();
+
+    ShmRing(const ShmRing&) = delete;
+    ShmRing& operator=(const ShmRing&) = delete;
+
+    /**
+     * @brief Returns whether the segment was created and mapped.
+     */
+    bool isValid() const;
+
+    /**
+     * @brief Writes all bytes, waiting while the ring is full.
+     *
+     * @param bytes Data to send.
+     * @param size Number of bytes.
+     * @param peer_alive Polled while waiting; returning false gives up.
+     * @return False if the reader went away first.
+     */
+    bool write(const void* bytes, std::size_t size, const std::function<bool()>& peer_alive);
+
+    /**
+     * @brief Reads exactly @p size bytes, waiting while the ring is empty.
+     *
+     * @param bytes Receives the data.
+     * @param size Number of bytes.
+     * @param peer_alive Polled while waiting; returning false gives up.
+     * @return False if the writer went away first.
+     */
+    bool read(void* bytes, std::size_t size, const std::function<bool()>& peer_alive);
+};
\ No newline at end of file
@@ -0,0 +1,251 @@
+/**
+ * @file SpillFile.cpp
+ * @brief Implementation of the request spill file.
+ */
+
+#include "SpillFile.h"
+#include "Color.h"
+#include "Log.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+/**
+ * @brief Nanoseconds on the steady clock.
+ */
+static long long nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * @brief Ends the run when spilled requests cannot be read back: the
+ * queue would otherwise be missing part of its backlog.
+ */
+[[noreturn]] static void spillLost(const char* reason) {
+    logStream() << Color::RED << "[QUEUE] Spilled requests lost: " << reason
+              << Color::RESET << "\n";
+    std::cerr << "ERROR: spilled requests lost: " << reason << "\n";
+    std::exit(1);
+}
+
+/**
+ * @brief Sums every counter, including the peaks.
+ */
+void SpillStats::add(const SpillStats& other) {
+    blocks_written += other.blocks_written;
+    bytes_written += other.bytes_written;
+    write_ns += other.write_ns;
+    blocks_read += other.blocks_read;
+    bytes_read += other.bytes_read;
+    read_ns += other.read_ns;
+    peak_bytes += other.peak_bytes;
+    write_failures += other.write_failures;
+}
+
+/**
+ * @brief Constructor implementation.
+ *
+ * A block holds as many whole requests as fit in block_bytes rounded up
+ * to pages, so every block starts on a page boundary and can be mapped.
+ */
+SpillFile::SpillFile(const std::string& directory, std::size_t block_bytes)
+ : directory(directory),
+   block_bytes(0),
+   fd(-1),
+   end(0),
+   stored(0),
+   prefetched(~std::uint64_t(0)),
+   failed(false) {
+
+    std::size_t page = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+    block_bytes = std::max(block_bytes, sizeof(Request));
+    this->block_bytes = (block_bytes + page - 1) / page * page;
+}
+
+/**
+ * @brief Destructor implementation.
+ */
+SpillFile::~SpillFile() {
+    if (fd >= 0) close(fd);
+}
+
+/**
+ * @brief mkstemp, then unlink so only the descriptor keeps the file alive.
+ */
+bool SpillFile::open() {
+    std::string path = directory + "/lbsim-spill-XXXXXX";
+    fd = mkstemp(&path[0]);
+    if (fd < 0) return false;
+    unlink(path.c_str());
+    return true;
+}
+
+/**
+ * @brief Returns the number of requests in a full block.
+ */
+std::size_t SpillFile::getBlockRequests() const {
+    return block_bytes / sizeof(Request);
+}
+
+/**
+ * @brief Gathers the block and writes it with pwrite.
+ *
+ * A full disk is not retried on every arrival: after the first failure
+ * the file refuses further blocks.
+ */
+bool SpillFile::pushBack(std::deque<Request>& from) {
+    std::size_t count = std::min(getBlockRequests(), from.size());
+    if (failed) return false;
+    if (count == 0) return true;
+    if (fd < 0 && !open()) {
+        failed = true;
+        stats.write_failures++;
+        return false;
+    }
+
+    long long start = nowNs();
+    staging.assign(from.begin(), from.begin() + static_cast<std::ptrdiff_t>(count));
+    const char* data = reinterpret_cast<const char*>(staging.data());
+    std::size_t bytes = count * sizeof(Request);
+    std::size_t done = 0;
+    while (done < bytes) {
+        ssize_t written = pwrite(fd, data + done, bytes - done, static_cast<off_t>(end + done));
+        if (written <= 0) {
+            failed = true;
+            stats.write_failures++;
+            return false;
+        }
+        done += static_cast<std::size_t>(written);
+    }
+
+    blocks.push_back(Block{end, count});
+    end += block_bytes;
+    stored += count;
+    from.erase(from.begin(), from.begin() + static_cast<std::ptrdiff_t>(count));
+
+    stats.blocks_written++;
+    stats.bytes_written += static_cast<long long>(bytes);
+    stats.write_ns += nowNs() - start;
+    stats.peak_bytes = std::max(stats.peak_bytes, static_cast<long long>(blocks.size() * block_bytes));
+    return true;
+}
+
+/**
+ * @brief Maps the block's pages (populated up front) and hands them over.
+ */
+bool SpillFile::readBlock(const Block& block,
+                          const std::function<void(const Request*, std::size_t)>& use) const {
+    std::size_t bytes = block.requests * sizeof(Request);
+    void* map = mmap(nullptr, bytes, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd,
+                     static_cast<off_t>(block.offset));
+    if (map == MAP_FAILED) return false;
+    use(static_cast<const Request*>(map), block.requests);
+    munmap(map, bytes);
+    return true;
+}
+
+/**
+ * @brief Offsets restart at zero, so an earlier prefetch no longer applies.
+ */
+void SpillFile::truncate() {
+    end = 0;
+    prefetched = ~std::uint64_t(0);
+    // a failure only leaves the space for the next blocks to overwrite
+    int ignored = ftruncate(fd, 0);
+    (void)ignored;
+}
+
+/**
+ * @brief Punches out the block, or truncates the file once it is empty.
+ */
+void SpillFile::release(const Block& block) {
+    stored -= block.requests;
+    if (blocks.empty()) {
+        truncate();
+        return;
+    }
+    fallocate(fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, static_cast<off_t>(block.offset),
+              static_cast<off_t>(block_bytes));
+}
+
+/**
+ * @brief Copies the oldest block to the back of @p into.
+ */
+void SpillFile::popFront(std::deque<Request>& into) {
+    long long start = nowNs();
+    Block block = blocks.front();
+    bool read = readBlock(block, [&](const Request* requests, std::size_t count) {
+        into.insert(into.end(), requests, requests + count);
+    });
+    if (!read) spillLost("could not map a spilled block");
+    blocks.pop_front();
+    release(block);
+
+    stats.blocks_read++;
+    stats.bytes_read += static_cast<long long>(block.requests * sizeof(Request));
+    stats.read_ns += nowNs() - start;
+}
+
+/**
+ * @brief Copies the newest block to the front of @p into; the file end
+ * moves back over it.
+ */
+void SpillFile::popBack(std::deque<Request>& into) {
+    long long start = nowNs();
+    Block block = blocks.back();
+    bool read = readBlock(block, [&](const Request* requests, std::size_t count) {
+        into.insert(into.begin(), requests, requests + count);
+    });
+    if (!read) spillLost("could not map a spilled block");
+    blocks.pop_back();
+    end = block.offset;
+    release(block);
+
+    stats.blocks_read++;
+    stats.bytes_read += static_cast<long long>(block.requests * sizeof(Request));
+    stats.read_ns += nowNs() - start;
+}
+
+/**
+ * @brief Issues POSIX_FADV_WILLNEED once per front block.
+ */
+void SpillFile::prefetchFront() {
+    if (blocks.empty() || blocks.front().offset == prefetched) return;
+    const Block& block = blocks.front();
+    prefetched = block.offset;
+    posix_fadvise(fd, static_cast<off_t>(block.offset),
+                  static_cast<off_t>(block.requests * sizeof(Request)), POSIX_FADV_WILLNEED);
+}
+
+/**
+ * @brief Maps each block in turn without consuming it.
+ */
+void SpillFile::forEach(const std::function<void(const Request&)>& use) const {
+    for (const Block& block : blocks) {
+        bool read = readBlock(block, [&](const Request* requests, std::size_t count) {
+            for (std::size_t i = 0; i < count; i++) use(requests[i]);
+        });
+        if (!read) spillLost("could not map a spilled block");
+    }
+}
+
+/**
+ * @brief Forgets every block and truncates the file.
+ */
+void SpillFile::clear() {
+    blocks.clear();
+    stored = 0;
+    if (fd >= 0) truncate();
+}
+
+/**
+ * @brief Returns the counters.
+ */
+const SpillStats& SpillFile::getStats() const {
+    return stats;
+}
\ No newline at end of file
@@ -0,0 +1,207 @@
+/**
+ * @file SpillFile.h
+ * @brief Defines the append-only segment file a RequestQueue spills the
+ * middle of an oversized FIFO backlog to.
+ *
+ * The file holds a FIFO of fixed-size blocks of raw Requests. Blocks are
+ * appended at the end with one sequential write each. Writeback is left
+ * to the kernel: a block read back soon never reaches the disk, and one
+ * that stays is written out and evicted under memory pressure like any
+ * other file page, which anonymous queue memory cannot be without swap.
+ * Blocks are read back by mapping them with MAP_POPULATE and copying the
+ * requests out; the space of a consumed block is released by punching a
+ * hole, and the file is truncated to nothing whenever it empties.
+ *
+ * prefetchFront() asks the kernel to read the oldest block ahead
+ * (POSIX_FADV_WILLNEED), so the copy in popFront() normally finds it in
+ * the page cache instead of waiting for the disk.
+ *
+ * The file is unlinked as soon as it is created: it disappears with the
+ * process, however the process ends.
+ */
+
+#pragma once
+#include "Request.h"
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <string>
+#include <vector>
+
+/**
+ * @struct SpillStats
+ * @brief Traffic between a queue and its spill file.
+ */
+struct SpillStats {
+
+    /** @brief Blocks written. */
+    long long blocks_written = 0;
+
+    /** @brief Bytes written. */
+    long long bytes_written = 0;
+
+    /** @brief Wall time spent writing, in nanoseconds. */
+    long long write_ns = 0;
+
+    /** @brief Blocks read back. */
+    long long blocks_read = 0;
+
+    /** @brief Bytes read back. */
+    long long bytes_read = 0;
+
+    /** @brief Wall time spent reading back, in nanoseconds. */
+    long long read_ns = 0;
+
+    /** @brief Most bytes held on disk at once. */
+    long long peak_bytes = 0;
+
+    /** @brief Files that stopped spilling because a write failed. */
+    long long write_failures = 0;
+
+    /**
+     * @brief Adds another queue's traffic; peaks are summed as well.
+     */
+    void add(const SpillStats& other);
+};
+
+/**
+ * @class SpillFile
+ * @brief FIFO of request blocks on disk.
+ */
+class SpillFile {
+private:
+
+    /**
+     * @brief Location of one block in the file.
+     */
+    struct Block {
+        std::uint64_t offset;
+        std::size_t requests;
+    };
+
+    /** @brief Directory the file is created in. */
+    std::string directory;
+
+    /** @brief Bytes each block occupies in the file (whole pages). */
+    std::size_t block_bytes;
+
+    /** @brief File descriptor (-1 until the first block is written). */
+    int fd;
+
+    /** @brief Offset the next block is appended at. */
+    std::uint64_t end;
+
+    /** @brief Blocks in the file, oldest first. */
+    std::deque<Block> blocks;
+
+    /** @brief Requests in all blocks. */
+    std::size_t stored;
+
+    /** @brief Offset of the block last passed to prefetchFront(). */
+    std::uint64_t prefetched;
+
+    /** @brief Staging area a block is gathered into before writing. */
+    std::vector<Request> staging;
+
+    /** @brief Traffic counters. */
+    SpillStats stats;
+
+    /** @brief Set by a failed write; the queue then stays in memory. */
+    bool failed;
+
+    /** @brief Creates and unlinks the file; false if that fails. */
+    bool open();
+
+    /**
+     * @brief Maps a block and passes its requests to @p use.
+     *
+     * @return False if the block could not be mapped.
+     */
+    bool readBlock(const Block& block,
+                   const std::function<void(const Request*, std::size_t)>& use) const;
+
+    /** @brief Releases the disk space of a consumed block. */
+    void release(const Block& block);
+
+    /** @brief Empties the file. */
+    void truncate();
+
+public:
+
+    /**
+     * @brief Describes a file that is created on the first pushBack().
+     *
+     * @param directory Directory for the file.
+     * @param block_bytes Size of a block, rounded up to whole pages.
+     */
+    SpillFile(const std::string& directory, std::size_t block_bytes);
+
+    /**
+     * @brief Closes (and so deletes) the file.
+     */
+    ~SpillFile();
+
+    SpillFile(const SpillFile&) = delete;
+    SpillFile& operator=(const SpillFile&) = delete;
+
+    /**
+     * @brief Requests per block.
+     */
+    std::size_t getBlockRequests() const;
+
+    /**
+     * @brief Returns whether no blocks are stored.
+     */
+    bool empty() const {
+        return blocks.empty();
+    }
+
+    /**
+     * @brief Returns the number of stored requests.
+     */
+    std::size_t size() const {
+        return stored;
+    }
+
+    /**
+     * @brief Moves the first getBlockRequests() requests of @p from into a
+     * new block at the end of the file.
+     *
+     * @return False (leaving @p from untouched) if this or an earlier
+     * write failed.
+     */
+    bool pushBack(std::deque<Request>& from);
+
+    /**
+     * @brief Appends the oldest block to the back of @p into and drops it.
+     */
+    void popFront(std::deque<Request>& into);
+
+    /**
+     * @brief Prepends the newest block to the front of @p into and drops it.
+     */
+    void popBack(std::deque<Request>& into);
+
+    /**
+     * @brief Asks the kernel to start reading the oldest block.
+     *
+     * Does nothing if that block was already prefetched.
+     */
+    void prefetchFront();
+
+    /**
+     * @brief Passes every stored request to @p use, oldest first.
+     */
+    void forEach(const std::function<void(const Request&)>& use) const;
+
+    /**
+     * @brief Drops every block and truncates the file.
+     */
+    void clear();
+
+    /**
+     * @brief Returns the traffic counters.
+     */
+    const SpillStats& getStats() const;
+};
\ No newline at end of file
@@ -0,0 +1,287 @@
+/**
+ * @file StressHarness.cpp
+ * @brief Runs generated topologies from 1 to 10,000 balancers and 1 to
+ * 1,000,000 servers and records how each phase of the simulation scales.
+ *
+ * Three sweeps are run, each point in a forked child so its peak RSS is its own:
+ * - servers: one balancer, 1 to 1,000,000 servers, offered load 0.9
+ * - balancers: 100,000 servers split over 1 to 10,000 balancers, load 0.9
+ * - load: 100 balancers of 100 servers at offered loads 0.5 to 2.0
+ *
+ * Every run is headless (no log, no console status) with phase timing on.
+ * The cycle count is sized so each run generates about --budget requests.
+ * Per point the harness records:
+ * - simulated cycles and requests per second
+ * - peak RSS
+ * - wall time per phase: generation, routing, assignment, scaling
+ *
+ * The curve is printed and written as CSV. At the end of each sweep, the
+ * phase whose cost per request grew the most is named, since that is the
+ * one that stops scaling first.
+ *
+ * Usage:
+ *   ./stress [--budget requests] [--max-servers n] [--out stress_curve.csv]
+ */
+
+#include "Switch.h"
+#include "SwitchConfig.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/** @brief Mean request length with the default 1-5 cycle range. */
+static const double MEAN_REQUEST_TIME = 3.0;
+
+/** @brief Bounds of the cycle count of one run. */
+static const int MIN_CYCLES = 10;
+static const int MAX_CYCLES = 2000;
+
+/** @brief Growth of cost per request still counted as scaling linearly. */
+static const double LINEAR_GROWTH = 1.5;
+
+/** @brief Phases in the order they are printed. */
+static const char* const PHASE_NAMES[] = {"generation", "routing", "assignment", "scaling"};
+static const int PHASES = 4;
+
+/**
+ * @struct StressPoint
+ * @brief One generated topology and load.
+ */
+struct StressPoint {
+    std::string sweep;
+    int balancers;
+    int servers;
+    double load;
+};
+
+/**
+ * @struct StressResult
+ * @brief Measurements of one run; plain data so a child can send it through a pipe.
+ */
+struct StressResult {
+    bool ok = false;
+    int cycles = 0;
+    long long requests = 0;
+    double setup_ms = 0.0;
+    double run_ms = 0.0;
+    double preload_ms = 0.0;
+    double phase_ms[PHASES] = {};
+    long peak_rss_kb = 0;
+};
+
+/**
+ * @brief Builds the configuration of a point: one job class of baseline
+ * servers, a request generator sized to the offered load, and a cycle
+ * count that keeps the run near @p budget requests.
+ */
+static SwitchConfig makeConfig(const StressPoint& point, long long budget) {
+    SwitchConfig config;
+    JobClass web;
+    web.name = "web";
+    web.balancers = point.balancers;
+    web.servers_per_balancer = std::max(point.servers / point.balancers, 1);
+    config.job_classes.push_back(web);
+
+    // arrivals are uniform in [0, max], so the mean is max / 2
+    double offered = point.load * point.servers / MEAN_REQUEST_TIME;
+    config.max_requests_per_cycle = std::max(static_cast<int>(std::lround(2.0 * offered)), 1);
+    double mean_arrivals = config.max_requests_per_cycle / 2.0;
+    config.total_clock_cycles = static_cast<int>(std::clamp(budget / mean_arrivals,
+                                                            static_cast<double>(MIN_CYCLES),
+                                                            static_cast<double>(MAX_CYCLES)));
+
+    // one queued request per server is enough to start busy without
+    // queuing 100 million requests at the largest sizes
+    config.preload_per_server = 1;
+    config.random_seed = 1;
+    config.phase_timing = true;
+    return config;
+}
+
+/**
+ * @brief Runs one point in this process and measures it.
+ */
+static StressResult runPoint(const StressPoint& point, long long budget) {
+    // headless: log lines and status reports are dropped unformatted
+    std::cout.rdbuf(nullptr);
+    std::cerr.rdbuf(nullptr);
+
+    StressResult result;
+    SwitchConfig config = makeConfig(point, budget);
+    auto start = std::chrono::steady_clock::now();
+    Switch sw(config);
+    auto built = std::chrono::steady_clock::now();
+    sw.start(config.total_clock_cycles);
+    auto done = std::chrono::steady_clock::now();
+
+    PhaseTimes times = sw.getPhaseTimes();
+    result.ok = true;
+    result.cycles = times.cycles;
+    result.requests = times.requests;
+    result.setup_ms = std::chrono::duration<double, std::milli>(built - start).count();
+    result.run_ms = std::chrono::duration<double, std::milli>(done - built).count();
+    result.preload_ms = times.preload_ns / 1e6;
+    result.phase_ms[0] = times.generation_ns / 1e6;
+    result.phase_ms[1] = times.routing_ns / 1e6;
+    result.phase_ms[2] = times.assignment_ns / 1e6;
+    result.phase_ms[3] = times.scaling_ns / 1e6;
+
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    result.peak_rss_kb = usage.ru_maxrss;
+    return result;
+}
+
+/**
+ * @brief Runs a point in a forked child and reads its result back; a
+ * crashed or killed child gives a result with ok unset.
+ */
+static StressResult runIsolated(const StressPoint& point, long long budget) {
+    StressResult result;
+    int fds[2];
+    if (pipe(fds) != 0) return result;
+
+    std::cout.flush();
+    pid_t pid = fork();
+    if (pid < 0) {
+        close(fds[0]);
+        close(fds[1]);
+        return result;
+    }
+    if (pid == 0) {
+        close(fds[0]);
+        StressResult measured = runPoint(point, budget);
+        ssize_t written = write(fds[1], &measured, sizeof(measured));
+        _exit(written == static_cast<ssize_t>(sizeof(measured)) ? 0 : 1);
+    }
+
+    close(fds[1]);
+    StressResult received;
+    if (read(fds[0], &received, sizeof(received)) == static_cast<ssize_t>(sizeof(received))) {
+        result = received;
+    }
+    close(fds[0]);
+    waitpid(pid, nullptr, 0);
+    return result;
+}
+
+/**
+ * @brief Returns the run time of a phase per generated request, in ns.
+ */
+static double nsPerRequest(const StressResult& r, int phase) {
+    return r.requests > 0 ? r.phase_ms[phase] * 1e6 / r.requests : 0.0;
+}
+
+/**
+ * @brief Names the phase whose cost per request grew the most from the
+ * first to the last completed point of a sweep. Phases that grew by less
+ * than LINEAR_GROWTH times are not counted, and of the rest the largest
+ * absolute increase wins, so a phase that stays tiny cannot be named.
+ */
+static void reportSweep(const std::string& sweep, const std::vector<StressPoint>& points,
+                        const std::vector<StressResult>& results) {
+    int first = -1, last = -1;
+    for (std::size_t i = 0; i < points.size(); i++) {
+        if (points[i].sweep != sweep || !results[i].ok) continue;
+        if (first < 0) first = static_cast<int>(i);
+        last = static_cast<int>(i);
+    }
+    if (first < 0 || first == last) return;
+
+    int worst = -1;
+    double worst_increase = 0.0;
+    std::cout << "  " << sweep << " sweep, cost per request from first to last point:";
+    for (int p = 0; p < PHASES; p++) {
+        double before = nsPerRequest(results[first], p);
+        double after = nsPerRequest(results[last], p);
+        double growth = after / std::max(before, 1.0);
+        std::printf(" %s x%.1f", PHASE_NAMES[p], growth);
+        if (growth >= LINEAR_GROWTH && after - before > worst_increase) {
+            worst_increase = after - before;
+            worst = p;
+        }
+    }
+    if (worst < 0) {
+        std::cout << "\n    -> every phase scales with the work\n";
+    } else {
+        std::cout << "\n    -> " << PHASE_NAMES[worst] << " stops scaling first\n";
+    }
+}
+
+int main(int argc, char* argv[]) {
+    long long budget = 500000;
+    int max_servers = 1000000;
+    std::string out_path = "stress_curve.csv";
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (i + 1 < argc && arg == "--budget") budget = std::max(std::atoll(argv[++i]), 1LL);
+        else if (i + 1 < argc && arg == "--max-servers") max_servers = std::max(std::atoi(argv[++i]), 1);
+        else if (i + 1 < argc && arg == "--out") out_path = argv[++i];
+        else {
+            std::cerr << "usage: " << argv[0] << " [--budget requests] [--max-servers n] [--out file.csv]\n";
+            return 2;
+        }
+    }
+
+    std::vector<StressPoint> points;
+    for (int servers = 1; servers <= max_servers; servers *= 10) {
+        points.push_back({"servers", 1, servers, 0.9});
+    }
+    int split = std::min(100000, max_servers);
+    for (int balancers = 1; balancers <= std::min(10000, split); balancers *= 10) {
+        points.push_back({"balancers", balancers, split, 0.9});
+    }
+    for (double load : {0.5, 0.9, 1.2, 2.0}) {
+        points.push_back({"load", 100, std::min(10000, max_servers), load});
+    }
+
+    std::ofstream csv(out_path);
+    csv << "sweep,balancers,servers,load,cycles,requests,cycles_per_sec,requests_per_sec,"
+        << "peak_rss_mb,setup_ms,preload_ms,generation_ms,routing_ms,assignment_ms,scaling_ms,"
+        << "generation_ns_per_req,routing_ns_per_req,assignment_ns_per_req,scaling_ns_per_req\n";
+
+    std::printf("%-9s %9s %9s %5s %6s %10s %10s %8s %9s %9s %9s %9s\n",
+                "sweep", "balancers", "servers", "load", "cycles", "cycles/s", "req/s", "rss_mb",
+                "gen_ms", "route_ms", "assign_ms", "scale_ms");
+    std::vector<StressResult> results;
+    for (const StressPoint& point : points) {
+        StressResult r = runIsolated(point, budget);
+        results.push_back(r);
+        if (!r.ok) {
+            std::printf("%-9s %9d %9d %5.1f  run failed\n", point.sweep.c_str(), point.balancers,
+                        point.servers, point.load);
+            continue;
+        }
+
+        // setup and preload are excluded, so the rates are per simulated cycle
+        double loop_s = std::max(r.run_ms - r.preload_ms, 1e-3) / 1e3;
+        double rss_mb = r.peak_rss_kb / 1024.0;
+        std::printf("%-9s %9d %9d %5.1f %6d %10.1f %10.0f %8.1f %9.1f %9.1f %9.1f %9.1f\n",
+                    point.sweep.c_str(), point.balancers, point.servers, point.load, r.cycles,
+                    r.cycles / loop_s, r.requests / loop_s, rss_mb,
+                    r.phase_ms[0], r.phase_ms[1], r.phase_ms[2], r.phase_ms[3]);
+        std::cout.flush();
+
+        csv << point.sweep << "," << point.balancers << "," << point.servers << "," << point.load << ","
+            << r.cycles << "," << r.requests << "," << r.cycles / loop_s << "," << r.requests / loop_s << ","
+            << rss_mb << "," << r.setup_ms << "," << r.preload_ms;
+        for (int p = 0; p < PHASES; p++) csv << "," << r.phase_ms[p];
+        for (int p = 0; p < PHASES; p++) csv << "," << nsPerRequest(r, p);
+        csv << "\n";
+    }
+
+    std::cout << "\nScaling limits:\n";
+    for (const char* sweep : {"servers", "balancers", "load"}) {
+        reportSweep(sweep, points, results);
+    }
+    std::cout << "Curve written to " << out_path << "\n";
+    return 0;
+}
\ No newline at end of file
@@ -5,226 +5,1906 @@
 
 #include "Switch.h"
 #include "IPAddress.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <fstream>
 #include <iostream>
+#include <limits>
 #include <random>
+#include <cstdint>
+#include <cstdlib>
+#include <type_traits>
+#include <sys/wait.h>
+#include <unistd.h>
 #include "Color.h"
+#include "Log.h"
+#include "Profiler.h"
+#include "Checkpoint.h"
+
+/** @brief Capacity of each ring between the Switch and a leaf process. */
+static const std::size_t LEAF_RING_BYTES = 1 << 20;
+
+/** @brief Commands sent from the Switch process to a leaf process. */
+enum class LeafCommand : int { Arrival, Step, Finish };
+
+/**
+ * @struct LeafMessage
+ * @brief Fixed header of every command; an Arrival is followed by its Request.
+ */
+struct LeafMessage {
+
+    /** @brief What to do. */
+    LeafCommand command;
+
+    /** @brief Cycle the arrival is delivered at or the step runs. */
+    int cycle;
+
+    /** @brief Leaf index within the process (Arrival only). */
+    int slot;
+
+    /** @brief Whether leaves return status report lines (Step only). */
+    bool status_due;
+};
+
+static_assert(std::is_trivially_copyable<Request>::value, "requests are copied through rings");
+static_assert(std::is_trivially_copyable<NodeStats>::value, "stats are copied through rings");
+
+/**
+ * @class PhaseClock
+ * @brief Charges the time since the previous mark to a phase total; does
+ * nothing unless phase timing is on.
+ */
+class PhaseClock {
+private:
+    /** @brief Whether the clock is read at all. */
+    bool enabled;
+
+    /** @brief Time of the previous mark or charge. */
+    std::chrono::steady_clock::time_point last;
+
+public:
+    explicit PhaseClock(bool enabled) : enabled(enabled) {
+        mark();
+    }
+
+    /** @brief Starts a new interval without charging the current one. */
+    void mark() {
+        if (enabled) last = std::chrono::steady_clock::now();
+    }
+
+    /** @brief Adds the current interval to @p total_ns and starts a new one. */
+    void charge(long long& total_ns) {
+        if (!enabled) return;
+        auto now = std::chrono::steady_clock::now();
+        total_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(now - last).count();
+        last = now;
+    }
+};
+
+/**
+ * @brief Ends the run when a leaf process dies: its leaves cannot be recovered.
+ */
+[[noreturn]] static void leafProcessLost(pid_t pid) {
+    logStream() << Color::RED << "[SWITCH] Leaf process " << pid << " exited unexpectedly"
+              << Color::RESET << "\n";
+    std::cerr << "ERROR: leaf process " << pid << " exited unexpectedly\n";
+    std::exit(1);
+}
+
+/**
+ * @brief Writes to a leaf process's command ring.
+ */
+static void sendToLeafProcess(LeafProcess& process, const void* bytes, std::size_t size) {
+    pid_t pid = process.pid;
+    auto alive = [pid]() { return waitpid(pid, nullptr, WNOHANG) == 0; };
+    if (!process.commands.write(bytes, size, alive)) leafProcessLost(pid);
+}
+
+/**
+ * @brief Reads from a leaf process's result ring.
+ */
+static void receiveFromLeafProcess(LeafProcess& process, void* bytes, std::size_t size) {
+    pid_t pid = process.pid;
+    auto alive = [pid]() { return waitpid(pid, nullptr, WNOHANG) == 0; };
+    if (!process.results.read(bytes, size, alive)) leafProcessLost(pid);
+}
+
+/**
+ * @brief Reads a length-prefixed string from a leaf process.
+ */
+static std::string receiveTextFromLeafProcess(LeafProcess& process) {
+    std::uint64_t size = 0;
+    receiveFromLeafProcess(process, &size, sizeof(size));
+    std::string text(static_cast<std::size_t>(size), '\0');
+    receiveFromLeafProcess(process, &text[0], text.size());
+    return text;
+}
+
+/**
+ * @brief Constructs the root Switch, seeding its engine from the config or the OS.
+ */
+Switch::Switch(const SwitchConfig& config)
+ : Switch(config, "root", 0, 0, config.random_seed != 0
+                                    ? static_cast<unsigned int>(config.random_seed)
+                                    : std::random_device{}()) {}
+
+/**
+ * @brief Constructs one node and initializes its load balancer pools or children.
+ */
+Switch::Switch(const SwitchConfig& config, const std::string& name, int link_latency,
+               int depth, unsigned int seed)
+ : name(name),
+   depth(depth),
+   link_latency(link_latency),
+   generator(seed),
+   pipelines(false),
+   handoff_limit(static_cast<std::size_t>(std::max(config.handoff_limit, 0))),
+   min_request_time(config.min_request_time),
+   max_request_time(config.max_request_time),
+   num_priority_classes(std::clamp(config.queue.priority_classes, 1, 32)),
+   random_admission(config.admission.policy == AdmissionPolicy::RED),
+   max_requests_per_cycle(std::max(config.max_requests_per_cycle, 0)),
+   load_curve_steps(std::max(config.load_curve_steps, 0)),
+   load_curve_peak(config.load_curve_peak),
+   load_curve_file(config.load_curve_file),
+   active_policy(nullptr),
+   active_policy_version(0),
+   policy_reloads(0),
+   policy_reload_us(0),
+   rate_limiter(config.rate_limits,
+                static_cast<std::size_t>(std::max(config.rate_limit_table_entries, 1))),
+   heavy_hitters(static_cast<std::size_t>(std::max(config.heavy_hitter_sketch_width, 1)),
+                 static_cast<std::size_t>(std::max(config.heavy_hitter_top_k, 1))),
+   heavy_hitter_threshold(std::max(config.heavy_hitter_threshold, 0.0)),
+   heavy_hitter_window(std::max(config.heavy_hitter_window, 1)),
+   heavy_hitter_block_ttl(std::max(config.heavy_hitter_block_ttl, 0)),
+   heavy_hitter_window_start(0),
+   auto_blocks(0),
+   flood_fraction(std::clamp(config.flood_fraction, 0.0, 1.0)),
+   work_stealing(config.work_stealing),
+   steal_batch(static_cast<std::size_t>(std::max(config.steal_batch, 0))),
+   routing_mode(config.routing_mode),
+   request_timeout(std::max(config.request_timeout, 0)),
+   max_retries(std::max(config.max_retries, 0)),
+   retry_backoff(std::max(config.retry_backoff, 0)),
+   hedge_delay(std::max(config.hedge_delay, 0)),
+   next_request_id(0),
+   last_routed_balancer(nullptr),
+   retries_sent(0),
+   hedges_sent(0),
+   timed_out_requests(0),
+   subtree_queue(0.0),
+   subtree_capacity(0.0),
+   received(0),
+   blocked_here(0),
+   arrivals_refused(0),
+   forwarded_down(0),
+   in_transit_sum(0),
+   cycles_stepped(0),
+   preload_per_server(std::max(config.preload_per_server, 0)),
+   phase_timing(config.phase_timing),
+   status_interval(std::max(config.status_interval, 0)),
+   cycle_metric(nullptr),
+   timeseries_config(config.timeseries),
+   live_name(config.live_snapshot),
+   live_interval(std::max(config.live_interval, 1)),
+   checkpoint_file(config.checkpoint_file),
+   checkpoint_interval(std::max(config.checkpoint_interval, 0)),
+   leaf_process_count(static_cast<std::size_t>(std::max(config.topology_processes, 0))),
+   remote_process(nullptr),
+   remote_slot(0) {
+
+    bool affinity = (routing_mode == RoutingMode::Affinity);
+
+    // only leaves of a topology own balancers
+    bool leaf = std::none_of(config.topology.begin(), config.topology.end(),
+                             [&](const TopologyNode& node) { return node.parent == name; });
+
+    // counters are opened per thread as threads first enter a profiled phase
+    if (config.profile_counters) enableProfileCounters();
+
+    // startup policy; later versions come from a ConfigWatcher
+    policy.publish(buildPolicySnapshot(config, 0));
+    active_policy = policy.read();
+    active_policy_version = active_policy->version;
+    reportBlocklistImports(*active_policy);
+
+    // one balancer group per registered job class, indexed by class id
+    std::vector<JobClass> job_classes = resolveJobClasses(config);
+    std::vector<double> shares;
+    // sized once: groups are never relocated, so balancers need not be movable
+    groups = std::vector<BalancerGroup>(job_classes.size());
+    for (std::size_t c = 0; c < job_classes.size(); c++) {
+        const JobClass& job_class = job_classes[c];
+        BalancerGroup& group = groups[c];
+        group.name = job_class.name;
+
+        // apply the cache model to every server type
+        std::vector<ServerProfile> profiles = job_class.profiles;
+        if (profiles.empty()) profiles.push_back(ServerProfile());
+        for (ServerProfile& profile : profiles) {
+            profile.cache_entries = config.server_cache_entries;
+            profile.cache_hit_speedup = config.cache_hit_speedup;
+        }
+
+        // initialize load balancers
+        std::vector<unsigned int> ids;
+        for (int i = 0; leaf && i < job_class.balancers; i++) {
+            std::string label = std::to_string(i+1) + job_class.name;
+            group.balancers.emplace_back(job_class.servers_per_balancer, config.num_wait_clock_cycles,
+                                         label, profiles, affinity, config.queue, config.admission);
+            group.balancers.back().setPhaseTiming(phase_timing);
+            ids.push_back(i + 1);
+        }
+        if (affinity) group.table.build(ids);
+
+        shares.push_back(std::max(job_class.share, 0.0));
+    }
+
+    // routes follow next links; an unknown name ends the route
+    std::unordered_map<std::string, int> class_ids;
+    for (std::size_t c = 0; c < job_classes.size(); c++) {
+        class_ids.emplace(job_classes[c].name, static_cast<int>(c));
+    }
+    for (std::size_t c = 0; c < job_classes.size(); c++) {
+        std::vector<int>& route = groups[c].route;
+        route.push_back(static_cast<int>(c));
+        while (static_cast<int>(route.size()) < Request::MAX_STAGES) {
+            auto next = class_ids.find(job_classes[route.back()].next);
+            if (next == class_ids.end()) break;
+            route.push_back(next->second);
+        }
+        if (route.size() > 1) pipelines = true;
+    }
+
+    // all-zero shares would leave the distribution undefined
+    if (std::all_of(shares.begin(), shares.end(), [](double w) { return w <= 0.0; })) {
+        std::fill(shares.begin(), shares.end(), 1.0);
+    }
+    class_dist = std::discrete_distribution<int>(shares.begin(), shares.end());
+
+    // balancers only consult the registry once every group is in place
+    if (hedge_delay > 0) {
+        for (BalancerGroup& group : groups) {
+            for (LoadBalancer& lb : group.balancers) lb.setHedgeTracker(&hedge_tracker);
+        }
+    }
+
+    // repeat clients make per-server caching observable
+    std::uniform_int_distribution<unsigned int> ip_dist;
+    for (int i = 0; i < config.client_pool_size; i++) {
+        client_pool.emplace_back(ip_dist(generator));
+    }
+    for (int i = 0; i < config.flood_sources; i++) {
+        flood_pool.emplace_back(ip_dist(generator));
+    }
+
+    if (leaf) return;
+
+    // deadlines, retries and hedges belong to the leaf serving the request
+    request_timeout = 0;
+    max_retries = 0;
+    hedge_delay = 0;
+
+    buildTopology(config);
+    if (affinity) {
+        std::vector<unsigned int> ids;
+        for (std::size_t i = 0; i < children.size(); i++) {
+            ids.push_back(static_cast<unsigned int>(i + 1));
+        }
+        child_table.build(ids);
+    }
+    if (depth > 0) return;
+
+    // the root keeps flat views of the tree for stepping and reporting
+    collectNodes(topology_nodes);
+    for (Switch* node : topology_nodes) {
+        (node->children.empty() ? leaves : routers).push_back(node);
+    }
+    std::size_t threads = config.topology_threads > 0
+        ? static_cast<std::size_t>(config.topology_threads)
+        : std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+    leaf_process_count = std::min(leaf_process_count, leaves.size());
+    // no threads may be running when the leaf processes are forked
+    if (leaf_process_count > 1) threads = 1;
+    workers = std::make_unique<WorkerPool>(std::min(threads, leaves.size()));
+    refreshSubtreeLoad();
+
+    logStream() << Color::CYAN << "[SWITCH] Topology: " << topology_nodes.size() << " nodes, "
+              << leaves.size() << " leaves, stepped on ";
+    if (leaf_process_count > 1) {
+        logStream() << leaf_process_count << " process(es)";
+    } else {
+        logStream() << workers->getThreadCount() << " thread(s)";
+    }
+    logStream() << Color::RESET << "\n";
+}
+
+/**
+ * @brief Narrows this node's configuration to each child and builds it.
+ */
+void Switch::buildTopology(const SwitchConfig& config) {
+    for (const TopologyNode& node : config.topology) {
+        if (node.parent != name) continue;
+
+        SwitchConfig child = config;
+        if (node.routing_set) child.routing_mode = node.routing_mode;
+        child.blocked_ranges = node.blocked_ranges;
+        child.blocklist_files = node.blocklist_files;
+        child.rate_limits.clear();
+        child.heavy_hitter_threshold = 0.0;
+        child.client_pool_size = 0;
+        child.flood_sources = 0;
+        if (node.servers_per_balancer > 0) {
+            child.job_classes = resolveJobClasses(config);
+            for (JobClass& job_class : child.job_classes) {
+                job_class.servers_per_balancer = node.servers_per_balancer;
+            }
+        }
+
+        logStream() << Color::CYAN << "[SWITCH] Building node " << node.name
+                  << " under " << name << " | link latency " << node.link_latency
+                  << " cycles" << Color::RESET << "\n";
+        children.push_back(std::unique_ptr<Switch>(
+            new Switch(child, node.name, node.link_latency, depth + 1, generator())));
+    }
+}
+
+/**
+ * @brief Depth-first walk of the subtree.
+ */
+void Switch::collectNodes(std::vector<Switch*>& out) {
+    out.push_back(this);
+    for (std::unique_ptr<Switch>& child : children) {
+        child->collectNodes(out);
+    }
+}
+
+/**
+ * @brief Returns the policy cell.
+ */
+RcuCell<PolicySnapshot>& Switch::getPolicyCell() {
+    return policy;
+}
+
+/**
+ * @brief Loads the current snapshot and applies it if its version is new.
+ *
+ * The pointer is reloaded every time: the previous one may have been freed
+ * at the last quiescent state.
+ */
+void Switch::applyPolicy() {
+    const PolicySnapshot* snapshot = policy.read();
+    active_policy = snapshot;
+    if (snapshot->version == active_policy_version) return;
+    active_policy_version = snapshot->version;
+
+    max_requests_per_cycle = std::max(snapshot->max_requests_per_cycle, 0);
+    min_request_time = snapshot->min_request_time;
+    max_request_time = snapshot->max_request_time;
+
+    long long visible_us = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - snapshot->published_at).count();
+    policy_reloads++;
+    policy_reload_us += snapshot->build_us + visible_us;
+
+    logStream() << Color::CYAN << "[SWITCH] Installed config v" << snapshot->version
+              << " | blocked ranges=" << snapshot->blocklist.size()
+              << " | build " << snapshot->build_us << " us"
+              << " | visible after " << visible_us << " us"
+              << Color::RESET << "\n";
+    reportBlocklistImports(*snapshot);
+}
+
+/**
+ * @brief Clears the snapshot pointer before the quiescent state it ends.
+ */
+void Switch::releasePolicy() {
+    active_policy = nullptr;
+    policy.quiescent();
+}
+
+/**
+ * @brief Prints one line per imported blocklist file.
+ */
+void Switch::reportBlocklistImports(const PolicySnapshot& snapshot) {
+    for (const BlocklistImport& import : snapshot.imports) {
+        if (!import.loaded) {
+            logStream() << Color::RED << "[SWITCH] Could not read blocklist " << import.path
+                      << Color::RESET << "\n";
+            continue;
+        }
+        logStream() << Color::CYAN << "[SWITCH] Imported blocklist " << import.path << ": ";
+        if (import.stats.from_cache) {
+            logStream() << import.stats.merged_ranges << " ranges from cache";
+        } else {
+            logStream() << import.stats.parsed_entries << " entries ("
+                      << import.stats.malformed_lines << " malformed) merged into "
+                      << import.stats.merged_ranges << " ranges on "
+                      << import.stats.threads << " thread(s)";
+        }
+        logStream() << " in " << import.stats.elapsed_us << " us" << Color::RESET << "\n";
+    }
+}
+
+/**
+ * @brief Generates a random Request, optionally forcing its job class.
+ */
+Request Switch::makeRandomRequest(int classOverride) {
+    // random distributions
+    std::uniform_int_distribution<int> ip_dist(0, 255);
+    std::uniform_int_distribution<int> time_dist(min_request_time, max_request_time);
+
+    // lambda to generate random IP address string
+    auto random_ip = [&]() {
+        return std::to_string(ip_dist(generator)) + "." +
+               std::to_string(ip_dist(generator)) + "." +
+               std::to_string(ip_dist(generator)) + "." +
+               std::to_string(ip_dist(generator));
+    };
+
+    // create request with random values
+    IPAddress in;
+    if (client_pool.empty()) {
+        in = IPAddress(random_ip());
+    } else {
+        std::uniform_int_distribution<std::size_t> client_dist(0, client_pool.size() - 1);
+        in = client_pool[client_dist(generator)];
+    }
+    if (!flood_pool.empty() &&
+        std::uniform_real_distribution<double>(0.0, 1.0)(generator) < flood_fraction) {
+        std::uniform_int_distribution<std::size_t> flood_dist(0, flood_pool.size() - 1);
+        in = flood_pool[flood_dist(generator)];
+    }
+    IPAddress out(random_ip());
+    int time = time_dist(generator);
+    int job_class = class_dist(generator);
+    if (classOverride >= 0 && classOverride < static_cast<int>(groups.size())) {
+        job_class = classOverride;
+    }
+
+    // return request
+    Request r(in, out, time, job_class);
+    const std::vector<int>& route = groups[job_class].route;
+    for (std::size_t s = 0; s < route.size(); s++) {
+        r.route[s] = static_cast<unsigned short>(route[s]);
+    }
+    r.route_length = static_cast<unsigned char>(route.size());
+    r.id = next_request_id++;
+    if (num_priority_classes > 1) {
+        std::uniform_int_distribution<int> priority_dist(0, num_priority_classes - 1);
+        r.priority = priority_dist(generator);
+    }
+    if (logEnabled()) {
+        logStream() << Color::MAGENTA << "Generated Request: "
+                  << r.in.getString() << " -> " << r.out.getString()
+                  << " | time=" << r.time <<  " | job=" << groups[r.job_class].name
+                  << Color::RESET << "\n";
+    }
+    return r;
+}
+
+/**
+ * @brief Routes a request to the least-loaded load balancer of its job class.
+ *
+ * Load is queue size divided by pool capacity, so a balancer of fast or
+ * multi-slot servers absorbs proportionally more requests. Drops the request
+ * if it is blocked, rate limited or a later stage of its route is backed up,
+ * and lets the chosen balancer's admission control decide whether it is queued.
+ */
+bool Switch::addRequestToBalancer(Request& request, int current_cycle,
+                                  const LoadBalancer* avoid) {
+    // count every arrival, blocked or not, so flooding sources stay visible
+    if (heavy_hitter_threshold > 0.0) {
+        trackSource(request.in, current_cycle);
+    }
+
+    // the class id indexes the group table directly
+    BalancerGroup& group = groups[request.job_class];
+
+    // check if this request should be blocked
+    if (isBlocked(request, current_cycle)) {
+        blocked_here++;
+        if (logEnabled()) {
+            logStream() << Color::RED << "[SWITCH ACTION] Blocked IP: "
+                      << request.in.getString()
+                      << Color::RESET << "\n";
+        }
+        return false;
+    }
+
+    // spend a token from the source's bucket
+    if (!rate_limiter.allow(request.in, current_cycle)) {
+        group.rate_limited++;
+        if (logEnabled()) {
+            logStream() << Color::RED << "[SWITCH ACTION] Rate limited IP: "
+                      << request.in.getString()
+                      << Color::RESET << "\n";
+        }
+        return false;
+    }
+
+    // a full handoff further along the route pushes back on new arrivals
+    if (handoff_limit > 0) {
+        for (int s = request.stage + 1; s < request.route_length; s++) {
+            BalancerGroup& downstream = groups[request.route[s]];
+            if (downstream.handoff.size() >= handoff_limit) {
+                downstream.backpressure_refusals++;
+                if (logEnabled()) {
+                    logStream() << Color::RED << "[SWITCH ACTION] Backpressure from class "
+                              << downstream.name << ": refused request from "
+                              << request.in.getString()
+                              << Color::RESET << "\n";
+                }
+                return false;
+            }
+        }
+    }
+
+    if (!children.empty()) return forwardToChild(request, current_cycle);
+    return offerToGroup(group, request, current_cycle, avoid);
+}
+
+/**
+ * @brief Picks a child by source hash or by queue per unit of capacity and
+ * appends the request to its link.
+ */
+bool Switch::forwardToChild(Request& request, int current_cycle) {
+    Switch* target = nullptr;
+    if (routing_mode == RoutingMode::Affinity) {
+        target = children[child_table.lookup(request.in.getValue())].get();
+    } else {
+        double min_load = 0.0;
+        for (std::unique_ptr<Switch>& child : children) {
+            double load = child->subtree_capacity > 0.0
+                ? child->subtree_queue / child->subtree_capacity
+                : std::numeric_limits<double>::max();
+            if (target == nullptr || load < min_load) {
+                min_load = load;
+                target = child.get();
+            }
+        }
+    }
+
+    target->inbox.emplace_back(current_cycle + target->link_latency, request);
+    target->subtree_queue += 1.0;
+    forwarded_down++;
+    return true;
+}
+
+/**
+ * @brief Delivers due link arrivals; a leaf counts them like generated requests.
+ */
+void Switch::deliverTransit(int current_cycle) {
+    in_transit_sum += static_cast<long long>(inbox.size());
+    cycles_stepped++;
+
+    while (!inbox.empty() && inbox.front().first <= current_cycle) {
+        Request r = inbox.front().second;
+        inbox.pop_front();
+        received++;
+        if (remote_process != nullptr) {
+            LeafMessage message{LeafCommand::Arrival, current_cycle, remote_slot, false};
+            sendToLeafProcess(*remote_process, &message, sizeof(message));
+            sendToLeafProcess(*remote_process, &r, sizeof(r));
+            continue;
+        }
+        if (!children.empty()) {
+            sendAttempt(r, current_cycle);
+            continue;
+        }
+
+        // a block is counted where it happens, without a second lookup
+        BalancerGroup& group = groups[r.job_class];
+        group.generated++;
+        long long blocked_before = blocked_here;
+        if (!sendAttempt(r, current_cycle)) arrivals_refused++;
+        if (blocked_here != blocked_before) group.blocked++;
+    }
+}
+
+/**
+ * @brief Same order as the root's own cycle, with link arrivals in place
+ * of generated requests.
+ */
+void Switch::stepLeaf(int current_cycle) {
+    releaseDelayedRequests(current_cycle);
+    deliverTransit(current_cycle);
+    goThroughClockCycleAllLoadBalancers(current_cycle);
+    handleExpiredRequests(current_cycle);
+    forwardCompletedStages(current_cycle);
+}
+
+/**
+ * @brief Routes top-down, steps leaves on the worker pool, then flushes
+ * their logs and refreshes subtree loads for the next cycle's routing.
+ */
+void Switch::stepTopology(int current_cycle, bool status_due) {
+    for (Switch* router : routers) {
+        router->deliverTransit(current_cycle);
+    }
+
+    if (!processes.empty()) {
+        stepLeafProcesses(current_cycle, status_due);
+    } else {
+        workers->run(leaves.size(), [this, current_cycle](std::size_t i) {
+            Switch* leaf = leaves[i];
+            setThreadLogStream(&leaf->log_buffer);
+            leaf->stepLeaf(current_cycle);
+            setThreadLogStream(nullptr);
+        });
+    }
+
+    for (Switch* leaf : leaves) {
+        logStream() << leaf->log_buffer.str();
+        leaf->log_buffer.str("");
+    }
+    refreshSubtreeLoad();
+}
+
+/**
+ * @brief Sums queued, in-transit and handoff requests and capacity below this node.
+ */
+void Switch::refreshSubtreeLoad() {
+    subtree_queue = static_cast<double>(inbox.size());
+    subtree_capacity = 0.0;
+    if (remote_process != nullptr) {
+        subtree_queue += static_cast<double>(remote_stats.queued);
+        subtree_capacity = remote_stats.capacity;
+        return;
+    }
+    for (BalancerGroup& group : groups) {
+        for (LoadBalancer& lb : group.balancers) {
+            subtree_queue += lb.getQueueSize();
+            subtree_capacity += lb.getCapacity();
+        }
+        subtree_queue += group.handoff.size();
+    }
+    for (std::unique_ptr<Switch>& child : children) {
+        child->refreshSubtreeLoad();
+        subtree_queue += child->subtree_queue;
+        subtree_capacity += child->subtree_capacity;
+    }
+}
+
+/**
+ * @brief Splits the leaves into contiguous blocks, one per process, and forks.
+ */
+void Switch::startLeafProcesses() {
+    for (std::size_t p = 0; p < leaf_process_count; p++) {
+        processes.push_back(std::make_unique<LeafProcess>(LEAF_RING_BYTES));
+        if (!processes.back()->commands.isValid() || !processes.back()->results.isValid()) {
+            logStream() << Color::RED << "[SWITCH] Could not map shared memory rings;"
+                      << " stepping leaves in this process" << Color::RESET << "\n";
+            processes.clear();
+            return;
+        }
+        std::size_t first = p * leaves.size() / leaf_process_count;
+        std::size_t last = (p + 1) * leaves.size() / leaf_process_count;
+        processes.back()->leaves.assign(leaves.begin() + first, leaves.begin() + last);
+    }
+
+    // buffered output would otherwise be written once per process
+    logStream().flush();
+    std::cerr.flush();
+
+    pid_t coordinator = getpid();
+    for (std::size_t p = 0; p < processes.size(); p++) {
+        pid_t pid = fork();
+        if (pid == 0) runLeafProcess(*processes[p], coordinator);
+        if (pid < 0) {
+            // leaves already handed out cannot be taken back
+            logStream() << Color::RED << "[SWITCH] Could not fork leaf process " << p
+                      << Color::RESET << "\n";
+            for (std::size_t q = 0; q < p; q++) kill(processes[q]->pid, SIGKILL);
+            std::exit(1);
+        }
+        processes[p]->pid = pid;
+    }
+
+    for (std::unique_ptr<LeafProcess>& process : processes) {
+        for (std::size_t slot = 0; slot < process->leaves.size(); slot++) {
+            Switch* leaf = process->leaves[slot];
+            leaf->remote_stats = leaf->getNodeStats();
+            leaf->remote_slot = static_cast<int>(slot);
+            leaf->remote_process = process.get();
+            leaf->releaseBalancers();
+        }
+        logStream() << Color::CYAN << "[SWITCH] Leaf process " << process->pid << " steps "
+                  << process->leaves.size() << " leaves from " << process->leaves.front()->name
+                  << Color::RESET << "\n";
+    }
+}
+
+/**
+ * @brief Frees the other processes' leaves, then serves commands.
+ */
+void Switch::runLeafProcess(LeafProcess& process, pid_t coordinator) {
+    for (Switch* leaf : leaves) {
+        if (std::find(process.leaves.begin(), process.leaves.end(), leaf) == process.leaves.end()) {
+            leaf->releaseBalancers();
+        }
+    }
+
+    // the Switch process going away ends this one
+    auto alive = [coordinator]() { return getppid() == coordinator; };
+    auto send = [&](const void* bytes, std::size_t size) {
+        if (!process.results.write(bytes, size, alive)) _exit(1);
+    };
+    auto send_text = [&](const std::string& text) {
+        std::uint64_t size = text.size();
+        send(&size, sizeof(size));
+        send(text.data(), text.size());
+    };
+
+    while (true) {
+        LeafMessage message;
+        if (!process.commands.read(&message, sizeof(message), alive)) _exit(1);
+
+        if (message.command == LeafCommand::Arrival) {
+            Request r;
+            if (!process.commands.read(&r, sizeof(r), alive)) _exit(1);
+            process.leaves[message.slot]->inbox.emplace_back(message.cycle, r);
+            continue;
+        }
+
+        for (Switch* leaf : process.leaves) {
+            if (message.command == LeafCommand::Step) {
+                setThreadLogStream(&leaf->log_buffer);
+                leaf->stepLeaf(message.cycle);
+                setThreadLogStream(nullptr);
+                NodeStats stats = leaf->getNodeStats();
+                send(&stats, sizeof(stats));
+                send_text(leaf->log_buffer.str());
+                leaf->log_buffer.str("");
+                send_text(message.status_due ? leaf->describeBalancers() : std::string());
+                continue;
+            }
+
+            // Finish: everything the summary reads from a leaf
+            NodeStats stats = leaf->getNodeStats(true);
+            send(&stats, sizeof(stats));
+            std::ostringstream report;
+            setThreadLogStream(&report);
+            leaf->reportGroups();
+            setThreadLogStream(nullptr);
+            send_text(report.str());
+            for (std::size_t c = 0; c < leaf->groups.size(); c++) {
+                int servers = leaf->getServerCount(static_cast<int>(c));
+                send(&servers, sizeof(servers));
+            }
+        }
+        if (message.command == LeafCommand::Finish) _exit(0);
+    }
+}
+
+/**
+ * @brief Sends each remote leaf's due link arrivals, then a step command
+ * that closes the cycle; waiting for every reply is the barrier.
+ */
+void Switch::stepLeafProcesses(int current_cycle, bool status_due) {
+    for (std::unique_ptr<LeafProcess>& process : processes) {
+        for (Switch* leaf : process->leaves) {
+            leaf->deliverTransit(current_cycle);
+        }
+        LeafMessage message{LeafCommand::Step, current_cycle, 0, status_due};
+        sendToLeafProcess(*process, &message, sizeof(message));
+    }
+
+    for (std::unique_ptr<LeafProcess>& process : processes) {
+        for (Switch* leaf : process->leaves) {
+            receiveFromLeafProcess(*process, &leaf->remote_stats, sizeof(leaf->remote_stats));
+            leaf->log_buffer << receiveTextFromLeafProcess(*process);
+            leaf->remote_status = receiveTextFromLeafProcess(*process);
+        }
+    }
+}
+
+/**
+ * @brief Sends Finish, stores each leaf's final report and waits for exit.
+ */
+void Switch::stopLeafProcesses() {
+    for (std::unique_ptr<LeafProcess>& process : processes) {
+        LeafMessage message{LeafCommand::Finish, 0, 0, false};
+        sendToLeafProcess(*process, &message, sizeof(message));
+    }
+
+    for (std::unique_ptr<LeafProcess>& process : processes) {
+        for (Switch* leaf : process->leaves) {
+            receiveFromLeafProcess(*process, &leaf->remote_stats, sizeof(leaf->remote_stats));
+            leaf->remote_report = receiveTextFromLeafProcess(*process);
+            leaf->remote_servers.assign(leaf->groups.size(), 0);
+            for (int& servers : leaf->remote_servers) {
+                receiveFromLeafProcess(*process, &servers, sizeof(servers));
+            }
+        }
+        waitpid(process->pid, nullptr, 0);
+    }
+}
+
+/**
+ * @brief Swaps each group's balancers with an empty vector, so their
+ * memory is returned without needing LoadBalancer to be movable.
+ */
+void Switch::releaseBalancers() {
+    for (BalancerGroup& group : groups) {
+        std::vector<LoadBalancer>().swap(group.balancers);
+    }
+}
+
+/**
+ * @brief Sums this node's balancers and client counters.
+ */
+NodeStats Switch::getNodeStats(bool latency) {
+    if (remote_process != nullptr) return remote_stats;
+
+    NodeStats stats;
+    LatencyHistogram merged;
+    for (BalancerGroup& group : groups) {
+        stats.queued += static_cast<long long>(group.handoff.size());
+        stats.rejected += group.unroutable;
+        for (LoadBalancer& lb : group.balancers) {
+            stats.queued += static_cast<long long>(lb.getQueueSize());
+            stats.capacity += lb.getCapacity();
+            stats.busy += lb.getUtilisation() * lb.getCapacity();
+            stats.mean_queue += lb.getAverageQueueSize();
+            stats.servers += lb.getServerCount();
+            stats.completed += lb.getCompletedCount();
+            stats.rejected += lb.getRejectedCount();
+            stats.expired += lb.getExpiredCount();
+            if (!latency) continue;
+            for (const LatencyHistogram& by_class : lb.getLatencyByClass()) {
+                merged.merge(by_class);
+            }
+        }
+    }
+    stats.arrivals_refused = arrivals_refused;
+    stats.timed_out = timed_out_requests;
+    stats.retries = retries_sent;
+    stats.hedges = hedges_sent;
+    stats.hedge_wins = hedge_tracker.getHedgeWins();
+    stats.hedges_cancelled = hedge_tracker.getCancelledCount();
+    stats.p99 = merged.percentile(99);
+    return stats;
+}
+
+/**
+ * @brief One line per balancer, plus waiting handoffs.
+ */
+std::string Switch::describeBalancers() {
+    std::string text;
+    for (BalancerGroup& group : groups) {
+        for (LoadBalancer& lb : group.balancers) {
+            text += "  Balancer " + lb.getLabel()
+                 + " (" + group.name + ") servers=" + std::to_string(lb.getServerCount())
+                 + " capacity=" + std::to_string(lb.getCapacity())
+                 + " queue=" + std::to_string(lb.getQueueSize())
+                 + " util=" + std::to_string(lb.getUtilisation())
+                 + " stolen=" + std::to_string(lb.getStolenInCount()) + "\n";
+        }
+        if (!group.handoff.empty()) {
+            text += "  Handoff (" + group.name + ") waiting="
+                 + std::to_string(group.handoff.size()) + "\n";
+        }
+    }
+    return text;
+}
+
+/**
+ * @brief Picks a balancer of the group and offers it the request.
+ *
+ * A hedge copy never goes to the balancer holding the original, so in
+ * affinity mode it falls back to the least-loaded sibling.
+ */
+bool Switch::offerToGroup(BalancerGroup& group, Request& request, int current_cycle,
+                          const LoadBalancer* avoid) {
+    std::vector<LoadBalancer>& balancers = group.balancers;
+
+    // a class configured with no balancers refuses everything
+    if (balancers.empty()) {
+        group.unroutable++;
+        return false;
+    }
+
+    // only RED consumes a random draw, so other policies leave the generator untouched
+    double uniform = 0.0;
+    if (random_admission) {
+        uniform = std::uniform_real_distribution<double>(0.0, 1.0)(generator);
+    }
+
+    // affinity mode: the source IP decides the balancer
+    if (routing_mode == RoutingMode::Affinity) {
+        int index = group.table.lookup(request.in.getValue());
+        LoadBalancer* lb = index >= 0 ? &balancers[static_cast<std::size_t>(index)] : nullptr;
+        if (lb != nullptr && lb != avoid) {
+            last_routed_balancer = lb;
+            if (!lb->offerRequest(request, current_cycle, uniform)) return false;
+            group.admitted++;
+            return true;
+        }
+    }
+
+    // find balancer with smallest queue per unit of capacity
+    LoadBalancer* least_busy_balancer = nullptr;
+    double min_load = 0.0;
+    for (LoadBalancer& lb : balancers) {
+        if (&lb == avoid) continue;
+        double load = lb.getQueueSize() / lb.getCapacity();
+        if (least_busy_balancer == nullptr || load < min_load) {
+            min_load = load;
+            least_busy_balancer = &lb;
+        }
+    }
+    if (least_busy_balancer == nullptr) return false;
+
+    // offer request to least loaded balancer
+    last_routed_balancer = least_busy_balancer;
+    if (!least_busy_balancer->offerRequest(request, current_cycle, uniform)) return false;
+    group.admitted++;
+    return true;
+}
+
+/**
+ * @brief Updates the sketch and adds flooding sources to the dynamic blocklist.
+ *
+ * The sketch is cleared at each window boundary, when expired blocks are
+ * also purged so the blocklist only holds currently blocked sources.
+ */
+void Switch::trackSource(const IPAddress& source, int current_cycle) {
+    if (current_cycle - heavy_hitter_window_start >= heavy_hitter_window) {
+        heavy_hitters.reset();
+        heavy_hitter_window_start = current_cycle;
+        for (auto it = dynamic_blocks.begin(); it != dynamic_blocks.end();) {
+            it = (it->second < current_cycle) ? dynamic_blocks.erase(it) : std::next(it);
+        }
+    }
+
+    std::uint32_t count = heavy_hitters.update(source.getValue());
+    if (count <= heavy_hitter_threshold * heavy_hitter_window) return;
+
+    auto it = dynamic_blocks.find(source.getValue());
+    if (it != dynamic_blocks.end() && it->second >= current_cycle) return;
+
+    dynamic_blocks[source.getValue()] = current_cycle + heavy_hitter_block_ttl;
+    auto_blocks++;
+    logStream() << Color::RED << "[SWITCH ACTION] Auto-blocked flooding IP: "
+              << source.getString() << " | " << count << " requests this window"
+              << " | blocked for " << heavy_hitter_block_ttl << " cycles"
+              << Color::RESET << "\n";
+}
+
+/**
+ * @brief Sets the attempt's deadline, routes it and schedules its hedge.
+ */
+bool Switch::sendAttempt(Request& request, int current_cycle) {
+    request.stage_arrival_cycle = current_cycle;
+    request.deadline = request_timeout > 0 ? current_cycle + request_timeout : -1;
+    request.hedged = (hedge_delay > 0);
+    request.hedge_copy = false;
+
+    if (!addRequestToBalancer(request, current_cycle)) return false;
+
+    if (request.hedged) {
+        hedge_tracker.track(request.id);
+        DelayedRequest hedge{current_cycle + hedge_delay, request, last_routed_balancer};
+        hedge.request.hedge_copy = true;
+        delayed_requests.push(hedge);
+    }
+    return true;
+}
+
+/**
+ * @brief Pops due entries off the pending queue and routes them.
+ */
+void Switch::releaseDelayedRequests(int current_cycle) {
+    while (!delayed_requests.empty() && delayed_requests.top().send_cycle <= current_cycle) {
+        DelayedRequest pending = delayed_requests.top();
+        delayed_requests.pop();
+        Request& r = pending.request;
+
+        if (!r.hedge_copy) {
+            retries_sent++;
+            if (logEnabled()) {
+                logStream() << Color::MAGENTA << "[SWITCH ACTION] Retrying request from "
+                          << r.in.getString() << " | attempt " << r.attempt + 1
+                          << Color::RESET << "\n";
+            }
+            sendAttempt(r, current_cycle);
+            continue;
+        }
+
+        // the original may have started or expired while the hedge waited
+        if (!hedge_tracker.addCopy(r.id)) continue;
+        r.stage_arrival_cycle = current_cycle;
+        if (addRequestToBalancer(r, current_cycle, pending.avoid)) {
+            hedges_sent++;
+            if (logEnabled()) {
+                logStream() << Color::MAGENTA << "[SWITCH ACTION] Hedged request from "
+                          << r.in.getString() << " to balancer " << last_routed_balancer->getLabel()
+                          << Color::RESET << "\n";
+            }
+        } else {
+            hedge_tracker.dropCopy(r.id);
+        }
+    }
+}
+
+/**
+ * @brief Turns expired requests into retries or client-visible timeouts.
+ */
+void Switch::handleExpiredRequests(int current_cycle) {
+    std::vector<Request> expired;
+    for (BalancerGroup& group : groups) {
+        for (LoadBalancer& lb : group.balancers) lb.takeExpiredRequests(expired);
+    }
+
+    for (Request& r : expired) {
+        // another copy of a hedged request may still be queued or running
+        if (r.hedged && !hedge_tracker.dropCopy(r.id)) continue;
+
+        if (r.attempt < max_retries) {
+            r.attempt++;
+            delayed_requests.push(DelayedRequest{current_cycle + retry_backoff + 1, r, nullptr});
+        } else {
+            timed_out_requests++;
+        }
+    }
+}
+
+/**
+ * @brief Advances finished stages and drains every class's handoff.
+ *
+ * Later stages carry no client deadline and no hedge: both only govern
+ * how long a client waits for the first stage to start.
+ */
+void Switch::forwardCompletedStages(int current_cycle) {
+    if (!pipelines) return;
+
+    std::vector<Request> finished;
+    for (BalancerGroup& group : groups) {
+        for (LoadBalancer& lb : group.balancers) lb.takeForwardedRequests(finished);
+    }
+
+    for (Request& r : finished) {
+        r.stage++;
+        r.job_class = r.route[r.stage];
+        r.stage_arrival_cycle = current_cycle;
+        r.deadline = -1;
+        r.hedged = false;
+        r.hedge_copy = false;
+
+        BalancerGroup& group = groups[r.job_class];
+        group.forwarded_in++;
+        group.handoff.push_back(r);
+    }
+
+    // the head blocks the handoff until a balancer admits it
+    for (BalancerGroup& group : groups) {
+        while (!group.handoff.empty() &&
+               offerToGroup(group, group.handoff.front(), current_cycle, nullptr)) {
+            group.handoff.pop_front();
+        }
+        group.handoff_wait_cycles += static_cast<long long>(group.handoff.size());
+    }
+}
+
+/**
+ * @brief Calculates the total number of queued requests across all load balancers.
+ *
+ * Iterates through the load balancers of every job class group and sums
+ * their individual queue sizes plus requests waiting in each handoff,
+ * then adds every child's links and subtree.
+ *
+ * @return Total number of pending requests across the entire system.
+ */
+std::size_t Switch::getTotalQueueSize() {
+    if (remote_process != nullptr) return static_cast<std::size_t>(remote_stats.queued);
+    std::size_t total = 0;
+
+    for (BalancerGroup& group : groups) {
+        for (LoadBalancer& lb : group.balancers) {
+            total += lb.getQueueSize();
+        }
+        total += group.handoff.size();
+    }
+    for (std::unique_ptr<Switch>& child : children) {
+        total += child->inbox.size() + child->getTotalQueueSize();
+    }
+
+    return total;
+}
+
+
+/**
+ * @brief Sums queue spill traffic over every load balancer.
+ *
+ * Leaves in other processes spill to their own files and are not counted.
+ *
+ * @return Combined counters; peaks are summed, an upper bound on disk use.
+ */
+SpillStats Switch::getTotalSpillStats() {
+    SpillStats total;
+    if (remote_process != nullptr) return total;
+
+    for (BalancerGroup& group : groups) {
+        for (LoadBalancer& lb : group.balancers) {
+            total.add(lb.getQueueSpillStats());
+        }
+    }
+    for (std::unique_ptr<Switch>& child : children) {
+        total.add(child->getTotalSpillStats());
+    }
+
+    return total;
+}
+
+/**
+ * @brief Sums completed requests over every load balancer.
+ *
+ * @return Total number of requests that finished processing.
+ */
+long long Switch::getTotalCompleted() {
+    if (remote_process != nullptr) return remote_stats.completed;
+    long long total = 0;
+
+    for (BalancerGroup& group : groups) {
+        for (LoadBalancer& lb : group.balancers) {
+            total += lb.getCompletedCount();
+        }
+    }
+    for (std::unique_ptr<Switch>& child : children) {
+        total += child->getTotalCompleted();
+    }
+
+    return total;
+}
+
+/**
+ * @brief Sums arrivals rejected by admission control over every load balancer.
+ *
+ * @return Total number of rejected requests.
+ */
+long long Switch::getTotalRejected() {
+    if (remote_process != nullptr) return remote_stats.rejected;
+    long long total = 0;
+
+    for (BalancerGroup& group : groups) {
+        for (LoadBalancer& lb : group.balancers) {
+            total += lb.getRejectedCount();
+        }
+    }
+    for (std::unique_ptr<Switch>& child : children) {
+        total += child->getTotalRejected();
+    }
+
+    return total;
+}
+
+/**
+ * @brief Sums requests dropped past their deadline over every load balancer.
+ *
+ * @return Total number of expired requests, counting each attempt and copy.
+ */
+long long Switch::getTotalExpired() {
+    if (remote_process != nullptr) return remote_stats.expired;
+    long long total = 0;
+
+    for (BalancerGroup& group : groups) {
+        for (LoadBalancer& lb : group.balancers) {
+            total += lb.getExpiredCount();
+        }
+    }
+    for (std::unique_ptr<Switch>& child : children) {
+        total += child->getTotalExpired();
+    }
+
+    return total;
+}
+
+/**
+ * @brief Calculates the number of servers of one job class in the subtree.
+ *
+ * Iterates through the class's load balancers at this node and every
+ * descendant and sums the number of servers managed by each.
+ *
+ * @param job_class Job class id to count.
+ * @return Total count of the class's WebServers.
+ */
+int Switch::getServerCount(int job_class) {
+    if (remote_process != nullptr) return remote_servers[job_class];
+    int total = 0;
+
+    for (LoadBalancer& lb : groups[job_class].balancers) {
+        total += lb.getServerCount();
+    }
+    for (std::unique_ptr<Switch>& child : children) {
+        total += child->getServerCount(job_class);
+    }
+
+    return total;
+}
+
+/**
+ * @brief Recursive sum over the subtree.
+ */
+long long Switch::sumSubtree(const std::function<long long(Switch&)>& value) {
+    long long total = value(*this);
+    for (std::unique_ptr<Switch>& child : children) {
+        total += child->sumSubtree(value);
+    }
+    return total;
+}
+
+/**
+ * @brief Sums completed requests over one job class group.
+ *
+ * @param group Job class group to count.
+ * @return Requests of the class that finished processing.
+ */
+long long Switch::getCompleted(BalancerGroup& group) {
+    long long total = 0;
+
+    for (LoadBalancer& lb : group.balancers) {
+        total += lb.getCompletedCount();
+    }
+
+    return total;
+}
+
+/**
+ * @brief Checks whether a request's source IP is auto-blocked or within any
+ * blocked IP range.
+ */
+bool Switch::isBlocked(Request& request, int current_cycle) {
+    // dynamic blocks expire after their TTL
+    if (!dynamic_blocks.empty()) {
+        auto it = dynamic_blocks.find(request.in.getValue());
+        if (it != dynamic_blocks.end() && it->second >= current_cycle) {
+            return true;
+        }
+    }
+
+    // check if the request's source IP is in any blocked range
+    return active_policy->blocklist.contains(request.in);
+}
+
+/**
+ * @brief Prints completions, cache hit rate, spills and queue imbalance for a pool.
+ *
+ * Imbalance is the largest time-averaged queue divided by the pool mean
+ * (1.0 = perfectly even), the cost side of routing by affinity.
+ */
+void Switch::reportAffinitySummary(BalancerGroup& group) {
+    std::vector<LoadBalancer>& balancers = group.balancers;
+    long long completed = 0, hits = 0, misses = 0, spills = 0;
+    double max_queue = 0.0, sum_queue = 0.0;
+
+    for (LoadBalancer& lb : balancers) {
+        completed += lb.getCompletedCount();
+        hits += lb.getCacheHits();
+        misses += lb.getCacheMisses();
+        spills += lb.getAffinitySpills();
+        max_queue = std::max(max_queue, lb.getAverageQueueSize());
+        sum_queue += lb.getAverageQueueSize();
+    }
+
+    double mean_queue = balancers.empty() ? 0.0 : sum_queue / balancers.size();
+    double hit_rate = (hits + misses) > 0 ? static_cast<double>(hits) / (hits + misses) : 0.0;
+    double imbalance = mean_queue > 0.0 ? max_queue / mean_queue : 1.0;
+
+    logStream() << "  Pool (" << group.name << ") completed=" << completed
+              << " cache_hit_rate=" << hit_rate
+              << " affinity_spills=" << spills
+              << " queue_imbalance=" << imbalance << "\n";
+}
+
+/**
+ * @brief Prints count, mean, p50, p99 and max response time per priority class.
+ */
+void Switch::reportLatencySummary(BalancerGroup& group) {
+    std::vector<LatencyHistogram> merged;
+    for (LoadBalancer& lb : group.balancers) {
+        const std::vector<LatencyHistogram>& by_class = lb.getLatencyByClass();
+        if (by_class.size() > merged.size()) merged.resize(by_class.size());
+        for (std::size_t c = 0; c < by_class.size(); c++) {
+            merged[c].merge(by_class[c]);
+        }
+    }
+
+    for (std::size_t c = 0; c < merged.size(); c++) {
+        logStream() << "  Latency (" << group.name << ") class " << c
+                  << ": count=" << merged[c].count()
+                  << " mean=" << merged[c].mean()
+                  << " p50=" << merged[c].percentile(50)
+                  << " p99=" << merged[c].percentile(99)
+                  << " max=" << merged[c].max() << "\n";
+    }
+}
 
 /**
- * @brief Static random engine used across all methods to avoid re-seeding every call.
+ * @brief Prints one line of request counts per job class.
+ *
+ * Blocked counts new requests like the overall total; rate limited and
+ * queued count every attempt, including retries and hedge copies.
  */
-static std::mt19937 generator(std::random_device{}());
+void Switch::reportClassSummary() {
+    for (BalancerGroup& group : groups) {
+        long long rejected = group.unroutable, expired = 0;
+        for (LoadBalancer& lb : group.balancers) {
+            rejected += lb.getRejectedCount();
+            expired += lb.getExpiredCount();
+        }
+        logStream() << "  Class " << group.name << ": generated=" << group.generated
+                  << " blocked=" << group.blocked
+                  << " rate_limited=" << group.rate_limited
+                  << " queued=" << group.admitted
+                  << " rejected=" << rejected
+                  << " expired=" << expired
+                  << " completed=" << getCompleted(group) << "\n";
+    }
+}
 
 /**
- * @brief Constructs the Switch and initializes its load balancer pools.
+ * @brief Prints one line per tier, the most utilised tier and one line per route.
+ *
+ * The tier with the highest utilisation limits pipeline throughput; a
+ * growing handoff or backpressure refusals show where it pushes back.
  */
-Switch::Switch(int num_p_balancers,
-               int num_s_balancers,
-               int servers_per_p_balancer,
-               int servers_per_s_balancer,
-               int num_wait_clock_cycles,
-               int min_request_time,
-               int max_request_time,
-               const std::vector<IPRange>& blocked_ranges)
- : min_request_time(min_request_time),
-   max_request_time(max_request_time),
-   blocked_ranges(blocked_ranges) {
+void Switch::reportPipelineSummary() {
+    const BalancerGroup* bottleneck = nullptr;
+    double bottleneck_util = -1.0;
+
+    for (BalancerGroup& group : groups) {
+        LatencyHistogram stage;
+        double busy = 0.0, capacity = 0.0;
+        for (LoadBalancer& lb : group.balancers) {
+            stage.merge(lb.getStageLatency());
+            busy += lb.getUtilisation() * lb.getCapacity();
+            capacity += lb.getCapacity();
+        }
+        double util = capacity > 0.0 ? busy / capacity : 0.0;
+        if (util > bottleneck_util) {
+            bottleneck_util = util;
+            bottleneck = &group;
+        }
 
-    // initialize load balancers
-    for (int i = 0; i < num_p_balancers; i++) {
-        std::string label = std::to_string(i+1) + "P";
-        p_load_balancers.emplace_back(servers_per_p_balancer, num_wait_clock_cycles, label);
+        logStream() << "  Tier (" << group.name << ") utilisation=" << util
+                  << " forwarded_in=" << group.forwarded_in
+                  << " handoff_waiting=" << group.handoff.size()
+                  << " handoff_wait_cycles=" << group.handoff_wait_cycles
+                  << " backpressure_refusals=" << group.backpressure_refusals
+                  << " stage_p50=" << stage.percentile(50)
+                  << " stage_p99=" << stage.percentile(99) << "\n";
+    }
+    if (bottleneck != nullptr) {
+        logStream() << "  Busiest tier: " << bottleneck->name
+                  << " (utilisation " << bottleneck_util << ")\n";
     }
-    for (int i = 0; i < num_s_balancers; i++) {
-        std::string label = std::to_string(i+1) + "S";
-        s_load_balancers.emplace_back(servers_per_s_balancer, num_wait_clock_cycles, label);
+
+    // end-to-end time of multi-stage requests, by the class they started in
+    for (std::size_t c = 0; c < groups.size(); c++) {
+        if (groups[c].route.size() < 2) continue;
+
+        LatencyHistogram merged;
+        for (BalancerGroup& group : groups) {
+            for (LoadBalancer& lb : group.balancers) {
+                const std::vector<LatencyHistogram>& by_route = lb.getLatencyByRoute();
+                if (c < by_route.size()) merged.merge(by_route[c]);
+            }
+        }
+
+        std::string path;
+        for (int id : groups[c].route) {
+            path += (path.empty() ? "" : "->") + groups[id].name;
+        }
+        logStream() << "  Route " << path
+                  << ": count=" << merged.count()
+                  << " mean=" << merged.mean()
+                  << " p50=" << merged.percentile(50)
+                  << " p99=" << merged.percentile(99)
+                  << " max=" << merged.max() << "\n";
     }
 }
 
 /**
- * @brief Generates a random Request, optionally forcing its job type.
+ * @brief Moves surplus work from the longest queue to siblings with spare slots.
  */
-Request Switch::makeRandomRequest(char jobOverride) {
-    // random distributions
-    std::uniform_int_distribution<int> ip_dist(0, 255);
-    std::uniform_int_distribution<int> time_dist(min_request_time, max_request_time);
-    std::uniform_int_distribution<int> job_dist(0, 1); // 0 for 'P', 1 for 'S'
+void Switch::stealWork(std::vector<LoadBalancer>& balancers, int current_cycle) {
+    if (balancers.size() < 2) return;
 
-    // lambda to generate random IP address string
-    auto random_ip = [&]() {
-        return std::to_string(ip_dist(generator)) + "." +
-               std::to_string(ip_dist(generator)) + "." +
-               std::to_string(ip_dist(generator)) + "." +
-               std::to_string(ip_dist(generator));
-    };
+    // the victim is the balancer with the longest queue
+    LoadBalancer* victim = &balancers[0];
+    for (LoadBalancer& lb : balancers) {
+        if (lb.getQueueSize() > victim->getQueueSize()) {
+            victim = &lb;
+        }
+    }
 
-    // create request with random values
-    IPAddress in(random_ip());
-    IPAddress out(random_ip());
-    int time = time_dist(generator);
-    char job = (job_dist(generator) == 0) ? 'P' : 'S';
-    if (jobOverride == 'P' || jobOverride == 'S') job = jobOverride;
+    // spare slots = slots that would stay idle after serving the own queue
+    std::vector<std::size_t> spare(balancers.size(), 0);
+    std::size_t total_spare = 0;
+    for (std::size_t i = 0; i < balancers.size(); i++) {
+        if (&balancers[i] == victim) continue;
+        std::size_t idle = static_cast<std::size_t>(balancers[i].getIdleSlots(current_cycle));
+        std::size_t queued = balancers[i].getQueueSize();
+        spare[i] = idle > queued ? idle - queued : 0;
+        total_spare += spare[i];
+    }
+    if (total_spare == 0) return;
 
-    // return request
-    Request r(in, out, time, job);
-    std::cout << Color::MAGENTA << "Generated Request: "
-              << r.in.getString() << " -> " << r.out.getString()
-              << " | time=" << r.time << " | job=" << r.job
-              << Color::RESET << "\n";
-    return r;
+    std::size_t batch = total_spare;
+    if (steal_batch > 0) batch = std::min(batch, steal_batch);
+    if (victim->publishSurplus(current_cycle, batch) == 0) return;
+
+    for (std::size_t i = 0; i < balancers.size(); i++) {
+        if (spare[i] > 0) {
+            balancers[i].stealFrom(*victim, spare[i]);
+        }
+    }
+    victim->reclaimSurplus();
 }
 
 /**
- * @brief Routes a request to the least-busy load balancer of the correct type.
+ * @brief Runs one clock cycle for each load balancer in every group.
  *
- * Drops the request if it is blocked.
+ * When work stealing is enabled, a steal phase runs first in each group so
+ * stolen requests are assigned in the same cycle.
  */
-void Switch::addRequestToBalancer(Request& request) {
-    // check if this request should be blocked
-    if (isBlocked(request)) {
-        std::cout << Color::RED << "[SWITCH ACTION] Blocked IP: "
-                  << request.in.getString()
-                  << Color::RESET << "\n";
-        return;
+void Switch::goThroughClockCycleAllLoadBalancers(int current_cycle) {
+    if (work_stealing) {
+        for (BalancerGroup& group : groups) {
+            stealWork(group.balancers, current_cycle);
+        }
     }
 
-    // check which balancer vector to use
-    std::vector<LoadBalancer>& balancers = (request.job == 'P') ? p_load_balancers : s_load_balancers;
-
-    // initialize to first balancer
-    LoadBalancer* least_busy_balancer = &balancers[0];
-    std::size_t min_queue_size = least_busy_balancer->getQueueSize();
+    // run a clock cycle for each load balancer
+    for (BalancerGroup& group : groups) {
+        for (LoadBalancer& lb : group.balancers) {
+            lb.goThroughClockCycle(current_cycle);
+        }
+    }
+}
 
-    // iterate through and find balancer with smallest queue
-    for (LoadBalancer& lb : balancers) {
-        size_t queue_size = lb.getQueueSize();
-        if (queue_size < min_queue_size) {
-            min_queue_size = queue_size;
-            least_busy_balancer = &lb;
+/**
+ * @brief Class counters are registered where requests are counted: at the
+ * root and at the leaves, which count the arrivals they receive.
+ */
+void Switch::registerMetrics(MetricsRegistry& registry) {
+    if (depth == 0) {
+        cycle_metric = &registry.gauge("lb_cycle", "Last completed simulation cycle.");
+    }
+    for (BalancerGroup& group : groups) {
+        std::string labels = metricLabel("node", name) + "," + metricLabel("class", group.name);
+        if (depth == 0 || children.empty()) {
+            group.generated_metric = &registry.counter("lb_switch_arrivals_total",
+                                                       "Requests arriving at the switch node.", labels);
+            group.blocked_metric = &registry.counter("lb_switch_blocked_total",
+                                                     "Arrivals whose source is blocked.", labels);
+            group.rate_limited_metric = &registry.counter("lb_switch_rate_limited_total",
+                                                          "Attempts dropped by the rate limiter.", labels);
+        }
+        for (LoadBalancer& lb : group.balancers) {
+            lb.registerMetrics(registry, labels + "," + metricLabel("balancer", lb.getLabel()));
         }
     }
 
-    // add request to balancer with smallest queue
-    if (least_busy_balancer != nullptr) {
-        least_busy_balancer->addRequest(request);
+    if (depth == 0 && leaf_process_count > 1) return;
+    for (std::unique_ptr<Switch>& child : children) {
+        child->registerMetrics(registry);
     }
 }
 
 /**
- * @brief Calculates the total number of queued requests across all load balancers.
- *
- * Iterates through all Processing (P) and Streaming (S) load balancers
- * managed by the Switch and sums their individual queue sizes.
- *
- * @return Total number of pending requests across the entire system.
+ * @brief Balancers publish their own series as they finish a cycle.
  */
-std::size_t Switch::getTotalQueueSize() {
-    std::size_t total = 0;
+void Switch::publishMetrics(int current_cycle) {
+    if (cycle_metric != nullptr) cycle_metric->set(current_cycle);
+    for (BalancerGroup& group : groups) {
+        if (group.generated_metric == nullptr) continue;
+        group.generated_metric->set(static_cast<std::uint64_t>(group.generated));
+        group.blocked_metric->set(static_cast<std::uint64_t>(group.blocked));
+        group.rate_limited_metric->set(static_cast<std::uint64_t>(group.rate_limited));
+    }
+    for (std::unique_ptr<Switch>& child : children) {
+        child->publishMetrics(current_cycle);
+    }
+}
 
-    for (LoadBalancer& lb : p_load_balancers) {
-        total += lb.getQueueSize();
+/**
+ * @brief Depth-first over the subtree, in group order within a node.
+ */
+void Switch::collectLocalBalancers(std::vector<LoadBalancer*>& balancers,
+                                   std::vector<std::string>& node_names) {
+    std::vector<Switch*> nodes;
+    collectNodes(nodes);
+    for (Switch* node : nodes) {
+        for (BalancerGroup& group : node->groups) {
+            for (LoadBalancer& lb : group.balancers) {
+                balancers.push_back(&lb);
+                node_names.push_back(node->name);
+            }
+        }
     }
+}
+
+/**
+ * @brief One column group per local balancer.
+ */
+void Switch::openTimeSeries() {
+    std::vector<std::string> node_names, labels;
+    collectLocalBalancers(series_balancers, node_names);
+    for (LoadBalancer* lb : series_balancers) labels.push_back(lb->getLabel());
+    series_samples.resize(series_balancers.size());
 
-    for (LoadBalancer& lb : s_load_balancers) {
-        total += lb.getQueueSize();
+    timeseries = std::make_unique<TimeSeriesWriter>(timeseries_config, node_names, labels);
+    if (!timeseries->isOpen()) {
+        std::cerr << "WARNING: could not open time series file " << timeseries_config.file << "\n";
+        timeseries.reset();
+        return;
     }
 
-    return total;
+    // preloaded requests are not arrivals of the first row
+    recordTimeSeries(0, false);
 }
 
+/**
+ * @brief Reads each balancer's gauges and running totals.
+ */
+void Switch::recordTimeSeries(int current_cycle, bool end_of_run) {
+    if (current_cycle > 0 && !timeseries->wantsSample(current_cycle, end_of_run)) return;
+
+    for (std::size_t b = 0; b < series_balancers.size(); b++) {
+        LoadBalancer& lb = *series_balancers[b];
+        BalancerSample& sample = series_samples[b];
+        sample.queue = static_cast<double>(lb.getQueueSize());
+        sample.servers = lb.getServerCount();
+        sample.arrivals = lb.getArrivalCount();
+        sample.completed = lb.getCompletedCount();
+        sample.scale_ups = lb.getScaleUpCount();
+        sample.scale_downs = lb.getScaleDownCount();
+    }
+    if (current_cycle == 0) {
+        timeseries->setBaseline(series_samples);
+    } else {
+        timeseries->record(current_cycle, series_samples, end_of_run);
+    }
+}
 
 /**
- * @brief Calculates the total number of Processing (P) servers.
- *
- * Iterates through all Processing load balancers and sums the number
- * of servers managed by each.
- *
- * @return Total count of P-type WebServers.
+ * @brief A segment that cannot be created only costs a warning.
  */
-int Switch::getServerCountP() {
-    int total = 0;
+void Switch::openLiveSnapshot(int total_clock_cycles) {
+    std::vector<std::string> node_names, labels;
+    collectLocalBalancers(live_balancers, node_names);
+    for (LoadBalancer* lb : live_balancers) labels.push_back(lb->getLabel());
 
-    for (LoadBalancer& lb : p_load_balancers) {
-        total += lb.getServerCount();
+    live = std::make_unique<LiveSnapshot>(live_name, node_names, labels, total_clock_cycles);
+    if (!live->isValid()) {
+        std::cerr << "WARNING: could not create live snapshot " << live_name << "\n";
+        live.reset();
+        return;
     }
+    logStream() << Color::CYAN << "[SWITCH] Live snapshot in shared memory " << live_name
+              << " every " << live_interval << " cycle(s)" << Color::RESET << "\n";
+}
 
-    return total;
+/**
+ * @brief Percentiles are of the whole run so far, over every class.
+ */
+void Switch::publishLiveSnapshot(int current_cycle, bool end_of_run) {
+    live->begin();
+    for (std::size_t b = 0; b < live_balancers.size(); b++) {
+        LoadBalancer& lb = *live_balancers[b];
+        const std::vector<LatencyHistogram>& by_class = lb.getLatencyByClass();
+        const LatencyHistogram* latency = &live_latency;
+        if (by_class.size() == 1) {
+            latency = &by_class[0];
+        } else {
+            live_latency.reset();
+            for (const LatencyHistogram& histogram : by_class) live_latency.merge(histogram);
+        }
+
+        LiveBalancer& slot = live->slot(b);
+        slot.queue.store(static_cast<double>(lb.getQueueSize()), std::memory_order_relaxed);
+        slot.servers.store(lb.getServerCount(), std::memory_order_relaxed);
+        slot.utilisation.store(lb.getUtilisation(), std::memory_order_relaxed);
+        slot.arrivals.store(lb.getArrivalCount(), std::memory_order_relaxed);
+        slot.completed.store(lb.getCompletedCount(), std::memory_order_relaxed);
+        slot.rejected.store(lb.getRejectedCount(), std::memory_order_relaxed);
+        slot.expired.store(lb.getExpiredCount(), std::memory_order_relaxed);
+        slot.p50.store(latency->percentile(50.0), std::memory_order_relaxed);
+        slot.p95.store(latency->percentile(95.0), std::memory_order_relaxed);
+        slot.p99.store(latency->percentile(99.0), std::memory_order_relaxed);
+    }
+    live->end(current_cycle, end_of_run);
 }
 
+/**
+ * @brief Streams the run header and the tree, then logs size and time.
+ */
+void Switch::writeCheckpoint(const RunProgress& progress) {
+    auto began = std::chrono::steady_clock::now();
+    CheckpointWriter out(checkpoint_file);
+    if (out.isOpen()) {
+        out.putTag("RUN ");
+        out.put(static_cast<std::uint32_t>(sizeof(Request)));
+        out.put(progress.cycle);
+        out.put(progress.generated);
+        out.put(progress.blocked);
+        out.put(static_cast<std::uint64_t>(progress.starting_queue_size));
+        out.putVector(progress.starting_servers);
+        out.put(progress.window_offered);
+        out.put(progress.window_admitted);
+        out.put(progress.window_start_completed);
+        out.put(progress.window_start_refused);
+        saveState(out);
+        out.putTag("END ");
+    }
+    if (!out.finish()) {
+        logStream() << Color::RED << "[SWITCH] Could not write checkpoint " << checkpoint_file
+                  << Color::RESET << "\n";
+        return;
+    }
+    long long ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - began).count();
+    logStream() << Color::CYAN << "[SWITCH] Checkpoint of cycle " << progress.cycle << ": "
+              << out.getByteCount() << " bytes written to " << checkpoint_file << " in " << ms << " ms"
+              << Color::RESET << "\n";
+}
 
 /**
- * @brief Calculates the total number of Streaming (S) servers.
- *
- * Iterates through all Streaming load balancers and sums the number
- * of servers managed by each.
- *
- * @return Total count of S-type WebServers.
+ * @brief Depth-first: this node's fields, its groups, then its children.
  */
-int Switch::getServerCountS() {
-    int total = 0;
+void Switch::saveState(CheckpointWriter& out) const {
+    out.putTag("NODE");
+    out.putText(name);
+    std::ostringstream engine;
+    engine << generator;
+    out.putText(engine.str());
 
-    for (LoadBalancer& lb : s_load_balancers) {
-        total += lb.getServerCount();
+    out.put(next_request_id);
+    out.put(retries_sent);
+    out.put(hedges_sent);
+    out.put(timed_out_requests);
+    out.put(received);
+    out.put(blocked_here);
+    out.put(arrivals_refused);
+    out.put(forwarded_down);
+    out.put(in_transit_sum);
+    out.put(cycles_stepped);
+    out.put(subtree_queue);
+    out.put(subtree_capacity);
+    out.put(auto_blocks);
+    out.put(heavy_hitter_window_start);
+    out.putVector(client_pool);
+    out.putVector(flood_pool);
+    out.put(static_cast<std::uint64_t>(dynamic_blocks.size()));
+    for (const std::pair<const unsigned int, int>& block : dynamic_blocks) {
+        out.put(block.first);
+        out.put(block.second);
     }
+    rate_limiter.save(out);
+    heavy_hitters.save(out);
+    hedge_tracker.save(out);
 
-    return total;
+    // a hedge's avoided balancer is saved as its position within this node
+    std::unordered_map<const LoadBalancer*, int> positions;
+    for (const BalancerGroup& group : groups) {
+        for (const LoadBalancer& lb : group.balancers) {
+            positions.emplace(&lb, static_cast<int>(positions.size()));
+        }
+    }
+    const std::vector<DelayedRequest>& delayed = heapStorage(delayed_requests);
+    out.put(static_cast<std::uint64_t>(delayed.size()));
+    for (const DelayedRequest& pending : delayed) {
+        auto avoid = positions.find(pending.avoid);
+        out.put(pending.send_cycle);
+        out.put(pending.request);
+        out.put(avoid != positions.end() ? avoid->second : -1);
+    }
+    out.put(static_cast<std::uint64_t>(inbox.size()));
+    for (const std::pair<int, Request>& entry : inbox) {
+        out.put(entry.first);
+        out.put(entry.second);
+    }
+
+    out.put(static_cast<std::uint64_t>(groups.size()));
+    for (const BalancerGroup& group : groups) {
+        out.putText(group.name);
+        out.put(group.generated);
+        out.put(group.blocked);
+        out.put(group.rate_limited);
+        out.put(group.admitted);
+        out.put(group.unroutable);
+        out.put(group.forwarded_in);
+        out.put(group.handoff_wait_cycles);
+        out.put(group.backpressure_refusals);
+        out.putDeque(group.handoff);
+        out.put(static_cast<std::uint64_t>(group.balancers.size()));
+        for (const LoadBalancer& lb : group.balancers) lb.save(out);
+    }
+
+    out.put(static_cast<std::uint64_t>(children.size()));
+    for (const std::unique_ptr<Switch>& child : children) child->saveState(out);
 }
 
 /**
- * @brief Checks whether a request's source IP is within any blocked IP range.
+ * @brief Reads the fields in saveState() order, checking names and counts
+ * against this node before reading what they describe.
  */
-bool Switch::isBlocked(Request& request) {
-    // check if the request's source IP is in any blocked range
-    for (const auto& range : blocked_ranges) {
-        unsigned int in_val = request.in.getValue();
-        unsigned int low_val = range.low.getValue();
-        unsigned int high_val = range.high.getValue();
+void Switch::restoreState(CheckpointReader& in) {
+    in.expectTag("NODE");
+    std::string saved_name = in.getText();
+    if (in.ok() && saved_name != name) {
+        in.fail("node " + saved_name + " found where " + name + " was expected");
+    }
+    if (!in.ok()) return;
+    std::istringstream engine(in.getText());
+    engine >> generator;
+    if (in.ok() && !engine) in.fail("random engine of node " + name + " is invalid");
 
-        if (in_val >= low_val && in_val <= high_val) {
-            return true;
+    in.get(next_request_id);
+    in.get(retries_sent);
+    in.get(hedges_sent);
+    in.get(timed_out_requests);
+    in.get(received);
+    in.get(blocked_here);
+    in.get(arrivals_refused);
+    in.get(forwarded_down);
+    in.get(in_transit_sum);
+    in.get(cycles_stepped);
+    in.get(subtree_queue);
+    in.get(subtree_capacity);
+    in.get(auto_blocks);
+    in.get(heavy_hitter_window_start);
+    in.getVector(client_pool);
+    in.getVector(flood_pool);
+    dynamic_blocks.clear();
+    std::uint64_t blocks = in.get<std::uint64_t>();
+    for (std::uint64_t i = 0; i < blocks && in.ok(); i++) {
+        unsigned int source = in.get<unsigned int>();
+        dynamic_blocks[source] = in.get<int>();
+    }
+    rate_limiter.restore(in);
+    heavy_hitters.restore(in);
+    hedge_tracker.restore(in);
+
+    std::vector<LoadBalancer*> positions;
+    for (BalancerGroup& group : groups) {
+        for (LoadBalancer& lb : group.balancers) positions.push_back(&lb);
+    }
+    std::vector<DelayedRequest>& delayed = heapStorage(delayed_requests);
+    delayed.clear();
+    std::uint64_t pending = in.get<std::uint64_t>();
+    for (std::uint64_t i = 0; i < pending && in.ok(); i++) {
+        DelayedRequest entry{};
+        in.get(entry.send_cycle);
+        in.get(entry.request);
+        int avoid = in.get<int>();
+        if (avoid >= 0 && static_cast<std::size_t>(avoid) < positions.size()) entry.avoid = positions[avoid];
+        delayed.push_back(entry);
+    }
+    inbox.clear();
+    std::uint64_t in_transit = in.get<std::uint64_t>();
+    for (std::uint64_t i = 0; i < in_transit && in.ok(); i++) {
+        int deliver_at = in.get<int>();
+        inbox.emplace_back(deliver_at, in.get<Request>());
+    }
+
+    in.expectCount(groups.size(), "job classes");
+    for (BalancerGroup& group : groups) {
+        std::string saved_class = in.getText();
+        if (in.ok() && saved_class != group.name) {
+            in.fail("job class " + saved_class + " found where " + group.name + " was expected");
+        }
+        if (!in.ok()) return;
+        in.get(group.generated);
+        in.get(group.blocked);
+        in.get(group.rate_limited);
+        in.get(group.admitted);
+        in.get(group.unroutable);
+        in.get(group.forwarded_in);
+        in.get(group.handoff_wait_cycles);
+        in.get(group.backpressure_refusals);
+        in.getDeque(group.handoff);
+        in.expectCount(group.balancers.size(), ("balancers of class " + group.name + " at " + name).c_str());
+        for (LoadBalancer& lb : group.balancers) {
+            if (!in.ok()) return;
+            lb.restore(in);
         }
     }
-    return false;
+
+    in.expectCount(children.size(), ("children of node " + name).c_str());
+    for (std::unique_ptr<Switch>& child : children) {
+        if (!in.ok()) return;
+        child->restoreState(in);
+    }
 }
 
 /**
- * @brief Runs one clock cycle for each load balancer in both pools.
+ * @brief Reads the run header and the tree; the state is only used if
+ * every section matched and the whole file was read.
  */
-void Switch::goThroughClockCycleAllLoadBalancers(int current_cycle) {
-    // run a clock cycle for each load balancer
-    for (LoadBalancer& lb : p_load_balancers) {
-        lb.goThroughClockCycle(current_cycle);
+bool Switch::restoreCheckpoint(const std::string& path) {
+    auto began = std::chrono::steady_clock::now();
+    CheckpointReader in(path);
+    if (in.ok() && leaf_process_count > 1) {
+        in.fail("checkpoints are not available with topology_processes above 1");
+    }
+
+    in.expectTag("RUN ");
+    if (in.get<std::uint32_t>() != sizeof(Request) && in.ok()) {
+        in.fail("checkpoint was written by a build with a different request layout");
     }
-    for (LoadBalancer& lb : s_load_balancers) {
-        lb.goThroughClockCycle(current_cycle);
+    RunProgress progress;
+    in.get(progress.cycle);
+    in.get(progress.generated);
+    in.get(progress.blocked);
+    progress.starting_queue_size = static_cast<std::size_t>(in.get<std::uint64_t>());
+    in.getVector(progress.starting_servers);
+    in.get(progress.window_offered);
+    in.get(progress.window_admitted);
+    in.get(progress.window_start_completed);
+    in.get(progress.window_start_refused);
+    if (in.ok() && progress.starting_servers.size() != groups.size()) {
+        in.fail("checkpoint has " + std::to_string(progress.starting_servers.size()) +
+                " job classes, configuration has " + std::to_string(groups.size()));
     }
+    restoreState(in);
+    in.expectTag("END ");
+    if (in.ok() && !in.atEnd()) in.fail("checkpoint has data after its last section");
+
+    if (!in.ok()) {
+        logStream() << Color::RED << "[SWITCH] Could not restore " << path << ": " << in.getError()
+                  << Color::RESET << "\n";
+        return false;
+    }
+    resume = progress;
+    long long ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - began).count();
+    logStream() << Color::CYAN << "[SWITCH] Restored cycle " << resume.cycle << " from " << path
+              << " (" << in.getByteCount() << " bytes in " << ms << " ms)" << Color::RESET << "\n";
+    return true;
 }
 
 /**
  * @brief Prints a status report of all load balancers.
  *
- * Displays server count and queue size for each load balancer, separated by job type.
+ * Displays server count and queue size for each load balancer, grouped by
+ * job class, then the report of every child node.
  */
 void Switch::reportStatus(int current_cycle) {
     // helper that writes the same text to both cout (log) and cerr (console)
     auto emit = [&](const std::string &text) {
-        std::cout << text;
+        logStream() << text;
         std::cerr << text;
     };
 
-    emit(Color::TURQUOISE + std::string("[SWITCH] Status report at cycle ")
+    std::string tag = depth == 0 ? "[SWITCH]" : "[SWITCH " + name + "]";
+    emit(Color::TURQUOISE + tag + " Status report at cycle "
          + std::to_string(current_cycle) + "\n");
-
-    for (LoadBalancer& lb : p_load_balancers) {
-        emit("  Balancer " + lb.getLabel()
-             + " (P) servers=" + std::to_string(lb.getServerCount())
-             + " queue=" + std::to_string(lb.getQueueSize()) + "\n");
+    if (depth > 0) {
+        emit("  Link latency=" + std::to_string(link_latency)
+             + " in_transit=" + std::to_string(inbox.size()) + "\n");
     }
-    for (LoadBalancer& lb : s_load_balancers) {
-        emit("  Balancer " + lb.getLabel()
-             + " (S) servers=" + std::to_string(lb.getServerCount())
-             + " queue=" + std::to_string(lb.getQueueSize()) + "\n");
+
+    emit(remote_process != nullptr ? remote_status : describeBalancers());
+
+    // current window's heaviest sources
+    if (heavy_hitter_threshold > 0.0) {
+        std::string talkers = "  Top talkers:";
+        for (const auto& talker : heavy_hitters.topTalkers(5)) {
+            talkers += " " + IPAddress(talker.first).getString() + "=" + std::to_string(talker.second);
+        }
+        emit(talkers + " | auto-blocked=" + std::to_string(dynamic_blocks.size()) + "\n");
     }
     emit(Color::RESET);
+
+    for (std::unique_ptr<Switch>& child : children) {
+        child->reportStatus(current_cycle);
+    }
 }
 
 /**
@@ -232,86 +1912,471 @@ void Switch::reportStatus(int current_cycle) {
  */
 void Switch::start(int total_clock_cycles) {
 
-    // summary statistics
+    // summary statistics; a restored run continues from its checkpointed totals
+    bool resumed = resume.cycle > 0;
     std::size_t starting_queue_size = 0;
     std::size_t ending_queue_size = 0;
-    int total_requests_generated = 0;
-    int total_requests_blocked = 0;
-    int starting_servers_p = getServerCountP();
-    int starting_servers_s = getServerCountS();
-    int total_starting_servers = starting_servers_p + starting_servers_s;
-    int ending_servers_p = 0;
-    int ending_servers_s = 0;
+    int total_requests_generated = resume.generated;
+    int total_requests_blocked = resume.blocked;
+    std::vector<int> starting_servers;
+    int total_starting_servers = 0;
+    for (std::size_t c = 0; c < groups.size(); c++) {
+        starting_servers.push_back(resumed ? resume.starting_servers[c]
+                                           : getServerCount(static_cast<int>(c)));
+        total_starting_servers += starting_servers.back();
+    }
+    std::vector<int> ending_servers;
     int total_ending_servers = 0;
 
-    // preload each balancer with 100 requests per server
-    std::cout << Color::CYAN << "[SWITCH] Preloading requests at start..." << Color::RESET << "\n";
-    for (LoadBalancer& lb : p_load_balancers) {
-        int servers = lb.getServerCount();
-        int requests_to_create = 100 * servers;
-        std::cout << Color::CYAN << "  Balancer " << lb.getLabel()
-                  << " (type P) has " << servers << " server(s); adding "
-                  << requests_to_create << " requests" << Color::RESET << "\n";
-        for (int i = 0; i < requests_to_create; ++i) {
-            Request r = makeRandomRequest('P');
-            lb.addRequest(r);
-        }
-    }
-    for (LoadBalancer& lb : s_load_balancers) {
-        int servers = lb.getServerCount();
-        int requests_to_create = 100 * servers;
-        std::cout << Color::CYAN << "  Balancer " << lb.getLabel()
-                  << " (type S) has " << servers << " server(s); adding "
-                  << requests_to_create << " requests" << Color::RESET << "\n";
-        for (int i = 0; i < requests_to_create; ++i) {
-            Request r = makeRandomRequest('S');
-            lb.addRequest(r);
-        }
+    // preload each balancer with preload_per_server requests per server
+    PhaseClock phase_clock(phase_timing);
+    if (!resumed) {
+        logStream() << Color::CYAN << "[SWITCH] Preloading requests at start..." << Color::RESET << "\n";
+        PROFILE_SCOPE(ProfilePhase::Preload);
+        preloadBalancers();
+        refreshSubtreeLoad();
     }
+    phase_clock.charge(phase_times.preload_ns);
 
     // get starting queue size
-    starting_queue_size = getTotalQueueSize();
+    starting_queue_size = resumed ? resume.starting_queue_size : getTotalQueueSize();
+
+    // leaves move to their processes with their preloaded queues
+    if (leaf_process_count > 1) {
+        startLeafProcesses();
+    }
+    // leaf state lives in other processes, out of reach of a checkpoint
+    if (!checkpoint_file.empty() && !processes.empty()) {
+        logStream() << Color::YELLOW << "[SWITCH] Checkpoints are not available with leaf processes; "
+                  << "checkpoint_file ignored" << Color::RESET << "\n";
+        checkpoint_file.clear();
+    }
+    if (!timeseries_config.file.empty()) {
+        openTimeSeries();
+    }
+    if (!live_name.empty()) {
+        openLiveSnapshot(total_clock_cycles);
+    }
+
+    // goodput curve: one window per load step
+    std::ofstream curve;
+    int window_length = 0;
+    int window_offered = resume.window_offered;
+    int window_admitted = resume.window_admitted;
+    long long window_start_completed = resumed ? resume.window_start_completed : getTotalCompleted();
+    // in a topology the root only forwards, so the leaves' refusals of those
+    // requests are taken off its admissions when the window closes
+    auto refused_below = [this]() {
+        return sumSubtree([](Switch& node) { return node.getNodeStats().arrivals_refused; });
+    };
+    long long window_start_refused = resumed ? resume.window_start_refused : refused_below();
+    if (load_curve_steps > 0) {
+        window_length = std::max(total_clock_cycles / load_curve_steps, 1);
+        curve.open(load_curve_file);
+        curve << "step,load_factor,offered_per_cycle,admitted_per_cycle,"
+              << "rejected_per_cycle,goodput_per_cycle,queue_size\n";
+    }
 
     // go through clock cycles
-    for (int cycle = 1; cycle <= total_clock_cycles; ++cycle) {
+    for (int cycle = resume.cycle + 1; cycle <= total_clock_cycles; ++cycle) {
+        PROFILE_SCOPE(ProfilePhase::Cycle);
+
+        // a reloaded config takes effect at the cycle boundary
+        applyPolicy();
+
+        // scale the arrival rate while tracing the goodput curve
+        int step = 0;
+        double load_factor = 1.0;
+        int max_requests = max_requests_per_cycle;
+        if (load_curve_steps > 0) {
+            step = std::min((cycle - 1) / window_length, load_curve_steps - 1);
+            load_factor = load_curve_peak * (step + 1) / load_curve_steps;
+            max_requests = static_cast<int>(std::lround(max_requests_per_cycle * load_factor));
+        }
+
+        // retries and hedge copies due this cycle go out before new arrivals
+        phase_clock.mark();
+        {
+            PROFILE_SCOPE(ProfilePhase::Routing);
+            releaseDelayedRequests(cycle);
+        }
+        phase_clock.charge(phase_times.routing_ns);
+
         // generate random number of requests
-        std::uniform_int_distribution<int> request_count_dist(0, 5);
+        std::uniform_int_distribution<int> request_count_dist(0, max_requests);
         int num_requests = request_count_dist(generator);
         for (int i = 0; i < num_requests; ++i) {
-            Request r = makeRandomRequest();
-            total_requests_generated++;
-            if (isBlocked(r)) {
-                total_requests_blocked++;
+            Request r;
+            {
+                PROFILE_SCOPE(ProfilePhase::Generation);
+                r = makeRandomRequest();
+            }
+            phase_clock.charge(phase_times.generation_ns);
+            {
+                PROFILE_SCOPE(ProfilePhase::Routing);
+                r.arrival_cycle = cycle;
+                r.stage_arrival_cycle = cycle;
+                total_requests_generated++;
+                BalancerGroup& group = groups[r.job_class];
+                group.generated++;
+
+                // addRequestToBalancer() counts blocks in blocked_here, so
+                // the blocklist is looked up once per request
+                long long blocked_before = blocked_here;
+                bool admitted = sendAttempt(r, cycle);
+                if (blocked_here != blocked_before) {
+                    total_requests_blocked++;
+                    group.blocked++;
+                } else {
+                    window_offered++;
+                }
+                if (admitted) {
+                    window_admitted++;
+                }
+            }
+            phase_clock.charge(phase_times.routing_ns);
+        }
+        bool status_due = status_interval > 0 && cycle % status_interval == 0;
+        {
+            PROFILE_SCOPE(ProfilePhase::Step);
+            if (children.empty()) {
+                goThroughClockCycleAllLoadBalancers(cycle);
+            } else {
+                stepTopology(cycle, status_due);
+            }
+        }
+        phase_clock.charge(phase_times.assignment_ns);
+        {
+            PROFILE_SCOPE(ProfilePhase::Forwarding);
+            handleExpiredRequests(cycle);
+            forwardCompletedStages(cycle);
+        }
+        phase_clock.charge(phase_times.routing_ns);
+        phase_times.cycles++;
+
+        // close the goodput window at the end of each step
+        bool window_end = (cycle == total_clock_cycles) ||
+                          (step < load_curve_steps - 1 && cycle % window_length == 0);
+        if (curve.is_open() && window_end) {
+            int cycles_in_window = cycle - step * window_length;
+            long long completed = getTotalCompleted();
+            long long refused = refused_below();
+            long long admitted = window_admitted - (refused - window_start_refused);
+            curve << (step + 1) << "," << load_factor << ","
+                  << static_cast<double>(window_offered) / cycles_in_window << ","
+                  << static_cast<double>(admitted) / cycles_in_window << ","
+                  << static_cast<double>(window_offered - admitted) / cycles_in_window << ","
+                  << static_cast<double>(completed - window_start_completed) / cycles_in_window << ","
+                  << getTotalQueueSize() << "\n";
+            window_offered = 0;
+            window_admitted = 0;
+            window_start_completed = completed;
+            window_start_refused = refused;
+        }
+
+        if (timeseries) {
+            recordTimeSeries(cycle, cycle == total_clock_cycles);
+        }
+        if (live && (cycle % live_interval == 0 || cycle == total_clock_cycles)) {
+            publishLiveSnapshot(cycle, cycle == total_clock_cycles);
+        }
+        if (cycle_metric != nullptr) {
+            publishMetrics(cycle);
+        }
+
+        // report every status_interval cycles
+        {
+            PROFILE_SCOPE(ProfilePhase::Reporting);
+            if (status_due) {
+                reportStatus(cycle);
             }
-            addRequestToBalancer(r);
+
+            logStream() << Color::BLUE << "--- End of cycle " << cycle << " ---"
+                      << Color::RESET << "\n";
         }
-        goThroughClockCycleAllLoadBalancers(cycle);
 
-        // report every 50 cycles
-        if (cycle % 50 == 0) {
-            reportStatus(cycle);
+        // saved after the cycle's log, so a restored run's log picks up here
+        if (!checkpoint_file.empty() &&
+            (cycle == total_clock_cycles || (checkpoint_interval > 0 && cycle % checkpoint_interval == 0))) {
+            RunProgress progress;
+            progress.cycle = cycle;
+            progress.generated = total_requests_generated;
+            progress.blocked = total_requests_blocked;
+            progress.starting_queue_size = starting_queue_size;
+            progress.starting_servers = starting_servers;
+            progress.window_offered = window_offered;
+            progress.window_admitted = window_admitted;
+            progress.window_start_completed = window_start_completed;
+            progress.window_start_refused = window_start_refused;
+            writeCheckpoint(progress);
         }
 
-        std::cout << Color::BLUE << "--- End of cycle " << cycle << " ---"
-                  << Color::RESET << "\n";
+        // no snapshot reference is held past this point
+        releasePolicy();
+    }
+
+    // final reports of remote leaves
+    if (!processes.empty()) {
+        stopLeafProcesses();
+    }
+
+    // remaining rows are written before the summary reports the file
+    if (timeseries) {
+        timeseries->close();
     }
 
     // get ending stats size
     ending_queue_size = getTotalQueueSize();
-    ending_servers_p = getServerCountP();
-    ending_servers_s = getServerCountS();
-    total_ending_servers = ending_servers_p + ending_servers_s;
+    for (std::size_t c = 0; c < groups.size(); c++) {
+        ending_servers.push_back(getServerCount(static_cast<int>(c)));
+        total_ending_servers += ending_servers.back();
+    }
 
     // print summary statistics
-    std::cout << Color::GREEN << "\n[SWITCH] Simulation complete!\n"
+    logStream() << Color::GREEN << "\n[SWITCH] Simulation complete!\n"
               << "  Total requests generated: " << total_requests_generated << "\n"
               << "  Total requests blocked: " << total_requests_blocked << "\n"
+              << "  Total requests rate limited: " << rate_limiter.getLimitedCount() << "\n"
+              << "  Total requests rejected: " << getTotalRejected() << "\n"
+              << "  Total requests expired in queue: " << getTotalExpired() << "\n"
+              << "  Total requests timed out: "
+              << sumSubtree([](Switch& node) { return node.getNodeStats().timed_out; }) << "\n"
               << "  Starting queue size: " << starting_queue_size << "\n"
-              << "  Ending queue size: " << ending_queue_size << "\n"
-              << "  Starting servers (P): " << starting_servers_p << "\n"
-              << "  Starting servers (S): " << starting_servers_s << "\n"
-              << "  Total starting servers: " << total_starting_servers << "\n"
-              << "  Ending servers (P): " << ending_servers_p << "\n"
-              << "  Ending servers (S): " << ending_servers_s << "\n"
-                << "  Total ending servers: " << total_ending_servers << "\n";
+              << "  Ending queue size: " << ending_queue_size << "\n";
+    for (std::size_t c = 0; c < groups.size(); c++) {
+        logStream() << "  Starting servers (" << groups[c].name << "): " << starting_servers[c] << "\n";
+    }
+    logStream() << "  Total starting servers: " << total_starting_servers << "\n";
+    for (std::size_t c = 0; c < groups.size(); c++) {
+        logStream() << "  Ending servers (" << groups[c].name << "): " << ending_servers[c] << "\n";
+    }
+    logStream() << "  Total ending servers: " << total_ending_servers << "\n";
+
+    // hot reloads and reclamation of replaced snapshots
+    if (policy_reloads > 0) {
+        logStream() << "  Config reloads: " << policy_reloads
+                  << " mean_latency_us=" << static_cast<double>(policy_reload_us) / policy_reloads
+                  << " snapshots_reclaimed=" << policy.getReclaimedCount()
+                  << " pending=" << policy.getPendingCount()
+                  << " mean_reclaim_delay_us=" << policy.getMeanReclaimDelayUs() << "\n";
+    }
+
+    // automatic blocking of flooding sources
+    if (heavy_hitter_threshold > 0.0) {
+        logStream() << "  Heavy hitters: sketch=" << heavy_hitters.getMemoryBytes() << " bytes"
+                  << " auto_blocks=" << auto_blocks << "\n";
+    }
+
+    // backlogs beyond queue_memory_mb and how fast they moved to and from disk
+    SpillStats spill = getTotalSpillStats();
+    if (spill.blocks_written > 0 || spill.write_failures > 0) {
+        auto megabytes = [](long long bytes) { return bytes / 1048576.0; };
+        auto rate = [&](long long bytes, long long ns) { return ns > 0 ? megabytes(bytes) / (ns / 1e9) : 0.0; };
+        logStream() << "  Queue spill: written=" << megabytes(spill.bytes_written) << " MB in "
+                  << spill.blocks_written << " blocks at " << rate(spill.bytes_written, spill.write_ns) << " MB/s"
+                  << " read_back=" << megabytes(spill.bytes_read) << " MB in " << spill.blocks_read
+                  << " blocks at " << rate(spill.bytes_read, spill.read_ns) << " MB/s"
+                  << " peak_on_disk=" << megabytes(spill.peak_bytes) << " MB"
+                  << " write_failures=" << spill.write_failures << "\n";
+    }
+
+    // fixed-size bucket table: evictions show when the source budget is too small
+    if (rate_limiter.isEnabled()) {
+        logStream() << "  Rate limiter: " << rate_limiter.getMemoryBytes() << " bytes"
+                  << " evictions=" << rate_limiter.getEvictionCount() << "\n";
+    }
+
+    // extra load caused by client retries and hedging
+    long long total_retries = sumSubtree([](Switch& node) { return node.getNodeStats().retries; });
+    long long total_hedges = sumSubtree([](Switch& node) { return node.getNodeStats().hedges; });
+    double extra_load = total_requests_generated > 0
+        ? static_cast<double>(total_retries + total_hedges) / total_requests_generated : 0.0;
+    logStream() << "  Retries sent: " << total_retries << "\n"
+              << "  Hedges sent: " << total_hedges
+              << " (won=" << sumSubtree([](Switch& node) { return node.getNodeStats().hedge_wins; })
+              << " cancelled=" << sumSubtree([](Switch& node) { return node.getNodeStats().hedges_cancelled; })
+              << ")\n"
+              << "  Extra load from retries and hedges: " << extra_load * 100.0 << "%\n";
+
+    if (timeseries) {
+        logStream() << "  Time series: " << timeseries->getRowCount() << " rows of "
+                  << series_balancers.size() << " balancer(s), " << timeseries->getByteCount()
+                  << " bytes written to " << timeseries_config.file << "\n";
+    }
+
+    // where the wall time went
+    phase_times.requests = total_requests_generated;
+    if (phase_timing) {
+        PhaseTimes times = getPhaseTimes();
+        logStream() << "  Phase times (ms): preload=" << times.preload_ns / 1e6
+                  << " generation=" << times.generation_ns / 1e6
+                  << " routing=" << times.routing_ns / 1e6
+                  << " assignment=" << times.assignment_ns / 1e6
+                  << " scaling=" << times.scaling_ns / 1e6 << "\n";
+    }
+
+    // a flat switch reports its own balancers, a tree reports per node
+    if (children.empty()) {
+        reportGroups();
+    } else {
+        reportTopologySummary();
+    }
+
+    // per-phase timers, in builds made with PROFILE=1
+    reportProfile(logStream());
+}
+
+/**
+ * @brief Collects scaling time from every local balancer of the tree and
+ * takes it out of the balancer steps that contain it.
+ */
+PhaseTimes Switch::getPhaseTimes() {
+    PhaseTimes times = phase_times;
+    times.scaling_ns = sumSubtree([](Switch& node) {
+        long long ns = 0;
+        for (BalancerGroup& group : node.groups) {
+            for (LoadBalancer& lb : group.balancers) ns += lb.getScalingNs();
+        }
+        return ns;
+    });
+    times.assignment_ns = std::max(times.assignment_ns - times.scaling_ns, 0LL);
+    return times;
+}
+
+/**
+ * @brief Preloads this node's balancers, then every child's.
+ */
+void Switch::preloadBalancers() {
+    for (std::size_t c = 0; c < groups.size(); c++) {
+        for (LoadBalancer& lb : groups[c].balancers) {
+            int servers = lb.getServerCount();
+            int requests_to_create = preload_per_server * servers;
+            logStream() << Color::CYAN << "  Balancer " << lb.getLabel()
+                      << " (type " << groups[c].name << ") has " << servers << " server(s); adding "
+                      << requests_to_create << " requests" << Color::RESET << "\n";
+            for (int i = 0; i < requests_to_create; ++i) {
+                Request r = makeRandomRequest(static_cast<int>(c));
+                lb.addRequest(r);
+            }
+        }
+    }
+    for (std::unique_ptr<Switch>& child : children) {
+        child->preloadBalancers();
+    }
+}
+
+/**
+ * @brief Prints the per-class, per-balancer, routing, latency and pipeline
+ * summaries of this node's groups.
+ */
+void Switch::reportGroups() {
+    if (remote_process != nullptr) {
+        logStream() << remote_report;
+        return;
+    }
+
+    // per-class request accounting
+    reportClassSummary();
+
+    // per-balancer capacity, utilisation and work stealing
+    long long total_requests_stolen = 0;
+    for (BalancerGroup& group : groups) {
+        for (LoadBalancer& lb : group.balancers) {
+            logStream() << "  Balancer " << lb.getLabel() << " (" << group.name << ") capacity=" << lb.getCapacity()
+                      << " completed=" << lb.getCompletedCount()
+                      << " utilisation=" << lb.getUtilisation()
+                      << " stolen_in=" << lb.getStolenInCount()
+                      << " stolen_out=" << lb.getStolenOutCount() << "\n";
+            total_requests_stolen += lb.getStolenInCount();
+        }
+    }
+    logStream() << "  Total requests stolen: " << total_requests_stolen << "\n";
+
+    // routing locality versus load balance
+    logStream() << "  Routing mode: "
+              << (routing_mode == RoutingMode::Affinity ? "affinity" : "least_queue") << "\n";
+    for (BalancerGroup& group : groups) {
+        reportAffinitySummary(group);
+    }
+
+    // response time (first arrival to completion, across attempts) per priority class
+    for (BalancerGroup& group : groups) {
+        reportLatencySummary(group);
+    }
+
+    // where multi-stage requests queue and which tier limits them
+    if (pipelines) {
+        reportPipelineSummary();
+    }
+}
+
+/**
+ * @brief Reports transit, queueing and utilisation per node and per depth,
+ * and names the leaf whose queue per unit of capacity is highest.
+ */
+void Switch::reportTopologySummary() {
+    struct TierTotals {
+        int nodes = 0;
+        double in_transit = 0.0;
+        double queued = 0.0;
+        double busy = 0.0;
+        double capacity = 0.0;
+    };
+    std::vector<TierTotals> tiers;
+    const Switch* hottest = nullptr;
+    double hottest_load = -1.0;
+
+    for (Switch* node : topology_nodes) {
+        double mean_in_transit = node->cycles_stepped > 0
+            ? static_cast<double>(node->in_transit_sum) / node->cycles_stepped : 0.0;
+        if (static_cast<int>(tiers.size()) <= node->depth) tiers.resize(node->depth + 1);
+        TierTotals& tier = tiers[node->depth];
+        tier.nodes++;
+        tier.in_transit += mean_in_transit;
+
+        logStream() << "  Node " << node->name << " tier=" << node->depth
+                  << " link_latency=" << node->link_latency
+                  << " received=" << node->received
+                  << " blocked=" << node->blocked_here
+                  << " mean_in_transit=" << mean_in_transit;
+        if (!node->children.empty()) {
+            logStream() << " forwarded=" << node->forwarded_down << "\n";
+            continue;
+        }
+
+        // a leaf: queueing relative to the capacity it owns
+        NodeStats stats = node->getNodeStats(true);
+        double queue_per_capacity = stats.capacity > 0.0 ? stats.mean_queue / stats.capacity : 0.0;
+        if (queue_per_capacity > hottest_load) {
+            hottest_load = queue_per_capacity;
+            hottest = node;
+        }
+        tier.queued += stats.mean_queue;
+        tier.busy += stats.busy;
+        tier.capacity += stats.capacity;
+
+        logStream() << " servers=" << stats.servers
+                  << " mean_queue=" << stats.mean_queue
+                  << " queue_per_capacity=" << queue_per_capacity
+                  << " utilisation=" << (stats.capacity > 0.0 ? stats.busy / stats.capacity : 0.0)
+                  << " completed=" << stats.completed
+                  << " p99=" << stats.p99 << "\n";
+    }
+
+    for (std::size_t d = 0; d < tiers.size(); d++) {
+        logStream() << "  Tier " << d << ": nodes=" << tiers[d].nodes
+                  << " mean_in_transit=" << tiers[d].in_transit
+                  << " mean_queued=" << tiers[d].queued
+                  << " utilisation="
+                  << (tiers[d].capacity > 0.0 ? tiers[d].busy / tiers[d].capacity : 0.0) << "\n";
+    }
+    if (hottest != nullptr) {
+        logStream() << "  Capacity pays off most at: " << hottest->name
+                  << " (queue per unit of capacity " << hottest_load << ")\n";
+    }
+
+    for (Switch* leaf : leaves) {
+        logStream() << "  Node " << leaf->name << ":\n";
+        leaf->reportGroups();
+    }
 }
@@ -5,39 +5,310 @@
  * The Switch sits above multiple LoadBalancer instances and is responsible for:
  * - Generating random requests
  * - Blocking requests from specified IP ranges
- * - Routing requests to the least-busy load balancer of the correct job type
+ * - Rate limiting each source IP with per-CIDR token buckets
+ * - Detecting flooding sources and blocking them temporarily
+ * - Routing requests to the least-loaded (queue per unit of capacity) load
+ *   balancer of their job class, or by source-IP affinity
  * - Advancing all load balancers through each clock cycle
+ * - Client timeouts, retries and hedged requests
+ * - Forwarding multi-stage requests between job classes with backpressure
+ * - Forwarding requests down a tree of child Switches (regions, sites),
+ *   each with its own routing policy, blocklist and link latency
+ * - Optionally stepping the leaves of that tree in separate processes,
+ *   fed through shared-memory rings
  * - Reporting status periodically
+ * - Checkpointing the whole simulation state and continuing from a checkpoint
+ * - Routing real localhost TCP connections instead of simulated requests
+ *   (live mode, see LiveProxy.h)
  */
 
 #pragma once
 #include "LoadBalancer.h"
 #include "IPAddress.h"
+#include "SwitchConfig.h"
+#include "MaglevTable.h"
+#include "HedgeTracker.h"
+#include "RateLimiter.h"
+#include "HeavyHitters.h"
+#include "ConfigReload.h"
+#include "WorkerPool.h"
+#include "ShmRing.h"
+#include "Metrics.h"
+#include "TimeSeries.h"
+#include "LiveSnapshot.h"
+#include "Checkpoint.h"
+#include <memory>
+#include <sstream>
+#include <utility>
 #include <vector>
+#include <deque>
+#include <unordered_map>
+#include <queue>
+#include <functional>
 #include <random>
+#include <sys/types.h>
+
+/**
+ * @struct DelayedRequest
+ * @brief A retry or hedge copy waiting to be sent at a later cycle.
+ */
+struct DelayedRequest {
+
+    /** @brief Cycle at which the request is sent. */
+    int send_cycle;
+
+    /** @brief Request to send. */
+    Request request;
+
+    /** @brief Balancer holding the original copy, avoided by a hedge (may be null). */
+    const LoadBalancer* avoid;
+
+    /** @brief Orders the pending queue by send cycle (earliest first). */
+    bool operator>(const DelayedRequest& other) const {
+        return send_cycle > other.send_cycle;
+    }
+};
+
+/**
+ * @struct BalancerGroup
+ * @brief The load balancers serving one job class, with per-class counters.
+ */
+struct BalancerGroup {
+
+    /** @brief Class name from the registry. */
+    std::string name;
+
+    /** @brief Balancers serving the class. */
+    std::vector<LoadBalancer> balancers;
+
+    /** @brief Maglev table over the balancers (affinity mode only). */
+    MaglevTable table;
+
+    /** @brief New requests generated for the class. */
+    long long generated = 0;
+
+    /** @brief New requests whose source was blocked. */
+    long long blocked = 0;
+
+    /** @brief Attempts dropped by the rate limiter. */
+    long long rate_limited = 0;
+
+    /** @brief Attempts queued at one of the balancers. */
+    long long admitted = 0;
+
+    /** @brief Attempts refused because the class has no balancer. */
+    long long unroutable = 0;
+
+    /** @brief Job class ids of the route followed by requests generated here. */
+    std::vector<int> route;
+
+    /**
+     * @brief Requests that finished an earlier stage and wait, in order,
+     * for a balancer of this class to admit them.
+     */
+    std::deque<Request> handoff;
+
+    /** @brief Requests forwarded into the class from an earlier stage. */
+    long long forwarded_in = 0;
+
+    /** @brief Sum of the handoff length over all cycles (request-cycles waited). */
+    long long handoff_wait_cycles = 0;
+
+    /** @brief New arrivals refused because this class's handoff was full. */
+    long long backpressure_refusals = 0;
+
+    /** @brief Exported copies of generated, blocked and rate_limited (null when off). */
+    MetricCounter* generated_metric = nullptr;
+    MetricCounter* blocked_metric = nullptr;
+    MetricCounter* rate_limited_metric = nullptr;
+};
+
+/**
+ * @struct NodeStats
+ * @brief Totals over one node's own balancers and clients.
+ *
+ * Plain data, so a leaf process can send it through a ShmRing.
+ */
+struct NodeStats {
+
+    /** @brief Requests in balancer queues and handoffs. */
+    long long queued = 0;
+
+    /** @brief Sum of balancer capacities. */
+    double capacity = 0.0;
+
+    /** @brief Capacity-weighted utilisation times capacity. */
+    double busy = 0.0;
+
+    /** @brief Sum of the balancers' average queue sizes. */
+    double mean_queue = 0.0;
+
+    /** @brief Servers over all classes. */
+    int servers = 0;
+
+    /** @brief Completed, rejected and expired requests. */
+    long long completed = 0;
+    long long rejected = 0;
+    long long expired = 0;
+
+    /** @brief Link arrivals the node did not admit. */
+    long long arrivals_refused = 0;
+
+    /** @brief Client timeouts, retries and hedges. */
+    long long timed_out = 0;
+    long long retries = 0;
+    long long hedges = 0;
+    long long hedge_wins = 0;
+    long long hedges_cancelled = 0;
+
+    /** @brief 99th percentile latency over all classes (only when asked for). */
+    int p99 = 0;
+};
+
+/**
+ * @struct PhaseTimes
+ * @brief Wall time of a run split by simulation phase (when phase_timing is set).
+ */
+struct PhaseTimes {
+
+    /** @brief Cycles run and requests generated. */
+    int cycles = 0;
+    long long requests = 0;
+
+    /** @brief Filling the balancers before the first cycle. */
+    long long preload_ns = 0;
+
+    /** @brief Creating arrivals. */
+    long long generation_ns = 0;
+
+    /**
+     * @brief Blocklist and rate limit checks, balancer choice, link
+     * transit, retries, hedges and stage forwarding.
+     */
+    long long routing_ns = 0;
+
+    /** @brief Stepping balancers: completions and assigning queued requests. */
+    long long assignment_ns = 0;
+
+    /**
+     * @brief Balancer scaling decisions and server changes. With worker
+     * threads this is CPU time summed over the threads.
+     */
+    long long scaling_ns = 0;
+};
+
+/**
+ * @struct RunProgress
+ * @brief Position and running totals of start(), saved with a checkpoint
+ * so a restored run ends with the same summary as an uninterrupted one.
+ */
+struct RunProgress {
+
+    /** @brief Last completed cycle (0 = not started). */
+    int cycle = 0;
+
+    /** @brief Requests generated and blocked so far. */
+    int generated = 0;
+    int blocked = 0;
+
+    /** @brief Queue size after preloading, and servers per class before it. */
+    std::size_t starting_queue_size = 0;
+    std::vector<int> starting_servers;
+
+    /** @brief Offered and admitted requests of the open goodput window. */
+    int window_offered = 0;
+    int window_admitted = 0;
+
+    /** @brief Completions at the start of the open goodput window. */
+    long long window_start_completed = 0;
+
+    /** @brief Leaf refusals of link arrivals at the start of the open window. */
+    long long window_start_refused = 0;
+};
+
+class Switch;
+
+/**
+ * @struct LeafProcess
+ * @brief A forked process stepping a contiguous block of topology leaves.
+ */
+struct LeafProcess {
+
+    /** @brief Process id (-1 until forked). */
+    pid_t pid = -1;
+
+    /** @brief Arrivals and cycle commands from the Switch process. */
+    ShmRing commands;
+
+    /** @brief Per-leaf stats, logs and reports back to the Switch process. */
+    ShmRing results;
+
+    /** @brief Leaves owned by the process, in depth-first order. */
+    std::vector<Switch*> leaves;
+
+    /**
+     * @brief Creates both rings.
+     *
+     * @param ring_bytes Capacity of each ring.
+     */
+    explicit LeafProcess(std::size_t ring_bytes) : commands(ring_bytes), results(ring_bytes) {}
+};
 
 /**
  * @class Switch
  * @brief Top-level router that distributes requests to multiple load balancers.
  *
- * The Switch owns separate pools of load balancers for each job type:
- * - Processing ('P')
- * - Streaming ('S')
+ * The Switch owns one group of load balancers per job class in the
+ * registry, indexed by the class id each request carries. With a topology
+ * configured, the Switch built from the file is the root of a tree: only
+ * leaves own balancers, and every other node forwards each request to one
+ * of its children over a link with a fixed latency.
  *
  * It generates requests, filters them using blocked IP ranges, and forwards
- * allowed requests to the least-busy load balancer within the appropriate pool.
+ * allowed requests to the least-busy load balancer within their class's group.
  */
 class Switch {
 private:
     /**
-     * @brief Load balancers responsible for processing ('P') jobs.
+     * @brief Node name ("root" for the Switch built from the config file).
+     */
+    std::string name;
+
+    /**
+     * @brief Distance from the root of the topology (0 = root).
+     */
+    int depth;
+
+    /**
+     * @brief Cycles a request spends on the link from the parent node.
+     */
+    int link_latency;
+
+    /**
+     * @brief Random engine for this node, so subtrees can step in parallel.
+     */
+    std::mt19937 generator;
+
+    /**
+     * @brief Balancer groups indexed by job class id.
+     */
+    std::vector<BalancerGroup> groups;
+
+    /**
+     * @brief Draws the job class of generated requests by configured share.
+     */
+    std::discrete_distribution<int> class_dist;
+
+    /**
+     * @brief Whether any class routes requests on to another class.
      */
-    std::vector<LoadBalancer> p_load_balancers;
+    bool pipelines;
 
     /**
-     * @brief Load balancers responsible for streaming ('S') jobs.
+     * @brief Handoff length at which new arrivals routed through a class
+     * are refused (0 = no limit).
      */
-    std::vector<LoadBalancer> s_load_balancers;
+    std::size_t handoff_limit;
 
     /**
      * @brief Minimum randomly-generated request processing time (clock cycles).
@@ -50,83 +321,779 @@ private:
     int max_request_time;
 
     /**
-     * @brief Ranges of source IP addresses that should be blocked.
+     * @brief Number of priority classes generated requests are drawn from.
+     */
+    int num_priority_classes;
+
+    /**
+     * @brief Whether admission control needs a random draw per arrival (RED).
+     */
+    bool random_admission;
+
+    /**
+     * @brief Upper bound of the uniform number of arrivals per cycle.
+     */
+    int max_requests_per_cycle;
+
+    /**
+     * @brief Number of rising-load windows for the goodput curve (0 = off).
+     */
+    int load_curve_steps;
+
+    /**
+     * @brief Load multiplier reached in the last goodput curve window.
+     */
+    double load_curve_peak;
+
+    /**
+     * @brief Output path of the goodput curve CSV.
+     */
+    std::string load_curve_file;
+
+    /**
+     * @brief Hot-reloadable settings, replaced by a ConfigWatcher thread.
+     */
+    RcuCell<PolicySnapshot> policy;
+
+    /**
+     * @brief Snapshot in use this cycle; only valid between applyPolicy()
+     * and releasePolicy(), which clears it.
      */
-    std::vector<IPRange> blocked_ranges;
+    const PolicySnapshot* active_policy;
 
+    /**
+     * @brief Version of the last applied snapshot. Changes are detected by
+     * version, since a freed snapshot's address may be reused by the next.
+     */
+    unsigned long long active_policy_version;
+
+    /** @brief Reloaded snapshots picked up by the simulation. */
+    long long policy_reloads;
+
+    /** @brief Sum of build plus propagation time of reloads, in microseconds. */
+    long long policy_reload_us;
+
+    /**
+     * @brief Per-source token buckets checked after the blocklist.
+     */
+    RateLimiter rate_limiter;
+
+    /**
+     * @brief Per-window request counts and top talkers by source IP.
+     */
+    HeavyHitterSketch heavy_hitters;
+
+    /**
+     * @brief Requests per cycle above which a source is auto-blocked (0 = off).
+     */
+    double heavy_hitter_threshold;
+
+    /**
+     * @brief Cycles per heavy-hitter counting window.
+     */
+    int heavy_hitter_window;
+
+    /**
+     * @brief Cycles an auto-blocked source stays blocked.
+     */
+    int heavy_hitter_block_ttl;
+
+    /**
+     * @brief Cycle at which the current counting window started.
+     */
+    int heavy_hitter_window_start;
+
+    /**
+     * @brief Automatically blocked source IPs and the last cycle they stay blocked.
+     */
+    std::unordered_map<unsigned int, int> dynamic_blocks;
+
+    /** @brief Number of times a source was auto-blocked. */
+    long long auto_blocks;
+
+    /**
+     * @brief Client IPs that send flood_fraction of all generated requests.
+     */
+    std::vector<IPAddress> flood_pool;
+
+    /**
+     * @brief Fraction of generated requests drawn from flood_pool.
+     */
+    double flood_fraction;
+
+    /**
+     * @brief Whether idle balancers steal queued work from same-class siblings.
+     */
+    bool work_stealing;
+
+    /**
+     * @brief Maximum requests moved per steal phase per class (0 = no limit).
+     */
+    std::size_t steal_batch;
+
+    /**
+     * @brief Balancer selection policy.
+     */
+    RoutingMode routing_mode;
+
+    /**
+     * @brief Fixed population of client IPs that generated requests come from.
+     * Empty means every request gets a fresh random source IP.
+     */
+    std::vector<IPAddress> client_pool;
+
+    /**
+     * @brief Cycles after arrival within which a request must start (0 = none).
+     */
+    int request_timeout;
+
+    /**
+     * @brief Maximum client retries after a timeout.
+     */
+    int max_retries;
+
+    /**
+     * @brief Cycles between a timeout and the client's retry.
+     */
+    int retry_backoff;
+
+    /**
+     * @brief Cycles before a hedge copy is sent (0 = hedging off).
+     */
+    int hedge_delay;
+
+    /**
+     * @brief Id given to the next generated request.
+     */
+    long long next_request_id;
+
+    /**
+     * @brief Decides which copy of a hedged request is served.
+     */
+    HedgeTracker hedge_tracker;
+
+    /**
+     * @brief Retries and hedge copies ordered by send cycle.
+     */
+    std::priority_queue<DelayedRequest, std::vector<DelayedRequest>,
+                        std::greater<DelayedRequest>> delayed_requests;
+
+    /**
+     * @brief Balancer chosen by the most recent successful routing decision.
+     */
+    LoadBalancer* last_routed_balancer;
+
+    /** @brief Retries sent after timeouts. */
+    long long retries_sent;
+
+    /** @brief Hedge copies that were queued at a second balancer. */
+    long long hedges_sent;
+
+    /** @brief Requests that timed out with no retries left. */
+    long long timed_out_requests;
+
+    /**
+     * @brief Child switches; a node with children owns no balancers.
+     */
+    std::vector<std::unique_ptr<Switch>> children;
+
+    /**
+     * @brief Maglev table over children (affinity mode only).
+     */
+    MaglevTable child_table;
+
+    /**
+     * @brief Requests on the link from the parent, with the cycle each is
+     * delivered, in delivery order.
+     */
+    std::deque<std::pair<int, Request>> inbox;
+
+    /**
+     * @brief Every node of the tree in depth-first order (root only).
+     */
+    std::vector<Switch*> topology_nodes;
+
+    /**
+     * @brief Nodes with children, parents before children (root only).
+     */
+    std::vector<Switch*> routers;
+
+    /**
+     * @brief Nodes that own balancers (root only).
+     */
+    std::vector<Switch*> leaves;
+
+    /**
+     * @brief Threads stepping leaves in parallel (root of a topology only).
+     */
+    std::unique_ptr<WorkerPool> workers;
+
+    /**
+     * @brief Log lines written while this leaf stepped on a worker thread.
+     */
+    std::ostringstream log_buffer;
+
+    /**
+     * @brief Requests queued in or heading into the subtree; refreshed every
+     * cycle and bumped on every forward so routing sees its own decisions.
+     */
+    double subtree_queue;
+
+    /**
+     * @brief Balancer capacity of the subtree, refreshed every cycle.
+     */
+    double subtree_capacity;
+
+    /** @brief Requests delivered to this node over its link. */
+    long long received;
+
+    /** @brief Requests dropped by this node's own blocklist. */
+    long long blocked_here;
+
+    /** @brief Link arrivals this leaf did not admit. */
+    long long arrivals_refused;
+
+    /** @brief Requests forwarded to a child. */
+    long long forwarded_down;
+
+    /** @brief Sum over cycles of the number of requests on the link. */
+    long long in_transit_sum;
+
+    /** @brief Cycles this node has been stepped. */
+    long long cycles_stepped;
+
+    /** @brief Requests queued per server before the first cycle. */
+    int preload_per_server;
+
+    /** @brief Whether start() times its phases (root only). */
+    bool phase_timing;
+
+    /** @brief Phase times so far; scaling is collected from the balancers. */
+    PhaseTimes phase_times;
+
+    /** @brief Cycles between status reports (0 = none). */
+    int status_interval;
+
+    /** @brief Last completed cycle, exported by the root (null when metrics are off). */
+    MetricGauge* cycle_metric;
+
+    /** @brief Time-series file and sampling (root only). */
+    TimeSeriesConfig timeseries_config;
+
+    /** @brief Time-series recorder, open while start() runs (root only). */
+    std::unique_ptr<TimeSeriesWriter> timeseries;
+
+    /** @brief Balancers of the tree in time-series column order, and their samples. */
+    std::vector<LoadBalancer*> series_balancers;
+    std::vector<BalancerSample> series_samples;
+
+    /** @brief Shared-memory segment of the live snapshot (empty = off, root only). */
+    std::string live_name;
+
+    /** @brief Cycles between live snapshots. */
+    int live_interval;
+
+    /** @brief Live snapshot writer, open while start() runs. */
+    std::unique_ptr<LiveSnapshot> live;
+
+    /** @brief Balancers of the tree in snapshot slot order. */
+    std::vector<LoadBalancer*> live_balancers;
+
+    /** @brief Scratch histogram for merging a balancer's classes. */
+    LatencyHistogram live_latency;
+
+    /** @brief Checkpoint written during start() (empty = off, root only). */
+    std::string checkpoint_file;
+
+    /** @brief Cycles between checkpoints (0 = only after the last cycle). */
+    int checkpoint_interval;
+
+    /** @brief Where start() continues from; cycle 0 unless a checkpoint was restored. */
+    RunProgress resume;
+
+    /**
+     * @brief Processes the leaves are split across (root only, 0 or 1 = none).
+     */
+    std::size_t leaf_process_count;
+
+    /**
+     * @brief Running leaf processes (root only, empty in single-process runs).
+     */
+    std::vector<std::unique_ptr<LeafProcess>> processes;
+
+    /**
+     * @brief Process that steps this leaf; null when the leaf is stepped
+     * here. A remote leaf keeps no balancers in this process.
+     */
+    LeafProcess* remote_process;
+
+    /** @brief Index of this leaf within its process. */
+    int remote_slot;
+
+    /** @brief Stats of a remote leaf as of the last cycle. */
+    NodeStats remote_stats;
+
+    /** @brief Balancer lines of a remote leaf's latest status report. */
+    std::string remote_status;
+
+    /** @brief Final group reports of a remote leaf. */
+    std::string remote_report;
+
+    /** @brief Final server count per class of a remote leaf. */
+    std::vector<int> remote_servers;
+
+    /**
+     * @brief Constructs one node of a topology.
+     *
+     * @param config Configuration of this node, already narrowed to its
+     *               routing policy and blocklist.
+     * @param name Node name.
+     * @param link_latency Cycles on the link from the parent.
+     * @param depth Distance from the root.
+     * @param seed Seed of the node's random engine.
+     */
+    Switch(const SwitchConfig& config, const std::string& name, int link_latency,
+           int depth, unsigned int seed);
+
+    /**
+     * @brief Creates a child Switch for every topology node whose parent is this node.
+     *
+     * Children keep the job class registry and client settings, but take
+     * their own routing policy and blocklist; rate limiting and flood
+     * detection stay at the root.
+     *
+     * @param config Configuration of this node.
+     */
+    void buildTopology(const SwitchConfig& config);
+
+    /**
+     * @brief Appends this node and its descendants in depth-first order.
+     *
+     * @param out Vector the nodes are appended to.
+     */
+    void collectNodes(std::vector<Switch*>& out);
+
+    /**
+     * @brief Puts a request on the link to the least-loaded child, or to the
+     * child its source maps to in affinity mode.
+     *
+     * @param request Request to forward.
+     * @param current_cycle Current simulation clock cycle.
+     * @return Always true; a link never refuses a request (the leaf that
+     * receives it counts a refusal in arrivals_refused).
+     */
+    bool forwardToChild(Request& request, int current_cycle);
+
+    /**
+     * @brief Takes every request due on the link and sends it on, to a
+     * child or to this node's balancers.
+     *
+     * @param current_cycle Current simulation clock cycle.
+     */
+    void deliverTransit(int current_cycle);
+
+    /**
+     * @brief Runs one cycle of a leaf: retries, deliveries, balancers,
+     * expiries and stage forwarding.
+     *
+     * @param current_cycle Current simulation clock cycle.
+     */
+    void stepLeaf(int current_cycle);
+
+    /**
+     * @brief Runs one cycle of the whole tree below the root.
+     *
+     * Routers deliver top-down on the calling thread; leaves then step in
+     * parallel (on worker threads or in leaf processes), each logging into
+     * its own buffer, and the buffers are flushed in depth-first order.
+     *
+     * @param current_cycle Current simulation clock cycle.
+     * @param status_due Whether a status report follows this cycle.
+     */
+    void stepTopology(int current_cycle, bool status_due);
+
+    /**
+     * @brief Forks the leaf processes and hands each a block of leaves.
+     *
+     * Each side frees the balancers of leaves the other side steps. If a
+     * ring or process cannot be created the run stays in one process.
+     */
+    void startLeafProcesses();
+
+    /**
+     * @brief Body of a leaf process: steps its leaves on every command
+     * until told to finish. Never returns.
+     *
+     * @param process Rings and leaves of this process.
+     * @param coordinator Process id of the Switch process.
+     */
+    [[noreturn]] void runLeafProcess(LeafProcess& process, pid_t coordinator);
+
+    /**
+     * @brief Sends due link arrivals and a step command to every leaf
+     * process, then waits for each leaf's stats and log (the cycle barrier).
+     *
+     * @param current_cycle Current simulation clock cycle.
+     * @param status_due Whether leaves also return status report lines.
+     */
+    void stepLeafProcesses(int current_cycle, bool status_due);
+
+    /**
+     * @brief Collects final reports from every leaf process and reaps it.
+     */
+    void stopLeafProcesses();
+
+    /**
+     * @brief Destroys this node's balancers, keeping the (empty) groups.
+     */
+    void releaseBalancers();
+
+    /**
+     * @brief Recomputes subtree_queue and subtree_capacity bottom-up.
+     */
+    void refreshSubtreeLoad();
+
+    /**
+     * @brief Copies the per-class counters of the subtree into their
+     * series, and the cycle at the root. Runs on the simulation thread
+     * between steps, so no worker is writing the counters.
+     *
+     * @param current_cycle Cycle that just completed.
+     */
+    void publishMetrics(int current_cycle);
+
+    /**
+     * @brief Lists every balancer stepped in this process, with its node.
+     *
+     * Balancers of leaves moved to other processes were released, so
+     * they are not listed.
+     *
+     * @param balancers Receives the balancers, in tree order.
+     * @param node_names Receives the node name of each.
+     */
+    void collectLocalBalancers(std::vector<LoadBalancer*>& balancers,
+                               std::vector<std::string>& node_names);
+
+    /**
+     * @brief Opens the time-series file over every local balancer.
+     */
+    void openTimeSeries();
+
+    /**
+     * @brief Creates the live snapshot segment over every local balancer.
+     *
+     * @param total_clock_cycles Length of the run, for progress.
+     */
+    void openLiveSnapshot(int total_clock_cycles);
+
+    /**
+     * @brief Stores every local balancer's state into the live snapshot.
+     *
+     * @param current_cycle Cycle that just completed.
+     * @param end_of_run Whether it is the final cycle.
+     */
+    void publishLiveSnapshot(int current_cycle, bool end_of_run);
+
+    /**
+     * @brief Writes the run's progress and every node's state to checkpoint_file.
+     *
+     * @param progress Position and totals of start() after the checkpointed cycle.
+     */
+    void writeCheckpoint(const RunProgress& progress);
+
+    /**
+     * @brief Appends this node's state, then each child's, to a checkpoint.
+     *
+     * Covers the random engine, counters, client pools, dynamic blocks,
+     * rate limiter, sketch, hedges, pending retries, link contents,
+     * handoffs and every balancer. Settings are not saved: they come from
+     * the configuration of the run that restores.
+     *
+     * @param out Checkpoint being written.
+     */
+    void saveState(CheckpointWriter& out) const;
+
+    /**
+     * @brief Reads back what saveState() wrote, failing @p in if the
+     * tree, classes or balancers differ from this configuration.
+     *
+     * @param in Checkpoint being read.
+     */
+    void restoreState(CheckpointReader& in);
+
+    /**
+     * @brief Samples the balancers if the recorder needs this cycle.
+     *
+     * @param current_cycle Cycle that just completed, or 0 to set the
+     * totals the first row counts from.
+     * @param end_of_run Whether it is the final cycle.
+     */
+    void recordTimeSeries(int current_cycle, bool end_of_run);
+
+    /**
+     * @brief Preloads every balancer in the subtree with 100 requests per server.
+     */
+    void preloadBalancers();
+
+    /**
+     * @brief Totals over this node's own balancers and clients (cached
+     * for a remote leaf).
+     *
+     * @param latency Whether to merge latency histograms for p99.
+     * @return Stats of this node, excluding children.
+     */
+    NodeStats getNodeStats(bool latency = false);
+
+    /**
+     * @brief Formats one status line per balancer and non-empty handoff.
+     */
+    std::string describeBalancers();
     /**
      * @brief Generates a random Request.
      *
-     * If @p jobOverride is provided as 'P' or 'S', the request's job type will be forced.
-     * Otherwise, the job type is chosen randomly.
+     * If @p classOverride is a valid class id, the request's job class will be forced.
+     * Otherwise, the class is drawn by the configured shares.
      *
-     * @param jobOverride Optional job type override ('P' or 'S'), or '\0' for random.
+     * @param classOverride Optional job class id, or -1 for random.
      * @return Newly generated Request instance.
      */
-    Request makeRandomRequest(char jobOverride = '\0');
+    Request makeRandomRequest(int classOverride = -1);
 
     /**
      * @brief Routes a request to the appropriate load balancer.
      *
-     * If the request is blocked (based on its source IP), it will be dropped.
-     * Otherwise, it is sent to the least-busy (smallest queue) load balancer
-     * in the pool corresponding to its job type.
+     * If the request is blocked (based on its source IP) or its source is
+     * over its rate limit, it will be dropped. Otherwise, it is sent to the load balancer with the smallest queue per
+     * unit of capacity in the group of its job class, or in
+     * affinity mode to the balancer its source IP maps to. The chosen
+     * balancer's admission control may still reject it.
      *
      * @param request Request to route.
+     * @param current_cycle Current simulation clock cycle.
+     * @param avoid Balancer that must not be chosen (used for hedge copies).
+     * @return True if the request was queued, false if blocked, rate
+     *         limited, rejected or no other balancer exists.
+     */
+    bool addRequestToBalancer(Request& request, int current_cycle,
+                              const LoadBalancer* avoid = nullptr);
+
+    /**
+     * @brief Offers a request to the best balancer of a group.
+     *
+     * Uses the Maglev table in affinity mode, otherwise the balancer with
+     * the smallest queue per unit of capacity.
+     *
+     * @param group Group of the request's current job class.
+     * @param request Request to queue.
+     * @param current_cycle Current simulation clock cycle.
+     * @param avoid Balancer that must not be chosen (may be null).
+     * @return True if a balancer admitted the request.
+     */
+    bool offerToGroup(BalancerGroup& group, Request& request, int current_cycle,
+                      const LoadBalancer* avoid);
+
+    /**
+     * @brief Moves requests that finished a stage to their next class.
+     *
+     * Forwarded requests join the next class's handoff, which is drained
+     * in order until a balancer rejects its head.
+     *
+     * @param current_cycle Current simulation clock cycle.
+     */
+    void forwardCompletedStages(int current_cycle);
+
+    /**
+     * @brief Picks up the current policy snapshot at a cycle boundary.
+     *
+     * Copies the generator limits out of a newly installed snapshot and
+     * logs how long the reload took to build and to become visible.
+     */
+    void applyPolicy();
+
+    /**
+     * @brief Drops the active snapshot and announces a quiescent state, so
+     * the writer may free it; applyPolicy() must run before the next use.
+     */
+    void releasePolicy();
+
+    /**
+     * @brief Logs how each include_blocklist file of a snapshot was imported.
+     *
+     * @param snapshot Snapshot whose imports are reported.
+     */
+    void reportBlocklistImports(const PolicySnapshot& snapshot);
+
+    /**
+     * @brief Counts a request in the heavy-hitter sketch and auto-blocks its
+     * source if it exceeds the flood threshold in the current window.
+     *
+     * @param source Source address of the request.
+     * @param current_cycle Current simulation clock cycle.
+     */
+    void trackSource(const IPAddress& source, int current_cycle);
+
+    /**
+     * @brief Sends one client attempt, setting its deadline and hedge.
+     *
+     * @param request Request to send; arrival_cycle is left untouched so
+     *                latency spans every attempt.
+     * @param current_cycle Current simulation clock cycle.
+     * @return True if the request was queued.
+     */
+    bool sendAttempt(Request& request, int current_cycle);
+
+    /**
+     * @brief Sends every retry and hedge copy that is due.
+     *
+     * Hedge copies are skipped if the original already started.
+     *
+     * @param current_cycle Current simulation clock cycle.
      */
-    void addRequestToBalancer(Request& request);
+    void releaseDelayedRequests(int current_cycle);
+
+    /**
+     * @brief Collects expired requests from all balancers and schedules retries.
+     *
+     * A hedged request only counts as timed out once both copies expired.
+     *
+     * @param current_cycle Current simulation clock cycle.
+     */
+    void handleExpiredRequests(int current_cycle);
 
     /**
      * @brief Advances all load balancers by one simulation clock cycle.
      *
-     * Calls goThroughClockCycle(current_cycle) on every load balancer in both pools.
+     * Calls goThroughClockCycle(current_cycle) on every load balancer in every group.
      *
      * @param current_cycle Current simulation clock cycle.
      */
     void goThroughClockCycleAllLoadBalancers(int current_cycle);
 
+    /**
+     * @brief Runs one work-stealing phase within a pool of same-class balancers.
+     *
+     * The balancer with the longest queue publishes the requests it cannot
+     * start this cycle; every sibling with spare slots steals up to its spare
+     * count from the tail of that queue; the remainder is reclaimed.
+     *
+     * @param balancers Pool of balancers sharing a job class.
+     * @param current_cycle Current simulation clock cycle.
+     */
+    void stealWork(std::vector<LoadBalancer>& balancers, int current_cycle);
+
     /**
      * @brief Determines whether a request should be blocked.
      *
-     * A request is blocked if its source IP falls within any configured blocked IP range.
+     * A request is blocked if its source IP is on the dynamic blocklist or
+     * falls within a range of the active policy's compiled blocklist.
      *
      * @param request Request to evaluate.
+     * @param current_cycle Current simulation clock cycle.
      * @return True if request should be blocked, false otherwise.
      */
-    bool isBlocked(Request& request);
+    bool isBlocked(Request& request, int current_cycle);
+
+    /**
+     * @brief Prints per-pool throughput, cache and imbalance statistics.
+     *
+     * @param group Job class group to summarise.
+     */
+    void reportAffinitySummary(BalancerGroup& group);
+
+    /**
+     * @brief Prints response-time percentiles per priority class for a pool.
+     *
+     * @param group Job class group to summarise.
+     */
+    void reportLatencySummary(BalancerGroup& group);
+
+    /**
+     * @brief Prints generated, dropped, queued and completed requests per job class.
+     */
+    void reportClassSummary();
+
+    /**
+     * @brief Prints per-tier utilisation, handoff and stage latency, the
+     * busiest tier and end-to-end latency per multi-stage route.
+     */
+    void reportPipelineSummary();
+
+    /**
+     * @brief Prints every report about this node's own balancer groups.
+     */
+    void reportGroups();
+
+    /**
+     * @brief Prints one line per node and per tier of the topology, the
+     * leaf where added capacity would help most, then each leaf's groups.
+     */
+    void reportTopologySummary();
+
+    /**
+     * @brief Sums a per-node value over this node and its descendants.
+     *
+     * @param value Returns the value of one node.
+     */
+    long long sumSubtree(const std::function<long long(Switch&)>& value);
 
     std::size_t getTotalQueueSize();
-    int getServerCountP();
-    int getServerCountS();
+    SpillStats getTotalSpillStats();
+    long long getTotalCompleted();
+    long long getTotalRejected();
+    long long getTotalExpired();
+    int getServerCount(int job_class);
+    long long getCompleted(BalancerGroup& group);
+
+    /** @brief Lets the microbenchmarks (MicroBench.cpp) time private hot paths. */
+    friend struct BenchAccess;
+
+    /** @brief Lets the live mode (LiveProxy.cpp) route connections through the groups and policies. */
+    friend class LiveProxy;
 
 public:
     /**
      * @brief Constructs the Switch and initializes all load balancers.
      *
-     * Creates:
-     * - @p num_p_balancers load balancers for 'P' jobs
-     * - @p num_s_balancers load balancers for 'S' jobs
+     * Creates one group of load balancers per job class returned by
+     * resolveJobClasses(), in class id order, or the tree of child
+     * Switches described by config.topology.
      *
-     * Each load balancer is initialized with the requested number of servers and
-     * a scaling cooldown period.
+     * Each load balancer is initialized with the requested number of servers,
+     * the configured server profile mix and a scaling cooldown period.
      *
-     * @param num_p_balancers Number of processing ('P') load balancers.
-     * @param num_s_balancers Number of streaming ('S') load balancers.
-     * @param servers_per_p_balancer Initial servers per processing load balancer.
-     * @param servers_per_s_balancer Initial servers per streaming load balancer.
-     * @param num_wait_clock_cycles Cooldown cycles between scaling actions.
-     * @param min_request_time Minimum request processing time (cycles).
-     * @param max_request_time Maximum request processing time (cycles).
-     * @param blocked_ranges Optional list of blocked IP ranges.
+     * @param config Loaded switch configuration.
+     */
+    explicit Switch(const SwitchConfig& config);
+
+    /**
+     * @brief Returns the cell a ConfigWatcher publishes reloaded policy into.
      */
-    Switch(int num_p_balancers,
-           int num_s_balancers,
-           int servers_per_p_balancer,
-           int servers_per_s_balancer,
-           int num_wait_clock_cycles,
-           int min_request_time,
-           int max_request_time,
-           const std::vector<IPRange>& blocked_ranges = {});
+    RcuCell<PolicySnapshot>& getPolicyCell();
+
+    /**
+     * @brief Registers per-class switch counters and every balancer's
+     * series for this node and its subtree; start() then updates them
+     * once per cycle.
+     *
+     * Balancers stepped in leaf processes (topology_processes > 1) are
+     * not exported, since their counters live in other processes.
+     *
+     * @param registry Registry that owns the series; must outlive start().
+     */
+    void registerMetrics(MetricsRegistry& registry);
+
+    /**
+     * @brief Replaces the state of the whole tree with a checkpoint, so
+     * start() continues after the checkpointed cycle instead of preloading.
+     *
+     * Must be called before start(). Not available with leaf processes.
+     *
+     * @param path Checkpoint written by a run with the same topology,
+     *             job classes, balancer counts and queue disciplines.
+     * @return False (after logging why) if the file could not be read or
+     *         does not match this configuration.
+     */
+    bool restoreCheckpoint(const std::string& path);
 
     /**
      * @brief Prints a status report showing queue sizes and server counts per load balancer.
@@ -139,14 +1106,27 @@ public:
      * @brief Starts the simulation for a given number of clock cycles.
      *
      * The start sequence:
-     * - Preloads each load balancer with 100 requests per server
+     * - Preloads each load balancer with preload_per_server requests per server,
+     *   unless the state was restored from a checkpoint
      * - Runs the simulation loop:
+     *   - Sends due retries and hedge copies
      *   - Generates a random number of new requests per cycle
      *   - Routes requests via addRequestToBalancer()
-     *   - Advances all load balancers
-     *   - Reports status every 50 cycles
+     *   - Advances all load balancers, or every node of the topology
+     *   - Schedules retries for requests that expired
+     *   - Forwards requests that finished a stage to the next class
+     *   - Records the time series, live snapshot and metrics, if enabled
+     *   - Reports status every status_interval cycles
+     *   - Writes a checkpoint every checkpoint_interval cycles and after
+     *     the last cycle, if enabled
      *
      * @param total_clock_cycles Total number of cycles to simulate.
      */
     void start(int total_clock_cycles);
+
+    /**
+     * @brief Returns the cycles, requests and time per phase of start();
+     * the times stay zero unless phase_timing is set.
+     */
+    PhaseTimes getPhaseTimes();
 };
\ No newline at end of file
@@ -22,6 +22,160 @@ std::string trim(const std::string& s) {
     return s.substr(a, b - a + 1);
 }
 
+/**
+ * @brief Parses a comma-separated server profile list.
+ *
+ * Each entry has the form SPEEDxSLOTS (e.g. "2x4" or "0.5x1").
+ * Malformed entries are skipped.
+ *
+ * @param s Input string.
+ * @return Parsed profiles in order.
+ */
+std::vector<ServerProfile> parseServerProfiles(const std::string& s) {
+    std::vector<ServerProfile> profiles;
+    std::stringstream list(s);
+    std::string entry;
+
+    while (std::getline(list, entry, ',')) {
+        entry = trim(entry);
+        size_t x_pos = entry.find('x');
+        if (x_pos == std::string::npos) continue;
+
+        try {
+            ServerProfile profile;
+            profile.speed = std::stod(entry.substr(0, x_pos));
+            profile.slots = std::stoi(entry.substr(x_pos + 1));
+            if (profile.speed > 0.0 && profile.slots > 0) {
+                profiles.push_back(profile);
+            }
+        } catch (...) {
+            // ignore malformed profile entries
+        }
+    }
+    return profiles;
+}
+
+/**
+ * @brief Parses the fields of a job_class line after the keyword.
+ *
+ * The name comes first, followed by optional key=value settings:
+ * balancers, servers, profiles, share and next. Unknown keys are ignored.
+ *
+ * @param s Input string.
+ * @param job_class Receives the parsed class.
+ * @return True if the name and every known setting are valid.
+ */
+bool parseJobClass(const std::string& s, JobClass& job_class) {
+    std::istringstream fields(s);
+    std::string field;
+
+    if (!(fields >> job_class.name) || job_class.name.find('=') != std::string::npos) {
+        return false;
+    }
+
+    try {
+        while (fields >> field) {
+            size_t eq = field.find('=');
+            if (eq == std::string::npos) return false;
+            std::string key = field.substr(0, eq);
+            std::string val = field.substr(eq + 1);
+
+            if (key == "balancers")
+                job_class.balancers = std::stoi(val);
+            else if (key == "servers")
+                job_class.servers_per_balancer = std::stoi(val);
+            else if (key == "profiles")
+                job_class.profiles = parseServerProfiles(val);
+            else if (key == "share")
+                job_class.share = std::stod(val);
+            else if (key == "next")
+                job_class.next = val;
+        }
+    } catch (...) {
+        return false;
+    }
+    return job_class.balancers > 0 && job_class.servers_per_balancer > 0 &&
+           job_class.share >= 0.0;
+}
+
+/**
+ * @brief Parses the fields of a topology_node line after the keyword.
+ *
+ * The name comes first, followed by optional key=value settings: parent,
+ * latency, routing, servers, block (LOW-HIGH, repeatable) and blocklist
+ * (file, repeatable). Unknown keys are ignored.
+ *
+ * @param s Input string.
+ * @param node Receives the parsed node.
+ * @return True if the name and every known setting are valid.
+ */
+bool parseTopologyNode(const std::string& s, TopologyNode& node) {
+    std::istringstream fields(s);
+    std::string field;
+
+    if (!(fields >> node.name) || node.name.find('=') != std::string::npos ||
+        node.name == "root") {
+        return false;
+    }
+
+    try {
+        while (fields >> field) {
+            size_t eq = field.find('=');
+            if (eq == std::string::npos) return false;
+            std::string key = field.substr(0, eq);
+            std::string val = field.substr(eq + 1);
+
+            if (key == "parent") {
+                node.parent = val;
+            } else if (key == "latency") {
+                node.link_latency = std::stoi(val);
+            } else if (key == "routing") {
+                if (val == "affinity")
+                    node.routing_mode = RoutingMode::Affinity;
+                else if (val == "least_queue")
+                    node.routing_mode = RoutingMode::LeastQueue;
+                else
+                    return false;
+                node.routing_set = true;
+            } else if (key == "servers") {
+                node.servers_per_balancer = std::stoi(val);
+            } else if (key == "block") {
+                size_t dash = val.find('-');
+                if (dash == std::string::npos) return false;
+                IPAddress low(val.substr(0, dash));
+                IPAddress high(val.substr(dash + 1));
+                node.blocked_ranges.emplace_back(low, high);
+            } else if (key == "blocklist") {
+                node.blocklist_files.push_back(val);
+            }
+        }
+    } catch (...) {
+        return false;
+    }
+    return node.link_latency >= 0 && node.servers_per_balancer >= 0 && node.parent != node.name;
+}
+
+/**
+ * @brief Builds the registry from job_class entries or the legacy P/S keys.
+ */
+std::vector<JobClass> resolveJobClasses(const SwitchConfig& config) {
+    if (!config.job_classes.empty()) return config.job_classes;
+
+    JobClass p;
+    p.name = "P";
+    p.balancers = config.num_p_balancers;
+    p.servers_per_balancer = config.servers_per_p_balancer;
+    p.profiles = config.p_server_profiles;
+
+    JobClass s;
+    s.name = "S";
+    s.balancers = config.num_s_balancers;
+    s.servers_per_balancer = config.servers_per_s_balancer;
+    s.profiles = config.s_server_profiles;
+
+    return {p, s};
+}
+
 /**
  * @brief Loads configuration values from a file.
  *
@@ -29,6 +183,13 @@ std::string trim(const std::string& s) {
  * - Key-value pairs in the format key=value
  * - IP block ranges in the format:
  *     block <low_ip> - <high_ip>
+ * - Rate limits in the format:
+ *     rate_limit <cidr> <tokens_per_cycle> <burst>
+ * - Job classes in the format:
+ *     job_class <name> [balancers=N] [servers=N] [profiles=SxN,...] [share=W] [next=NAME]
+ * - Topology nodes in the format:
+ *     topology_node <name> [parent=NAME] [latency=N] [routing=MODE] [servers=N]
+ *                   [block=LOW-HIGH] [blocklist=FILE]
  *
  * Ignores:
  * - Blank lines
@@ -76,12 +237,191 @@ SwitchConfig loadSwitchConfig(const std::string& path = "switch.config_file_valu
             continue;
         }
 
+        // handle rate limits (format: rate_limit 10.0.0.0/8 0.5 20)
+        if (line.find("rate_limit ") == 0) {
+            std::istringstream fields(line.substr(11));
+            std::string cidr;
+            double rate = 0.0, burst = 0.0;
+
+            if (fields >> cidr >> rate >> burst && rate >= 0.0 && burst >= 1.0) {
+                try {
+                    int prefix_length = 0;
+                    IPRange range = parseCidr(cidr, &prefix_length);
+                    config_file_values.rate_limits.push_back(
+                        RateLimitRule{range, prefix_length, rate, burst});
+                } catch (...) {
+                    // ignore malformed rate limits
+                }
+            }
+            continue;
+        }
+
+        // handle job classes (format: job_class video balancers=2 share=3)
+        if (line.find("job_class ") == 0) {
+            JobClass job_class;
+            if (parseJobClass(line.substr(10), job_class)) {
+                // a repeated name redefines the class in place
+                auto same_name = [&](const JobClass& c) { return c.name == job_class.name; };
+                auto it = std::find_if(config_file_values.job_classes.begin(),
+                                       config_file_values.job_classes.end(), same_name);
+                if (it != config_file_values.job_classes.end()) {
+                    *it = job_class;
+                } else {
+                    config_file_values.job_classes.push_back(job_class);
+                }
+            }
+            continue;
+        }
+
+        // handle topology nodes (format: topology_node eu parent=root latency=8)
+        if (line.find("topology_node ") == 0) {
+            TopologyNode node;
+            if (parseTopologyNode(line.substr(14), node)) {
+                // a repeated name redefines the node in place
+                auto same_name = [&](const TopologyNode& n) { return n.name == node.name; };
+                auto it = std::find_if(config_file_values.topology.begin(),
+                                       config_file_values.topology.end(), same_name);
+                if (it != config_file_values.topology.end()) {
+                    *it = node;
+                } else {
+                    config_file_values.topology.push_back(node);
+                }
+            }
+            continue;
+        }
+
         size_t eq = line.find('=');
         if (eq == std::string::npos) continue;
 
         std::string key = trim(line.substr(0, eq));
         std::string val = trim(line.substr(eq + 1));
 
+        // handle non-numeric values
+        if (key == "p_server_profiles") {
+            config_file_values.p_server_profiles = parseServerProfiles(val);
+            continue;
+        }
+        if (key == "s_server_profiles") {
+            config_file_values.s_server_profiles = parseServerProfiles(val);
+            continue;
+        }
+        if (key == "routing_mode") {
+            if (val == "affinity")
+                config_file_values.routing_mode = RoutingMode::Affinity;
+            else if (val == "least_queue")
+                config_file_values.routing_mode = RoutingMode::LeastQueue;
+            continue;
+        }
+        if (key == "queue_discipline") {
+            if (val == "fifo")
+                config_file_values.queue.discipline = QueueDiscipline::FIFO;
+            else if (val == "sjf")
+                config_file_values.queue.discipline = QueueDiscipline::SJF;
+            else if (val == "priority")
+                config_file_values.queue.discipline = QueueDiscipline::Priority;
+            else if (val == "wfq")
+                config_file_values.queue.discipline = QueueDiscipline::WFQ;
+            continue;
+        }
+        if (key == "wfq_weights") {
+            std::stringstream list(val);
+            std::string entry;
+            config_file_values.queue.wfq_weights.clear();
+            while (std::getline(list, entry, ',')) {
+                try {
+                    config_file_values.queue.wfq_weights.push_back(std::stod(trim(entry)));
+                } catch (...) {
+                    // ignore malformed weights
+                }
+            }
+            continue;
+        }
+        if (key == "admission_policy") {
+            if (val == "tail_drop")
+                config_file_values.admission.policy = AdmissionPolicy::TailDrop;
+            else if (val == "red")
+                config_file_values.admission.policy = AdmissionPolicy::RED;
+            else if (val == "codel")
+                config_file_values.admission.policy = AdmissionPolicy::CoDel;
+            continue;
+        }
+        if (key == "include_blocklist") {
+            if (!val.empty()) config_file_values.blocklist_files.push_back(val);
+            continue;
+        }
+        if (key == "load_curve_file") {
+            config_file_values.load_curve_file = val;
+            continue;
+        }
+        if (key == "live_snapshot") {
+            config_file_values.live_snapshot = val;
+            continue;
+        }
+        if (key == "queue_spill_dir") {
+            config_file_values.queue.spill_directory = val;
+            continue;
+        }
+        if (key == "checkpoint_file") {
+            config_file_values.checkpoint_file = val;
+            continue;
+        }
+        if (key == "restore_file") {
+            config_file_values.restore_file = val;
+            continue;
+        }
+        if (key == "timeseries_file") {
+            config_file_values.timeseries.file = val;
+            continue;
+        }
+        if (key == "timeseries_format") {
+            if (val == "csv")
+                config_file_values.timeseries.format = SeriesFormat::Csv;
+            else if (val == "columnar")
+                config_file_values.timeseries.format = SeriesFormat::Columnar;
+            continue;
+        }
+        if (key == "timeseries_downsample") {
+            if (val == "last")
+                config_file_values.timeseries.downsample = SeriesDownsample::Last;
+            else if (val == "mean")
+                config_file_values.timeseries.downsample = SeriesDownsample::Mean;
+            else if (val == "max")
+                config_file_values.timeseries.downsample = SeriesDownsample::Max;
+            continue;
+        }
+        if (key == "cache_hit_speedup" || key == "red_min_threshold" ||
+            key == "red_max_threshold" || key == "red_max_probability" ||
+            key == "red_weight" || key == "load_curve_peak" ||
+            key == "heavy_hitter_threshold" || key == "flood_fraction" ||
+            key == "live_scale_up_connections" || key == "live_scale_down_connections") {
+            try {
+                double d = std::stod(val);
+                if (key == "cache_hit_speedup")
+                    config_file_values.cache_hit_speedup = d;
+                else if (key == "red_min_threshold")
+                    config_file_values.admission.red_min_threshold = d;
+                else if (key == "red_max_threshold")
+                    config_file_values.admission.red_max_threshold = d;
+                else if (key == "red_max_probability")
+                    config_file_values.admission.red_max_probability = d;
+                else if (key == "red_weight")
+                    config_file_values.admission.red_weight = d;
+                else if (key == "load_curve_peak")
+                    config_file_values.load_curve_peak = d;
+                else if (key == "heavy_hitter_threshold")
+                    config_file_values.heavy_hitter_threshold = d;
+                else if (key == "flood_fraction")
+                    config_file_values.flood_fraction = d;
+                else if (key == "live_scale_up_connections")
+                    config_file_values.live_proxy.scale_up_connections = d > 0.0 ? d : 8.0;
+                else if (key == "live_scale_down_connections")
+                    config_file_values.live_proxy.scale_down_connections = d > 0.0 ? d : 0.0;
+            } catch (...) {
+                // ignore malformed numeric values
+            }
+            continue;
+        }
+
         try {
             int v = std::stoi(val);
 
@@ -101,6 +441,90 @@ SwitchConfig loadSwitchConfig(const std::string& path = "switch.config_file_valu
                 config_file_values.max_request_time = v;
             else if (key == "total_clock_cycles")
                 config_file_values.total_clock_cycles = v;
+            else if (key == "work_stealing")
+                config_file_values.work_stealing = (v != 0);
+            else if (key == "steal_batch")
+                config_file_values.steal_batch = v;
+            else if (key == "server_cache_entries")
+                config_file_values.server_cache_entries = v;
+            else if (key == "client_pool_size")
+                config_file_values.client_pool_size = v;
+            else if (key == "num_priority_classes")
+                config_file_values.queue.priority_classes = v;
+            else if (key == "wfq_buckets")
+                config_file_values.queue.wfq_buckets = v;
+            else if (key == "queue_memory_mb")
+                config_file_values.queue.memory_limit = v > 0 ? static_cast<std::size_t>(v) << 20 : 0;
+            else if (key == "queue_spill_block_kb")
+                config_file_values.queue.spill_block = v > 0 ? static_cast<std::size_t>(v) << 10 : 4 << 20;
+            else if (key == "max_queue_length")
+                config_file_values.admission.max_queue_length = v > 0 ? v : 0;
+            else if (key == "codel_target")
+                config_file_values.admission.codel_target = v;
+            else if (key == "codel_interval")
+                config_file_values.admission.codel_interval = v;
+            else if (key == "max_requests_per_cycle")
+                config_file_values.max_requests_per_cycle = v;
+            else if (key == "load_curve_steps")
+                config_file_values.load_curve_steps = v;
+            else if (key == "request_timeout")
+                config_file_values.request_timeout = v;
+            else if (key == "max_retries")
+                config_file_values.max_retries = v;
+            else if (key == "retry_backoff")
+                config_file_values.retry_backoff = v;
+            else if (key == "hedge_delay")
+                config_file_values.hedge_delay = v;
+            else if (key == "config_reload")
+                config_file_values.config_reload = (v != 0);
+            else if (key == "rate_limit_table_entries")
+                config_file_values.rate_limit_table_entries = v;
+            else if (key == "heavy_hitter_window")
+                config_file_values.heavy_hitter_window = v;
+            else if (key == "heavy_hitter_block_ttl")
+                config_file_values.heavy_hitter_block_ttl = v;
+            else if (key == "heavy_hitter_sketch_width")
+                config_file_values.heavy_hitter_sketch_width = v;
+            else if (key == "heavy_hitter_top_k")
+                config_file_values.heavy_hitter_top_k = v;
+            else if (key == "flood_sources")
+                config_file_values.flood_sources = v;
+            else if (key == "handoff_limit")
+                config_file_values.handoff_limit = v;
+            else if (key == "topology_threads")
+                config_file_values.topology_threads = v;
+            else if (key == "topology_processes")
+                config_file_values.topology_processes = v;
+            else if (key == "random_seed")
+                config_file_values.random_seed = v;
+            else if (key == "preload_per_server")
+                config_file_values.preload_per_server = v > 0 ? v : 0;
+            else if (key == "phase_timing")
+                config_file_values.phase_timing = (v != 0);
+            else if (key == "profile_counters")
+                config_file_values.profile_counters = (v != 0);
+            else if (key == "status_interval")
+                config_file_values.status_interval = v > 0 ? v : 0;
+            else if (key == "metrics_port")
+                config_file_values.metrics_port = (v > 0 && v < 65536) ? v : 0;
+            else if (key == "timeseries_stride")
+                config_file_values.timeseries.stride = v > 0 ? v : 1;
+            else if (key == "live_interval")
+                config_file_values.live_interval = v > 0 ? v : 1;
+            else if (key == "checkpoint_interval")
+                config_file_values.checkpoint_interval = v > 0 ? v : 0;
+            else if (key == "live_proxy_port")
+                config_file_values.live_proxy.port = (v > 0 && v < 65536) ? v : 0;
+            else if (key == "live_proxy_seconds")
+                config_file_values.live_proxy.seconds = v > 0 ? v : 0;
+            else if (key == "live_backend_delay_us")
+                config_file_values.live_proxy.backend_delay_us = v > 0 ? v : 0;
+            else if (key == "live_scale_cooldown_ms")
+                config_file_values.live_proxy.scale_cooldown_ms = v > 0 ? v : 0;
+            else if (key == "live_max_backends")
+                config_file_values.live_proxy.max_backends = v > 0 ? v : 1;
+            else if (key == "live_status_ms")
+                config_file_values.live_proxy.status_ms = v > 0 ? v : 0;
 
         } catch (...) {
             // ignore malformed numeric values
@@ -10,6 +10,16 @@
  * - Key-value pairs (key=value)
  * - IP block ranges using the format:
  *     block 1.1.1.1 - 100.1.1.1
+ * - Bulk blocklist files (repeatable):
+ *     include_blocklist=feeds/threats.txt
+ * - Per-source rate limits by CIDR using the format:
+ *     rate_limit 10.0.0.0/8 0.5 20   (tokens per cycle, burst)
+ * - Server profile mixes using the format:
+ *     p_server_profiles=1x1,2x4   (speed x slots, comma separated)
+ * - Job classes (repeatable, replaces the P/S keys when present):
+ *     job_class video balancers=2 servers=1 profiles=2x4 share=3 next=cdn
+ * - Topology nodes below the root switch (repeatable):
+ *     topology_node eu parent=root latency=8 routing=affinity block=1.0.0.0-1.255.255.255
  * - Comments beginning with '#'
  */
 
@@ -17,6 +27,92 @@
 #include <string>
 #include <vector>
 #include "IPAddress.h"
+#include "WebServer.h"
+#include "RequestQueue.h"
+#include "AdmissionControl.h"
+#include "RateLimiter.h"
+#include "TimeSeries.h"
+#include "LiveProxy.h"
+
+/**
+ * @enum RoutingMode
+ * @brief How the Switch and its LoadBalancers pick a destination.
+ */
+enum class RoutingMode {
+    /** @brief Least queue per unit of capacity; any free server. */
+    LeastQueue,
+    /** @brief Maglev hash of the source IP selects balancer and server. */
+    Affinity
+};
+
+/**
+ * @struct JobClass
+ * @brief One entry of the workload class registry.
+ *
+ * Each class gets its own group of load balancers; requests carry the
+ * class's position in the registry as a dense id.
+ */
+struct JobClass {
+
+    /** @brief Class name used in balancer labels and reports. */
+    std::string name;
+
+    /** @brief Number of load balancers serving the class. */
+    int balancers = 1;
+
+    /** @brief Initial servers per load balancer. */
+    int servers_per_balancer = 1;
+
+    /**
+     * @brief Server types mixed into each balancer of the class.
+     * Empty means every server is a baseline 1x1 server.
+     */
+    std::vector<ServerProfile> profiles;
+
+    /** @brief Relative share of generated requests. */
+    double share = 1.0;
+
+    /**
+     * @brief Class a request continues at after finishing this one
+     * (empty = last stage). Routes follow next links for up to
+     * Request::MAX_STAGES stages.
+     */
+    std::string next;
+};
+
+/**
+ * @struct TopologyNode
+ * @brief One Switch below the root of a multi-tier topology.
+ *
+ * Nodes without children own the job class balancer groups; every other
+ * node only forwards requests to one of its children.
+ */
+struct TopologyNode {
+
+    /** @brief Unique node name; "root" is the Switch built from the file. */
+    std::string name;
+
+    /** @brief Name of the parent node. */
+    std::string parent = "root";
+
+    /** @brief Cycles a request spends on the link from the parent. */
+    int link_latency = 0;
+
+    /** @brief Whether routing_mode overrides the parent's policy. */
+    bool routing_set = false;
+
+    /** @brief How the node picks a child, or a balancer and server at a leaf. */
+    RoutingMode routing_mode = RoutingMode::LeastQueue;
+
+    /** @brief Servers per balancer for every class at a leaf (0 = inherit). */
+    int servers_per_balancer = 0;
+
+    /** @brief Source ranges dropped at this node. */
+    std::vector<IPRange> blocked_ranges;
+
+    /** @brief Blocklist files whose ranges are dropped at this node. */
+    std::vector<std::string> blocklist_files;
+};
 
 /**
  * @struct SwitchConfig
@@ -24,7 +120,7 @@
  *
  * Contains:
  * - Load balancer counts
- * - Server counts
+ * - Server counts and server profile mixes
  * - Scaling parameters
  * - Request timing limits
  * - Total simulation length
@@ -47,6 +143,104 @@ struct SwitchConfig {
     /** @brief Initial servers per streaming load balancer. */
     int servers_per_s_balancer = 1;
 
+    /**
+     * @brief Server types mixed into each processing load balancer.
+     * Empty means every server is a baseline 1x1 server.
+     */
+    std::vector<ServerProfile> p_server_profiles;
+
+    /** @brief Server types mixed into each streaming load balancer. */
+    std::vector<ServerProfile> s_server_profiles;
+
+    /**
+     * @brief Workload classes from job_class lines, in declaration order.
+     * Empty means the P/S keys above define the two classes.
+     */
+    std::vector<JobClass> job_classes;
+
+    /**
+     * @brief Requests that may wait to enter a class after finishing an
+     * earlier stage before new arrivals routed through it are refused
+     * (0 = no limit).
+     */
+    int handoff_limit = 0;
+
+    /**
+     * @brief Switches below the root, from topology_node lines.
+     * Empty means the root owns the balancers directly.
+     */
+    std::vector<TopologyNode> topology;
+
+    /**
+     * @brief Threads stepping topology leaves in parallel
+     * (0 = one per hardware thread, 1 = serial).
+     */
+    int topology_threads = 0;
+
+    /**
+     * @brief Processes the topology leaves are split across, connected to
+     * the Switch process by shared-memory rings (0 or 1 = single process).
+     */
+    int topology_processes = 0;
+
+    /** @brief Whether idle balancers steal work from same-class siblings (0/1). */
+    bool work_stealing = false;
+
+    /** @brief Maximum requests stolen per class per cycle (0 = no limit). */
+    int steal_batch = 0;
+
+    /** @brief Balancer and server selection policy. */
+    RoutingMode routing_mode = RoutingMode::LeastQueue;
+
+    /** @brief Client cache entries per server (0 disables the cache model). */
+    int server_cache_entries = 0;
+
+    /** @brief Processing time divisor for requests whose client is cached. */
+    double cache_hit_speedup = 1.0;
+
+    /** @brief Number of distinct clients generating requests (0 = all random). */
+    int client_pool_size = 0;
+
+    /**
+     * @brief Request queue scheduling for every load balancer.
+     * queue.priority_classes also sets how many classes requests are drawn from.
+     */
+    QueueConfig queue;
+
+    /** @brief Queue capacity limit and admission policy for every load balancer. */
+    AdmissionConfig admission;
+
+    /** @brief Upper bound of the uniform number of arrivals per cycle. */
+    int max_requests_per_cycle = 5;
+
+    /**
+     * @brief Number of load steps for the goodput curve (0 = constant load).
+     * The run is split into this many equal windows with linearly rising load.
+     */
+    int load_curve_steps = 0;
+
+    /** @brief Load multiplier reached in the final step of the curve. */
+    double load_curve_peak = 2.0;
+
+    /** @brief CSV file receiving one goodput-versus-offered-load row per step. */
+    std::string load_curve_file = "goodput_curve.csv";
+
+    /**
+     * @brief Cycles after arrival within which a request must start (0 = no deadline).
+     */
+    int request_timeout = 0;
+
+    /** @brief Times a client resends a request that timed out. */
+    int max_retries = 0;
+
+    /** @brief Cycles a client waits after a timeout before retrying. */
+    int retry_backoff = 0;
+
+    /**
+     * @brief Cycles after which a duplicate is sent to a second balancer (0 = off).
+     */
+    int hedge_delay = 0;
+
     /** @brief Cooldown cycles between scaling operations. */
     int num_wait_clock_cycles = 3;
 
@@ -59,8 +253,86 @@ struct SwitchConfig {
     /** @brief Total simulation clock cycles to run. */
     int total_clock_cycles = 2000;
 
+    /** @brief Seed of the Switch's random engine (0 = seeded from the OS). */
+    int random_seed = 0;
+
+    /** @brief Requests queued per server of each balancer before the first cycle. */
+    int preload_per_server = 100;
+
+    /** @brief Measure wall time per simulation phase and report it (0/1). */
+    bool phase_timing = false;
+
+    /** @brief Read hardware counters in each profiled phase (PROFILE=1 builds, 0/1). */
+    bool profile_counters = false;
+
     /** @brief List of IP address ranges that should be blocked. */
     std::vector<IPRange> blocked_ranges;
+
+    /** @brief Blocklist files whose ranges are added to blocked_ranges' lookup. */
+    std::vector<std::string> blocklist_files;
+
+    /** @brief Per-CIDR token-bucket limits applied to each source IP. */
+    std::vector<RateLimitRule> rate_limits;
+
+    /**
+     * @brief Reload the blocklist and request generator limits when the
+     * config file changes or on SIGHUP (0/1).
+     */
+    bool config_reload = false;
+
+    /** @brief Cycles between status reports on the console and in the log (0 = none). */
+    int status_interval = 50;
+
+    /** @brief Localhost port serving Prometheus metrics at /metrics (0 = off). */
+    int metrics_port = 0;
+
+    /** @brief Per-cycle balancer time series (off unless a file is set). */
+    TimeSeriesConfig timeseries;
+
+    /** @brief POSIX shared-memory name of the live snapshot (empty = off). */
+    std::string live_snapshot;
+
+    /** @brief Cycles between live snapshots. */
+    int live_interval = 10;
+
+    /** @brief Path the run's state is checkpointed to (empty = off). */
+    std::string checkpoint_file;
+
+    /** @brief Cycles between checkpoints (0 = only after the last cycle). */
+    int checkpoint_interval = 0;
+
+    /** @brief Checkpoint the run continues from instead of preloading (empty = off). */
+    std::string restore_file;
+
+    /** @brief Live TCP proxy mode (off unless live_proxy_port is set). */
+    LiveProxyConfig live_proxy;
+
+    /** @brief Maximum sources tracked by the rate limiter at once. */
+    int rate_limit_table_entries = 65536;
+
+    /**
+     * @brief Requests per cycle above which a source is blocked automatically
+     * (0 disables heavy-hitter detection).
+     */
+    double heavy_hitter_threshold = 0.0;
+
+    /** @brief Cycles per counting window of the heavy-hitter sketch. */
+    int heavy_hitter_window = 100;
+
+    /** @brief Cycles an automatically blocked source stays blocked. */
+    int heavy_hitter_block_ttl = 500;
+
+    /** @brief Counters per row of the Count-Min sketch. */
+    int heavy_hitter_sketch_width = 2048;
+
+    /** @brief Number of top talkers tracked and reported. */
+    int heavy_hitter_top_k = 16;
+
+    /** @brief Number of flooding client IPs mixed into generated traffic (0 = none). */
+    int flood_sources = 0;
+
+    /** @brief Fraction of generated requests sent by the flooding clients. */
+    double flood_fraction = 0.0;
 };
 
 /**
@@ -78,4 +350,15 @@ struct SwitchConfig {
  * @param path Path to configuration file.
  * @return Populated SwitchConfig structure.
  */
-SwitchConfig loadSwitchConfig(const std::string& path);
\ No newline at end of file
+SwitchConfig loadSwitchConfig(const std::string& path);
+
+/**
+ * @brief Returns the job class registry of a configuration.
+ *
+ * Uses the job_class entries if any were given, otherwise builds the
+ * processing ('P') and streaming ('S') classes from the legacy keys.
+ *
+ * @param config Loaded switch configuration.
+ * @return Classes in id order.
+ */
+std::vector<JobClass> resolveJobClasses(const SwitchConfig& config);
\ No newline at end of file
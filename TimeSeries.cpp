@@ -0,0 +1,300 @@
+/**
+ * @file TimeSeries.cpp
+ * @brief Implementation of the time-series recorder and its writer thread.
+ */
+
+#include "TimeSeries.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+
+/** @brief Values a block holds across all columns (about 1 MB of floats). */
+static const std::size_t BLOCK_VALUES = 1 << 18;
+
+/** @brief Version written after the magic of columnar files. */
+static const std::uint32_t COLUMNAR_VERSION = 1;
+
+/** @brief Field names, in column order within each balancer. */
+static const char* const FIELD_NAMES[] = {
+    "queue", "servers", "arrivals", "completions", "scale_ups", "scale_downs"};
+
+/**
+ * @brief Appends a little-endian u32.
+ */
+static void appendU32(std::string& buffer, std::uint32_t value) {
+    for (int b = 0; b < 4; b++) buffer += static_cast<char>((value >> (8 * b)) & 0xFF);
+}
+
+/**
+ * @brief Appends a length-prefixed string.
+ */
+static void appendText(std::string& buffer, const std::string& text) {
+    appendU32(buffer, static_cast<std::uint32_t>(text.size()));
+    buffer += text;
+}
+
+/**
+ * @brief Constructor implementation.
+ */
+TimeSeriesWriter::TimeSeriesWriter(const TimeSeriesConfig& config, const std::vector<std::string>& nodes,
+                                   const std::vector<std::string>& labels)
+ : config(config),
+   nodes(nodes),
+   labels(labels),
+   out(config.file, std::ios::binary | std::ios::trunc),
+   block_rows(std::max<std::size_t>(BLOCK_VALUES / std::max<std::size_t>(labels.size() * FIELDS, 1), 1)),
+   window_gauges(labels.size() * 2, 0.0),
+   window_counts(labels.size() * 4, 0),
+   window_samples(0),
+   last_row_cycle(0),
+   closing(false),
+   recording(false),
+   rows_written(0),
+   bytes_written(0) {
+
+    this->config.stride = std::max(config.stride, 1);
+    if (!out) return;
+    writeHeader();
+    filling = takeBlock();
+    worker = std::thread(&TimeSeriesWriter::run, this);
+    recording = true;
+}
+
+/**
+ * @brief Destructor implementation.
+ */
+TimeSeriesWriter::~TimeSeriesWriter() {
+    close();
+}
+
+/**
+ * @brief Returns whether the file is open.
+ */
+bool TimeSeriesWriter::isOpen() const {
+    return recording;
+}
+
+/**
+ * @brief Header of the chosen format.
+ */
+void TimeSeriesWriter::writeHeader() {
+    std::string header;
+    if (config.format == SeriesFormat::Csv) {
+        header = "cycle,node,balancer";
+        for (const char* field : FIELD_NAMES) header += std::string(",") + field;
+        header += "\n";
+    } else {
+        header = "LBTS";
+        appendU32(header, COLUMNAR_VERSION);
+        appendU32(header, static_cast<std::uint32_t>(labels.size()));
+        appendU32(header, FIELDS);
+        appendU32(header, static_cast<std::uint32_t>(config.stride));
+        appendU32(header, static_cast<std::uint32_t>(config.downsample));
+        for (const char* field : FIELD_NAMES) appendText(header, field);
+        for (std::size_t b = 0; b < labels.size(); b++) {
+            appendText(header, nodes[b]);
+            appendText(header, labels[b]);
+        }
+    }
+    out.write(header.data(), static_cast<std::streamsize>(header.size()));
+    bytes_written += static_cast<long long>(header.size());
+}
+
+/**
+ * @brief Pops a spare block or allocates one.
+ */
+std::unique_ptr<TimeSeriesWriter::Block> TimeSeriesWriter::takeBlock() {
+    std::unique_ptr<Block> block;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!spare.empty()) {
+            block = std::move(spare.back());
+            spare.pop_back();
+        }
+    }
+    if (!block) {
+        block = std::make_unique<Block>();
+        block->cycles.resize(block_rows);
+        block->values.resize(block_rows * labels.size() * FIELDS);
+    }
+    block->rows = 0;
+    return block;
+}
+
+/**
+ * @brief Queues the block, waiting while the writer is MAX_PENDING_BLOCKS behind.
+ */
+void TimeSeriesWriter::submit() {
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        written.wait(lock, [this]() { return pending.size() < MAX_PENDING_BLOCKS; });
+        pending.push_back(std::move(filling));
+    }
+    wake.notify_one();
+    filling = takeBlock();
+}
+
+/**
+ * @brief Only the end of a window needs a sample when the last value is kept.
+ */
+bool TimeSeriesWriter::wantsSample(int cycle, bool end_of_run) const {
+    if (!recording) return false;
+    return config.downsample != SeriesDownsample::Last ||
+           end_of_run || cycle - last_row_cycle >= config.stride;
+}
+
+/**
+ * @brief Copies the running totals into the window start.
+ */
+void TimeSeriesWriter::setBaseline(const std::vector<BalancerSample>& samples) {
+    for (std::size_t b = 0; b < samples.size() && b < labels.size(); b++) {
+        window_counts[b * 4] = samples[b].arrivals;
+        window_counts[b * 4 + 1] = samples[b].completed;
+        window_counts[b * 4 + 2] = samples[b].scale_ups;
+        window_counts[b * 4 + 3] = samples[b].scale_downs;
+    }
+}
+
+/**
+ * @brief Folds the gauges into the window and emits a row when it ends.
+ */
+void TimeSeriesWriter::record(int cycle, const std::vector<BalancerSample>& samples, bool end_of_run) {
+    if (!wantsSample(cycle, end_of_run)) return;
+
+    bool first = (window_samples == 0);
+    for (std::size_t b = 0; b < samples.size(); b++) {
+        double* gauges = &window_gauges[b * 2];
+        if (config.downsample == SeriesDownsample::Mean) {
+            gauges[0] += samples[b].queue;
+            gauges[1] += samples[b].servers;
+        } else if (config.downsample == SeriesDownsample::Max && !first) {
+            gauges[0] = std::max(gauges[0], samples[b].queue);
+            gauges[1] = std::max(gauges[1], samples[b].servers);
+        } else {
+            gauges[0] = samples[b].queue;
+            gauges[1] = samples[b].servers;
+        }
+    }
+    window_samples++;
+
+    if (end_of_run || cycle - last_row_cycle >= config.stride) emitRow(cycle, samples);
+}
+
+/**
+ * @brief Writes column values for one row; counts are differences from
+ * the start of the window.
+ */
+void TimeSeriesWriter::emitRow(int cycle, const std::vector<BalancerSample>& samples) {
+    Block& block = *filling;
+    std::size_t row = block.rows;
+    block.cycles[row] = cycle;
+
+    double divisor = config.downsample == SeriesDownsample::Mean ? window_samples : 1.0;
+    for (std::size_t b = 0; b < samples.size(); b++) {
+        long long totals[4] = {samples[b].arrivals, samples[b].completed,
+                               samples[b].scale_ups, samples[b].scale_downs};
+        float* column = &block.values[b * FIELDS * block_rows];
+        column[row] = static_cast<float>(window_gauges[b * 2] / divisor);
+        column[block_rows + row] = static_cast<float>(window_gauges[b * 2 + 1] / divisor);
+        for (int c = 0; c < 4; c++) {
+            long long& start = window_counts[b * 4 + c];
+            column[(2 + c) * block_rows + row] = static_cast<float>(totals[c] - start);
+            start = totals[c];
+        }
+        window_gauges[b * 2] = 0.0;
+        window_gauges[b * 2 + 1] = 0.0;
+    }
+    window_samples = 0;
+    last_row_cycle = cycle;
+
+    block.rows++;
+    if (block.rows == block_rows) submit();
+}
+
+/**
+ * @brief CSV rows are formatted here, off the simulation thread.
+ */
+void TimeSeriesWriter::writeBlock(const Block& block) {
+    std::string buffer;
+    if (config.format == SeriesFormat::Csv) {
+        char line[64];
+        for (std::size_t row = 0; row < block.rows; row++) {
+            std::string cycle = std::to_string(block.cycles[row]);
+            for (std::size_t b = 0; b < labels.size(); b++) {
+                buffer += cycle;
+                buffer += ",";
+                buffer += nodes[b];
+                buffer += ",";
+                buffer += labels[b];
+                const float* column = &block.values[b * FIELDS * block_rows];
+                for (int f = 0; f < FIELDS; f++) {
+                    std::snprintf(line, sizeof(line), ",%.9g", column[f * block_rows + row]);
+                    buffer += line;
+                }
+                buffer += "\n";
+            }
+        }
+    } else {
+        appendU32(buffer, static_cast<std::uint32_t>(block.rows));
+        buffer.append(reinterpret_cast<const char*>(block.cycles.data()), block.rows * sizeof(int));
+        for (std::size_t column = 0; column < labels.size() * FIELDS; column++) {
+            buffer.append(reinterpret_cast<const char*>(&block.values[column * block_rows]),
+                          block.rows * sizeof(float));
+        }
+    }
+    out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    bytes_written += static_cast<long long>(buffer.size());
+    rows_written += static_cast<long long>(block.rows);
+}
+
+/**
+ * @brief Writes blocks as they arrive and returns them to the spare list.
+ */
+void TimeSeriesWriter::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wake.wait(lock, [this]() { return closing || !pending.empty(); });
+        if (pending.empty()) break;
+
+        std::unique_ptr<Block> block = std::move(pending.front());
+        pending.pop_front();
+        lock.unlock();
+        writeBlock(*block);
+        lock.lock();
+
+        spare.push_back(std::move(block));
+        written.notify_one();
+    }
+    out.flush();
+}
+
+/**
+ * @brief Submits the partly filled block and waits for the thread.
+ */
+void TimeSeriesWriter::close() {
+    if (!worker.joinable()) return;
+
+    recording = false;
+    if (filling->rows > 0) submit();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        closing = true;
+    }
+    wake.notify_one();
+    worker.join();
+    out.close();
+}
+
+/**
+ * @brief Returns rows written.
+ */
+long long TimeSeriesWriter::getRowCount() const {
+    return rows_written;
+}
+
+/**
+ * @brief Returns bytes written.
+ */
+long long TimeSeriesWriter::getByteCount() const {
+    return bytes_written;
+}
\ No newline at end of file
@@ -0,0 +1,269 @@
+/**
+ * @file TimeSeries.h
+ * @brief Defines the per-cycle time-series recorder of balancer state.
+ *
+ * For every balancer the recorder keeps one row per stride cycles:
+ * - queue length and server count, as the value at the end of the
+ *   window or its mean or maximum over the window (downsampling)
+ * - arrivals, completions, scale-ups and scale-downs in the window
+ *
+ * The simulation thread only copies numbers into a column block. Full
+ * blocks go to a background thread, which formats them and writes the
+ * file. That thread can fall behind by MAX_PENDING_BLOCKS blocks;
+ * after that, the simulation waits for it rather than drop rows.
+ *
+ * Two file formats are supported:
+ * - CSV, one line per balancer and row:
+ *   cycle,node,balancer,queue,servers,arrivals,completions,scale_ups,scale_downs
+ * - columnar, little-endian binary:
+ *   - header: "LBTS", u32 version, u32 balancers, u32 fields, u32 stride,
+ *     u32 downsample, then the field names and each balancer's node and
+ *     label as u32 length + bytes
+ *   - then blocks: u32 rows, i32 cycle[rows], then per balancer and
+ *     field f32 value[rows]
+ */
+
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @enum SeriesFormat
+ * @brief File layout of the time series.
+ */
+enum class SeriesFormat {
+    /** @brief Text, one line per balancer and row. */
+    Csv,
+    /** @brief Binary blocks stored column by column. */
+    Columnar
+};
+
+/**
+ * @enum SeriesDownsample
+ * @brief How queue length and server count are reduced over a stride window.
+ */
+enum class SeriesDownsample {
+    /** @brief Value at the last cycle of the window. */
+    Last,
+    /** @brief Mean over the window's cycles. */
+    Mean,
+    /** @brief Maximum over the window's cycles. */
+    Max
+};
+
+/**
+ * @struct TimeSeriesConfig
+ * @brief Output file and sampling of the time series.
+ */
+struct TimeSeriesConfig {
+
+    /** @brief Output path; empty disables recording. */
+    std::string file;
+
+    /** @brief File layout. */
+    SeriesFormat format = SeriesFormat::Csv;
+
+    /** @brief Cycles per row. */
+    int stride = 1;
+
+    /** @brief Reduction of the gauges over a window. */
+    SeriesDownsample downsample = SeriesDownsample::Last;
+};
+
+/**
+ * @struct BalancerSample
+ * @brief One balancer's state at the end of a cycle; counts are totals
+ * since the start of the run.
+ */
+struct BalancerSample {
+    double queue = 0.0;
+    double servers = 0.0;
+    long long arrivals = 0;
+    long long completed = 0;
+    long long scale_ups = 0;
+    long long scale_downs = 0;
+};
+
+/**
+ * @class TimeSeriesWriter
+ * @brief Reduces per-cycle samples to rows and writes them on a
+ * background thread.
+ */
+class TimeSeriesWriter {
+private:
+
+    /** @brief Values per balancer and row. */
+    static const int FIELDS = 6;
+
+    /**
+     * @struct Block
+     * @brief Rows waiting to be written, stored column by column.
+     */
+    struct Block {
+        std::size_t rows = 0;
+        std::vector<int> cycles;
+        std::vector<float> values;
+    };
+
+    /** @brief Sampling settings. */
+    TimeSeriesConfig config;
+
+    /** @brief Node and label of each balancer, in sample order. */
+    std::vector<std::string> nodes;
+    std::vector<std::string> labels;
+
+    /** @brief Output file. */
+    std::ofstream out;
+
+    /** @brief Rows per block, chosen so a block holds about a megabyte. */
+    std::size_t block_rows;
+
+    /** @brief Per balancer, queue length and server count reduced so far. */
+    std::vector<double> window_gauges;
+
+    /** @brief Per balancer, the four counts at the start of the window. */
+    std::vector<long long> window_counts;
+
+    /** @brief Samples taken in the current window. */
+    int window_samples;
+
+    /** @brief Cycle of the last row (0 before the first). */
+    int last_row_cycle;
+
+    /** @brief Block being filled by the simulation thread. */
+    std::unique_ptr<Block> filling;
+
+    /** @brief Guards pending, spare and closing. */
+    std::mutex mutex;
+
+    /** @brief Signals the writer thread, and the simulation when a block is written. */
+    std::condition_variable wake;
+    std::condition_variable written;
+
+    /** @brief Full blocks in order, oldest first. */
+    std::deque<std::unique_ptr<Block>> pending;
+
+    /** @brief Written blocks kept for reuse. */
+    std::vector<std::unique_ptr<Block>> spare;
+
+    /** @brief Set once no more blocks will be submitted. */
+    bool closing;
+
+    /** @brief Whether rows are accepted (simulation thread only). */
+    bool recording;
+
+    /** @brief Rows and bytes written so far (writer thread, read after close). */
+    long long rows_written;
+    long long bytes_written;
+
+    /** @brief Background thread. */
+    std::thread worker;
+
+    /**
+     * @brief Writes the columnar header or the CSV column names.
+     */
+    void writeHeader();
+
+    /**
+     * @brief Writes pending blocks until closed and drained.
+     */
+    void run();
+
+    /**
+     * @brief Formats and writes one block.
+     */
+    void writeBlock(const Block& block);
+
+    /**
+     * @brief Returns an empty block, reusing a written one if possible.
+     */
+    std::unique_ptr<Block> takeBlock();
+
+    /**
+     * @brief Hands the filled block to the writer thread.
+     */
+    void submit();
+
+    /**
+     * @brief Appends one row for every balancer and starts a new window.
+     */
+    void emitRow(int cycle, const std::vector<BalancerSample>& samples);
+
+public:
+
+    /** @brief Blocks the writer may lag behind before the simulation waits. */
+    static const std::size_t MAX_PENDING_BLOCKS = 4;
+
+    /**
+     * @brief Opens the file, writes its header and starts the thread.
+     *
+     * @param config File and sampling settings.
+     * @param nodes Switch node of each balancer.
+     * @param labels Label of each balancer.
+     */
+    TimeSeriesWriter(const TimeSeriesConfig& config, const std::vector<std::string>& nodes,
+                     const std::vector<std::string>& labels);
+
+    /**
+     * @brief Closes the writer if close() was not called.
+     */
+    ~TimeSeriesWriter();
+
+    TimeSeriesWriter(const TimeSeriesWriter&) = delete;
+    TimeSeriesWriter& operator=(const TimeSeriesWriter&) = delete;
+
+    /**
+     * @brief Returns whether the file was opened and close() has not been called.
+     */
+    bool isOpen() const;
+
+    /**
+     * @brief Returns whether record() needs the samples of @p cycle.
+     *
+     * With Last downsampling only the last cycle of each window is read,
+     * so callers can skip collecting samples on the other cycles.
+     *
+     * @param cycle Cycle that just completed.
+     * @param end_of_run Whether it is the final cycle.
+     */
+    bool wantsSample(int cycle, bool end_of_run) const;
+
+    /**
+     * @brief Sets the totals the first window's counts start from, so
+     * requests preloaded before the first cycle are not counted.
+     *
+     * @param samples One sample per balancer, in constructor order.
+     */
+    void setBaseline(const std::vector<BalancerSample>& samples);
+
+    /**
+     * @brief Adds the samples of a cycle, writing a row at the end of each
+     * window and at the end of the run.
+     *
+     * @param cycle Cycle that just completed.
+     * @param samples One sample per balancer, in constructor order.
+     * @param end_of_run Whether it is the final cycle.
+     */
+    void record(int cycle, const std::vector<BalancerSample>& samples, bool end_of_run);
+
+    /**
+     * @brief Writes the remaining rows and joins the thread; safe to call twice.
+     */
+    void close();
+
+    /**
+     * @brief Returns rows written per balancer (valid after close()).
+     */
+    long long getRowCount() const;
+
+    /**
+     * @brief Returns the file size in bytes (valid after close()).
+     */
+    long long getByteCount() const;
+};
\ No newline at end of file
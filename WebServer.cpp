@@ -4,19 +4,44 @@
  */
 
 #include "WebServer.h"
+#include "Checkpoint.h"
+#include "MaglevTable.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
 
 /**
  * @brief Constructor implementation.
  *
  * Initializes:
- * - busy_until to 0 (available immediately)
- * - current_request to default
- * - has_current to false
+ * - speed and slot count from the profile (slots clamped to 1..MAX_SLOTS)
+ * - every slot's busy_until to 0 (available immediately)
+ * - slot requests to default
+ * - occupied mask to empty
+ * - client cache sized to the next power of two of profile.cache_entries
  *
  * @param id Unique identifier for this server.
+ * @param profile Speed factor and slot count of the server.
  */
-WebServer::WebServer(int id)
- : id(id), busy_until(0), current_request(), has_current(false) {}
+WebServer::WebServer(int id, const ServerProfile& profile)
+ : id(id),
+   speed(profile.speed > 0.0 ? profile.speed : 1.0),
+   num_slots(std::clamp(profile.slots, 1, MAX_SLOTS)),
+   occupied(0),
+   first_request(),
+   extra_requests(static_cast<std::size_t>(num_slots - 1)),
+   cache_hit_speedup(profile.cache_hit_speedup > 1.0 ? profile.cache_hit_speedup : 1.0),
+   cache_hits(0),
+   cache_misses(0) {
+
+    std::fill(busy_until, busy_until + MAX_SLOTS, 0);
+
+    if (profile.cache_entries > 0) {
+        std::size_t entries = 1;
+        while (entries < static_cast<std::size_t>(profile.cache_entries)) entries <<= 1;
+        cache_tags.assign(entries, 0);
+    }
+}
 
 /**
  * @brief Returns server ID.
@@ -26,44 +51,216 @@ int WebServer::getId() const {
 }
 
 /**
- * @brief Returns the cycle when the server becomes free.
+ * @brief Returns the speed factor.
+ */
+double WebServer::getSpeed() const {
+    return speed;
+}
+
+/**
+ * @brief Returns the number of worker slots.
+ */
+int WebServer::getSlotCount() const {
+    return num_slots;
+}
+
+/**
+ * @brief Returns speed * slots.
+ */
+double WebServer::getCapacity() const {
+    return speed * num_slots;
+}
+
+/**
+ * @brief Returns the cycle when the earliest slot becomes free.
  */
 int WebServer::getBusyUntil() const {
-    return busy_until;
+    return *std::min_element(busy_until, busy_until + num_slots);
 }
 
 /**
- * @brief Determines whether the server is currently busy.
+ * @brief Returns one slot's busy-until cycle.
+ */
+int WebServer::getSlotBusyUntil(int slot) const {
+    return busy_until[slot];
+}
+
+/**
+ * @brief Returns the earliest finish cycle among occupied slots.
+ */
+int WebServer::getNextCompletion() const {
+    int next = std::numeric_limits<int>::max();
+    for (int s = 0; s < num_slots; s++) {
+        if (occupied & (1u << s)) next = std::min(next, busy_until[s]);
+    }
+    return next;
+}
+
+/**
+ * @brief Determines whether every slot is currently busy.
  *
  * @param current_cycle Current simulation clock cycle.
- * @return True if current_cycle is less than busy_until.
+ * @return True if current_cycle is less than busy_until for all slots.
  */
 bool WebServer::isBusy(int current_cycle) const {
-    return current_cycle < busy_until;
+    return current_cycle < getBusyUntil();
+}
+
+/**
+ * @brief Counts the slots still processing at the given cycle.
+ */
+int WebServer::getBusySlots(int current_cycle) const {
+    int busy = 0;
+    for (int s = 0; s < num_slots; s++) {
+        if (current_cycle < busy_until[s]) busy++;
+    }
+    return busy;
 }
 
 /**
  * @brief Checks whether the server has an assigned request.
  *
- * @return True if a request is currently assigned.
+ * @return True if any slot currently holds a request.
  */
 bool WebServer::hasRequest() const {
-    return has_current;
+    return occupied != 0;
+}
+
+/**
+ * @brief Scales a request's processing time by the server speed.
+ */
+int WebServer::serviceTime(const Request& request) const {
+    int cycles = static_cast<int>(std::ceil(request.time / speed));
+    return std::max(cycles, 1);
+}
+
+/**
+ * @brief Direct-mapped lookup; a miss replaces the entry.
+ */
+bool WebServer::touchCache(unsigned int client) {
+    if (cache_tags.empty() || client == 0) return false;
+
+    unsigned int& tag = cache_tags[MaglevTable::hash(client, 0) & (cache_tags.size() - 1)];
+    if (tag == client) {
+        cache_hits++;
+        return true;
+    }
+    tag = client;
+    cache_misses++;
+    return false;
 }
 
 /**
- * @brief Assigns a request to this server.
+ * @brief Returns cache hits.
+ */
+long long WebServer::getCacheHits() const {
+    return cache_hits;
+}
+
+/**
+ * @brief Returns cache misses.
+ */
+long long WebServer::getCacheMisses() const {
+    return cache_misses;
+}
+
+/**
+ * @brief Assigns a request to the first free slot of this server.
  *
  * Sets:
- * - current_request
- * - busy_until based on processing time
- * - has_current flag
+ * - the slot's request
+ * - the slot's busy_until based on the scaled processing time,
+ *   divided by the cache speedup when the client was cached
+ * - the slot's occupied bit
  *
  * @param request Request to process.
  * @param current_cycle Current simulation clock cycle.
+ * @return Slot index, or -1 if the server has no free slot.
+ */
+int WebServer::assignRequest(Request& request, int current_cycle) {
+    for (int s = 0; s < num_slots; s++) {
+        if (current_cycle >= busy_until[s]) {
+            int cycles = serviceTime(request);
+            if (touchCache(request.in.getValue())) {
+                cycles = std::max(static_cast<int>(std::ceil(cycles / cache_hit_speedup)), 1);
+            }
+            slotRequest(s) = request;
+            busy_until[s] = current_cycle + cycles;
+            occupied |= 1u << s;
+            return s;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Clears the occupied bit of every slot that has finished and
+ * collects requests that continue at another stage.
+ */
+int WebServer::completeRequests(int current_cycle, std::vector<Request>& forward) {
+    int completed = 0;
+    for (int s = 0; s < num_slots; s++) {
+        if ((occupied & (1u << s)) && current_cycle >= busy_until[s]) {
+            occupied &= ~(1u << s);
+            completed++;
+            const Request& finished = slotRequest(s);
+            if (finished.hasNextStage()) forward.push_back(finished);
+        }
+    }
+    return completed;
+}
+
+/**
+ * @brief Hands over occupied slots with their finish cycles.
+ */
+void WebServer::takeInFlight(std::vector<std::pair<int, Request>>& out) {
+    for (int s = 0; s < num_slots; s++) {
+        if (occupied & (1u << s)) {
+            out.emplace_back(busy_until[s], slotRequest(s));
+        }
+    }
+    occupied = 0;
+}
+
+/**
+ * @brief Profile, slots and their requests, and the client cache.
+ */
+void WebServer::save(CheckpointWriter& out) const {
+    out.put(id);
+    out.put(speed);
+    out.put(num_slots);
+    out.put(busy_until);
+    out.put(occupied);
+    // only the slots in use, in putVector() layout
+    out.put<std::uint64_t>(static_cast<std::uint64_t>(num_slots));
+    out.put(first_request);
+    for (const Request& request : extra_requests) out.put(request);
+    out.putVector(cache_tags);
+    out.put(cache_hit_speedup);
+    out.put(cache_hits);
+    out.put(cache_misses);
+}
+
+/**
+ * @brief Reads the fields in save() order, including the profile, so a
+ * server keeps the type it was added with.
  */
-void WebServer::assignRequest(Request& request, int current_cycle) {
-    current_request = request;
-    busy_until = current_cycle + request.time;
-    has_current = true;
+void WebServer::restore(CheckpointReader& in) {
+    in.get(id);
+    in.get(speed);
+    in.get(num_slots);
+    in.get(busy_until);
+    in.get(occupied);
+    std::uint64_t saved_slots = in.get<std::uint64_t>();
+    if (num_slots < 1 || num_slots > MAX_SLOTS || saved_slots != static_cast<std::uint64_t>(num_slots)) {
+        in.fail("server " + std::to_string(id) + " has an invalid slot count");
+        num_slots = 1;
+        occupied = 0;
+    }
+    extra_requests.assign(static_cast<std::size_t>(num_slots - 1), Request());
+    for (int s = 0; s < num_slots; s++) in.get(slotRequest(s));
+    in.getVector(cache_tags);
+    in.get(cache_hit_speedup);
+    in.get(cache_hits);
+    in.get(cache_misses);
 }
\ No newline at end of file
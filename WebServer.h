@@ -3,12 +3,52 @@
  * @brief Defines the WebServer class used in the load balancer simulation.
  *
  * A WebServer represents an individual server instance that processes
- * incoming requests. It tracks its busy state and the clock cycle
- * at which it will become available.
+ * incoming requests. Each server has a speed factor and a fixed number of
+ * worker slots, and tracks the clock cycle at which each slot will become
+ * available.
  */
 
 #pragma once
 #include "Request.h"
+#include <utility>
+#include <vector>
+
+class CheckpointWriter;
+class CheckpointReader;
+
+/**
+ * @struct ServerProfile
+ * @brief Describes the hardware shape of a WebServer (an "instance type").
+ *
+ * A server with speed 2.0 finishes a request in half the cycles of a
+ * speed 1.0 server, and a server with 4 slots can work on 4 requests at once.
+ */
+struct ServerProfile {
+
+    /** @brief Relative processing speed (1.0 = baseline). */
+    double speed = 1.0;
+
+    /** @brief Number of requests the server can process concurrently. */
+    int slots = 1;
+
+    /**
+     * @brief Number of client entries in the server's local cache
+     * (0 disables the cache; rounded up to a power of two).
+     */
+    int cache_entries = 0;
+
+    /**
+     * @brief Factor by which a cache hit shortens a request's processing time.
+     */
+    double cache_hit_speedup = 1.0;
+
+    /**
+     * @brief Returns the capacity of the profile in baseline-server units.
+     *
+     * @return speed * slots.
+     */
+    double capacity() const { return speed * slots; }
+};
 
 /**
  * @class WebServer
@@ -16,11 +56,18 @@
  *
  * Each WebServer:
  * - Has a unique identifier
- * - Processes one request at a time
- * - Tracks when it will become available
- * - Maintains its current assigned request
+ * - Processes up to getSlotCount() requests at a time
+ * - Scales request processing time by its speed factor
+ * - Tracks when each of its slots will become available
+ * - Maintains the request assigned to each slot
+ * - Optionally caches recent clients, serving repeat clients faster
  */
 class WebServer {
+public:
+
+    /** @brief Upper bound on the number of worker slots per server. */
+    static constexpr int MAX_SLOTS = 16;
+
 private:
 
     /**
@@ -29,29 +76,75 @@ private:
     int id;
 
     /**
-     * @brief Clock cycle when the server will finish processing
-     * the current request and become free.
+     * @brief Relative processing speed of the server.
      */
-    int busy_until;
+    double speed;
 
     /**
-     * @brief Currently assigned request.
+     * @brief Number of usable worker slots (1..MAX_SLOTS).
      */
-    Request current_request;
+    int num_slots;
 
     /**
-     * @brief Indicates whether the server currently has a request.
+     * @brief Clock cycle when each slot will finish processing its
+     * current request and become free.
      */
-    bool has_current;
+    int busy_until[MAX_SLOTS];
+
+    /**
+     * @brief Bitmask of slots that currently hold a request.
+     */
+    unsigned int occupied;
+
+    /**
+     * @brief Request of slot 0, kept inline since most servers have a
+     * single slot.
+     */
+    Request first_request;
+
+    /**
+     * @brief Requests of slots 1..num_slots-1 (empty for a single-slot server).
+     */
+    std::vector<Request> extra_requests;
+
+    /**
+     * @brief Direct-mapped cache of recent source IPs (0 = empty entry).
+     */
+    std::vector<unsigned int> cache_tags;
+
+    /** @brief Processing time divisor applied on a cache hit. */
+    double cache_hit_speedup;
+
+    /** @brief Number of assigned requests whose client was cached. */
+    long long cache_hits;
+
+    /** @brief Number of assigned requests whose client was not cached. */
+    long long cache_misses;
+
+    /**
+     * @brief Returns the request held by a slot.
+     */
+    Request& slotRequest(int slot) {
+        return slot == 0 ? first_request : extra_requests[static_cast<std::size_t>(slot - 1)];
+    }
+
+    /**
+     * @brief Looks up and inserts a client in the cache.
+     *
+     * @param client Source IP of the request.
+     * @return True if the client was already cached.
+     */
+    bool touchCache(unsigned int client);
 
 public:
 
     /**
-     * @brief Constructs a WebServer with a given ID.
+     * @brief Constructs a WebServer with a given ID and profile.
      *
      * @param id Unique identifier for the server.
+     * @param profile Speed factor and slot count of the server.
      */
-    explicit WebServer(int id);
+    explicit WebServer(int id, const ServerProfile& profile = ServerProfile());
 
     /**
      * @brief Returns the server's ID.
@@ -61,35 +154,117 @@ public:
     int getId() const;
 
     /**
-     * @brief Returns the clock cycle when the server becomes free.
+     * @brief Returns the server's speed factor.
+     */
+    double getSpeed() const;
+
+    /**
+     * @brief Returns the number of worker slots.
+     */
+    int getSlotCount() const;
+
+    /**
+     * @brief Returns the capacity of the server in baseline-server units.
      *
-     * @return Busy-until clock cycle.
+     * @return speed * slot count.
+     */
+    double getCapacity() const;
+
+    /**
+     * @brief Returns the clock cycle when the next slot becomes free.
+     *
+     * @return Earliest busy-until clock cycle over all slots.
      */
     int getBusyUntil() const;
 
     /**
-     * @brief Determines if the server is currently busy.
+     * @brief Returns the clock cycle when a given slot becomes free.
+     *
+     * @param slot Slot index.
+     */
+    int getSlotBusyUntil(int slot) const;
+
+    /**
+     * @brief Returns the cycle the earliest occupied slot finishes.
+     *
+     * @return Earliest busy-until cycle of an occupied slot, or INT_MAX if
+     *         no slot holds a request.
+     */
+    int getNextCompletion() const;
+
+    /**
+     * @brief Determines if every slot of the server is currently busy.
      *
      * @param current_cycle Current simulation clock cycle.
-     * @return True if still processing a request.
+     * @return True if no slot can accept a request.
      */
     bool isBusy(int current_cycle) const;
 
+    /**
+     * @brief Returns the number of slots that are processing a request.
+     *
+     * @param current_cycle Current simulation clock cycle.
+     */
+    int getBusySlots(int current_cycle) const;
+
     /**
      * @brief Checks whether the server has a request assigned.
      *
-     * @return True if a request is currently assigned.
+     * @return True if any slot currently holds a request.
      */
     bool hasRequest() const;
 
     /**
-     * @brief Assigns a request to the server.
+     * @brief Returns the number of cycles this server needs for a request.
      *
-     * Updates the server’s busy time based on the request's
-     * processing time.
+     * @param request Request to be processed.
+     * @return ceil(request.time / speed), at least 1.
+     */
+    int serviceTime(const Request& request) const;
+
+    /**
+     * @brief Assigns a request to the first free slot.
+     *
+     * Updates the slot's busy time based on the request's
+     * processing time, the server speed, and whether the client
+     * hit in the server's cache.
      *
      * @param request Request to assign.
      * @param current_cycle Current simulation clock cycle.
+     * @return Index of the slot used, or -1 if every slot is busy.
+     */
+    int assignRequest(Request& request, int current_cycle);
+
+    /** @brief Returns the number of cache hits so far. */
+    long long getCacheHits() const;
+
+    /** @brief Returns the number of cache misses so far. */
+    long long getCacheMisses() const;
+
+    /**
+     * @brief Releases every slot whose request has finished.
+     *
+     * @param current_cycle Current simulation clock cycle.
+     * @param forward Receives finished requests that have another stage.
+     * @return Number of requests completed.
+     */
+    int completeRequests(int current_cycle, std::vector<Request>& forward);
+
+    /**
+     * @brief Moves every request still being processed into @p out,
+     * paired with the cycle it finishes, and frees all slots.
+     *
+     * @param out Vector the in-flight requests are appended to.
+     */
+    void takeInFlight(std::vector<std::pair<int, Request>>& out);
+
+    /**
+     * @brief Appends the server to a checkpoint.
+     */
+    void save(CheckpointWriter& out) const;
+
+    /**
+     * @brief Replaces the server with one read from a checkpoint.
      */
-    void assignRequest(Request& request, int current_cycle);
+    void restore(CheckpointReader& in);
 };
\ No newline at end of file
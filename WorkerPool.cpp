@@ -0,0 +1,93 @@
+/**
+ * @file WorkerPool.cpp
+ * @brief Implementation of the WorkerPool class.
+ */
+
+#include "WorkerPool.h"
+
+/**
+ * @brief Constructor implementation.
+ */
+WorkerPool::WorkerPool(std::size_t thread_count)
+ : task(nullptr), task_count(0), next_task(0), generation(0),
+   busy_workers(0), stopping(false) {
+    for (std::size_t i = 1; i < thread_count; i++) {
+        threads.emplace_back(&WorkerPool::workerLoop, this);
+    }
+}
+
+/**
+ * @brief Wakes every worker with the stop flag set and joins them.
+ */
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    batch_ready.notify_all();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
+
+/**
+ * @brief Runs tasks claimed with a shared atomic counter.
+ */
+void WorkerPool::drain() {
+    for (std::size_t i = next_task.fetch_add(1); i < task_count; i = next_task.fetch_add(1)) {
+        (*task)(i);
+    }
+}
+
+/**
+ * @brief Sleeps until a new generation or stop, then drains the batch.
+ */
+void WorkerPool::workerLoop() {
+    unsigned long long seen = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            batch_ready.wait(lock, [&] { return stopping || generation != seen; });
+            if (stopping) return;
+            seen = generation;
+        }
+
+        drain();
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--busy_workers == 0) batch_done.notify_one();
+    }
+}
+
+/**
+ * @brief Publishes the batch, drains it on the caller too, then waits.
+ */
+void WorkerPool::run(std::size_t count, const std::function<void(std::size_t)>& fn) {
+    if (threads.empty() || count < 2) {
+        for (std::size_t i = 0; i < count; i++) fn(i);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        task = &fn;
+        task_count = count;
+        next_task.store(0);
+        busy_workers = threads.size();
+        generation++;
+    }
+    batch_ready.notify_all();
+
+    drain();
+
+    std::unique_lock<std::mutex> lock(mutex);
+    batch_done.wait(lock, [&] { return busy_workers == 0; });
+    task = nullptr;
+}
+
+/**
+ * @brief Returns the thread count.
+ */
+std::size_t WorkerPool::getThreadCount() const {
+    return threads.size() + 1;
+}
\ No newline at end of file
@@ -0,0 +1,95 @@
+/**
+ * @file WorkerPool.h
+ * @brief Defines a fixed pool of threads that runs batches of indexed tasks.
+ *
+ * The Switch uses it to step independent subtrees of a topology in
+ * parallel once per clock cycle. Threads are started once and sleep
+ * between batches, so a batch costs two condition variable round trips
+ * rather than thread creation.
+ */
+
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @class WorkerPool
+ * @brief Runs task(0) .. task(count - 1) across its threads and the caller.
+ */
+class WorkerPool {
+private:
+
+    /** @brief Worker threads (the calling thread also takes tasks). */
+    std::vector<std::thread> threads;
+
+    /** @brief Guards the batch fields below. */
+    std::mutex mutex;
+
+    /** @brief Wakes workers when a batch starts or the pool stops. */
+    std::condition_variable batch_ready;
+
+    /** @brief Wakes the caller when every worker left the batch. */
+    std::condition_variable batch_done;
+
+    /** @brief Task of the current batch. */
+    const std::function<void(std::size_t)>* task;
+
+    /** @brief Number of tasks in the current batch. */
+    std::size_t task_count;
+
+    /** @brief Next task index to hand out. */
+    std::atomic<std::size_t> next_task;
+
+    /** @brief Incremented for every batch so workers see each one once. */
+    unsigned long long generation;
+
+    /** @brief Workers still inside the current batch. */
+    std::size_t busy_workers;
+
+    /** @brief Set when the pool is destroyed. */
+    bool stopping;
+
+    /**
+     * @brief Claims and runs tasks until the batch is exhausted.
+     */
+    void drain();
+
+    /**
+     * @brief Thread body: waits for batches and drains them.
+     */
+    void workerLoop();
+
+public:
+
+    /**
+     * @brief Starts the pool.
+     *
+     * @param thread_count Total threads including the caller; values
+     *                     below 2 run every batch on the caller.
+     */
+    explicit WorkerPool(std::size_t thread_count);
+
+    /** @brief Stops and joins all workers. */
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    /**
+     * @brief Runs @p task for every index in [0, count) and waits for all.
+     *
+     * @param count Number of tasks.
+     * @param task Callable invoked once per index, possibly concurrently.
+     */
+    void run(std::size_t count, const std::function<void(std::size_t)>& task);
+
+    /**
+     * @brief Returns the number of threads including the caller.
+     */
+    std::size_t getThreadCount() const;
+};
\ No newline at end of file
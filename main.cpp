@@ -10,6 +10,10 @@
 #include "LoadBalancer.h"
 #include "Switch.h"
 #include "SwitchConfig.h"
+#include "ConfigReload.h"
+#include "MetricsServer.h"
+#include "LiveProxy.h"
+#include <memory>
 #include <sstream>
 
 // create a log file at global scope so it stays alive until the program exits
@@ -26,22 +30,70 @@ int main() {
 
     // load runtime config (falls back to sensible defaults)
     SwitchConfig cfg = loadSwitchConfig("switch.cfg");
-    std::cout << "Switch config: P=" << cfg.num_p_balancers
-              << " S=" << cfg.num_s_balancers
-              << " servers(P/S)=" << cfg.servers_per_p_balancer << "/" << cfg.servers_per_s_balancer
-              << " waitCycles=" << cfg.num_wait_clock_cycles
-              << " timeRange=[" << cfg.min_request_time << "," << cfg.max_request_time << "]"
-              << " totalCycles=" << cfg.total_clock_cycles << "\n";
-
-    Switch sw(cfg.num_p_balancers,
-              cfg.num_s_balancers,
-              cfg.servers_per_p_balancer,
-              cfg.servers_per_s_balancer,
-              cfg.num_wait_clock_cycles,
-              cfg.min_request_time,
-              cfg.max_request_time,
-              cfg.blocked_ranges);
+    if (cfg.job_classes.empty()) {
+        std::cout << "Switch config: P=" << cfg.num_p_balancers
+                  << " S=" << cfg.num_s_balancers
+                  << " servers(P/S)=" << cfg.servers_per_p_balancer << "/" << cfg.servers_per_s_balancer
+                  << " waitCycles=" << cfg.num_wait_clock_cycles
+                  << " timeRange=[" << cfg.min_request_time << "," << cfg.max_request_time << "]"
+                  << " totalCycles=" << cfg.total_clock_cycles << "\n";
+    } else {
+        // job_class lines replace the P/S pair, so list the registry instead
+        std::cout << "Switch config: classes=" << cfg.job_classes.size()
+                  << " discipline=" << queueDisciplineName(cfg.queue.discipline)
+                  << " waitCycles=" << cfg.num_wait_clock_cycles
+                  << " timeRange=[" << cfg.min_request_time << "," << cfg.max_request_time << "]"
+                  << " totalCycles=" << cfg.total_clock_cycles << "\n";
+        for (const JobClass& job_class : cfg.job_classes) {
+            std::cout << "  Job class " << job_class.name
+                      << ": share=" << job_class.share
+                      << " balancers=" << job_class.balancers
+                      << " servers=" << job_class.servers_per_balancer;
+            if (!job_class.next.empty()) std::cout << " next=" << job_class.next;
+            std::cout << "\n";
+        }
+    }
+
+    // series are owned here so they outlive the switch that writes them
+    MetricsRegistry metrics;
+    Switch sw(cfg);
+
+    // continue a checkpointed run instead of preloading
+    if (!cfg.restore_file.empty() && !sw.restoreCheckpoint(cfg.restore_file)) {
+        std::cerr << "ERROR: could not restore " << cfg.restore_file << " (see switchlog.ansi)\n";
+        return 1;
+    }
+
+    // reload thread, stopped before the switch it publishes into is destroyed
+    std::unique_ptr<ConfigWatcher> watcher;
+    if (cfg.config_reload) {
+        watcher = std::make_unique<ConfigWatcher>("switch.cfg", sw.getPolicyCell());
+    }
+
+    // live mode: the same switch routes real connections instead of simulating
+    if (cfg.live_proxy.port > 0) {
+        LiveProxy proxy(sw, cfg.live_proxy);
+        std::unique_ptr<MetricsServer> metrics_server;
+        if (cfg.metrics_port > 0) {
+            proxy.registerMetrics(metrics);
+            metrics_server = std::make_unique<MetricsServer>(cfg.metrics_port, metrics);
+        }
+        bool ok = proxy.run();
+        if (watcher) watcher->stop();
+        if (metrics_server) metrics_server->stop();
+        return ok ? 0 : 1;
+    }
+
+    // metrics endpoint, stopped with the reload thread once the run ends
+    std::unique_ptr<MetricsServer> metrics_server;
+    if (cfg.metrics_port > 0) {
+        sw.registerMetrics(metrics);
+        metrics_server = std::make_unique<MetricsServer>(cfg.metrics_port, metrics);
+    }
+
     sw.start(cfg.total_clock_cycles);
+    if (watcher) watcher->stop();
+    if (metrics_server) metrics_server->stop();
     std::cout << "  Request time range: " << cfg.min_request_time << " - " << cfg.max_request_time << " cycles\n"
               << "  Blocked IP ranges: " << cfg.blocked_ranges.size() << "\n";
     for (const IPRange& r : cfg.blocked_ranges) {